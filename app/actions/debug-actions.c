@@ -30,6 +30,8 @@
 #include "debug-actions.h"
 #include "debug-commands.h"
 
+#include "gimp-trace.h"
+
 
 #ifdef ENABLE_DEBUG_MENU
 
@@ -69,6 +71,17 @@ static const GimpActionEntry debug_actions[] =
     NULL }
 };
 
+static const GimpToggleActionEntry debug_toggle_actions[] =
+{
+  { "debug-trace", NULL,
+    "Record _Trace", NULL,
+    "Record a trace of hot code paths, written in Chrome trace format "
+    "when recording is stopped",
+    G_CALLBACK (debug_trace_cmd_callback),
+    FALSE,
+    NULL }
+};
+
 #endif
 
 void
@@ -78,6 +91,10 @@ debug_actions_setup (GimpActionGroup *group)
   gimp_action_group_add_actions (group, NULL,
                                  debug_actions,
                                  G_N_ELEMENTS (debug_actions));
+
+  gimp_action_group_add_toggle_actions (group, NULL,
+                                        debug_toggle_actions,
+                                        G_N_ELEMENTS (debug_toggle_actions));
 #endif
 }
 
@@ -85,4 +102,8 @@ void
 debug_actions_update (GimpActionGroup *group,
                       gpointer         data)
 {
+#ifdef ENABLE_DEBUG_MENU
+  gimp_action_group_set_action_active (group, "debug-trace",
+                                       gimp_trace_is_active ());
+#endif
 }
@@ -50,6 +50,8 @@
 #include "actions.h"
 #include "debug-commands.h"
 
+#include "gimp-trace.h"
+
 
 #ifdef ENABLE_DEBUG_MENU
 
@@ -98,6 +100,36 @@ debug_show_image_graph_cmd_callback (GtkAction *action,
   g_idle_add ((GSourceFunc) debug_show_image_graph, g_object_ref (source_image));
 }
 
+void
+debug_trace_cmd_callback (GtkAction *action,
+                          gpointer   data)
+{
+  gboolean active = gtk_toggle_action_get_active (GTK_TOGGLE_ACTION (action));
+
+  if (active == gimp_trace_is_active ())
+    return;
+
+  if (active)
+    {
+      gimp_trace_start ();
+    }
+  else
+    {
+      GError *error = NULL;
+
+      if (gimp_trace_stop (NULL, &error))
+        {
+          g_print ("Trace written to '%s'\n",
+                   gimp_filename_to_utf8 (gimp_trace_get_filename ()));
+        }
+      else
+        {
+          g_printerr ("%s\n", error->message);
+          g_clear_error (&error);
+        }
+    }
+}
+
 void
 debug_dump_menus_cmd_callback (GtkAction *action,
                                gpointer   data)
@@ -40,6 +40,8 @@ void debug_benchmark_projection_cmd_callback    (GtkAction *action,
                                                  gpointer   data);
 void debug_show_image_graph_cmd_callback        (GtkAction *action,
                                                  gpointer   data);
+void debug_trace_cmd_callback                   (GtkAction *action,
+                                                 gpointer   data);
 
 #endif /* ENABLE_DEBUG_MENU */
 
@@ -123,6 +123,12 @@ const GimpStringActionEntry dialogs_dockable_actions[] =
     "gimp-sample-point-editor",
     GIMP_HELP_SAMPLE_POINT_DIALOG },
 
+  { "dialogs-memory", GIMP_STOCK_INFO,
+    NC_("dialogs-action", "_Memory Usage"), NULL,
+    NC_("dialogs-action", "Open the memory usage dialog"),
+    "gimp-memory-editor",
+    GIMP_HELP_MEMORY_DIALOG },
+
   { "dialogs-colors", GIMP_STOCK_DEFAULT_COLORS,
     NC_("dialogs-action", "Colo_rs"), NULL,
     NC_("dialogs-action", "Open the FG/BG color dialog"),
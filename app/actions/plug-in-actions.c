@@ -49,6 +49,19 @@
 #include "gimp-intl.h"
 
 
+typedef struct _PlugInActionsSensitivity PlugInActionsSensitivity;
+
+struct _PlugInActionsSensitivity
+{
+  /*  the procedure actions, bucketed by their image_types_val  */
+  GHashTable          *buckets;
+
+  /*  the drawable type the actions were last updated for  */
+  GimpPlugInImageType  image_type;
+  gboolean             valid;
+};
+
+
 /*  local function prototypes  */
 
 static void     plug_in_actions_menu_branch_added    (GimpPlugInManager   *manager,
@@ -68,6 +81,11 @@ static void     plug_in_actions_menu_path_added      (GimpPlugInProcedure *proc,
 static void     plug_in_actions_add_proc             (GimpActionGroup     *group,
                                                       GimpPlugInProcedure *proc);
 
+static PlugInActionsSensitivity *
+                plug_in_actions_get_sensitivity      (GimpActionGroup     *group);
+static void     plug_in_actions_sensitivity_free     (PlugInActionsSensitivity *sensitivity);
+static void     plug_in_actions_bucket_free          (GList               *actions);
+
 static void     plug_in_actions_history_changed      (GimpPlugInManager   *manager,
                                                       GimpActionGroup     *group);
 static gboolean plug_in_actions_check_translation    (const gchar         *original,
@@ -238,30 +256,47 @@ void
 plug_in_actions_update (GimpActionGroup *group,
                         gpointer         data)
 {
-  GimpImage         *image    = action_data_get_image (data);
-  GimpPlugInManager *manager  = group->gimp->plug_in_manager;
-  GimpDrawable      *drawable = NULL;
-  GSList            *list;
-  gint               i;
+  GimpImage                *image    = action_data_get_image (data);
+  GimpPlugInManager        *manager  = group->gimp->plug_in_manager;
+  GimpDrawable             *drawable = NULL;
+  PlugInActionsSensitivity *sensitivity;
+  GimpPlugInImageType       image_type;
+  GSList                   *list;
+  gint                      i;
 
   if (image)
     drawable = gimp_image_get_active_drawable (image);
 
-  for (list = manager->plug_in_procedures; list; list = g_slist_next (list))
+  sensitivity = plug_in_actions_get_sensitivity (group);
+  image_type  = gimp_plug_in_procedure_get_drawable_type (drawable);
+
+  /*  only touch the buckets whose sensitivity changed with the
+   *  drawable type, not every procedure's action
+   */
+  if (! sensitivity->valid || image_type != sensitivity->image_type)
     {
-      GimpPlugInProcedure *proc = list->data;
+      GHashTableIter iter;
+      gpointer       key;
+      gpointer       value;
+
+      g_hash_table_iter_init (&iter, sensitivity->buckets);
 
-      if ((proc->menu_label || proc->menu_paths) &&
-          ! proc->file_proc                      &&
-          proc->image_types_val)
+      while (g_hash_table_iter_next (&iter, &key, &value))
         {
-          gboolean sensitive = gimp_plug_in_procedure_get_sensitive (proc,
-                                                                     drawable);
+          GimpPlugInImageType  types     = GPOINTER_TO_UINT (key);
+          gboolean             sensitive = (types & image_type) != 0;
+          GList               *actions;
 
-          gimp_action_group_set_action_sensitive (group,
-                                                  gimp_object_get_name (proc),
-                                                  sensitive);
+          if (sensitivity->valid &&
+              sensitive == ((types & sensitivity->image_type) != 0))
+            continue;
+
+          for (actions = value; actions; actions = g_list_next (actions))
+            gtk_action_set_sensitive (actions->data, sensitive);
         }
+
+      sensitivity->image_type = image_type;
+      sensitivity->valid      = TRUE;
     }
 
   if (manager->history &&
@@ -378,7 +413,30 @@ plug_in_actions_unregister_procedure (GimpPDB         *pdb,
                                                 gimp_object_get_name (procedure));
 
           if (action)
-            gtk_action_group_remove_action (GTK_ACTION_GROUP (group), action);
+            {
+              PlugInActionsSensitivity *sensitivity;
+              gpointer                  key;
+              GList                    *actions;
+
+              sensitivity = plug_in_actions_get_sensitivity (group);
+              key = GUINT_TO_POINTER (plug_in_proc->image_types_val);
+
+              actions = g_hash_table_lookup (sensitivity->buckets, key);
+
+              if (g_list_find (actions, action))
+                {
+                  actions = g_list_remove (actions, action);
+                  g_object_unref (action);
+
+                  /*  steal first, replacing would free the list  */
+                  g_hash_table_steal (sensitivity->buckets, key);
+
+                  if (actions)
+                    g_hash_table_insert (sensitivity->buckets, key, actions);
+                }
+
+              gtk_action_group_remove_action (GTK_ACTION_GROUP (group), action);
+            }
         }
     }
 }
@@ -503,22 +561,87 @@ plug_in_actions_add_proc (GimpActionGroup     *group,
       ! proc->file_proc                      &&
       proc->image_types_val)
     {
-      GimpContext  *context  = gimp_get_user_context (group->gimp);
-      GimpImage    *image    = gimp_context_get_image (context);
-      GimpDrawable *drawable = NULL;
-      gboolean      sensitive;
+      PlugInActionsSensitivity *sensitivity;
+      GtkAction                *action;
+      gpointer                  key;
+      GList                    *actions;
+      gboolean                  sensitive;
 
-      if (image)
-        drawable = gimp_image_get_active_drawable (image);
+      sensitivity = plug_in_actions_get_sensitivity (group);
 
-      sensitive = gimp_plug_in_procedure_get_sensitive (proc, drawable);
+      action = gtk_action_group_get_action (GTK_ACTION_GROUP (group),
+                                            gimp_object_get_name (proc));
 
-      gimp_action_group_set_action_sensitive (group,
-                                              gimp_object_get_name (proc),
-                                              sensitive);
+      if (! action)
+        return;
+
+      key = GUINT_TO_POINTER (proc->image_types_val);
+
+      actions = g_hash_table_lookup (sensitivity->buckets, key);
+      g_hash_table_steal (sensitivity->buckets, key);
+      g_hash_table_insert (sensitivity->buckets, key,
+                           g_list_prepend (actions, g_object_ref (action)));
+
+      /*  match the bucket, the next update only touches changed ones  */
+      if (sensitivity->valid)
+        {
+          sensitive = (proc->image_types_val & sensitivity->image_type) != 0;
+        }
+      else
+        {
+          GimpContext  *context  = gimp_get_user_context (group->gimp);
+          GimpImage    *image    = gimp_context_get_image (context);
+          GimpDrawable *drawable = NULL;
+
+          if (image)
+            drawable = gimp_image_get_active_drawable (image);
+
+          sensitive = gimp_plug_in_procedure_get_sensitive (proc, drawable);
+        }
+
+      gtk_action_set_sensitive (action, sensitive);
     }
 }
 
+static PlugInActionsSensitivity *
+plug_in_actions_get_sensitivity (GimpActionGroup *group)
+{
+  PlugInActionsSensitivity *sensitivity;
+
+  sensitivity = g_object_get_data (G_OBJECT (group),
+                                   "plug-in-actions-sensitivity");
+
+  if (! sensitivity)
+    {
+      sensitivity = g_slice_new0 (PlugInActionsSensitivity);
+
+      sensitivity->buckets =
+        g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                               NULL,
+                               (GDestroyNotify) plug_in_actions_bucket_free);
+
+      g_object_set_data_full (G_OBJECT (group), "plug-in-actions-sensitivity",
+                              sensitivity,
+                              (GDestroyNotify) plug_in_actions_sensitivity_free);
+    }
+
+  return sensitivity;
+}
+
+static void
+plug_in_actions_sensitivity_free (PlugInActionsSensitivity *sensitivity)
+{
+  g_hash_table_unref (sensitivity->buckets);
+
+  g_slice_free (PlugInActionsSensitivity, sensitivity);
+}
+
+static void
+plug_in_actions_bucket_free (GList *actions)
+{
+  g_list_free_full (actions, (GDestroyNotify) g_object_unref);
+}
+
 static void
 plug_in_actions_history_changed (GimpPlugInManager *manager,
                                  GimpActionGroup   *group)
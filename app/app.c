@@ -63,6 +63,8 @@
 #include "units.h"
 #include "language.h"
 #include "gimp-debug.h"
+#include "gimp-startup.h"
+#include "gimp-trace.h"
 
 #include "gimp-intl.h"
 
@@ -72,6 +74,7 @@
 static void       app_init_update_noop    (const gchar *text1,
                                            const gchar *text2,
                                            gdouble      percentage);
+static gboolean   app_startup_finished    (Gimp        *gimp);
 static gboolean   app_exit_after_callback (Gimp        *gimp,
                                            gboolean     kill_it,
                                            GMainLoop   *loop);
@@ -146,6 +149,8 @@ app_run (const gchar         *full_prog_name,
   Gimp               *gimp;
   GMainLoop          *loop;
 
+  gimp_startup_phase ("core");
+
   /*  Create an instance of the "Gimp" object which is the root of the
    *  core object system
    */
@@ -168,7 +173,11 @@ app_run (const gchar         *full_prog_name,
    */
   if (! g_file_test (gimp_directory (), G_FILE_TEST_IS_DIR))
     {
-      GimpUserInstall *install = gimp_user_install_new (be_verbose);
+      GimpUserInstall *install;
+
+      gimp_startup_phase ("user install");
+
+      install = gimp_user_install_new (be_verbose);
 
 #ifdef GIMP_CONSOLE_COMPILATION
       gimp_user_install_run (install);
@@ -182,17 +191,25 @@ app_run (const gchar         *full_prog_name,
       gimp_user_install_free (install);
     }
 
+  gimp_startup_phase ("config");
+
   gimp_load_config (gimp, alternate_system_gimprc, alternate_gimprc);
 
   /*  change the locale if a language if specified  */
   language_init (gimp->config->language);
 
   /*  initialize lowlevel stuff  */
+  gimp_startup_phase ("gegl");
+
   gimp_gegl_init (gimp);
 
 #ifndef GIMP_CONSOLE_COMPILATION
   if (! no_interface)
-    update_status_func = gui_init (gimp, no_splash);
+    {
+      gimp_startup_phase ("gui");
+
+      update_status_func = gui_init (gimp, no_splash);
+    }
 #endif
 
   if (! update_status_func)
@@ -201,10 +218,14 @@ app_run (const gchar         *full_prog_name,
   /*  Create all members of the global Gimp instance which need an already
    *  parsed gimprc, e.g. the data factories
    */
+  gimp_startup_phase ("initialize");
+
   gimp_initialize (gimp, update_status_func);
 
   /*  Load all data files
    */
+  gimp_startup_phase ("data");
+
   gimp_restore (gimp, update_status_func);
 
   /*  enable autosave late so we don't autosave when the
@@ -218,6 +239,8 @@ app_run (const gchar         *full_prog_name,
     {
       gint i;
 
+      gimp_startup_phase ("command line images");
+
       for (i = 0; filenames[i] != NULL; i++)
         file_open_from_command_line (gimp, filenames[i], as_new);
     }
@@ -230,6 +253,11 @@ app_run (const gchar         *full_prog_name,
                           G_CALLBACK (app_exit_after_callback),
                           loop);
 
+  /*  the first window is up once the main loop gets idle  */
+  gimp_startup_phase ("first window");
+
+  g_idle_add ((GSourceFunc) app_startup_finished, gimp);
+
   gimp_threads_leave (gimp);
   g_main_loop_run (loop);
   gimp_threads_enter (gimp);
@@ -240,6 +268,8 @@ app_run (const gchar         *full_prog_name,
 
   gimp_debug_instances ();
 
+  gimp_trace_exit ();
+
   errors_exit ();
   gegl_exit ();
 }
@@ -255,6 +285,14 @@ app_init_update_noop (const gchar *text1,
   /*  deliberately do nothing  */
 }
 
+static gboolean
+app_startup_finished (Gimp *gimp)
+{
+  gimp_startup_finish (gimp->be_verbose);
+
+  return FALSE;
+}
+
 static gboolean
 app_exit_after_callback (Gimp      *gimp,
                          gboolean   kill_it,
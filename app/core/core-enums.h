@@ -807,4 +807,16 @@ typedef enum  /*< pdb-skip, skip >*/
 } GimpItemTypeMask;
 
 
+typedef enum  /*< pdb-skip, skip >*/
+{
+  SIOX_REFINEMENT_NO_CHANGE          = 0,
+  SIOX_REFINEMENT_ADD_FOREGROUND     = 1 << 0,
+  SIOX_REFINEMENT_ADD_BACKGROUND     = 1 << 1,
+  SIOX_REFINEMENT_CHANGE_SENSITIVITY = 1 << 2,
+  SIOX_REFINEMENT_CHANGE_SMOOTHNESS  = 1 << 3,
+  SIOX_REFINEMENT_CHANGE_MULTIBLOB   = 1 << 4,
+  SIOX_REFINEMENT_RECALCULATE        = 0xFF
+} SioxRefinementType;
+
+
 #endif /* __CORE_ENUMS_H__ */
@@ -517,22 +517,22 @@ gimp_edit_fill_full (GimpImage            *image,
       format = gimp_drawable_get_format (drawable);
     }
 
-  dest_buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, width, height),
-                                 format);
-
   if (pattern)
     {
       GeglBuffer *src_buffer = gimp_pattern_create_buffer (pattern);
 
-      gegl_buffer_set_pattern (dest_buffer, NULL, src_buffer, 0, 0);
+      dest_buffer = gimp_gegl_buffer_new_fill (GEGL_RECTANGLE (0, 0,
+                                                               width, height),
+                                               format, NULL, src_buffer,
+                                               0, 0, NULL, 0, 0);
       g_object_unref (src_buffer);
     }
   else
     {
-      GeglColor *gegl_color = gimp_gegl_color_new (color);
-
-      gegl_buffer_set_color (dest_buffer, NULL, gegl_color);
-      g_object_unref (gegl_color);
+      dest_buffer = gimp_gegl_buffer_new_fill (GEGL_RECTANGLE (0, 0,
+                                                               width, height),
+                                               format, color, NULL,
+                                               0, 0, NULL, 0, 0);
     }
 
   gimp_drawable_apply_buffer (drawable, dest_buffer,
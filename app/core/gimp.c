@@ -79,6 +79,7 @@
 #include "gimptoolpreset.h"
 #include "gimptoolpreset-load.h"
 
+#include "gimp-startup.h"
 #include "gimp-intl.h"
 
 
@@ -709,6 +710,8 @@ gimp_real_restore (Gimp               *gimp,
   if (gimp->be_verbose)
     g_print ("INIT: %s\n", G_STRFUNC);
 
+  gimp_startup_phase ("plug-ins");
+
   gimp_plug_in_manager_restore (gimp->plug_in_manager,
                                 gimp_get_user_context (gimp), status_callback);
 
@@ -973,6 +976,7 @@ gimp_restore (Gimp               *gimp,
                                gimp->no_data);
 
   /*  initialize the list of fonts  */
+  gimp_startup_phase ("fonts");
   status_callback (NULL, _("Fonts (this may take a while)"), 0.6);
   if (! gimp->no_fonts)
     gimp_fonts_load (gimp);
@@ -986,6 +990,7 @@ gimp_restore (Gimp               *gimp,
     }
 
   /*  initialize the template list  */
+  gimp_startup_phase ("templates and modules");
   status_callback (NULL, _("Templates"), 0.7);
   gimp_templates_load (gimp);
 
@@ -994,6 +999,7 @@ gimp_restore (Gimp               *gimp,
   gimp_modules_load (gimp);
 
   /* update tag cache */
+  gimp_startup_phase ("tag cache");
   status_callback (NULL, _("Updating tag cache"), 0.9);
   gimp_tag_cache_load (gimp->tag_cache);
   gimp_tag_cache_add_container (gimp->tag_cache,
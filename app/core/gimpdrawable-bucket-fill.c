@@ -27,11 +27,9 @@
 
 #include "core-types.h"
 
-#include "gegl/gimp-gegl-nodes.h"
 #include "gegl/gimp-gegl-utils.h"
 
 #include "gimp.h"
-#include "gimp-apply-operation.h"
 #include "gimpchannel.h"
 #include "gimpchannel-combine.h"
 #include "gimpcontext.h"
@@ -140,7 +138,6 @@ gimp_drawable_bucket_fill_internal (GimpDrawable        *drawable,
   GimpChannel *mask;
   GeglBuffer  *buffer;
   GeglBuffer  *mask_buffer;
-  GeglNode    *apply_opacity;
   gint         x1, y1, x2, y2;
   gint         mask_offset_x = 0;
   gint         mask_offset_y = 0;
@@ -221,41 +218,38 @@ gimp_drawable_bucket_fill_internal (GimpDrawable        *drawable,
       mask_offset_y = y1;
     }
 
-  buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, x2 - x1, y2 - y1),
-                            gimp_drawable_get_format_with_alpha (drawable));
-
+  /*  the fill shares its tiles wherever the mask is opaque and leaves
+   *  out those where it is empty, with the pattern aligned to the
+   *  drawable's origin
+   */
   switch (fill_mode)
     {
     case GIMP_FG_BUCKET_FILL:
     case GIMP_BG_BUCKET_FILL:
-      {
-        GeglColor *gegl_color = gimp_gegl_color_new (color);
-
-        gegl_buffer_set_color (buffer, NULL, gegl_color);
-        g_object_unref (gegl_color);
-      }
+      buffer = gimp_gegl_buffer_new_fill (GEGL_RECTANGLE (0, 0,
+                                                          x2 - x1, y2 - y1),
+                                          gimp_drawable_get_format_with_alpha (drawable),
+                                          color, NULL, 0, 0,
+                                          mask_buffer,
+                                          mask_offset_x, mask_offset_y);
       break;
 
     case GIMP_PATTERN_BUCKET_FILL:
+    default:
       {
         GeglBuffer *pattern_buffer = gimp_pattern_create_buffer (pattern);
 
-        gegl_buffer_set_pattern (buffer, NULL, pattern_buffer, -x1, -y1);
+        buffer = gimp_gegl_buffer_new_fill (GEGL_RECTANGLE (0, 0,
+                                                            x2 - x1, y2 - y1),
+                                            gimp_drawable_get_format_with_alpha (drawable),
+                                            NULL, pattern_buffer, -x1, -y1,
+                                            mask_buffer,
+                                            mask_offset_x, mask_offset_y);
         g_object_unref (pattern_buffer);
       }
       break;
     }
 
-  apply_opacity = gimp_gegl_create_apply_opacity_node (mask_buffer,
-                                                       -mask_offset_x,
-                                                       -mask_offset_y,
-                                                       1.0);
-
-  gimp_apply_operation (buffer, NULL, NULL,
-                        apply_opacity,
-                        buffer, NULL);
-
-  g_object_unref (apply_opacity);
   g_object_unref (mask);
 
   /*  Apply it to the image  */
@@ -15,30 +15,199 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-#if 0
+/*  Foreground extraction after the SIOX algorithm (Simple Interactive
+ *  Object Extraction, http://www.siox.org/): the known foreground and
+ *  background pixels of a trimap are clustered into color signatures
+ *  in CIE Lab space, and each unknown pixel goes to the side of the
+ *  nearest cluster.
+ *
+ *  The state keeps the working area's Lab pixels and each unknown
+ *  pixel's distance to the nearest cluster of either signature, so a
+ *  refinement that only marks more pixels as known clusters just the
+ *  new samples and measures the unknown pixels against the new
+ *  clusters only.
+ */
 
 #include "config.h"
 
+#include <string.h>
+
 #include <gegl.h>
 
 #include "libgimpbase/gimpbase.h"
 
 #include "core-types.h"
 
-#include "base/siox.h"
-#include "base/tile-manager.h"
-
-#include "gegl/gimp-gegl-utils.h"
+#include "config/gimpcoreconfig.h"
 
+#include "gimp.h"
 #include "gimpchannel.h"
 #include "gimpdrawable.h"
 #include "gimpdrawable-foreground-extract.h"
+#include "gimperror.h"
 #include "gimpimage.h"
 #include "gimpprogress.h"
 
 #include "gimp-intl.h"
 
 
+/*  the rows of the working area one worker processes at a time  */
+#define SIOX_BAND_HEIGHT          64
+
+/*  clusters standing for less than this fraction of all samples a
+ *  signature was built from are dropped from it
+ */
+#define SIOX_MIN_CLUSTER_FRACTION 0.001
+
+/*  the intermediate alpha value of blobs being measured  */
+#define SIOX_BLOB_MARK            1
+
+#define SIOX_IS_KNOWN(v)          ((v) == 0 || (v) == 255)
+
+
+typedef enum
+{
+  SIOX_PASS_CONVERT,   /*  convert the drawable's pixels to CIE Lab  */
+  SIOX_PASS_CLUSTER,   /*  cluster the samples of the known pixels   */
+  SIOX_PASS_CLASSIFY   /*  classify the unknown pixels               */
+} SioxPass;
+
+typedef struct _SioxCluster SioxCluster;
+typedef struct _SioxNode    SioxNode;
+typedef struct _SioxBand    SioxBand;
+typedef struct _SioxRender  SioxRender;
+typedef struct _SioxBlob    SioxBlob;
+
+struct _SioxCluster
+{
+  gfloat  lab[3];
+  gfloat  weight;     /*  the number of samples the cluster stands for  */
+};
+
+struct _SioxNode
+{
+  gint    start;
+  gint    end;
+  gint    dim;
+  gint    n_small;    /*  the dimensions in a row that were small enough  */
+};
+
+struct _SioxBand
+{
+  gint    y;
+  gint    height;
+
+  /*  the first clustering stage's result for the band's samples  */
+  GArray *fg_clusters;
+  GArray *bg_clusters;
+};
+
+struct _SioxState
+{
+  /*  the working area, in image coordinates  */
+  gint      x;
+  gint      y;
+  gint      width;
+  gint      height;
+
+  gint      n_threads;
+  SioxBand *bands;
+  gint      n_bands;
+
+  gfloat   *lab;
+  guchar   *trimap;       /*  the trimap of the last run                 */
+  gfloat   *fg_dist;      /*  the squared distance of the last run's     */
+  gfloat   *bg_dist;      /*  unknown pixels to the nearest cluster      */
+  gboolean  valid;        /*  whether there was a last run at all        */
+
+  GArray   *fg_signature;
+  GArray   *bg_signature;
+  gdouble   fg_n_samples; /*  the number of samples the signatures were  */
+  gdouble   bg_n_samples; /*  built from, including the dropped ones     */
+  gdouble   sensitivity[3];
+};
+
+struct _SioxRender
+{
+  SioxState         *state;
+  SioxPass           pass;
+
+  /*  SIOX_PASS_CONVERT  */
+  const guchar      *src;
+  gint               src_bpp;
+  const Babl        *fish;
+
+  /*  SIOX_PASS_CLUSTER and SIOX_PASS_CLASSIFY  */
+  const guchar      *trimap;
+  gboolean           full;
+  gfloat             limits[3];
+  const SioxCluster *fg;      /*  the clusters to measure against,  */
+  gint               n_fg;    /*  only the new ones unless full     */
+  const SioxCluster *bg;
+  gint               n_bg;
+  guchar            *alpha;
+
+  GMutex             mutex;
+  GCond              cond;
+  gint               n_done;
+};
+
+struct _SioxBlob
+{
+  gint      seed;
+  gint      size;
+  gboolean  known;
+};
+
+
+static void    siox_run              (SioxRender        *render,
+                                      GimpProgress      *progress,
+                                      gdouble            start,
+                                      gdouble            end);
+static void    siox_band             (SioxBand          *band,
+                                      SioxRender        *render);
+static void    siox_band_convert     (SioxBand          *band,
+                                      SioxRender        *render);
+static void    siox_band_cluster     (SioxBand          *band,
+                                      SioxRender        *render);
+static void    siox_band_classify    (SioxBand          *band,
+                                      SioxRender        *render);
+
+static void    siox_cluster          (SioxCluster       *points,
+                                      gint               n_points,
+                                      const gfloat       limits[3],
+                                      GArray            *clusters);
+static gint    siox_update_signature (SioxState         *state,
+                                      GArray            *signature,
+                                      gdouble           *n_samples,
+                                      gboolean           foreground,
+                                      gboolean           full,
+                                      const gfloat       limits[3]);
+static gfloat  siox_nearest          (const gfloat      *lab,
+                                      const SioxCluster *clusters,
+                                      gint               n_clusters,
+                                      gfloat             dist);
+
+static void    siox_smooth           (guchar            *alpha,
+                                      const guchar      *trimap,
+                                      gint               width,
+                                      gint               height);
+static void    siox_filter_blobs     (guchar            *alpha,
+                                      const guchar      *trimap,
+                                      gint               width,
+                                      gint               height,
+                                      gboolean           multiblob);
+static gint    siox_flood            (guchar            *alpha,
+                                      const guchar      *trimap,
+                                      gint               width,
+                                      gint               height,
+                                      gint               seed,
+                                      guchar             from,
+                                      guchar             to,
+                                      GArray            *stack,
+                                      gboolean          *known);
+
+
 /*  public functions  */
 
 void
@@ -59,7 +228,8 @@ gimp_drawable_foreground_extract (GimpDrawable              *drawable,
     gimp_drawable_foreground_extract_siox_init (drawable,
                                                 0, 0,
                                                 gimp_item_get_width  (GIMP_ITEM (mask)),
-                                                gimp_item_get_height (GIMP_ITEM (mask)));
+                                                gimp_item_get_height (GIMP_ITEM (mask)),
+                                                NULL);
 
   if (state)
     {
@@ -79,19 +249,25 @@ gimp_drawable_foreground_extract_siox_init (GimpDrawable *drawable,
                                             gint          x,
                                             gint          y,
                                             gint          width,
-                                            gint          height)
+                                            gint          height,
+                                            GError      **error)
 {
-  GeglBuffer   *buffer;
-  const guchar *colormap = NULL;
-  gboolean      intersect;
-  gint          offset_x;
-  gint          offset_y;
+  SioxState  *state;
+  SioxRender  render = { 0, };
+  GimpImage  *image;
+  const Babl *format;
+  guchar     *src;
+  gboolean    intersect;
+  gint        offset_x;
+  gint        offset_y;
+  gsize       n_pixels;
+  gint        i;
 
   g_return_val_if_fail (GIMP_IS_DRAWABLE (drawable), NULL);
   g_return_val_if_fail (gimp_item_is_attached (GIMP_ITEM (drawable)), NULL);
+  g_return_val_if_fail (error == NULL || *error == NULL, NULL);
 
-  if (gimp_drawable_is_indexed (drawable))
-    colormap = gimp_drawable_get_colormap (drawable);
+  image = gimp_item_get_image (GIMP_ITEM (drawable));
 
   gimp_item_get_offset (GIMP_ITEM (drawable), &offset_x, &offset_y);
 
@@ -101,19 +277,77 @@ gimp_drawable_foreground_extract_siox_init (GimpDrawable *drawable,
                                         x, y, width, height,
                                         &x, &y, &width, &height);
 
+  if (! intersect)
+    {
+      g_set_error_literal (error, GIMP_ERROR, GIMP_FAILED,
+                           _("The area to extract the foreground from "
+                             "does not overlap the layer."));
+      return NULL;
+    }
 
-  /* FIXME:
-   * Clear the mask outside the rectangle that we are working on?
-   */
+  format   = gimp_drawable_get_format (drawable);
+  n_pixels = (gsize) width * height;
 
-  if (! intersect)
-    return NULL;
+  state = g_slice_new0 (SioxState);
+
+  state->x      = x;
+  state->y      = y;
+  state->width  = width;
+  state->height = height;
+
+  state->n_threads = GIMP_GEGL_CONFIG (image->gimp->config)->num_processors;
+  state->n_bands   = (height + SIOX_BAND_HEIGHT - 1) / SIOX_BAND_HEIGHT;
+  state->bands     = g_new0 (SioxBand, state->n_bands);
+
+  for (i = 0; i < state->n_bands; i++)
+    {
+      SioxBand *band = &state->bands[i];
+
+      band->y           = i * SIOX_BAND_HEIGHT;
+      band->height      = MIN (SIOX_BAND_HEIGHT, height - band->y);
+      band->fg_clusters = g_array_new (FALSE, FALSE, sizeof (SioxCluster));
+      band->bg_clusters = g_array_new (FALSE, FALSE, sizeof (SioxCluster));
+    }
+
+  state->fg_signature = g_array_new (FALSE, FALSE, sizeof (SioxCluster));
+  state->bg_signature = g_array_new (FALSE, FALSE, sizeof (SioxCluster));
+
+  /*  the area may well be several megapixels, fail gracefully  */
+  state->lab     = g_try_new (gfloat, 3 * n_pixels);
+  state->trimap  = g_try_new (guchar, n_pixels);
+  state->fg_dist = g_try_new (gfloat, n_pixels);
+  state->bg_dist = g_try_new (gfloat, n_pixels);
+
+  src = g_try_malloc (n_pixels * babl_format_get_bytes_per_pixel (format));
 
-  buffer = gimp_drawable_get_buffer (drawable);
+  if (! state->lab || ! state->trimap || ! state->fg_dist || ! state->bg_dist ||
+      ! src)
+    {
+      g_free (src);
+      gimp_drawable_foreground_extract_siox_done (state);
+
+      g_set_error_literal (error, GIMP_ERROR, GIMP_FAILED,
+                           _("There is not enough memory to extract the "
+                             "foreground from this area."));
+      return NULL;
+    }
+
+  gegl_buffer_get (gimp_drawable_get_buffer (drawable),
+                   GEGL_RECTANGLE (x - offset_x, y - offset_y, width, height),
+                   1.0, format, src,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
 
-  return siox_init (gimp_gegl_buffer_get_tiles (buffer), colormap,
-                    offset_x, offset_y,
-                    x, y, width, height);
+  render.state   = state;
+  render.pass    = SIOX_PASS_CONVERT;
+  render.src     = src;
+  render.src_bpp = babl_format_get_bytes_per_pixel (format);
+  render.fish    = babl_fish (format, babl_format ("CIE Lab float"));
+
+  siox_run (&render, NULL, 0.0, 1.0);
+
+  g_free (src);
+
+  return state;
 }
 
 void
@@ -125,53 +359,739 @@ gimp_drawable_foreground_extract_siox (GimpDrawable       *mask,
                                        gboolean            multiblob,
                                        GimpProgress       *progress)
 {
-  GeglBuffer *buffer;
-  gint        x1, y1;
-  gint        x2, y2;
+  SioxRender     render  = { 0, };
+  GeglRectangle  rect;
+  guchar        *trimap;
+  guchar        *alpha;
+  gboolean       changed = FALSE;
+  gint           n_pixels;
+  gint           i;
 
   g_return_if_fail (GIMP_IS_DRAWABLE (mask));
-  g_return_if_fail (babl_format_get_bytes_per_pixel (gimp_drawable_get_format (mask)) == 1);
-
   g_return_if_fail (state != NULL);
-
+  g_return_if_fail (sensitivity != NULL);
   g_return_if_fail (progress == NULL || GIMP_IS_PROGRESS (progress));
 
+  gegl_rectangle_set (&rect, state->x, state->y, state->width, state->height);
+
+  n_pixels = state->width * state->height;
+
+  /*  as large as the state's arrays, fail gracefully too, and leave
+   *  the mask and the state alone
+   */
+  trimap = g_try_new (guchar, n_pixels);
+  alpha  = g_try_new (guchar, n_pixels);
+
+  if (! trimap || ! alpha)
+    {
+      g_free (trimap);
+      g_free (alpha);
+
+      return;
+    }
+
   if (progress)
     gimp_progress_start (progress, _("Foreground Extraction"), FALSE);
 
-  if (GIMP_IS_CHANNEL (mask))
+  gegl_buffer_get (gimp_drawable_get_buffer (mask), &rect, 1.0,
+                   babl_format ("Y u8"), trimap,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  render.state  = state;
+  render.trimap = trimap;
+  render.alpha  = alpha;
+
+  for (i = 0; i < 3; i++)
+    render.limits[i] = sensitivity[i];
+
+  /*  SIOX_REFINEMENT_RECALCULATE includes the sensitivity bit  */
+  render.full = (! state->valid ||
+                 (refinement & SIOX_REFINEMENT_CHANGE_SENSITIVITY) ||
+                 memcmp (sensitivity, state->sensitivity,
+                         sizeof (state->sensitivity)));
+
+  /*  the signatures and distances only carry over as long as no known
+   *  pixel was taken back or changed sides
+   */
+  for (i = 0; i < n_pixels && ! render.full; i++)
     {
-      gimp_channel_bounds (GIMP_CHANNEL (mask), &x1, &y1, &x2, &y2);
+      if (trimap[i] != state->trimap[i])
+        {
+          changed = TRUE;
+
+          if (SIOX_IS_KNOWN (state->trimap[i]))
+            render.full = TRUE;
+        }
     }
-  else
+
+  if (render.full || changed)
     {
-      x1 = 0;
-      y1 = 0;
-      x2 = gimp_item_get_width  (GIMP_ITEM (mask));
-      y2 = gimp_item_get_height (GIMP_ITEM (mask));
+      gint fg_first;
+      gint bg_first;
+
+      render.pass = SIOX_PASS_CLUSTER;
+
+      siox_run (&render, progress, 0.0, 0.5);
+
+      fg_first = siox_update_signature (state, state->fg_signature,
+                                        &state->fg_n_samples,
+                                        TRUE, render.full, render.limits);
+      bg_first = siox_update_signature (state, state->bg_signature,
+                                        &state->bg_n_samples,
+                                        FALSE, render.full, render.limits);
+
+      render.fg   = ((SioxCluster *) state->fg_signature->data) + fg_first;
+      render.n_fg = state->fg_signature->len - fg_first;
+      render.bg   = ((SioxCluster *) state->bg_signature->data) + bg_first;
+      render.n_bg = state->bg_signature->len - bg_first;
     }
 
-  buffer = gimp_drawable_get_buffer (mask);
+  render.pass = SIOX_PASS_CLASSIFY;
+
+  siox_run (&render, progress, 0.5, 1.0);
+
+  g_free (state->trimap);
+  state->trimap = trimap;
+  state->valid  = TRUE;
+
+  memcpy (state->sensitivity, sensitivity, sizeof (state->sensitivity));
 
-  siox_foreground_extract (state, refinement,
-                           gimp_gegl_buffer_get_tiles (buffer),
-                           x1, y1, x2, y2,
-                           smoothness, sensitivity, multiblob,
-                           (SioxProgressFunc) gimp_progress_set_value,
-                           progress);
+  for (i = 0; i < smoothness; i++)
+    siox_smooth (alpha, trimap, state->width, state->height);
+
+  for (i = 0; i < n_pixels; i++)
+    alpha[i] = (alpha[i] >= 128) ? 255 : 0;
+
+  siox_filter_blobs (alpha, trimap, state->width, state->height, multiblob);
+
+  gegl_buffer_set (gimp_drawable_get_buffer (mask), &rect, 0,
+                   babl_format ("Y u8"), alpha, GEGL_AUTO_ROWSTRIDE);
+
+  g_free (alpha);
+
+  if (GIMP_IS_CHANNEL (mask))
+    GIMP_CHANNEL (mask)->bounds_known = FALSE;
 
   if (progress)
     gimp_progress_end (progress);
 
-  gimp_drawable_update (mask, x1, y1, x2, y2);
+  gimp_drawable_update (mask, rect.x, rect.y, rect.width, rect.height);
 }
 
 void
 gimp_drawable_foreground_extract_siox_done (SioxState *state)
 {
+  gint i;
+
   g_return_if_fail (state != NULL);
 
-  siox_done (state);
+  for (i = 0; i < state->n_bands; i++)
+    {
+      g_array_free (state->bands[i].fg_clusters, TRUE);
+      g_array_free (state->bands[i].bg_clusters, TRUE);
+    }
+
+  g_free (state->bands);
+
+  g_array_free (state->fg_signature, TRUE);
+  g_array_free (state->bg_signature, TRUE);
+
+  g_free (state->lab);
+  g_free (state->trimap);
+  g_free (state->fg_dist);
+  g_free (state->bg_dist);
+
+  g_slice_free (SioxState, state);
 }
 
-#endif
+
+/*  private functions  */
+
+/*  runs @render's pass over all bands, in parallel if there is more
+ *  than one thread to use
+ */
+static void
+siox_run (SioxRender   *render,
+          GimpProgress *progress,
+          gdouble       start,
+          gdouble       end)
+{
+  SioxState *state = render->state;
+  gint       i;
+
+  render->n_done = 0;
+
+  g_mutex_init (&render->mutex);
+  g_cond_init (&render->cond);
+
+  if (state->n_threads > 1 && state->n_bands > 1)
+    {
+      GThreadPool *pool;
+
+      pool = g_thread_pool_new ((GFunc) siox_band, render,
+                                MIN (state->n_threads, state->n_bands),
+                                TRUE, NULL);
+
+      for (i = 0; i < state->n_bands; i++)
+        g_thread_pool_push (pool, &state->bands[i], NULL);
+
+      g_mutex_lock (&render->mutex);
+
+      while (render->n_done < state->n_bands)
+        {
+          gint64 end_time = g_get_monotonic_time () + 100 * G_TIME_SPAN_MILLISECOND;
+
+          g_cond_wait_until (&render->cond, &render->mutex, end_time);
+
+          if (progress)
+            {
+              gdouble value = (start + (end - start) *
+                               render->n_done / state->n_bands);
+
+              /*  the progress may run the main loop, don't block the
+               *  workers meanwhile
+               */
+              g_mutex_unlock (&render->mutex);
+              gimp_progress_set_value (progress, value);
+              g_mutex_lock (&render->mutex);
+            }
+        }
+
+      g_mutex_unlock (&render->mutex);
+
+      g_thread_pool_free (pool, FALSE, TRUE);
+    }
+  else
+    {
+      for (i = 0; i < state->n_bands; i++)
+        {
+          siox_band (&state->bands[i], render);
+
+          if (progress)
+            gimp_progress_set_value (progress,
+                                     start + (end - start) *
+                                     (i + 1) / state->n_bands);
+        }
+    }
+
+  g_mutex_clear (&render->mutex);
+  g_cond_clear (&render->cond);
+}
+
+/*  runs in a worker thread; the bands only write their own rows  */
+static void
+siox_band (SioxBand   *band,
+           SioxRender *render)
+{
+  switch (render->pass)
+    {
+    case SIOX_PASS_CONVERT:
+      siox_band_convert (band, render);
+      break;
+
+    case SIOX_PASS_CLUSTER:
+      siox_band_cluster (band, render);
+      break;
+
+    case SIOX_PASS_CLASSIFY:
+      siox_band_classify (band, render);
+      break;
+    }
+
+  g_mutex_lock (&render->mutex);
+
+  render->n_done++;
+  g_cond_signal (&render->cond);
+
+  g_mutex_unlock (&render->mutex);
+}
+
+static void
+siox_band_convert (SioxBand   *band,
+                   SioxRender *render)
+{
+  SioxState *state  = render->state;
+  gsize      offset = (gsize) band->y * state->width;
+
+  babl_process (render->fish,
+                render->src + offset * render->src_bpp,
+                state->lab + offset * 3,
+                band->height * state->width);
+}
+
+/*  clusters the band's known pixels, or on an incremental run only
+ *  the ones that were unknown the last time
+ */
+static void
+siox_band_cluster (SioxBand   *band,
+                   SioxRender *render)
+{
+  SioxState    *state      = render->state;
+  gsize         offset     = (gsize) band->y * state->width;
+  gint          n_pixels   = band->height * state->width;
+  const gfloat *lab        = state->lab + offset * 3;
+  const guchar *trimap     = render->trimap + offset;
+  const guchar *last       = state->trimap + offset;
+  GArray       *fg_samples = g_array_new (FALSE, FALSE, sizeof (SioxCluster));
+  GArray       *bg_samples = g_array_new (FALSE, FALSE, sizeof (SioxCluster));
+  gint          i;
+
+  for (i = 0; i < n_pixels; i++, lab += 3)
+    {
+      SioxCluster sample;
+
+      if (! SIOX_IS_KNOWN (trimap[i]))
+        continue;
+
+      if (! render->full && SIOX_IS_KNOWN (last[i]))
+        continue;
+
+      sample.lab[0] = lab[0];
+      sample.lab[1] = lab[1];
+      sample.lab[2] = lab[2];
+      sample.weight = 1.0;
+
+      g_array_append_val (trimap[i] ? fg_samples : bg_samples, sample);
+    }
+
+  g_array_set_size (band->fg_clusters, 0);
+  g_array_set_size (band->bg_clusters, 0);
+
+  siox_cluster ((SioxCluster *) fg_samples->data, fg_samples->len,
+                render->limits, band->fg_clusters);
+  siox_cluster ((SioxCluster *) bg_samples->data, bg_samples->len,
+                render->limits, band->bg_clusters);
+
+  g_array_free (fg_samples, TRUE);
+  g_array_free (bg_samples, TRUE);
+}
+
+static void
+siox_band_classify (SioxBand   *band,
+                    SioxRender *render)
+{
+  SioxState    *state    = render->state;
+  gsize         offset   = (gsize) band->y * state->width;
+  gint          n_pixels = band->height * state->width;
+  const gfloat *lab      = state->lab + offset * 3;
+  const guchar *trimap   = render->trimap + offset;
+  gfloat       *fg_dist  = state->fg_dist + offset;
+  gfloat       *bg_dist  = state->bg_dist + offset;
+  guchar       *alpha    = render->alpha + offset;
+  gint          prev     = -1;
+  gint          i;
+
+  for (i = 0; i < n_pixels; i++, lab += 3)
+    {
+      if (SIOX_IS_KNOWN (trimap[i]))
+        {
+          alpha[i] = trimap[i];
+          continue;
+        }
+
+      /*  equal colors always end up with equal distances, which saves
+       *  the search on flat areas
+       */
+      if (prev >= 0 && ! memcmp (lab, lab - 3 * (i - prev), 3 * sizeof (gfloat)))
+        {
+          fg_dist[i] = fg_dist[prev];
+          bg_dist[i] = bg_dist[prev];
+        }
+      else
+        {
+          if (render->full)
+            {
+              fg_dist[i] = G_MAXFLOAT;
+              bg_dist[i] = G_MAXFLOAT;
+            }
+
+          fg_dist[i] = siox_nearest (lab, render->fg, render->n_fg, fg_dist[i]);
+          bg_dist[i] = siox_nearest (lab, render->bg, render->n_bg, bg_dist[i]);
+        }
+
+      alpha[i] = (fg_dist[i] < bg_dist[i]) ? 255 : 0;
+
+      prev = i;
+    }
+}
+
+/*  splits @points at the middle of their extent, cycling through the
+ *  dimensions, until they are within @limits in all of them, and
+ *  appends the weighted mean of each leaf to @clusters; reorders
+ *  @points
+ */
+static void
+siox_cluster (SioxCluster  *points,
+              gint          n_points,
+              const gfloat  limits[3],
+              GArray       *clusters)
+{
+  GArray   *stack;
+  SioxNode  node = { 0, n_points, 0, 0 };
+
+  if (n_points == 0)
+    return;
+
+  stack = g_array_new (FALSE, FALSE, sizeof (SioxNode));
+
+  g_array_append_val (stack, node);
+
+  while (stack->len > 0)
+    {
+      gfloat min;
+      gfloat max;
+      gint   i;
+
+      node = g_array_index (stack, SioxNode, stack->len - 1);
+      g_array_set_size (stack, stack->len - 1);
+
+      min = max = points[node.start].lab[node.dim];
+
+      for (i = node.start + 1; i < node.end; i++)
+        {
+          gfloat value = points[i].lab[node.dim];
+
+          if (value < min)
+            min = value;
+          else if (value > max)
+            max = value;
+        }
+
+      if (max - min > limits[node.dim])
+        {
+          gfloat pivot = (min + max) / 2.0;
+          gint   lo    = node.start;
+          gint   hi    = node.end - 1;
+
+          while (lo <= hi)
+            {
+              if (points[lo].lab[node.dim] <= pivot)
+                {
+                  lo++;
+                }
+              else
+                {
+                  SioxCluster tmp = points[lo];
+
+                  points[lo] = points[hi];
+                  points[hi] = tmp;
+
+                  hi--;
+                }
+            }
+
+          /*  the pivot can round to an end when the extent is tiny  */
+          if (lo > node.start && lo < node.end)
+            {
+              SioxNode lower = { node.start, lo,       (node.dim + 1) % 3, 0 };
+              SioxNode upper = { lo,         node.end, (node.dim + 1) % 3, 0 };
+
+              g_array_append_val (stack, lower);
+              g_array_append_val (stack, upper);
+
+              continue;
+            }
+        }
+
+      if (++node.n_small < 3)
+        {
+          node.dim = (node.dim + 1) % 3;
+
+          g_array_append_val (stack, node);
+        }
+      else
+        {
+          SioxCluster cluster = { { 0.0, 0.0, 0.0 }, 0.0 };
+          gdouble     sum[3]  = { 0.0, 0.0, 0.0 };
+          gdouble     weight  = 0.0;
+
+          for (i = node.start; i < node.end; i++)
+            {
+              sum[0] += points[i].lab[0] * points[i].weight;
+              sum[1] += points[i].lab[1] * points[i].weight;
+              sum[2] += points[i].lab[2] * points[i].weight;
+              weight += points[i].weight;
+            }
+
+          cluster.lab[0] = sum[0] / weight;
+          cluster.lab[1] = sum[1] / weight;
+          cluster.lab[2] = sum[2] / weight;
+          cluster.weight = weight;
+
+          g_array_append_val (clusters, cluster);
+        }
+    }
+
+  g_array_free (stack, TRUE);
+}
+
+/*  clusters the bands' clusters once more, with twice the limits, and
+ *  replaces @signature with the result, or appends it; returns the
+ *  index of the first new cluster
+ *
+ *  Appending makes an incremental run an approximation of a full one:
+ *  the new samples are only clustered among themselves, and the
+ *  clusters kept from earlier runs are not dropped again once
+ *  @n_samples grew.  The new clusters are dropped by the same fraction
+ *  of all samples, @n_samples, as on a full run, so a refining
+ *  stroke's colors are weighed against the whole signature and not
+ *  only against each other.
+ */
+static gint
+siox_update_signature (SioxState    *state,
+                       GArray       *signature,
+                       gdouble      *n_samples,
+                       gboolean      foreground,
+                       gboolean      full,
+                       const gfloat  limits[3])
+{
+  GArray *points;
+  gfloat  stage_limits[3];
+  gdouble total = 0.0;
+  gfloat  max   = 0.0;
+  gfloat  min_weight;
+  gint    first;
+  gint    i, j;
+
+  points = g_array_new (FALSE, FALSE, sizeof (SioxCluster));
+
+  for (i = 0; i < state->n_bands; i++)
+    {
+      GArray *clusters = (foreground ?
+                          state->bands[i].fg_clusters :
+                          state->bands[i].bg_clusters);
+
+      g_array_append_vals (points, clusters->data, clusters->len);
+    }
+
+  if (full)
+    {
+      g_array_set_size (signature, 0);
+
+      *n_samples = 0.0;
+    }
+
+  first = signature->len;
+
+  for (i = 0; i < 3; i++)
+    stage_limits[i] = 2.0 * limits[i];
+
+  siox_cluster ((SioxCluster *) points->data, points->len,
+                stage_limits, signature);
+
+  g_array_free (points, TRUE);
+
+  /*  drop the clusters of stray samples, but keep the largest  */
+  for (i = first; i < signature->len; i++)
+    {
+      gfloat weight = g_array_index (signature, SioxCluster, i).weight;
+
+      total += weight;
+      max    = MAX (max, weight);
+    }
+
+  *n_samples += total;
+
+  min_weight = MIN (max, *n_samples * SIOX_MIN_CLUSTER_FRACTION);
+
+  for (i = j = first; i < signature->len; i++)
+    {
+      SioxCluster *cluster = &g_array_index (signature, SioxCluster, i);
+
+      if (cluster->weight >= min_weight)
+        g_array_index (signature, SioxCluster, j++) = *cluster;
+    }
+
+  g_array_set_size (signature, j);
+
+  return first;
+}
+
+/*  returns the smaller one of @dist and the squared distance of @lab
+ *  to the nearest one of @clusters
+ */
+static gfloat
+siox_nearest (const gfloat      *lab,
+              const SioxCluster *clusters,
+              gint               n_clusters,
+              gfloat             dist)
+{
+  gint i;
+
+  for (i = 0; i < n_clusters; i++)
+    {
+      gfloat dl = lab[0] - clusters[i].lab[0];
+      gfloat da = lab[1] - clusters[i].lab[1];
+      gfloat db = lab[2] - clusters[i].lab[2];
+      gfloat d  = dl * dl + da * da + db * db;
+
+      if (d < dist)
+        dist = d;
+    }
+
+  return dist;
+}
+
+/*  a 3x3 box blur that leaves the known pixels alone; keeps the
+ *  horizontal sums of three rows around so it can work in place
+ */
+static void
+siox_smooth (guchar       *alpha,
+             const guchar *trimap,
+             gint          width,
+             gint          height)
+{
+  gushort *sums = g_new (gushort, 3 * width);
+  gint     y;
+
+  for (y = 0; y <= height; y++)
+    {
+      if (y < height)
+        {
+          const guchar *src = alpha + (gsize) y * width;
+          gushort      *sum = sums + (y % 3) * width;
+          gint          x;
+
+          for (x = 0; x < width; x++)
+            sum[x] = (src[MAX (x - 1, 0)] +
+                      src[x] +
+                      src[MIN (x + 1, width - 1)]);
+        }
+
+      if (y > 0)
+        {
+          gint           row   = y - 1;
+          const gushort *above = sums + (MAX (row - 1, 0) % 3) * width;
+          const gushort *sum   = sums + (row % 3) * width;
+          const gushort *below = sums + (MIN (row + 1, height - 1) % 3) * width;
+          guchar        *dest  = alpha  + (gsize) row * width;
+          const guchar  *known = trimap + (gsize) row * width;
+          gint           x;
+
+          for (x = 0; x < width; x++)
+            {
+              if (SIOX_IS_KNOWN (known[x]))
+                dest[x] = known[x];
+              else
+                dest[x] = (above[x] + sum[x] + below[x] + 4) / 9;
+            }
+        }
+    }
+
+  g_free (sums);
+}
+
+/*  keeps the foreground blobs that contain known foreground, the
+ *  largest one, and with @multiblob all that are at least a quarter
+ *  of its size
+ */
+static void
+siox_filter_blobs (guchar       *alpha,
+                   const guchar *trimap,
+                   gint          width,
+                   gint          height,
+                   gboolean      multiblob)
+{
+  GArray *stack    = g_array_new (FALSE, FALSE, sizeof (gint));
+  GArray *blobs    = g_array_new (FALSE, FALSE, sizeof (SioxBlob));
+  gint    n_pixels = width * height;
+  gint    max_size = 0;
+  gint    i;
+
+  for (i = 0; i < n_pixels; i++)
+    {
+      if (alpha[i] == 255)
+        {
+          SioxBlob blob = { i, 0, FALSE };
+
+          blob.size = siox_flood (alpha, trimap, width, height, i,
+                                  255, SIOX_BLOB_MARK, stack, &blob.known);
+
+          max_size = MAX (max_size, blob.size);
+
+          g_array_append_val (blobs, blob);
+        }
+    }
+
+  for (i = 0; i < blobs->len; i++)
+    {
+      SioxBlob *blob = &g_array_index (blobs, SioxBlob, i);
+      gboolean  keep;
+
+      keep = (blob->known              ||
+              blob->size == max_size   ||
+              (multiblob && blob->size >= max_size / 4));
+
+      siox_flood (alpha, NULL, width, height, blob->seed,
+                  SIOX_BLOB_MARK, keep ? 255 : 0, stack, NULL);
+    }
+
+  g_array_free (blobs, TRUE);
+  g_array_free (stack, TRUE);
+}
+
+/*  sets the 4-connected pixels of value @from around @seed to @to and
+ *  returns their number; @known tells if any of them is known
+ *  foreground
+ */
+static gint
+siox_flood (guchar       *alpha,
+            const guchar *trimap,
+            gint          width,
+            gint          height,
+            gint          seed,
+            guchar        from,
+            guchar        to,
+            GArray       *stack,
+            gboolean     *known)
+{
+  gint n_pixels = width * height;
+  gint size     = 0;
+
+  alpha[seed] = to;
+  g_array_append_val (stack, seed);
+
+  while (stack->len > 0)
+    {
+      gint i = g_array_index (stack, gint, stack->len - 1);
+      gint x = i % width;
+      gint j;
+
+      g_array_set_size (stack, stack->len - 1);
+
+      size++;
+
+      if (known && trimap[i] == 255)
+        *known = TRUE;
+
+      if (x > 0 && alpha[i - 1] == from)
+        {
+          j = i - 1;
+          alpha[j] = to;
+          g_array_append_val (stack, j);
+        }
+
+      if (x < width - 1 && alpha[i + 1] == from)
+        {
+          j = i + 1;
+          alpha[j] = to;
+          g_array_append_val (stack, j);
+        }
+
+      if (i >= width && alpha[i - width] == from)
+        {
+          j = i - width;
+          alpha[j] = to;
+          g_array_append_val (stack, j);
+        }
+
+      if (i + width < n_pixels && alpha[i + width] == from)
+        {
+          j = i + width;
+          alpha[j] = to;
+          g_array_append_val (stack, j);
+        }
+    }
+
+  return size;
+}
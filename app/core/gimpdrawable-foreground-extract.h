@@ -15,36 +15,41 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-#if 0
-
 #ifndef  __GIMP_DRAWABLE_FOREGROUND_EXTRACT_H__
 #define  __GIMP_DRAWABLE_FOREGROUND_EXTRACT_H__
 
 
+#define SIOX_DEFAULT_SMOOTHNESS     3
+
+/*  the maximum extent of a color cluster, per CIE Lab component  */
+#define SIOX_DEFAULT_SENSITIVITY_L  0.64
+#define SIOX_DEFAULT_SENSITIVITY_A  1.28
+#define SIOX_DEFAULT_SENSITIVITY_B  2.56
+
+
 /*  general API (as seen from the PDB)  */
 
-void       gimp_drawable_foreground_extract (GimpDrawable              *drawable,
-                                             GimpForegroundExtractMode  mode,
-                                             GimpDrawable              *mask,
-                                             GimpProgress              *progress);
+void        gimp_drawable_foreground_extract           (GimpDrawable              *drawable,
+                                                        GimpForegroundExtractMode  mode,
+                                                        GimpDrawable              *mask,
+                                                        GimpProgress              *progress);
 
 /*  SIOX specific API  */
 
-SioxState * gimp_drawable_foreground_extract_siox_init   (GimpDrawable *drawable,
-                                                          gint          x,
-                                                          gint          y,
-                                                          gint          width,
-                                                          gint          height);
-void        gimp_drawable_foreground_extract_siox  (GimpDrawable       *mask,
-                                                    SioxState          *state,
-                                                    SioxRefinementType  refinemane,
-                                                    gint                smoothness,
-                                                    const gdouble       sensitivity[3],
-                                                    gboolean            multiblob,
-                                                    GimpProgress       *progress);
-void        gimp_drawable_foreground_extract_siox_done (SioxState      *state);
+SioxState * gimp_drawable_foreground_extract_siox_init (GimpDrawable              *drawable,
+                                                        gint                       x,
+                                                        gint                       y,
+                                                        gint                       width,
+                                                        gint                       height,
+                                                        GError                   **error);
+void        gimp_drawable_foreground_extract_siox      (GimpDrawable              *mask,
+                                                        SioxState                 *state,
+                                                        SioxRefinementType         refinement,
+                                                        gint                       smoothness,
+                                                        const gdouble              sensitivity[3],
+                                                        gboolean                   multiblob,
+                                                        GimpProgress              *progress);
+void        gimp_drawable_foreground_extract_siox_done (SioxState                 *state);
 
 
 #endif  /*  __GIMP_DRAWABLE_FOREGROUND_EXTRACT_H__  */
-
-#endif
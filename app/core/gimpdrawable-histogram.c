@@ -27,10 +27,30 @@
 
 #include "gimpchannel.h"
 #include "gimpdrawable-histogram.h"
+#include "gimpdrawable-private.h"
 #include "gimphistogram.h"
 #include "gimpimage.h"
 
 
+/*  the size of the squares the histogram cache is kept for  */
+#define TILE_SIZE 256
+
+
+struct _GimpDrawableHistogramCache
+{
+  const Babl     *format;
+  gint            width;
+  gint            height;
+  gint            n_tiles_x;
+  gint            n_tiles_y;
+  GimpHistogram **tiles;
+};
+
+
+static void   gimp_drawable_calculate_histogram_tiles (GimpDrawable  *drawable,
+                                                       GimpHistogram *histogram);
+
+
 void
 gimp_drawable_calculate_histogram (GimpDrawable  *drawable,
                                    GimpHistogram *histogram)
@@ -113,10 +133,149 @@ gimp_drawable_calculate_histogram (GimpDrawable  *drawable,
         }
       else
         {
-          gimp_histogram_calculate (histogram,
-                                    gimp_drawable_get_buffer (drawable),
-                                    GEGL_RECTANGLE (x, y, width, height),
-                                    NULL, NULL);
+          gimp_drawable_calculate_histogram_tiles (drawable, histogram);
         }
     }
 }
+
+/**
+ * gimp_drawable_invalidate_histogram:
+ * @drawable: a #GimpDrawable
+ * @x:        x coordinate of the changed area
+ * @y:        y coordinate of the changed area
+ * @width:    width of the changed area
+ * @height:   height of the changed area
+ *
+ * Drops the cached histograms of all tiles intersecting the changed
+ * area, they are recalculated the next time the drawable's histogram
+ * is asked for.  Called whenever the drawable is updated.
+ **/
+void
+gimp_drawable_invalidate_histogram (GimpDrawable *drawable,
+                                    gint          x,
+                                    gint          y,
+                                    gint          width,
+                                    gint          height)
+{
+  GimpDrawableHistogramCache *cache;
+  gint                        x1, y1, x2, y2;
+  gint                        tile_x, tile_y;
+
+  g_return_if_fail (GIMP_IS_DRAWABLE (drawable));
+
+  cache = drawable->private->histogram_cache;
+
+  if (! cache || width <= 0 || height <= 0)
+    return;
+
+  x1 = CLAMP (x,          0, cache->width);
+  y1 = CLAMP (y,          0, cache->height);
+  x2 = CLAMP (x + width,  0, cache->width);
+  y2 = CLAMP (y + height, 0, cache->height);
+
+  if (x1 == x2 || y1 == y2)
+    return;
+
+  for (tile_y = y1 / TILE_SIZE; tile_y <= (y2 - 1) / TILE_SIZE; tile_y++)
+    for (tile_x = x1 / TILE_SIZE; tile_x <= (x2 - 1) / TILE_SIZE; tile_x++)
+      {
+        GimpHistogram **tile = &cache->tiles[tile_y * cache->n_tiles_x + tile_x];
+
+        if (*tile)
+          {
+            gimp_histogram_unref (*tile);
+            *tile = NULL;
+          }
+      }
+}
+
+void
+gimp_drawable_free_histogram_cache (GimpDrawable *drawable)
+{
+  GimpDrawableHistogramCache *cache;
+
+  g_return_if_fail (GIMP_IS_DRAWABLE (drawable));
+
+  cache = drawable->private->histogram_cache;
+
+  if (cache)
+    {
+      gint i;
+
+      for (i = 0; i < cache->n_tiles_x * cache->n_tiles_y; i++)
+        if (cache->tiles[i])
+          gimp_histogram_unref (cache->tiles[i]);
+
+      g_free (cache->tiles);
+      g_slice_free (GimpDrawableHistogramCache, cache);
+
+      drawable->private->histogram_cache = NULL;
+    }
+}
+
+
+/*  private functions  */
+
+/*  Without a selection, the histogram is the sum of the histograms of
+ *  all tiles of the drawable.  Tile histograms are kept until the tile
+ *  is touched by an update, so while painting only the few tiles under
+ *  the brush need to be looked at again.
+ */
+static void
+gimp_drawable_calculate_histogram_tiles (GimpDrawable  *drawable,
+                                         GimpHistogram *histogram)
+{
+  GimpDrawableHistogramCache *cache  = drawable->private->histogram_cache;
+  GeglBuffer                 *buffer = gimp_drawable_get_buffer (drawable);
+  gint                        width  = gegl_buffer_get_width  (buffer);
+  gint                        height = gegl_buffer_get_height (buffer);
+  gint                        tile_x, tile_y;
+
+  if (cache &&
+      (cache->format != gegl_buffer_get_format (buffer) ||
+       cache->width  != width                           ||
+       cache->height != height))
+    {
+      gimp_drawable_free_histogram_cache (drawable);
+      cache = NULL;
+    }
+
+  if (! cache)
+    {
+      cache = g_slice_new (GimpDrawableHistogramCache);
+
+      cache->format    = gegl_buffer_get_format (buffer);
+      cache->width     = width;
+      cache->height    = height;
+      cache->n_tiles_x = (width  + TILE_SIZE - 1) / TILE_SIZE;
+      cache->n_tiles_y = (height + TILE_SIZE - 1) / TILE_SIZE;
+      cache->tiles     = g_new0 (GimpHistogram *,
+                                 cache->n_tiles_x * cache->n_tiles_y);
+
+      drawable->private->histogram_cache = cache;
+    }
+
+  gimp_histogram_clear_values (histogram);
+
+  for (tile_y = 0; tile_y < cache->n_tiles_y; tile_y++)
+    for (tile_x = 0; tile_x < cache->n_tiles_x; tile_x++)
+      {
+        GimpHistogram **tile = &cache->tiles[tile_y * cache->n_tiles_x + tile_x];
+
+        if (! *tile)
+          {
+            gint x = tile_x * TILE_SIZE;
+            gint y = tile_y * TILE_SIZE;
+
+            *tile = gimp_histogram_new ();
+
+            gimp_histogram_calculate (*tile, buffer,
+                                      GEGL_RECTANGLE (x, y,
+                                                      MIN (TILE_SIZE, width  - x),
+                                                      MIN (TILE_SIZE, height - y)),
+                                      NULL, NULL);
+          }
+
+        gimp_histogram_add (histogram, *tile);
+      }
+}
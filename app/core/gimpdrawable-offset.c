@@ -50,11 +50,8 @@ gimp_drawable_offset (GimpDrawable   *drawable,
   GimpItem      *item;
   GeglBuffer    *src_buffer;
   GeglBuffer    *new_buffer;
-  GeglRectangle  src_rect;
-  GeglRectangle  dest_rect;
   gint           width, height;
   gint           src_x, src_y;
-  gint           dest_x, dest_y;
 
   g_return_if_fail (GIMP_IS_DRAWABLE (drawable));
   g_return_if_fail (GIMP_IS_CONTEXT (context));
@@ -86,155 +83,79 @@ gimp_drawable_offset (GimpDrawable   *drawable,
 
   src_buffer = gimp_drawable_get_buffer (drawable);
 
-  new_buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, width, height),
-                                gimp_drawable_get_format (drawable));
-
   if (! wrap_around)
     {
+      GeglColor *color = NULL;
+
       if (fill_type == GIMP_OFFSET_BACKGROUND)
         {
-          GimpRGB    bg;
-          GeglColor *color;
+          GimpRGB bg;
 
           gimp_context_get_background (context, &bg);
 
           color = gimp_gegl_color_new (&bg);
-          gegl_buffer_set_color (new_buffer, NULL, color);
-          g_object_unref (color);
         }
-    }
 
-  if (offset_x >= 0)
-    {
-      src_x = 0;
-      dest_x = offset_x;
-      width = CLAMP ((width - offset_x), 0, width);
-    }
-  else
-    {
-      src_x = -offset_x;
-      dest_x = 0;
-      width = CLAMP ((width + offset_x), 0, width);
-    }
+      /*  Without wrap around, offsetting only shifts the tiles  */
+      new_buffer = gimp_gegl_buffer_new_shifted (src_buffer,
+                                                 GEGL_RECTANGLE (-offset_x,
+                                                                 -offset_y,
+                                                                 width, height),
+                                                 color);
 
-  if (offset_y >= 0)
-    {
-      src_y = 0;
-      dest_y = offset_y;
-      height = CLAMP ((height - offset_y), 0, height);
-    }
-  else
-    {
-      src_y = -offset_y;
-      dest_y = 0;
-      height = CLAMP ((height + offset_y), 0, height);
+      if (color)
+        g_object_unref (color);
+
+      gimp_drawable_set_buffer (drawable,
+                                gimp_item_is_attached (item),
+                                C_("undo-type", "Offset Drawable"),
+                                new_buffer);
+      g_object_unref (new_buffer);
+
+      return;
     }
 
+  new_buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, width, height),
+                                gimp_drawable_get_format (drawable));
+
+  /*  With wrap around, the offsets were reduced to 0 <= offset < size
+   *  above, so the part of the drawable which wraps around is always at
+   *  its right and bottom edges
+   */
+  src_x = width  - offset_x;
+  src_y = height - offset_y;
+
   /*  Copy the center region  */
-  if (width && height)
+  gegl_buffer_copy (src_buffer,
+                    GEGL_RECTANGLE (0, 0, src_x, src_y),
+                    new_buffer,
+                    GEGL_RECTANGLE (offset_x, offset_y, 0, 0));
+
+  /*  intersecting region  */
+  if (offset_x != 0 && offset_y != 0)
     {
       gegl_buffer_copy (src_buffer,
-                        GEGL_RECTANGLE (src_x,  src_y,  width, height),
+                        GEGL_RECTANGLE (src_x, src_y, offset_x, offset_y),
                         new_buffer,
-                        GEGL_RECTANGLE (dest_x,dest_y,  width, height));
+                        GEGL_RECTANGLE (0, 0, 0, 0));
     }
 
-  if (wrap_around)
+  /*  X offset  */
+  if (offset_x != 0)
     {
-      /*  Copy appropriately for wrap around  */
-
-      if (offset_x >= 0 && offset_y >= 0)
-        {
-          src_x = gimp_item_get_width  (item) - offset_x;
-          src_y = gimp_item_get_height (item) - offset_y;
-        }
-      else if (offset_x >= 0 && offset_y < 0)
-        {
-          src_x = gimp_item_get_width (item) - offset_x;
-          src_y = 0;
-        }
-      else if (offset_x < 0 && offset_y >= 0)
-        {
-          src_x = 0;
-          src_y = gimp_item_get_height (item) - offset_y;
-        }
-      else if (offset_x < 0 && offset_y < 0)
-        {
-          src_x = 0;
-          src_y = 0;
-        }
-
-      dest_x = (src_x + offset_x) % gimp_item_get_width (item);
-      if (dest_x < 0)
-        dest_x = gimp_item_get_width (item) + dest_x;
-
-      dest_y = (src_y + offset_y) % gimp_item_get_height (item);
-      if (dest_y < 0)
-        dest_y = gimp_item_get_height (item) + dest_y;
-
-      /*  intersecting region  */
-      if (offset_x != 0 && offset_y != 0)
-        {
-          gegl_buffer_copy (src_buffer,
-                            GEGL_RECTANGLE (src_x, src_y,
-                                            ABS (offset_x), ABS (offset_y)),
-                            new_buffer,
-                            GEGL_RECTANGLE (dest_x, dest_y, 0, 0));
-        }
-
-      /*  X offset  */
-      if (offset_x != 0)
-        {
-          if (offset_y >= 0)
-            {
-              src_rect.x      = src_x;
-              src_rect.y      = 0;
-              src_rect.width  = ABS (offset_x);
-              src_rect.height = gimp_item_get_height (item) - ABS (offset_y);
-
-              dest_rect.x = dest_x;
-              dest_rect.y = dest_y + offset_y;
-            }
-          else if (offset_y < 0)
-            {
-              src_rect.x      = src_x;
-              src_rect.y      = src_y - offset_y;
-              src_rect.width  = ABS (offset_x);
-              src_rect.height = gimp_item_get_height (item) - ABS (offset_y);
-
-              dest_rect.x = dest_x;
-              dest_rect.y = 0;
-            }
-
-          gegl_buffer_copy (src_buffer, &src_rect, new_buffer, &dest_rect);
-        }
+      gegl_buffer_copy (src_buffer,
+                        GEGL_RECTANGLE (src_x, 0, offset_x, src_y),
+                        new_buffer,
+                        GEGL_RECTANGLE (0, offset_y, 0, 0));
+    }
 
-      /*  X offset  */
-      if (offset_y != 0)
-        {
-          if (offset_x >= 0)
-            {
-              src_rect.x      = 0;
-              src_rect.y      = src_y;
-              src_rect.width  = gimp_item_get_width (item) - ABS (offset_x);
-              src_rect.height = ABS (offset_y);
-
-              dest_rect.x = dest_x + offset_x;
-              dest_rect.y = dest_y;
-            }
-          else if (offset_x < 0)
-            {
-              src_rect.x      = src_x - offset_x;
-              src_rect.y      = src_y;
-              src_rect.width  = gimp_item_get_width (item) - ABS (offset_x);
-              src_rect.height = ABS (offset_y);
-
-              dest_rect.x = 0;
-              dest_rect.y = dest_y;
-            }
-
-          gegl_buffer_copy (src_buffer, &src_rect, new_buffer, &dest_rect);
-        }
+  /*  Y offset  */
+  if (offset_y != 0)
+    {
+      gegl_buffer_copy (src_buffer,
+                        GEGL_RECTANGLE (0, src_y, src_x, offset_y),
+                        new_buffer,
+                        GEGL_RECTANGLE (offset_x, 0, 0, 0));
     }
 
   gimp_drawable_set_buffer (drawable,
@@ -18,6 +18,8 @@
 #ifndef __GIMP_DRAWABLE_PRIVATE_H__
 #define __GIMP_DRAWABLE_PRIVATE_H__
 
+typedef struct _GimpDrawableHistogramCache GimpDrawableHistogramCache;
+
 struct _GimpDrawablePrivate
 {
   GeglBuffer    *buffer; /* buffer for drawable data */
@@ -32,6 +34,8 @@ struct _GimpDrawablePrivate
   GeglNode      *fs_mode_node;
 
   GeglNode      *mode_node;
+
+  GimpDrawableHistogramCache *histogram_cache; /* per-tile histograms */
 };
 
 #endif /* __GIMP_DRAWABLE_PRIVATE_H__ */
@@ -28,6 +28,7 @@
 #include "core-types.h"
 
 #include "gegl/gimp-babl.h"
+#include "gegl/gimp-gegl-coverage.h"
 #include "gegl/gimp-gegl-nodes.h"
 #include "gegl/gimp-gegl-utils.h"
 
@@ -35,6 +36,7 @@
 #include "gimpchannel.h"
 #include "gimpcontext.h"
 #include "gimpdrawable-combine.h"
+#include "gimpdrawable-histogram.h"
 #include "gimpdrawable-operation.h"
 #include "gimpdrawable-preview.h"
 #include "gimpdrawable-private.h"
@@ -47,6 +49,7 @@
 #include "gimpmarshal.h"
 #include "gimppattern.h"
 #include "gimppickable.h"
+#include "gimppickable-average.h"
 #include "gimpprogress.h"
 
 #include "gimp-log.h"
@@ -155,6 +158,8 @@ static void       gimp_drawable_real_swap_pixels   (GimpDrawable      *drawable,
                                                     gint               x,
                                                     gint               y);
 
+static void       gimp_drawable_track_coverage     (GimpDrawable      *drawable);
+
 static void       gimp_drawable_sync_source_node   (GimpDrawable      *drawable,
                                                     gboolean           detach_fs);
 static void       gimp_drawable_fs_notify          (GimpLayer         *fs,
@@ -285,6 +290,7 @@ gimp_drawable_finalize (GObject *object)
     }
 
   gimp_drawable_free_shadow_buffer (drawable);
+  gimp_drawable_free_histogram_cache (drawable);
 
   if (drawable->private->source_node)
     {
@@ -390,7 +396,9 @@ gimp_drawable_duplicate (GimpItem *item,
         g_object_unref (new_drawable->private->buffer);
 
       new_drawable->private->buffer =
-        gegl_buffer_dup (gimp_drawable_get_buffer (drawable));
+        gimp_gegl_buffer_dup (gimp_drawable_get_buffer (drawable));
+
+      gimp_drawable_track_coverage (new_drawable);
     }
 
   return new_item;
@@ -413,20 +421,11 @@ gimp_drawable_scale (GimpItem              *item,
                                                 new_width, new_height),
                                 gimp_drawable_get_format (drawable));
 
-  scale = g_object_new (GEGL_TYPE_NODE,
-                        "operation", "gegl:scale",
-                        NULL);
-
-  gegl_node_set (scale,
-                 "origin-x",   0.0,
-                 "origin-y",   0.0,
-                 "filter",     gimp_interpolation_to_gegl_filter (interpolation_type),
-                 "hard-edges", TRUE,
-                 "x",          ((gdouble) new_width /
-                                gimp_item_get_width  (item)),
-                 "y",          ((gdouble) new_height /
-                                gimp_item_get_height (item)),
-                 NULL);
+  scale = gimp_gegl_create_scale_node ((gdouble) new_width /
+                                       gimp_item_get_width  (item),
+                                       (gdouble) new_height /
+                                       gimp_item_get_height (item),
+                                       interpolation_type);
 
   gimp_drawable_apply_operation_to_buffer (drawable, progress,
                                            C_("undo-type", "Scale"),
@@ -449,9 +448,9 @@ gimp_drawable_resize (GimpItem    *item,
 {
   GimpDrawable *drawable = GIMP_DRAWABLE (item);
   GeglBuffer   *new_buffer;
+  GeglColor    *fill     = NULL;
   gint          new_offset_x;
   gint          new_offset_y;
-  gint          copy_x, copy_y;
   gint          copy_width, copy_height;
 
   /*  if the size doesn't change, this is a nop  */
@@ -472,46 +471,35 @@ gimp_drawable_resize (GimpItem    *item,
                             new_offset_y,
                             new_width,
                             new_height,
-                            &copy_x,
-                            &copy_y,
+                            NULL,
+                            NULL,
                             &copy_width,
                             &copy_height);
 
-  new_buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0,
-                                                new_width, new_height),
-                                gimp_drawable_get_format (drawable));
-
-  if (copy_width  != new_width ||
-      copy_height != new_height)
+  /*  Fill the new area with the background color if needed,
+   *  otherwise it is transparent already
+   */
+  if ((copy_width  != new_width ||
+       copy_height != new_height) &&
+      ! gimp_drawable_has_alpha (drawable) && ! GIMP_IS_CHANNEL (drawable))
     {
-      /*  Clear the new tiles if needed  */
+      GimpRGB bg;
 
-      GimpRGB    bg;
-      GeglColor *col;
-
-      if (! gimp_drawable_has_alpha (drawable) && ! GIMP_IS_CHANNEL (drawable))
-        gimp_context_get_background (context, &bg);
-      else
-        gimp_rgba_set (&bg, 0.0, 0.0, 0.0, 0.0);
-
-      col = gimp_gegl_color_new (&bg);
+      gimp_context_get_background (context, &bg);
 
-      gegl_buffer_set_color (new_buffer, NULL, col);
-      g_object_unref (col);
+      fill = gimp_gegl_color_new (&bg);
     }
 
-  if (copy_width && copy_height)
-    {
-      /*  Copy the pixels in the intersection  */
-      gegl_buffer_copy (gimp_drawable_get_buffer (drawable),
-                        GEGL_RECTANGLE (copy_x - gimp_item_get_offset_x (item),
-                                        copy_y - gimp_item_get_offset_y (item),
-                                        copy_width,
-                                        copy_height),
-                        new_buffer,
-                        GEGL_RECTANGLE (copy_x - new_offset_x,
-                                        copy_y - new_offset_y, 0, 0));
-    }
+  /*  Don't copy the pixels in the intersection, share their tiles  */
+  new_buffer = gimp_gegl_buffer_new_shifted (gimp_drawable_get_buffer (drawable),
+                                             GEGL_RECTANGLE (-offset_x,
+                                                             -offset_y,
+                                                             new_width,
+                                                             new_height),
+                                             fill);
+
+  if (fill)
+    g_object_unref (fill);
 
   gimp_drawable_set_buffer_full (drawable, gimp_item_is_attached (item), NULL,
                                  new_buffer,
@@ -657,6 +645,15 @@ gimp_drawable_real_update (GimpDrawable *drawable,
         }
     }
 
+  gimp_drawable_invalidate_histogram (drawable, x, y, width, height);
+  gimp_pickable_invalidate_average (GIMP_PICKABLE (drawable),
+                                    x, y, width, height);
+
+  if (drawable->private->buffer)
+    gimp_gegl_buffer_invalidate_coverage (drawable->private->buffer,
+                                          GEGL_RECTANGLE (x, y,
+                                                          width, height));
+
   gimp_viewable_invalidate_preview (GIMP_VIEWABLE (drawable));
 }
 
@@ -736,6 +733,10 @@ gimp_drawable_real_set_buffer (GimpDrawable *drawable,
 
   drawable->private->buffer = buffer;
 
+  gimp_drawable_track_coverage (drawable);
+
+  gimp_drawable_free_histogram_cache (drawable);
+
   gimp_item_set_offset (item, offset_x, offset_y);
   gimp_item_set_size (item,
                       gegl_buffer_get_width  (buffer),
@@ -827,7 +828,7 @@ gimp_drawable_real_swap_pixels (GimpDrawable *drawable,
   gint        width  = gegl_buffer_get_width (buffer);
   gint        height = gegl_buffer_get_height (buffer);
 
-  tmp = gegl_buffer_dup (buffer);
+  tmp = gimp_gegl_buffer_dup (buffer);
 
   gegl_buffer_copy (gimp_drawable_get_buffer (drawable),
                     GEGL_RECTANGLE (x, y, width, height),
@@ -843,6 +844,17 @@ gimp_drawable_real_swap_pixels (GimpDrawable *drawable,
   gimp_drawable_update (drawable, x, y, width, height);
 }
 
+/*  let the layer modes skip what an opaque or empty drawable hides,
+ *  except for drawables whose pixels are rendered on demand, like
+ *  layer groups, where finding out would render them
+ */
+static void
+gimp_drawable_track_coverage (GimpDrawable *drawable)
+{
+  if (! gimp_viewable_get_children (GIMP_VIEWABLE (drawable)))
+    gimp_gegl_buffer_track_coverage (drawable->private->buffer);
+}
+
 static void
 gimp_drawable_sync_source_node (GimpDrawable *drawable,
                                 gboolean      detach_fs)
@@ -1054,6 +1066,8 @@ gimp_drawable_new (GType          type,
                                                                width, height),
                                                format);
 
+  gimp_drawable_track_coverage (drawable);
+
   return drawable;
 }
 
@@ -20,15 +20,31 @@
 
 #include "config.h"
 
+#include <cairo.h>
 #include <gegl.h>
 
 #include "core-types.h"
 
+#include "gegl/gimp-gegl-utils.h"
+#include "gegl/gimptilehandlerprojection.h"
+
 #include "gimpdrawable.h"
 #include "gimpdrawablestack.h"
 #include "gimpmarshal.h"
 
 
+/*  the number of backdrops kept for different sets of drawables  */
+#define N_BACKDROPS 3
+
+/*  a backdrop only pays off with at least two drawables below the top  */
+#define MIN_BACKDROP_CHILDREN 3
+
+/*  the memory all stacks together, including those of group layers,
+ *  may keep in backdrops, counted by the backdrops' full extents
+ */
+#define MAX_BACKDROP_MEMORY ((gint64) 512 << 20)
+
+
 enum
 {
   UPDATE,
@@ -36,6 +52,23 @@ enum
 };
 
 
+typedef struct _GimpDrawableStackBackdrop GimpDrawableStackBackdrop;
+
+/*  the composite of the drawables below the top one, rendered on
+ *  demand into a buffer, so changes to the top drawable, or moving
+ *  another one to the top and back, don't recomposite all of them
+ */
+struct _GimpDrawableStackBackdrop
+{
+  GList           *drawables;  /*  top to bottom, not referenced  */
+  guint            hash;
+  GeglRectangle    extent;
+  GeglBuffer      *buffer;
+  GeglTileHandler *handler;
+  gint64           memsize;
+};
+
+
 /*  local function prototypes  */
 
 static void   gimp_drawable_stack_constructed      (GObject           *object);
@@ -54,6 +87,25 @@ static void   gimp_drawable_stack_add_node         (GimpDrawableStack *stack,
 static void   gimp_drawable_stack_remove_node      (GimpDrawableStack *stack,
                                                     GimpDrawable      *drawable);
 
+static void   gimp_drawable_stack_plug_backdrop    (GimpDrawableStack *stack);
+static void   gimp_drawable_stack_unplug_backdrop  (GimpDrawableStack *stack);
+static void   gimp_drawable_stack_invalidate_backdrops
+                                                   (GimpDrawableStack *stack,
+                                                    GimpDrawable      *drawable,
+                                                    gint               x,
+                                                    gint               y,
+                                                    gint               width,
+                                                    gint               height);
+static void   gimp_drawable_stack_drop_backdrops   (GimpDrawableStack *stack,
+                                                    GimpDrawable      *drawable);
+
+static GimpDrawableStackBackdrop *
+              gimp_drawable_stack_backdrop_new     (GList             *drawables,
+                                                    guint              hash,
+                                                    const GeglRectangle *extent,
+                                                    gint64             memsize);
+static void   gimp_drawable_stack_backdrop_free    (GimpDrawableStackBackdrop *backdrop);
+
 static void   gimp_drawable_stack_update           (GimpDrawableStack *stack,
                                                     gint               x,
                                                     gint               y,
@@ -75,6 +127,8 @@ G_DEFINE_TYPE (GimpDrawableStack, gimp_drawable_stack, GIMP_TYPE_ITEM_STACK)
 
 static guint stack_signals[LAST_SIGNAL] = { 0 };
 
+static gint64 backdrop_memory = 0;
+
 
 static void
 gimp_drawable_stack_class_init (GimpDrawableStackClass *klass)
@@ -132,6 +186,9 @@ gimp_drawable_stack_finalize (GObject *object)
 {
   GimpDrawableStack *stack = GIMP_DRAWABLE_STACK (object);
 
+  stack->backdrop_plugged = FALSE;
+  gimp_drawable_stack_drop_backdrops (stack, NULL);
+
   if (stack->graph)
     {
       g_object_unref (stack->graph);
@@ -147,6 +204,9 @@ gimp_drawable_stack_add (GimpContainer *container,
 {
   GimpDrawableStack *stack = GIMP_DRAWABLE_STACK (container);
 
+  if (stack->graph)
+    gimp_drawable_stack_unplug_backdrop (stack);
+
   GIMP_CONTAINER_CLASS (parent_class)->add (container, object);
 
   if (stack->graph)
@@ -155,6 +215,7 @@ gimp_drawable_stack_add (GimpContainer *container,
                            gimp_item_get_node (GIMP_ITEM (object)));
 
       gimp_drawable_stack_add_node (stack, GIMP_DRAWABLE (object));
+      gimp_drawable_stack_plug_backdrop (stack);
     }
 
   if (gimp_item_get_visible (GIMP_ITEM (object)))
@@ -169,14 +230,22 @@ gimp_drawable_stack_remove (GimpContainer *container,
 
   if (stack->graph)
     {
+      gimp_drawable_stack_unplug_backdrop (stack);
+
       gimp_drawable_stack_remove_node (stack, GIMP_DRAWABLE (object));
 
       gegl_node_remove_child (stack->graph,
                               gimp_item_get_node (GIMP_ITEM (object)));
     }
 
+  /*  the drawable may change while it's not ours  */
+  gimp_drawable_stack_drop_backdrops (stack, GIMP_DRAWABLE (object));
+
   GIMP_CONTAINER_CLASS (parent_class)->remove (container, object);
 
+  if (stack->graph)
+    gimp_drawable_stack_plug_backdrop (stack);
+
   if (gimp_item_get_visible (GIMP_ITEM (object)))
     gimp_drawable_stack_drawable_visible (GIMP_ITEM (object), stack);
 }
@@ -189,12 +258,18 @@ gimp_drawable_stack_reorder (GimpContainer *container,
   GimpDrawableStack *stack = GIMP_DRAWABLE_STACK (container);
 
   if (stack->graph)
-    gimp_drawable_stack_remove_node (stack, GIMP_DRAWABLE (object));
+    {
+      gimp_drawable_stack_unplug_backdrop (stack);
+      gimp_drawable_stack_remove_node (stack, GIMP_DRAWABLE (object));
+    }
 
   GIMP_CONTAINER_CLASS (parent_class)->reorder (container, object, new_index);
 
   if (stack->graph)
-    gimp_drawable_stack_add_node (stack, GIMP_DRAWABLE (object));
+    {
+      gimp_drawable_stack_add_node (stack, GIMP_DRAWABLE (object));
+      gimp_drawable_stack_plug_backdrop (stack);
+    }
 
   if (gimp_item_get_visible (GIMP_ITEM (object)))
     gimp_drawable_stack_drawable_visible (GIMP_ITEM (object), stack);
@@ -261,9 +336,30 @@ gimp_drawable_stack_get_graph (GimpDrawableStack *stack)
     gegl_node_connect_to (previous, "output",
                           output,   "input");
 
+  gimp_drawable_stack_plug_backdrop (stack);
+
   return stack->graph;
 }
 
+/*  the memory used by the tiles of @stack's backdrops rendered so far  */
+gint64
+gimp_drawable_stack_get_backdrop_memsize (GimpDrawableStack *stack)
+{
+  GList  *list;
+  gint64  memsize = 0;
+
+  g_return_val_if_fail (GIMP_IS_DRAWABLE_STACK (stack), 0);
+
+  for (list = stack->backdrops; list; list = g_list_next (list))
+    {
+      GimpDrawableStackBackdrop *backdrop = list->data;
+
+      memsize += gimp_gegl_buffer_get_allocated_memsize (backdrop->buffer);
+    }
+
+  return memsize;
+}
+
 
 /*  private functions  */
 
@@ -355,6 +451,247 @@ gimp_drawable_stack_remove_node (GimpDrawableStack *stack,
     }
 }
 
+static void
+gimp_drawable_stack_plug_backdrop (GimpDrawableStack *stack)
+{
+  GimpDrawableStackBackdrop *backdrop = NULL;
+  GList                     *below;
+  GList                     *list;
+  GeglNode                  *top_node;
+  guint                      hash = 0;
+
+  g_return_if_fail (! stack->backdrop_plugged);
+
+  if (gimp_container_get_n_children (GIMP_CONTAINER (stack)) <
+      MIN_BACKDROP_CHILDREN)
+    return;
+
+  below = g_list_next (GIMP_LIST (stack)->list);
+
+  for (list = below; list; list = g_list_next (list))
+    hash = (hash << 5) - hash + g_direct_hash (list->data);
+
+  for (list = stack->backdrops; list; list = g_list_next (list))
+    {
+      GimpDrawableStackBackdrop *candidate = list->data;
+      GList                     *a;
+      GList                     *b;
+
+      if (candidate->hash != hash)
+        continue;
+
+      for (a = candidate->drawables, b = below;
+           a && b && a->data == b->data;
+           a = g_list_next (a), b = g_list_next (b));
+
+      if (! a && ! b)
+        {
+          backdrop = candidate;
+
+          stack->backdrops = g_list_delete_link (stack->backdrops, list);
+          break;
+        }
+    }
+
+  if (! backdrop)
+    {
+      GeglNode      *node = gimp_item_get_node (GIMP_ITEM (below->data));
+      GeglRectangle  extent;
+      gint64         memsize;
+
+      extent  = gegl_node_get_bounding_box (node);
+      memsize = ((gint64) extent.width * extent.height *
+                 babl_format_get_bytes_per_pixel (babl_format ("RGBA float")));
+
+      /*  make room by dropping this stack's least recently used
+       *  backdrops, and do without one if that is not enough
+       */
+      while (stack->backdrops &&
+             (g_list_length (stack->backdrops) >= N_BACKDROPS ||
+              backdrop_memory + memsize > MAX_BACKDROP_MEMORY))
+        {
+          GList *last = g_list_last (stack->backdrops);
+
+          gimp_drawable_stack_backdrop_free (last->data);
+          stack->backdrops = g_list_delete_link (stack->backdrops, last);
+        }
+
+      if (backdrop_memory + memsize > MAX_BACKDROP_MEMORY)
+        return;
+
+      backdrop = gimp_drawable_stack_backdrop_new (below, hash,
+                                                   &extent, memsize);
+    }
+
+  stack->backdrops = g_list_prepend (stack->backdrops, backdrop);
+
+  if (! stack->backdrop_node)
+    stack->backdrop_node = gegl_node_new_child (stack->graph,
+                                                "operation", "gegl:buffer-source",
+                                                NULL);
+
+  gegl_node_set (stack->backdrop_node,
+                 "buffer", backdrop->buffer,
+                 NULL);
+
+  top_node = gimp_item_get_node (GIMP_ITEM (GIMP_LIST (stack)->list->data));
+
+  gegl_node_connect_to (stack->backdrop_node, "output",
+                        top_node,             "input");
+
+  stack->backdrop_plugged = TRUE;
+}
+
+/*  wires the top drawable straight to the one below again, must be
+ *  called before the stack's children change
+ */
+static void
+gimp_drawable_stack_unplug_backdrop (GimpDrawableStack *stack)
+{
+  if (stack->backdrop_plugged)
+    {
+      GList    *list = GIMP_LIST (stack)->list;
+      GeglNode *top_node;
+      GeglNode *below_node;
+
+      top_node   = gimp_item_get_node (GIMP_ITEM (list->data));
+      below_node = gimp_item_get_node (GIMP_ITEM (list->next->data));
+
+      gegl_node_connect_to (below_node, "output",
+                            top_node,   "input");
+
+      gegl_node_set (stack->backdrop_node,
+                     "buffer", NULL,
+                     NULL);
+
+      stack->backdrop_plugged = FALSE;
+    }
+}
+
+static void
+gimp_drawable_stack_invalidate_backdrops (GimpDrawableStack *stack,
+                                          GimpDrawable      *drawable,
+                                          gint               x,
+                                          gint               y,
+                                          gint               width,
+                                          gint               height)
+{
+  GeglRectangle  rect = { x, y, width, height };
+  GList         *list;
+  gboolean       replug = FALSE;
+
+  if (width <= 0 || height <= 0)
+    return;
+
+  list = stack->backdrops;
+
+  while (list)
+    {
+      GimpDrawableStackBackdrop *backdrop = list->data;
+      GList                     *next     = g_list_next (list);
+
+      if (g_list_find (backdrop->drawables, drawable))
+        {
+          if (gegl_rectangle_contains (&backdrop->extent, &rect))
+            {
+              gimp_tile_handler_projection_invalidate (GIMP_TILE_HANDLER_PROJECTION (backdrop->handler),
+                                                       x, y, width, height);
+            }
+          else
+            {
+              /*  the drawables grew beyond the buffer, start over  */
+              if (list == stack->backdrops && stack->backdrop_plugged)
+                {
+                  gimp_drawable_stack_unplug_backdrop (stack);
+                  replug = TRUE;
+                }
+
+              gimp_drawable_stack_backdrop_free (backdrop);
+              stack->backdrops = g_list_delete_link (stack->backdrops, list);
+            }
+        }
+
+      list = next;
+    }
+
+  if (replug)
+    gimp_drawable_stack_plug_backdrop (stack);
+}
+
+/*  drops the backdrops containing @drawable, or all of them  */
+static void
+gimp_drawable_stack_drop_backdrops (GimpDrawableStack *stack,
+                                    GimpDrawable      *drawable)
+{
+  GList *list = stack->backdrops;
+
+  while (list)
+    {
+      GimpDrawableStackBackdrop *backdrop = list->data;
+      GList                     *next     = g_list_next (list);
+
+      if (! drawable || g_list_find (backdrop->drawables, drawable))
+        {
+          gimp_drawable_stack_backdrop_free (backdrop);
+          stack->backdrops = g_list_delete_link (stack->backdrops, list);
+        }
+
+      list = next;
+    }
+}
+
+static GimpDrawableStackBackdrop *
+gimp_drawable_stack_backdrop_new (GList               *drawables,
+                                  guint                hash,
+                                  const GeglRectangle *extent,
+                                  gint64               memsize)
+{
+  GimpDrawableStackBackdrop *backdrop;
+  GeglNode                  *node;
+
+  backdrop = g_slice_new0 (GimpDrawableStackBackdrop);
+
+  node = gimp_item_get_node (GIMP_ITEM (drawables->data));
+
+  /*  keep the composite in the compositing format, so the drawables
+   *  above get the same input as without a backdrop
+   */
+  backdrop->drawables = g_list_copy (drawables);
+  backdrop->hash      = hash;
+  backdrop->extent    = *extent;
+  backdrop->buffer    = gegl_buffer_new (&backdrop->extent,
+                                         babl_format ("RGBA float"));
+  backdrop->handler   = gimp_tile_handler_projection_new (node);
+  backdrop->memsize   = memsize;
+
+  gegl_buffer_add_handler (backdrop->buffer, backdrop->handler);
+
+  gimp_tile_handler_projection_invalidate (GIMP_TILE_HANDLER_PROJECTION (backdrop->handler),
+                                           backdrop->extent.x,
+                                           backdrop->extent.y,
+                                           backdrop->extent.width,
+                                           backdrop->extent.height);
+
+  backdrop_memory += memsize;
+
+  return backdrop;
+}
+
+static void
+gimp_drawable_stack_backdrop_free (GimpDrawableStackBackdrop *backdrop)
+{
+  gegl_buffer_remove_handler (backdrop->buffer, backdrop->handler);
+
+  g_object_unref (backdrop->buffer);
+  g_object_unref (backdrop->handler);
+
+  g_list_free (backdrop->drawables);
+
+  backdrop_memory -= backdrop->memsize;
+
+  g_slice_free (GimpDrawableStackBackdrop, backdrop);
+}
+
 static void
 gimp_drawable_stack_update (GimpDrawableStack *stack,
                             gint               x,
@@ -381,6 +718,10 @@ gimp_drawable_stack_drawable_update (GimpItem          *item,
 
       gimp_item_get_offset (item, &offset_x, &offset_y);
 
+      gimp_drawable_stack_invalidate_backdrops (stack, GIMP_DRAWABLE (item),
+                                                x + offset_x, y + offset_y,
+                                                width, height);
+
       gimp_drawable_stack_update (stack,
                                   x + offset_x, y + offset_y,
                                   width, height);
@@ -396,6 +737,11 @@ gimp_drawable_stack_drawable_visible (GimpItem          *item,
 
   gimp_item_get_offset (item, &offset_x, &offset_y);
 
+  gimp_drawable_stack_invalidate_backdrops (stack, GIMP_DRAWABLE (item),
+                                            offset_x, offset_y,
+                                            gimp_item_get_width  (item),
+                                            gimp_item_get_height (item));
+
   gimp_drawable_stack_update (stack,
                               offset_x, offset_y,
                               gimp_item_get_width  (item),
@@ -38,6 +38,13 @@ struct _GimpDrawableStack
   GimpItemStack  parent_instance;
 
   GeglNode      *graph;
+
+  /*  composites of the drawables below the top one, most recently
+   *  used first, the first one is fed to the top drawable if plugged
+   */
+  GList         *backdrops;
+  GeglNode      *backdrop_node;
+  gboolean       backdrop_plugged;
 };
 
 struct _GimpDrawableStackClass
@@ -57,5 +64,8 @@ GimpContainer * gimp_drawable_stack_new       (GType              drawable_type)
 
 GeglNode      * gimp_drawable_stack_get_graph (GimpDrawableStack *stack);
 
+gint64          gimp_drawable_stack_get_backdrop_memsize
+                                              (GimpDrawableStack *stack);
+
 
 #endif  /*  __GIMP_DRAWABLE_STACK_H__  */
@@ -158,7 +158,7 @@ gimp_histogram_calculate (GimpHistogram       *histogram,
           switch (n_components)
             {
             case 1:
-              while (iter->length)
+              while (iter->length--)
                 {
                   const gdouble masked = *mask_data;
 
@@ -290,6 +290,35 @@ gimp_histogram_calculate (GimpHistogram       *histogram,
 #undef VALUE
 }
 
+/**
+ * gimp_histogram_add:
+ * @histogram: a %GimpHistogram
+ * @addend:    another %GimpHistogram
+ *
+ * Adds the values of @addend to @histogram, which is how histograms
+ * calculated over disjoint regions of the same buffer are combined.
+ * If @histogram has no values or a different number of channels, it
+ * is reset first.
+ **/
+void
+gimp_histogram_add (GimpHistogram *histogram,
+                    GimpHistogram *addend)
+{
+  gint i;
+
+  g_return_if_fail (histogram != NULL);
+  g_return_if_fail (addend != NULL);
+
+  if (! addend->values)
+    return;
+
+  if (histogram->n_channels != addend->n_channels)
+    gimp_histogram_alloc_values (histogram, addend->n_channels - 1);
+
+  for (i = 0; i < histogram->n_channels * 256; i++)
+    histogram->values[i] += addend->values[i];
+}
+
 void
 gimp_histogram_clear_values (GimpHistogram *histogram)
 {
@@ -34,6 +34,9 @@ void            gimp_histogram_calculate     (GimpHistogram        *histogram,
                                               GeglBuffer           *mask,
                                               const GeglRectangle  *mask_rect);
 
+void            gimp_histogram_add           (GimpHistogram        *histogram,
+                                              GimpHistogram        *addend);
+
 void            gimp_histogram_clear_values  (GimpHistogram        *histogram);
 
 gdouble         gimp_histogram_get_maximum   (GimpHistogram        *histogram,
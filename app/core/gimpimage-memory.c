@@ -0,0 +1,409 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <gegl.h>
+
+#include "core-types.h"
+
+#include "gegl/gimp-gegl-utils.h"
+
+#include "gimp-utils.h"
+#include "gimpchannel.h"
+#include "gimpchannelundo.h"
+#include "gimpdrawable.h"
+#include "gimpdrawable-private.h"
+#include "gimpdrawablestack.h"
+#include "gimpdrawablemodundo.h"
+#include "gimpdrawableundo.h"
+#include "gimpgrouplayer.h"
+#include "gimpimage.h"
+#include "gimpimage-memory.h"
+#include "gimpimage-undo.h"
+#include "gimplayer.h"
+#include "gimplayermask.h"
+#include "gimplayermaskundo.h"
+#include "gimplayerundo.h"
+#include "gimplist.h"
+#include "gimpmaskundo.h"
+#include "gimpprojection.h"
+#include "gimpundostack.h"
+
+
+/*  Unlike gimp_object_get_memsize() on the image, which attributes
+ *  everything to the object tree it happens to walk (and counts group
+ *  layer projections twice), this looks at each buffer exactly once and
+ *  charges it to the kind of object owning it.  Tiles shared
+ *  copy-on-write between duplicated drawables, or between drawables and
+ *  the undo steps that copied them, are charged only to the first
+ *  buffer found using them, looking at the image before the undo and
+ *  redo stacks.  It only looks at cached tiles and never touches pixel
+ *  data.  Projections, and the backdrops the layer stacks
+ *  composite into, render lazily, so only their tiles rendered so far
+ *  are counted.
+ *
+ *  Walking the tiles is linear in the image size, so the result is
+ *  cached on the image and only computed again after the image was
+ *  dirtied, its selection changed, or an undo step was pushed, undone,
+ *  redone or freed.  Every operation changing the image's buffers does
+ *  one of these, and the next call happens after it finished.  Drawable
+ *  and projection updates, which are emitted continuously while
+ *  painting, don't invalidate it, so projection tiles rendered since
+ *  are only counted after the next of these events.
+ */
+
+
+#define MEMORY_CACHE_KEY "gimp-image-memory-cache"
+
+
+typedef struct _MemoryCache MemoryCache;
+
+struct _MemoryCache
+{
+  GimpImageMemoryUsage usage;
+  gboolean             valid;
+};
+
+
+static MemoryCache * gimp_image_memory_cache_new     (GimpImage            *image);
+static void          gimp_image_memory_invalidate    (GimpImage            *image);
+static void          gimp_image_memory_calculate     (GimpImage            *image,
+                                                      GimpImageMemoryUsage *usage);
+static gint64        gimp_image_memory_drawable      (GimpDrawable         *drawable,
+                                                      GHashTable           *tiles,
+                                                      GimpImageMemoryUsage *usage);
+static gint64        gimp_image_memory_projection    (GimpProjection       *projection);
+static gint64        gimp_image_memory_undo_shared   (GimpUndo             *undo,
+                                                      GHashTable           *tiles);
+static gint64        gimp_image_memory_item_shared   (GimpItem             *item,
+                                                      GHashTable           *tiles);
+static gint64        gimp_image_memory_buffer_shared (GeglBuffer           *buffer,
+                                                      GHashTable           *tiles);
+
+
+/*  public functions  */
+
+void
+gimp_image_get_memory_usage (GimpImage            *image,
+                             GimpImageMemoryUsage *usage)
+{
+  MemoryCache *cache;
+
+  g_return_if_fail (GIMP_IS_IMAGE (image));
+  g_return_if_fail (usage != NULL);
+
+  cache = g_object_get_data (G_OBJECT (image), MEMORY_CACHE_KEY);
+
+  if (! cache)
+    cache = gimp_image_memory_cache_new (image);
+
+  if (! cache->valid)
+    {
+      gimp_image_memory_calculate (image, &cache->usage);
+
+      cache->valid = TRUE;
+    }
+
+  *usage = cache->usage;
+}
+
+gint64
+gimp_image_memory_usage_get_total (const GimpImageMemoryUsage *usage)
+{
+  g_return_val_if_fail (usage != NULL, 0);
+
+  return (usage->layers      +
+          usage->layer_masks +
+          usage->channels    +
+          usage->selection   +
+          usage->projections +
+          usage->shadows     +
+          usage->undo        +
+          usage->redo        +
+          usage->previews);
+}
+
+
+/*  private functions  */
+
+/*  the cache stays invalid until the first call, and from then on
+ *  follows the events listed at the top of this file
+ */
+static MemoryCache *
+gimp_image_memory_cache_new (GimpImage *image)
+{
+  MemoryCache *cache = g_new0 (MemoryCache, 1);
+
+  g_object_set_data_full (G_OBJECT (image), MEMORY_CACHE_KEY, cache,
+                          (GDestroyNotify) g_free);
+
+  g_signal_connect (image, "dirty",
+                    G_CALLBACK (gimp_image_memory_invalidate),
+                    NULL);
+  g_signal_connect (image, "mask-changed",
+                    G_CALLBACK (gimp_image_memory_invalidate),
+                    NULL);
+  g_signal_connect (image, "undo-event",
+                    G_CALLBACK (gimp_image_memory_invalidate),
+                    NULL);
+
+  return cache;
+}
+
+static void
+gimp_image_memory_invalidate (GimpImage *image)
+{
+  MemoryCache *cache = g_object_get_data (G_OBJECT (image), MEMORY_CACHE_KEY);
+
+  if (cache)
+    cache->valid = FALSE;
+}
+
+static void
+gimp_image_memory_calculate (GimpImage            *image,
+                             GimpImageMemoryUsage *usage)
+{
+  GList             *list;
+  GList             *iter;
+  GHashTable        *tiles;
+  GimpDrawableStack *stack;
+  GimpUndo          *undo_stack;
+  gint64             gui_size;
+
+  memset (usage, 0, sizeof (GimpImageMemoryUsage));
+
+  tiles = g_hash_table_new (NULL, NULL);
+
+  list = gimp_image_get_layer_list (image);
+
+  for (iter = list; iter; iter = g_list_next (iter))
+    {
+      GimpLayer     *layer = iter->data;
+      GimpLayerMask *mask  = gimp_layer_get_mask (layer);
+
+      if (GIMP_IS_GROUP_LAYER (layer))
+        {
+          GimpProjection *projection;
+          GimpContainer  *children;
+
+          /*  a group layer's buffer is its projection's buffer  */
+          projection = gimp_group_layer_get_projection (GIMP_GROUP_LAYER (layer));
+          children   = gimp_viewable_get_children (GIMP_VIEWABLE (layer));
+
+          usage->projections += gimp_image_memory_projection (projection);
+          usage->projections +=
+            gimp_drawable_stack_get_backdrop_memsize (GIMP_DRAWABLE_STACK (children));
+          gimp_image_memory_drawable (GIMP_DRAWABLE (layer), tiles, usage);
+        }
+      else
+        {
+          usage->layers += gimp_image_memory_drawable (GIMP_DRAWABLE (layer),
+                                                       tiles, usage);
+        }
+
+      if (mask)
+        usage->layer_masks += gimp_image_memory_drawable (GIMP_DRAWABLE (mask),
+                                                          tiles, usage);
+    }
+
+  g_list_free (list);
+
+  list = gimp_image_get_channel_list (image);
+
+  for (iter = list; iter; iter = g_list_next (iter))
+    usage->channels += gimp_image_memory_drawable (iter->data, tiles, usage);
+
+  g_list_free (list);
+
+  list = gimp_image_get_vectors_list (image);
+
+  for (iter = list; iter; iter = g_list_next (iter))
+    usage->previews += gimp_viewable_get_preview_memsize (iter->data);
+
+  g_list_free (list);
+
+  usage->selection +=
+    gimp_image_memory_drawable (GIMP_DRAWABLE (gimp_image_get_mask (image)),
+                                tiles, usage);
+
+  usage->projections +=
+    gimp_image_memory_projection (gimp_image_get_projection (image));
+  stack = GIMP_DRAWABLE_STACK (gimp_image_get_layers (image));
+  usage->projections += gimp_drawable_stack_get_backdrop_memsize (stack);
+
+  stack = GIMP_DRAWABLE_STACK (gimp_image_get_channels (image));
+  usage->projections += gimp_drawable_stack_get_backdrop_memsize (stack);
+
+  /*  after the image, so tiles the undo steps share with it are
+   *  charged to the image
+   */
+  undo_stack = GIMP_UNDO (gimp_image_get_undo_stack (image));
+
+  usage->undo += (gimp_object_get_memsize (GIMP_OBJECT (undo_stack),
+                                           &gui_size) -
+                  gimp_image_memory_undo_shared (undo_stack, tiles));
+  usage->previews += gui_size;
+
+  undo_stack = GIMP_UNDO (gimp_image_get_redo_stack (image));
+
+  usage->redo += (gimp_object_get_memsize (GIMP_OBJECT (undo_stack),
+                                           &gui_size) -
+                  gimp_image_memory_undo_shared (undo_stack, tiles));
+  usage->previews += gui_size;
+
+  g_hash_table_unref (tiles);
+
+  usage->previews += gimp_viewable_get_preview_memsize (GIMP_VIEWABLE (image));
+}
+
+/*  adds the drawable's shadow buffer and preview to @usage, and returns
+ *  the size of its own buffer's tiles not in @tiles yet for the caller
+ *  to attribute
+ */
+static gint64
+gimp_image_memory_drawable (GimpDrawable         *drawable,
+                            GHashTable           *tiles,
+                            GimpImageMemoryUsage *usage)
+{
+  GeglBuffer *buffer = gimp_drawable_get_buffer (drawable);
+
+  usage->shadows  += gimp_gegl_buffer_get_memsize (drawable->private->shadow);
+  usage->previews += gimp_viewable_get_preview_memsize (GIMP_VIEWABLE (drawable));
+
+  /*  don't walk a projection's tiles, that would render them  */
+  if (GIMP_IS_GROUP_LAYER (drawable))
+    return 0;
+
+  return (gimp_gegl_buffer_get_unshared_memsize (buffer, tiles) +
+          gimp_g_object_get_memsize (G_OBJECT (buffer)));
+}
+
+/*  like gimp_object_get_memsize(), but counting only the tiles of the
+ *  projection's buffer that were rendered, without rendering any
+ */
+static gint64
+gimp_image_memory_projection (GimpProjection *projection)
+{
+  gint64 memsize = gimp_object_get_memsize (GIMP_OBJECT (projection), NULL);
+
+  if (projection->buffer)
+    memsize += (gimp_gegl_buffer_get_allocated_memsize (projection->buffer) +
+                gimp_g_object_get_memsize (G_OBJECT (projection->buffer)) -
+                gimp_gegl_buffer_get_memsize (projection->buffer));
+
+  return memsize;
+}
+
+/*  returns how much less @undo and the undo steps in it take than
+ *  gimp_object_get_memsize() says, because their buffers' tiles are
+ *  already in @tiles
+ */
+static gint64
+gimp_image_memory_undo_shared (GimpUndo   *undo,
+                               GHashTable *tiles)
+{
+  gint64 shared = 0;
+
+  if (GIMP_IS_UNDO_STACK (undo))
+    {
+      GList *list;
+
+      for (list = GIMP_LIST (GIMP_UNDO_STACK (undo)->undos)->list;
+           list;
+           list = g_list_next (list))
+        {
+          shared += gimp_image_memory_undo_shared (list->data, tiles);
+        }
+    }
+  else if (GIMP_IS_DRAWABLE_UNDO (undo))
+    {
+      shared += gimp_image_memory_buffer_shared (GIMP_DRAWABLE_UNDO (undo)->buffer,
+                                                 tiles);
+    }
+  else if (GIMP_IS_DRAWABLE_MOD_UNDO (undo))
+    {
+      shared += gimp_image_memory_buffer_shared (GIMP_DRAWABLE_MOD_UNDO (undo)->buffer,
+                                                 tiles);
+    }
+  else if (GIMP_IS_MASK_UNDO (undo))
+    {
+      shared += gimp_image_memory_buffer_shared (GIMP_MASK_UNDO (undo)->buffer,
+                                                 tiles);
+    }
+  else if (GIMP_IS_LAYER_UNDO (undo) || GIMP_IS_CHANNEL_UNDO (undo))
+    {
+      GimpItem *item = GIMP_ITEM_UNDO (undo)->item;
+
+      /*  the same condition as in their get_memsize()  */
+      if (! gimp_item_is_attached (item))
+        shared += gimp_image_memory_item_shared (item, tiles);
+    }
+  else if (GIMP_IS_LAYER_MASK_UNDO (undo))
+    {
+      GimpLayer     *layer = GIMP_LAYER (GIMP_ITEM_UNDO (undo)->item);
+      GimpLayerMask *mask  = GIMP_LAYER_MASK_UNDO (undo)->layer_mask;
+
+      if (gimp_layer_get_mask (layer) != mask)
+        shared += gimp_image_memory_item_shared (GIMP_ITEM (mask), tiles);
+    }
+
+  return shared;
+}
+
+/*  the part of gimp_object_get_memsize() on a removed item that is
+ *  shared, see gimp_image_memory_undo_shared()
+ */
+static gint64
+gimp_image_memory_item_shared (GimpItem   *item,
+                               GHashTable *tiles)
+{
+  GimpLayerMask *mask   = NULL;
+  gint64         shared = 0;
+
+  /*  a group layer's buffer is its projection, nothing is shared  */
+  if (! GIMP_IS_DRAWABLE (item) || GIMP_IS_GROUP_LAYER (item))
+    return 0;
+
+  if (GIMP_IS_LAYER (item))
+    mask = gimp_layer_get_mask (GIMP_LAYER (item));
+
+  shared += gimp_image_memory_buffer_shared (gimp_drawable_get_buffer (GIMP_DRAWABLE (item)),
+                                             tiles);
+
+  if (mask)
+    shared += gimp_image_memory_item_shared (GIMP_ITEM (mask), tiles);
+
+  return shared;
+}
+
+/*  the difference between gimp_gegl_buffer_get_memsize(), which counts
+ *  @buffer by its extent, and what its tiles not in @tiles yet take
+ */
+static gint64
+gimp_image_memory_buffer_shared (GeglBuffer *buffer,
+                                 GHashTable *tiles)
+{
+  if (! buffer)
+    return 0;
+
+  return (gimp_gegl_buffer_get_memsize (buffer) -
+          gimp_g_object_get_memsize (G_OBJECT (buffer)) -
+          gimp_gegl_buffer_get_unshared_memsize (buffer, tiles));
+}
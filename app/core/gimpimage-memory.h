@@ -0,0 +1,43 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GIMP_IMAGE_MEMORY_H__
+#define __GIMP_IMAGE_MEMORY_H__
+
+
+typedef struct _GimpImageMemoryUsage GimpImageMemoryUsage;
+
+struct _GimpImageMemoryUsage
+{
+  gint64 layers;       /* layer buffers, excluding group layers         */
+  gint64 layer_masks;  /* layer mask buffers                            */
+  gint64 channels;     /* channel buffers                               */
+  gint64 selection;    /* the selection mask                            */
+  gint64 projections;  /* rendered projection and backdrop tiles        */
+  gint64 shadows;      /* shadow buffers of all drawables               */
+  gint64 undo;         /* the undo stack                                */
+  gint64 redo;         /* the redo stack                                */
+  gint64 previews;     /* cached previews of the image, items and undos */
+};
+
+
+void     gimp_image_get_memory_usage       (GimpImage                  *image,
+                                            GimpImageMemoryUsage       *usage);
+gint64   gimp_image_memory_usage_get_total (const GimpImageMemoryUsage *usage);
+
+
+#endif /* __GIMP_IMAGE_MEMORY_H__ */
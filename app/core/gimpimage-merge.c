@@ -46,15 +46,25 @@
 #include "gimplayermask.h"
 #include "gimpmarshal.h"
 #include "gimpparasitelist.h"
+#include "gimppickable.h"
+#include "gimpprojection.h"
 #include "gimpundostack.h"
 
 #include "gimp-intl.h"
 
-static GimpLayer * gimp_image_merge_layers (GimpImage     *image,
-                                            GimpContainer *container,
-                                            GSList        *merge_list,
-                                            GimpContext   *context,
-                                            GimpMergeType  merge_type);
+static GimpLayer * gimp_image_merge_layers        (GimpImage     *image,
+                                                   GimpContainer *container,
+                                                   GSList        *merge_list,
+                                                   GimpContext   *context,
+                                                   GimpMergeType  merge_type);
+static gboolean    gimp_image_merge_is_projection (GimpImage     *image,
+                                                   GimpContainer *container,
+                                                   GSList        *layers,
+                                                   gboolean       on_background,
+                                                   gint           x1,
+                                                   gint           y1,
+                                                   gint           x2,
+                                                   gint           y2);
 
 
 /*  public functions  */
@@ -419,6 +429,8 @@ gimp_image_merge_layers (GimpImage     *image,
   gint              position;
   gchar            *name;
   GimpLayer        *parent;
+  GeglBuffer       *merge_buffer;
+  gboolean          on_background = FALSE;
 
   g_return_val_if_fail (GIMP_IS_IMAGE (image), NULL);
   g_return_val_if_fail (GIMP_IS_CONTEXT (context), NULL);
@@ -530,7 +542,8 @@ gimp_image_merge_layers (GimpImage     *image,
                              GEGL_RECTANGLE(0,0,x2-x1,y2-y1), color);
       g_object_unref (color);
 
-      position = 0;
+      on_background = TRUE;
+      position      = 0;
     }
   else
     {
@@ -577,59 +590,125 @@ gimp_image_merge_layers (GimpImage     *image,
   gimp_item_set_parasites (GIMP_ITEM (merge_layer), parasites);
   g_object_unref (parasites);
 
-  for (layers = reverse_list; layers; layers = g_slist_next (layers))
+  merge_buffer = gimp_drawable_get_buffer (GIMP_DRAWABLE (merge_layer));
+
+  if (gimp_image_merge_is_projection (image, container, reverse_list,
+                                      on_background, x1, y1, x2, y2))
     {
-      GeglBuffer           *merge_buffer;
-      GeglBuffer           *layer_buffer;
-      GeglBuffer           *mask_buffer = NULL;
-      GeglNode             *apply;
-      GimpLayerModeEffects  mode;
+      GimpProjection *projection = gimp_image_get_projection (image);
+      GeglBuffer     *proj_buffer;
 
-      layer = layers->data;
+      /*  the projection already holds the merged layers, and its
+       *  validated tiles don't need to be composited again
+       */
+      gimp_pickable_flush (GIMP_PICKABLE (projection));
 
-      gimp_item_get_offset (GIMP_ITEM (layer), &off_x, &off_y);
+      proj_buffer = gimp_pickable_get_buffer (GIMP_PICKABLE (projection));
 
-      /* DISSOLVE_MODE is special since it is the only mode that does not
-       *  work on the projection with the lower layer, but only locally on
-       *  the layers alpha channel.
-       */
-      mode = gimp_layer_get_mode (layer);
-      if (layer == bottom_layer && mode != GIMP_DISSOLVE_MODE)
-        mode = GIMP_NORMAL_MODE;
+      if (on_background)
+        {
+          GeglNode *apply;
+
+          apply = gimp_gegl_create_apply_buffer_node (proj_buffer,
+                                                      - x1, - y1,
+                                                      0, 0,
+                                                      0, 0,
+                                                      NULL, 0, 0,
+                                                      GIMP_OPACITY_OPAQUE,
+                                                      GIMP_NORMAL_MODE,
+                                                      GIMP_COMPONENT_ALL);
+
+          gimp_apply_operation (merge_buffer, NULL, NULL,
+                                apply,
+                                merge_buffer, NULL);
+
+          g_object_unref (apply);
+        }
+      else
+        {
+          gegl_buffer_copy (proj_buffer,
+                            GEGL_RECTANGLE (x1, y1, x2 - x1, y2 - y1),
+                            merge_buffer,
+                            GEGL_RECTANGLE (0, 0, 0, 0));
+        }
+    }
+  else
+    {
+      GeglNode *merge;
+      GeglNode *input;
+      GeglNode *output;
 
-      merge_buffer = gimp_drawable_get_buffer (GIMP_DRAWABLE (merge_layer));
-      layer_buffer = gimp_drawable_get_buffer (GIMP_DRAWABLE (layer));
+      /*  composite all layers in one pass, instead of writing the
+       *  merge buffer once for each of them
+       */
+      merge  = gegl_node_new ();
+      input  = gegl_node_get_input_proxy  (merge, "input");
+      output = gegl_node_get_output_proxy (merge, "output");
 
-      if (gimp_layer_get_mask (layer) &&
-          gimp_layer_get_apply_mask (layer))
+      for (layers = reverse_list; layers; layers = g_slist_next (layers))
         {
-          mask_buffer = gimp_drawable_get_buffer (GIMP_DRAWABLE (layer->mask));
+          GeglBuffer           *layer_buffer;
+          GeglBuffer           *mask_buffer = NULL;
+          GeglNode             *apply;
+          GimpLayerModeEffects  mode;
+
+          layer = layers->data;
+
+          gimp_item_get_offset (GIMP_ITEM (layer), &off_x, &off_y);
+
+          /* DISSOLVE_MODE is special since it is the only mode that does not
+           *  work on the projection with the lower layer, but only locally on
+           *  the layers alpha channel.
+           */
+          mode = gimp_layer_get_mode (layer);
+          if (layer == bottom_layer && mode != GIMP_DISSOLVE_MODE)
+            mode = GIMP_NORMAL_MODE;
+
+          layer_buffer = gimp_drawable_get_buffer (GIMP_DRAWABLE (layer));
+
+          if (gimp_layer_get_mask (layer) &&
+              gimp_layer_get_apply_mask (layer))
+            {
+              mask_buffer = gimp_drawable_get_buffer (GIMP_DRAWABLE (layer->mask));
+            }
+
+          apply =
+            gimp_gegl_create_apply_buffer_node (layer_buffer,
+                                                - (x1 - off_x),
+                                                - (y1 - off_y),
+                                                0,
+                                                0,
+                                                0,
+                                                0,
+                                                mask_buffer,
+                                                - (x1 - off_x),
+                                                - (y1 - off_y),
+                                                gimp_layer_get_opacity (layer),
+                                                mode,
+                                                GIMP_COMPONENT_ALL);
+
+          gegl_node_add_child (merge, apply);
+          g_object_unref (apply);
+
+          gegl_node_connect_to (input, "output",
+                                apply, "input");
+
+          input = apply;
         }
 
-      apply =
-        gimp_gegl_create_apply_buffer_node (layer_buffer,
-                                            - (x1 - off_x),
-                                            - (y1 - off_y),
-                                            0,
-                                            0,
-                                            0,
-                                            0,
-                                            mask_buffer,
-                                            - (x1 - off_x),
-                                            - (y1 - off_y),
-                                            gimp_layer_get_opacity (layer),
-                                            mode,
-                                            GIMP_COMPONENT_ALL);
+      gegl_node_connect_to (input,  "output",
+                            output, "input");
 
       gimp_apply_operation (merge_buffer, NULL, NULL,
-                            apply,
+                            merge,
                             merge_buffer, NULL);
 
-      g_object_unref (apply);
-
-      gimp_image_remove_layer (image, layer, TRUE, NULL);
+      g_object_unref (merge);
     }
 
+  for (layers = reverse_list; layers; layers = g_slist_next (layers))
+    gimp_image_remove_layer (image, layers->data, TRUE, NULL);
+
   g_slist_free (reverse_list);
 
   gimp_object_take_name (GIMP_OBJECT (merge_layer), name);
@@ -667,3 +746,94 @@ gimp_image_merge_layers (GimpImage     *image,
 
   return merge_layer;
 }
+
+/*  whether merging @layers, bottom layer first, would produce what the
+ *  image's projection already holds; @on_background is whether they
+ *  are composited onto the background color rather than onto nothing
+ */
+static gboolean
+gimp_image_merge_is_projection (GimpImage     *image,
+                                GimpContainer *container,
+                                GSList        *layers,
+                                gboolean       on_background,
+                                gint           x1,
+                                gint           y1,
+                                gint           x2,
+                                gint           y2)
+{
+  GimpLayer            *bottom_layer = layers->data;
+  GimpLayerModeEffects  bottom_mode  = gimp_layer_get_mode (bottom_layer);
+  gboolean              all_normal   = TRUE;
+  GList                *list;
+  GSList               *slist;
+
+  if (container != gimp_image_get_layers (image))
+    return FALSE;
+
+  if (x1 != 0 || y1 != 0                     ||
+      x2 != gimp_image_get_width  (image)    ||
+      y2 != gimp_image_get_height (image))
+    return FALSE;
+
+  /*  visible channels are blended over the layers  */
+  for (list = gimp_image_get_channel_iter (image);
+       list;
+       list = g_list_next (list))
+    {
+      if (gimp_item_get_visible (list->data))
+        return FALSE;
+    }
+
+  /*  the projection shows exactly the visible layers  */
+  for (list = gimp_image_get_layer_iter (image);
+       list;
+       list = g_list_next (list))
+    {
+      gboolean visible = gimp_item_get_visible (list->data) ? TRUE : FALSE;
+      gboolean merged  = g_slist_find (layers, list->data)  ? TRUE : FALSE;
+
+      if (visible != merged)
+        return FALSE;
+    }
+
+  for (slist = layers; slist; slist = g_slist_next (slist))
+    {
+      GimpLayer *layer = slist->data;
+
+      /*  the projection shows the mask instead of the layer  */
+      if (gimp_layer_get_mask (layer) && gimp_layer_get_show_mask (layer))
+        return FALSE;
+
+      if (gimp_layer_get_mode (layer) != GIMP_NORMAL_MODE)
+        all_normal = FALSE;
+    }
+
+  /*  the bottom layer is merged in normal mode, but the projection
+   *  composites it onto nothing in its own mode
+   */
+  if (bottom_mode != GIMP_NORMAL_MODE && bottom_mode != GIMP_DISSOLVE_MODE)
+    return FALSE;
+
+  /*  compositing onto the background only equals compositing onto
+   *  nothing and the result onto the background if the modes are
+   *  associative with it, or if the bottom layer hides it entirely
+   */
+  if (on_background && ! all_normal)
+    {
+      GimpItem *item = GIMP_ITEM (bottom_layer);
+      gint      off_x, off_y;
+
+      gimp_item_get_offset (item, &off_x, &off_y);
+
+      if (bottom_mode != GIMP_NORMAL_MODE                              ||
+          gimp_drawable_has_alpha (GIMP_DRAWABLE (bottom_layer))       ||
+          gimp_layer_get_opacity (bottom_layer) != GIMP_OPACITY_OPAQUE ||
+          (gimp_layer_get_mask (bottom_layer) &&
+           gimp_layer_get_apply_mask (bottom_layer))                   ||
+          off_x > 0 || off_x + gimp_item_get_width  (item) < x2        ||
+          off_y > 0 || off_y + gimp_item_get_height (item) < y2)
+        return FALSE;
+    }
+
+  return TRUE;
+}
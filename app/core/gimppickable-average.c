@@ -0,0 +1,353 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimppickable-average.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Averages square areas of a pickable from summed-area tables kept
+ * for the squares of a fixed grid, so the cost of a query only
+ * depends on the number of squares the area touches, not on its
+ * size.  The tables are built on demand and dropped when the area
+ * they cover is invalidated.
+ */
+
+#include "config.h"
+
+#include <gegl.h>
+
+#include "core-types.h"
+
+#include "gimpdrawable.h"
+#include "gimppickable.h"
+#include "gimppickable-average.h"
+#include "gimpprojection.h"
+
+
+/*  the size of the squares summed-area tables are kept for  */
+#define TILE_SIZE   64
+#define TILE_STRIDE (TILE_SIZE + 1)
+
+
+typedef struct _GimpPickableAverageCache GimpPickableAverageCache;
+
+struct _GimpPickableAverageCache
+{
+  gint      width;
+  gint      height;
+  gint      n_tiles_x;
+  gint      n_tiles_y;
+
+  /*  per tile, TILE_STRIDE² sums of the R'G'B'A u8 pixels above and
+   *  left of each position, or NULL
+   */
+  guint32 **tiles;
+};
+
+
+static GimpPickableAverageCache *
+                  gimp_pickable_average_cache_get  (GimpPickable             *pickable,
+                                                    GeglBuffer               *buffer);
+static void       gimp_pickable_average_cache_free (GimpPickableAverageCache *cache);
+static guint32  * gimp_pickable_average_tile_get   (GimpPickableAverageCache *cache,
+                                                    GeglBuffer               *buffer,
+                                                    gint                      tile_x,
+                                                    gint                      tile_y);
+static void       gimp_pickable_average_sum_buffer (GeglBuffer               *buffer,
+                                                    const GeglRectangle      *rect,
+                                                    guint64                  *sum);
+
+
+static GQuark average_cache_quark = 0;
+
+
+/**
+ * gimp_pickable_get_average:
+ * @pickable: a #GimpPickable
+ * @x:        x coordinate of the center
+ * @y:        y coordinate of the center
+ * @radius:   the radius of the square to average
+ * @pixel:    return location for an R'G'B'A u8 pixel
+ *
+ * Averages the pixels of @pickable in the square of size
+ * 2 * @radius + 1 around (@x, @y), ignoring the parts outside of
+ * @pickable.  For drawables and projections, which invalidate the
+ * summed-area tables whenever they change, the time this takes does
+ * not depend on @radius.
+ *
+ * Returns: %FALSE if (@x, @y) is outside of @pickable.
+ **/
+gboolean
+gimp_pickable_get_average (GimpPickable *pickable,
+                           gint          x,
+                           gint          y,
+                           gint          radius,
+                           guchar       *pixel)
+{
+  GeglBuffer          *buffer;
+  const GeglRectangle *extent;
+  GeglRectangle        rect;
+  guint64              sum[4] = { 0, 0, 0, 0 };
+  gint64               count;
+  gint                 i;
+
+  g_return_val_if_fail (GIMP_IS_PICKABLE (pickable), FALSE);
+  g_return_val_if_fail (radius >= 0, FALSE);
+  g_return_val_if_fail (pixel != NULL, FALSE);
+
+  buffer = gimp_pickable_get_buffer (pickable);
+  extent = gegl_buffer_get_extent (buffer);
+
+  if (x <  0              ||
+      y <  0              ||
+      x >= extent->width  ||
+      y >= extent->height)
+    return FALSE;
+
+  gegl_rectangle_intersect (&rect,
+                            GEGL_RECTANGLE (x - radius, y - radius,
+                                            2 * radius + 1, 2 * radius + 1),
+                            GEGL_RECTANGLE (0, 0,
+                                            extent->width, extent->height));
+
+  /*  only drawables and projections tell us when to drop the tables  */
+  if (GIMP_IS_DRAWABLE (pickable) || GIMP_IS_PROJECTION (pickable))
+    {
+      GimpPickableAverageCache *cache;
+      gint                      tile_x, tile_y;
+
+      cache = gimp_pickable_average_cache_get (pickable, buffer);
+
+      for (tile_y = rect.y / TILE_SIZE;
+           tile_y <= (rect.y + rect.height - 1) / TILE_SIZE;
+           tile_y++)
+        for (tile_x = rect.x / TILE_SIZE;
+             tile_x <= (rect.x + rect.width - 1) / TILE_SIZE;
+             tile_x++)
+          {
+            guint32 *table;
+            gint     x1, y1, x2, y2;
+
+            table = gimp_pickable_average_tile_get (cache, buffer,
+                                                    tile_x, tile_y);
+
+            /*  the part of the square in this tile, in tile coordinates  */
+            x1 = MAX (rect.x, tile_x * TILE_SIZE) - tile_x * TILE_SIZE;
+            y1 = MAX (rect.y, tile_y * TILE_SIZE) - tile_y * TILE_SIZE;
+            x2 = MIN (rect.x + rect.width,
+                      (tile_x + 1) * TILE_SIZE) - tile_x * TILE_SIZE;
+            y2 = MIN (rect.y + rect.height,
+                      (tile_y + 1) * TILE_SIZE) - tile_y * TILE_SIZE;
+
+            for (i = 0; i < 4; i++)
+              sum[i] += ((guint64) table[4 * (y2 * TILE_STRIDE + x2) + i] -
+                         table[4 * (y1 * TILE_STRIDE + x2) + i] -
+                         table[4 * (y2 * TILE_STRIDE + x1) + i] +
+                         table[4 * (y1 * TILE_STRIDE + x1) + i]);
+          }
+    }
+  else
+    {
+      gimp_pickable_average_sum_buffer (buffer, &rect, sum);
+    }
+
+  count = (gint64) rect.width * rect.height;
+
+  for (i = 0; i < 4; i++)
+    pixel[i] = (guchar) ((sum[i] + count / 2) / count);
+
+  return TRUE;
+}
+
+/**
+ * gimp_pickable_invalidate_average:
+ * @pickable: a #GimpPickable
+ * @x:        x coordinate of the changed area
+ * @y:        y coordinate of the changed area
+ * @width:    width of the changed area
+ * @height:   height of the changed area
+ *
+ * Drops the summed-area tables of all tiles intersecting the changed
+ * area.  Called whenever a drawable is updated or a projection is
+ * invalidated.
+ **/
+void
+gimp_pickable_invalidate_average (GimpPickable *pickable,
+                                  gint          x,
+                                  gint          y,
+                                  gint          width,
+                                  gint          height)
+{
+  GimpPickableAverageCache *cache;
+  gint                      x1, y1, x2, y2;
+  gint                      tile_x, tile_y;
+
+  g_return_if_fail (GIMP_IS_PICKABLE (pickable));
+
+  if (! average_cache_quark)
+    return;
+
+  cache = g_object_get_qdata (G_OBJECT (pickable), average_cache_quark);
+
+  if (! cache || width <= 0 || height <= 0)
+    return;
+
+  x1 = CLAMP (x,          0, cache->width);
+  y1 = CLAMP (y,          0, cache->height);
+  x2 = CLAMP (x + width,  0, cache->width);
+  y2 = CLAMP (y + height, 0, cache->height);
+
+  if (x1 == x2 || y1 == y2)
+    return;
+
+  for (tile_y = y1 / TILE_SIZE; tile_y <= (y2 - 1) / TILE_SIZE; tile_y++)
+    for (tile_x = x1 / TILE_SIZE; tile_x <= (x2 - 1) / TILE_SIZE; tile_x++)
+      {
+        guint32 **tile = &cache->tiles[tile_y * cache->n_tiles_x + tile_x];
+
+        if (*tile)
+          {
+            g_free (*tile);
+            *tile = NULL;
+          }
+      }
+}
+
+
+/*  private functions  */
+
+static GimpPickableAverageCache *
+gimp_pickable_average_cache_get (GimpPickable *pickable,
+                                 GeglBuffer   *buffer)
+{
+  GimpPickableAverageCache *cache;
+  gint                      width  = gegl_buffer_get_width  (buffer);
+  gint                      height = gegl_buffer_get_height (buffer);
+
+  if (! average_cache_quark)
+    average_cache_quark = g_quark_from_static_string ("gimp-pickable-average");
+
+  cache = g_object_get_qdata (G_OBJECT (pickable), average_cache_quark);
+
+  if (cache && cache->width == width && cache->height == height)
+    return cache;
+
+  cache = g_slice_new0 (GimpPickableAverageCache);
+
+  cache->width     = width;
+  cache->height    = height;
+  cache->n_tiles_x = (width  + TILE_SIZE - 1) / TILE_SIZE;
+  cache->n_tiles_y = (height + TILE_SIZE - 1) / TILE_SIZE;
+  cache->tiles     = g_new0 (guint32 *, cache->n_tiles_x * cache->n_tiles_y);
+
+  g_object_set_qdata_full (G_OBJECT (pickable), average_cache_quark, cache,
+                           (GDestroyNotify) gimp_pickable_average_cache_free);
+
+  return cache;
+}
+
+static void
+gimp_pickable_average_cache_free (GimpPickableAverageCache *cache)
+{
+  gint i;
+
+  for (i = 0; i < cache->n_tiles_x * cache->n_tiles_y; i++)
+    g_free (cache->tiles[i]);
+
+  g_free (cache->tiles);
+
+  g_slice_free (GimpPickableAverageCache, cache);
+}
+
+static guint32 *
+gimp_pickable_average_tile_get (GimpPickableAverageCache *cache,
+                                GeglBuffer               *buffer,
+                                gint                      tile_x,
+                                gint                      tile_y)
+{
+  guint32 **tile = &cache->tiles[tile_y * cache->n_tiles_x + tile_x];
+  guchar   *data;
+  gint      width;
+  gint      height;
+  gint      x, y, i;
+
+  if (*tile)
+    return *tile;
+
+  width  = MIN (TILE_SIZE, cache->width  - tile_x * TILE_SIZE);
+  height = MIN (TILE_SIZE, cache->height - tile_y * TILE_SIZE);
+
+  data = g_new (guchar, width * height * 4);
+
+  gegl_buffer_get (buffer,
+                   GEGL_RECTANGLE (tile_x * TILE_SIZE, tile_y * TILE_SIZE,
+                                   width, height),
+                   1.0, babl_format ("R'G'B'A u8"), data,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  /*  the first row and column stay zero  */
+  *tile = g_new0 (guint32, TILE_STRIDE * TILE_STRIDE * 4);
+
+  for (y = 0; y < height; y++)
+    {
+      const guchar *src    = data + y * width * 4;
+      guint32      *above  = *tile + 4 * (y * TILE_STRIDE + 1);
+      guint32      *dest   = *tile + 4 * ((y + 1) * TILE_STRIDE + 1);
+      guint32       row[4] = { 0, 0, 0, 0 };
+
+      for (x = 0; x < width; x++)
+        {
+          for (i = 0; i < 4; i++)
+            {
+              row[i] += src[i];
+              dest[i] = above[i] + row[i];
+            }
+
+          src   += 4;
+          above += 4;
+          dest  += 4;
+        }
+    }
+
+  g_free (data);
+
+  return *tile;
+}
+
+/*  for pickables without invalidation, sum the area directly  */
+static void
+gimp_pickable_average_sum_buffer (GeglBuffer          *buffer,
+                                  const GeglRectangle *rect,
+                                  guint64             *sum)
+{
+  guchar *data;
+  gint    n_pixels = rect->width * rect->height;
+  gint    i;
+
+  data = g_new (guchar, n_pixels * 4);
+
+  gegl_buffer_get (buffer, rect, 1.0, babl_format ("R'G'B'A u8"), data,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  for (i = 0; i < n_pixels; i++)
+    {
+      sum[0] += data[4 * i + 0];
+      sum[1] += data[4 * i + 1];
+      sum[2] += data[4 * i + 2];
+      sum[3] += data[4 * i + 3];
+    }
+
+  g_free (data);
+}
@@ -20,8 +20,7 @@
 
 /* This file contains an interface for pixel objects that their color at
  * a given position can be picked. Also included is a utility for
- * sampling an average area (which uses the implemented picking
- * functions).
+ * sampling an average area (which uses gimp_pickable_get_average()).
  */
 
 #include "config.h"
@@ -37,6 +36,7 @@
 #include "gimpobject.h"
 #include "gimpimage.h"
 #include "gimppickable.h"
+#include "gimppickable-average.h"
 
 
 GType
@@ -216,29 +216,7 @@ gimp_pickable_pick_color (GimpPickable *pickable,
     return FALSE;
 
   if (sample_average)
-    {
-      gint count        = 0;
-      gint color_avg[4] = { 0, 0, 0, 0 };
-      gint radius       = (gint) average_radius;
-      gint i, j;
-
-      for (i = x - radius; i <= x + radius; i++)
-        for (j = y - radius; j <= y + radius; j++)
-          if (gimp_pickable_get_pixel_at (pickable, i, j, format, pixel))
-            {
-              count++;
-
-              color_avg[RED]   += pixel[RED];
-              color_avg[GREEN] += pixel[GREEN];
-              color_avg[BLUE]  += pixel[BLUE];
-              color_avg[ALPHA] += pixel[ALPHA];
-            }
-
-      pixel[RED]   = (guchar) ((color_avg[RED]   + count / 2) / count);
-      pixel[GREEN] = (guchar) ((color_avg[GREEN] + count / 2) / count);
-      pixel[BLUE]  = (guchar) ((color_avg[BLUE]  + count / 2) / count);
-      pixel[ALPHA] = (guchar) ((color_avg[ALPHA] + count / 2) / count);
-    }
+    gimp_pickable_get_average (pickable, x, y, (gint) average_radius, pixel);
 
   gimp_rgba_set_uchar (color,
                        pixel[RED],
@@ -32,9 +32,12 @@
 #include "gimpimage.h"
 #include "gimpmarshal.h"
 #include "gimppickable.h"
+#include "gimppickable-average.h"
 #include "gimpprojectable.h"
 #include "gimpprojection.h"
 
+#include "gimp-trace.h"
+
 
 /*  halfway between G_PRIORITY_HIGH_IDLE and G_PRIORITY_DEFAULT_IDLE  */
 #define GIMP_PROJECTION_IDLE_PRIORITY \
@@ -380,6 +383,11 @@ gimp_projection_free_buffer (GimpProjection  *proj)
 {
   if (proj->buffer)
     {
+      gimp_pickable_invalidate_average (GIMP_PICKABLE (proj),
+                                        0, 0,
+                                        gegl_buffer_get_width  (proj->buffer),
+                                        gegl_buffer_get_height (proj->buffer));
+
       if (proj->validate_handler)
         gegl_buffer_remove_handler (proj->buffer, proj->validate_handler);
 
@@ -629,6 +637,8 @@ gimp_projection_paint_area (GimpProjection *proj,
   gint width, height;
   gint x1, y1, x2, y2;
 
+  GIMP_TRACE_BEGIN ("gimp_projection_paint_area");
+
   gimp_projectable_get_offset (proj->projectable, &off_x, &off_y);
   gimp_projectable_get_size   (proj->projectable, &width, &height);
 
@@ -650,6 +660,8 @@ gimp_projection_paint_area (GimpProjection *proj,
                  y1 + off_y,
                  x2 - x1,
                  y2 - y1);
+
+  GIMP_TRACE_END ("gimp_projection_paint_area");
 }
 
 static void
@@ -662,6 +674,8 @@ gimp_projection_invalidate (GimpProjection *proj,
   if (proj->validate_handler)
     gimp_tile_handler_projection_invalidate (proj->validate_handler,
                                              x, y, w, h);
+
+  gimp_pickable_invalidate_average (GIMP_PICKABLE (proj), x, y, w, h);
 }
 
 
@@ -704,13 +704,27 @@ gimp_selection_extract (GimpSelection *selection,
 
   src_buffer = gimp_pickable_get_buffer (pickable);
 
-  /*  Allocate the temp buffer  */
-  dest_buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, x2 - x1, y2 - y1),
-                                 dest_format);
+  if (dest_format == gegl_buffer_get_format (src_buffer))
+    {
+      /*  Share the source's tiles, only the tiles masked below or
+       *  modified later are actually copied
+       */
+      dest_buffer =
+        gimp_gegl_buffer_new_shifted (src_buffer,
+                                      GEGL_RECTANGLE (x1, y1,
+                                                      x2 - x1, y2 - y1),
+                                      NULL);
+    }
+  else
+    {
+      /*  Allocate the temp buffer  */
+      dest_buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, x2 - x1, y2 - y1),
+                                     dest_format);
 
-  /*  First, copy the pixels, possibly doing INDEXED->RGB and adding alpha  */
-  gegl_buffer_copy (src_buffer, GEGL_RECTANGLE (x1, y1, x2 - x1, y2 - y1),
-                    dest_buffer, GEGL_RECTANGLE (0, 0,0 ,0 ));
+      /*  Copy the pixels, possibly doing INDEXED->RGB and adding alpha  */
+      gegl_buffer_copy (src_buffer, GEGL_RECTANGLE (x1, y1, x2 - x1, y2 - y1),
+                        dest_buffer, GEGL_RECTANGLE (0, 0, 0, 0));
+    }
 
   if (non_empty)
     {
@@ -22,8 +22,11 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
 
 #include <gegl.h>
+#include <glib/gstdio.h>
 
 #include "libgimpbase/gimpbase.h"
 #include "libgimpmath/gimpmath.h"
@@ -44,7 +47,17 @@
 #include "gimp-intl.h"
 
 
-#define GIMP_TAG_CACHE_FILE  "tags.xml"
+#define GIMP_TAG_CACHE_FILE         "tags.xml"
+#define GIMP_TAG_CACHE_BINARY_FILE  "tags.cache"
+
+/*  the binary cache starts with the magic and the version, followed
+ *  by the number of records and the records, each one being the
+ *  identifier, the checksum, the number of tags and the tags.  Strings
+ *  are stored as their length followed by their bytes, all numbers are
+ *  big endian guint32.  Bump the version whenever this changes.
+ */
+#define GIMP_TAG_CACHE_MAGIC        "GIMPTAGS"
+#define GIMP_TAG_CACHE_VERSION      1
 
 /* #define DEBUG_GIMP_TAG_CACHE  1 */
 
@@ -72,8 +85,12 @@ typedef struct
 
 struct _GimpTagCachePriv
 {
-  GArray *records;
-  GList  *containers;
+  GArray     *records;
+  GList      *containers;
+
+  /*  quark => index into records + 1  */
+  GHashTable *identifiers;
+  GHashTable *checksums;
 };
 
 
@@ -85,6 +102,34 @@ static void          gimp_tag_cache_object_initialize  (GimpTagged             *
                                                         GimpTagCache           *cache);
 static void          gimp_tag_cache_add_object         (GimpTagCache           *cache,
                                                         GimpTagged             *tagged);
+static void          gimp_tag_cache_index_records      (GimpTagCache           *cache);
+static GimpTagCacheRecord *
+                     gimp_tag_cache_lookup             (GimpTagCache           *cache,
+                                                        GHashTable             *index,
+                                                        GQuark                  quark);
+
+static void          gimp_tag_cache_save_xml           (GList                  *records,
+                                                        const gchar            *filename);
+static void          gimp_tag_cache_save_binary        (GList                  *records,
+                                                        const gchar            *filename);
+static void          gimp_tag_cache_append_uint32      (GString                *buf,
+                                                        guint32                 value);
+static void          gimp_tag_cache_append_string      (GString                *buf,
+                                                        const gchar            *string);
+static gboolean      gimp_tag_cache_binary_is_current  (const gchar            *binary_filename,
+                                                        const gchar            *xml_filename);
+static gboolean      gimp_tag_cache_load_binary        (GimpTagCache           *cache,
+                                                        const gchar            *filename,
+                                                        GError                **error);
+static void          gimp_tag_cache_clear_records      (GimpTagCache           *cache);
+static gboolean      gimp_tag_cache_read_uint32        (const guchar          **data,
+                                                        const guchar           *end,
+                                                        guint32                *value);
+static gchar       * gimp_tag_cache_read_string        (const guchar          **data,
+                                                        const guchar           *end,
+                                                        gboolean               *valid);
+static void          gimp_tag_cache_load_xml           (GimpTagCache           *cache,
+                                                        const gchar            *filename);
 
 static void          gimp_tag_cache_load_start_element (GMarkupParseContext    *context,
                                                         const gchar            *element_name,
@@ -139,9 +184,11 @@ gimp_tag_cache_init (GimpTagCache *cache)
                                              GIMP_TYPE_TAG_CACHE,
                                              GimpTagCachePriv);
 
-  cache->priv->records    = g_array_new (FALSE, FALSE,
-                                         sizeof (GimpTagCacheRecord));
-  cache->priv->containers = NULL;
+  cache->priv->records     = g_array_new (FALSE, FALSE,
+                                          sizeof (GimpTagCacheRecord));
+  cache->priv->containers  = NULL;
+  cache->priv->identifiers = g_hash_table_new (g_direct_hash, g_direct_equal);
+  cache->priv->checksums   = g_hash_table_new (g_direct_hash, g_direct_equal);
 }
 
 static void
@@ -165,6 +212,18 @@ gimp_tag_cache_finalize (GObject *object)
       cache->priv->records = NULL;
     }
 
+  if (cache->priv->identifiers)
+    {
+      g_hash_table_unref (cache->priv->identifiers);
+      cache->priv->identifiers = NULL;
+    }
+
+  if (cache->priv->checksums)
+    {
+      g_hash_table_unref (cache->priv->checksums);
+      cache->priv->checksums = NULL;
+    }
+
   if (cache->priv->containers)
     {
       g_list_free (cache->priv->containers);
@@ -183,6 +242,8 @@ gimp_tag_cache_get_memsize (GimpObject *object,
 
   memsize += gimp_g_list_get_memsize (cache->priv->containers, 0);
   memsize += cache->priv->records->len * sizeof (GimpTagCacheRecord);
+  memsize += gimp_g_hash_table_get_memsize (cache->priv->identifiers, 0);
+  memsize += gimp_g_hash_table_get_memsize (cache->priv->checksums, 0);
 
   return memsize + GIMP_OBJECT_CLASS (parent_class)->get_memsize (object,
                                                                   gui_size);
@@ -236,12 +297,12 @@ static void
 gimp_tag_cache_add_object (GimpTagCache *cache,
                            GimpTagged   *tagged)
 {
-  gchar  *identifier;
-  GQuark  identifier_quark = 0;
-  gchar  *checksum;
-  GQuark  checksum_quark = 0;
-  GList  *list;
-  gint    i;
+  GimpTagCacheRecord *rec = NULL;
+  gchar              *identifier;
+  GQuark              identifier_quark = 0;
+  gchar              *checksum;
+  GQuark              checksum_quark = 0;
+  GList              *list;
 
   identifier = gimp_tagged_get_identifier (tagged);
 
@@ -252,61 +313,117 @@ gimp_tag_cache_add_object (GimpTagCache *cache,
     }
 
   if (identifier_quark)
+    rec = gimp_tag_cache_lookup (cache, cache->priv->identifiers,
+                                 identifier_quark);
+
+  /*  computing the checksum is expensive, don't bother if no record
+   *  could match it
+   */
+  if (! rec && g_hash_table_size (cache->priv->checksums) > 0)
     {
-      for (i = 0; i < cache->priv->records->len; i++)
+      checksum = gimp_tagged_get_checksum (tagged);
+
+      if (checksum)
         {
-          GimpTagCacheRecord *rec = &g_array_index (cache->priv->records,
-                                                    GimpTagCacheRecord, i);
+          checksum_quark = g_quark_try_string (checksum);
+          g_free (checksum);
+        }
+
+      if (checksum_quark)
+        rec = gimp_tag_cache_lookup (cache, cache->priv->checksums,
+                                     checksum_quark);
+
+      if (rec)
+        {
+#if DEBUG_GIMP_TAG_CACHE
+          g_printerr ("remapping identifier: %s ==> %s\n",
+                      rec->identifier ? g_quark_to_string (rec->identifier) : "(NULL)",
+                      identifier_quark ? g_quark_to_string (identifier_quark) : "(NULL)");
+#endif
 
-          if (rec->identifier == identifier_quark)
+          if (rec->identifier &&
+              gimp_tag_cache_lookup (cache, cache->priv->identifiers,
+                                     rec->identifier) == rec)
             {
-              for (list = rec->tags; list; list = g_list_next (list))
-                {
-                  gimp_tagged_add_tag (tagged, GIMP_TAG (list->data));
-                }
+              g_hash_table_remove (cache->priv->identifiers,
+                                   GUINT_TO_POINTER (rec->identifier));
+            }
+
+          rec->identifier = identifier_quark;
+
+          if (identifier_quark &&
+              ! g_hash_table_contains (cache->priv->identifiers,
+                                       GUINT_TO_POINTER (identifier_quark)))
+            {
+              gint index = rec - &g_array_index (cache->priv->records,
+                                                 GimpTagCacheRecord, 0);
 
-              rec->referenced = TRUE;
-              return;
+              g_hash_table_insert (cache->priv->identifiers,
+                                   GUINT_TO_POINTER (identifier_quark),
+                                   GUINT_TO_POINTER (index + 1));
             }
         }
     }
 
-  checksum = gimp_tagged_get_checksum (tagged);
-
-  if (checksum)
+  if (rec)
     {
-      checksum_quark = g_quark_try_string (checksum);
-      g_free (checksum);
+      for (list = rec->tags; list; list = g_list_next (list))
+        {
+          gimp_tagged_add_tag (tagged, GIMP_TAG (list->data));
+        }
+
+      rec->referenced = TRUE;
     }
+}
 
-  if (checksum_quark)
-    {
-      for (i = 0; i < cache->priv->records->len; i++)
-        {
-          GimpTagCacheRecord *rec = &g_array_index (cache->priv->records,
-                                                    GimpTagCacheRecord, i);
+/*  the first record for a quark wins, like it did when the records
+ *  were searched in order
+ */
+static void
+gimp_tag_cache_index_records (GimpTagCache *cache)
+{
+  gint i;
 
-          if (rec->checksum == checksum_quark)
-            {
-#if DEBUG_GIMP_TAG_CACHE
-              g_printerr ("remapping identifier: %s ==> %s\n",
-                          rec->identifier ? g_quark_to_string (rec->identifier) : "(NULL)",
-                          identifier_quark ? g_quark_to_string (identifier_quark) : "(NULL)");
-#endif
+  g_hash_table_remove_all (cache->priv->identifiers);
+  g_hash_table_remove_all (cache->priv->checksums);
 
-              rec->identifier = identifier_quark;
+  for (i = 0; i < cache->priv->records->len; i++)
+    {
+      GimpTagCacheRecord *rec = &g_array_index (cache->priv->records,
+                                                GimpTagCacheRecord, i);
 
-              for (list = rec->tags; list; list = g_list_next (list))
-                {
-                  gimp_tagged_add_tag (tagged, GIMP_TAG (list->data));
-                }
+      if (rec->identifier &&
+          ! g_hash_table_contains (cache->priv->identifiers,
+                                   GUINT_TO_POINTER (rec->identifier)))
+        {
+          g_hash_table_insert (cache->priv->identifiers,
+                               GUINT_TO_POINTER (rec->identifier),
+                               GUINT_TO_POINTER (i + 1));
+        }
 
-              rec->referenced = TRUE;
-              return;
-            }
+      if (rec->checksum &&
+          ! g_hash_table_contains (cache->priv->checksums,
+                                   GUINT_TO_POINTER (rec->checksum)))
+        {
+          g_hash_table_insert (cache->priv->checksums,
+                               GUINT_TO_POINTER (rec->checksum),
+                               GUINT_TO_POINTER (i + 1));
         }
     }
+}
+
+static GimpTagCacheRecord *
+gimp_tag_cache_lookup (GimpTagCache *cache,
+                       GHashTable   *index,
+                       GQuark        quark)
+{
+  gint i = GPOINTER_TO_UINT (g_hash_table_lookup (index,
+                                                  GUINT_TO_POINTER (quark)));
+
+  if (! i)
+    return NULL;
 
+  return &g_array_index (cache->priv->records, GimpTagCacheRecord, i - 1);
 }
 
 static void
@@ -345,17 +462,16 @@ gimp_tag_cache_tagged_to_cache_record_foreach (GimpTagged  *tagged,
  * gimp_tag_cache_save:
  * @cache:      a GimpTagCache object.
  *
- * Saves tag cache to cache file.
+ * Saves tag cache to the binary cache file, and to the XML file it
+ * can be imported from.
  **/
 void
 gimp_tag_cache_save (GimpTagCache *cache)
 {
-  GString *buf;
-  GList   *saved_records;
-  GList   *iterator;
-  gchar   *filename;
-  GError  *error = NULL;
-  gint     i;
+  GList *saved_records;
+  GList *iterator;
+  gchar *filename;
+  gint   i;
 
   g_return_if_fail (GIMP_IS_TAG_CACHE (cache));
 
@@ -391,11 +507,42 @@ gimp_tag_cache_save (GimpTagCache *cache)
 
   saved_records = g_list_reverse (saved_records);
 
+  /*  write the XML first, so the binary cache isn't older than it  */
+  filename = g_build_filename (gimp_directory (), GIMP_TAG_CACHE_FILE, NULL);
+  gimp_tag_cache_save_xml (saved_records, filename);
+  g_free (filename);
+
+  filename = g_build_filename (gimp_directory (), GIMP_TAG_CACHE_BINARY_FILE,
+                               NULL);
+  gimp_tag_cache_save_binary (saved_records, filename);
+  g_free (filename);
+
+  for (iterator = saved_records;
+       iterator;
+       iterator = g_list_next (iterator))
+    {
+      GimpTagCacheRecord *cache_rec = iterator->data;
+
+      g_list_free (cache_rec->tags);
+      g_free (cache_rec);
+    }
+
+  g_list_free (saved_records);
+}
+
+static void
+gimp_tag_cache_save_xml (GList       *records,
+                         const gchar *filename)
+{
+  GString *buf;
+  GList   *iterator;
+  GError  *error = NULL;
+
   buf = g_string_new ("");
   g_string_append (buf, "<?xml version='1.0' encoding='UTF-8'?>\n");
   g_string_append (buf, "<tags>\n");
 
-  for (iterator = saved_records; iterator; iterator = g_list_next (iterator))
+  for (iterator = records; iterator; iterator = g_list_next (iterator))
     {
       GimpTagCacheRecord *cache_rec = iterator->data;
       GList              *tag_iterator;
@@ -427,52 +574,331 @@ gimp_tag_cache_save (GimpTagCache *cache)
 
   g_string_append (buf, "</tags>\n");
 
-  filename = g_build_filename (gimp_directory (), GIMP_TAG_CACHE_FILE, NULL);
-
   if (! g_file_set_contents (filename, buf->str, buf->len, &error))
     {
       g_printerr ("Error while saving tag cache: %s\n", error->message);
       g_error_free (error);
     }
 
-  g_free (filename);
-
   g_string_free (buf, TRUE);
+}
 
-  for (iterator = saved_records;
-       iterator;
-       iterator = g_list_next (iterator))
+static void
+gimp_tag_cache_append_uint32 (GString *buf,
+                              guint32  value)
+{
+  value = GUINT32_TO_BE (value);
+
+  g_string_append_len (buf, (const gchar *) &value, sizeof (value));
+}
+
+static void
+gimp_tag_cache_append_string (GString     *buf,
+                              const gchar *string)
+{
+  gsize length = string ? strlen (string) : 0;
+
+  gimp_tag_cache_append_uint32 (buf, length);
+  g_string_append_len (buf, string, length);
+}
+
+static void
+gimp_tag_cache_save_binary (GList       *records,
+                            const gchar *filename)
+{
+  GString *buf;
+  GList   *iterator;
+  GError  *error = NULL;
+
+  buf = g_string_new (GIMP_TAG_CACHE_MAGIC);
+
+  gimp_tag_cache_append_uint32 (buf, GIMP_TAG_CACHE_VERSION);
+  gimp_tag_cache_append_uint32 (buf, g_list_length (records));
+
+  for (iterator = records; iterator; iterator = g_list_next (iterator))
     {
       GimpTagCacheRecord *cache_rec = iterator->data;
+      GList              *tag_iterator;
+      guint32             n_tags    = 0;
 
-      g_list_free (cache_rec->tags);
-      g_free (cache_rec);
+      gimp_tag_cache_append_string (buf,
+                                    g_quark_to_string (cache_rec->identifier));
+      gimp_tag_cache_append_string (buf,
+                                    g_quark_to_string (cache_rec->checksum));
+
+      for (tag_iterator = cache_rec->tags;
+           tag_iterator;
+           tag_iterator = g_list_next (tag_iterator))
+        {
+          if (! gimp_tag_get_internal (GIMP_TAG (tag_iterator->data)))
+            n_tags++;
+        }
+
+      gimp_tag_cache_append_uint32 (buf, n_tags);
+
+      for (tag_iterator = cache_rec->tags;
+           tag_iterator;
+           tag_iterator = g_list_next (tag_iterator))
+        {
+          GimpTag *tag = GIMP_TAG (tag_iterator->data);
+
+          if (! gimp_tag_get_internal (tag))
+            gimp_tag_cache_append_string (buf, gimp_tag_get_name (tag));
+        }
     }
 
-  g_list_free (saved_records);
+  if (! g_file_set_contents (filename, buf->str, buf->len, &error))
+    {
+      g_printerr ("Error while saving tag cache: %s\n", error->message);
+      g_error_free (error);
+    }
+
+  g_string_free (buf, TRUE);
 }
 
 /**
  * gimp_tag_cache_load:
  * @cache:      a GimpTagCache object.
  *
- * Loads tag cache from file.
+ * Loads tag cache from the binary cache file, or imports it from the
+ * XML file if there is no binary cache, or if the XML file was
+ * changed after the binary cache was written.
  **/
 void
 gimp_tag_cache_load (GimpTagCache *cache)
 {
-  gchar                 *filename;
+  gchar    *xml_filename;
+  gchar    *binary_filename;
+  gboolean  loaded = FALSE;
+
+  g_return_if_fail (GIMP_IS_TAG_CACHE (cache));
+
+  xml_filename    = g_build_filename (gimp_directory (),
+                                      GIMP_TAG_CACHE_FILE, NULL);
+  binary_filename = g_build_filename (gimp_directory (),
+                                      GIMP_TAG_CACHE_BINARY_FILE, NULL);
+
+  if (gimp_tag_cache_binary_is_current (binary_filename, xml_filename))
+    {
+      GError *error = NULL;
+
+      loaded = gimp_tag_cache_load_binary (cache, binary_filename, &error);
+
+      if (! loaded)
+        {
+          g_printerr ("Failed to load tag cache: %s\n", error->message);
+          g_clear_error (&error);
+        }
+    }
+
+  if (! loaded)
+    gimp_tag_cache_load_xml (cache, xml_filename);
+
+  gimp_tag_cache_index_records (cache);
+
+  g_free (xml_filename);
+  g_free (binary_filename);
+}
+
+static gboolean
+gimp_tag_cache_binary_is_current (const gchar *binary_filename,
+                                  const gchar *xml_filename)
+{
+  struct stat binary_stat;
+  struct stat xml_stat;
+
+  if (g_stat (binary_filename, &binary_stat) != 0)
+    return FALSE;
+
+  if (g_stat (xml_filename, &xml_stat) != 0)
+    return TRUE;
+
+  return xml_stat.st_mtime <= binary_stat.st_mtime;
+}
+
+static void
+gimp_tag_cache_clear_records (GimpTagCache *cache)
+{
+  gint i;
+
+  for (i = 0; i < cache->priv->records->len; i++)
+    {
+      GimpTagCacheRecord *rec = &g_array_index (cache->priv->records,
+                                                GimpTagCacheRecord, i);
+
+      g_list_free_full (rec->tags, (GDestroyNotify) g_object_unref);
+    }
+
+  cache->priv->records = g_array_set_size (cache->priv->records, 0);
+}
+
+static gboolean
+gimp_tag_cache_read_uint32 (const guchar **data,
+                            const guchar  *end,
+                            guint32       *value)
+{
+  if (end - *data < sizeof (guint32))
+    return FALSE;
+
+  memcpy (value, *data, sizeof (guint32));
+  *value = GUINT32_FROM_BE (*value);
+
+  *data += sizeof (guint32);
+
+  return TRUE;
+}
+
+/*  returns a newly allocated copy of the string, or NULL for an empty
+ *  one; sets *valid to FALSE if the string runs past the end
+ */
+static gchar *
+gimp_tag_cache_read_string (const guchar **data,
+                            const guchar  *end,
+                            gboolean      *valid)
+{
+  guint32  length;
+  gchar   *string;
+
+  if (! gimp_tag_cache_read_uint32 (data, end, &length) ||
+      end - *data < length)
+    {
+      *valid = FALSE;
+      return NULL;
+    }
+
+  if (length == 0)
+    return NULL;
+
+  string = g_strndup ((const gchar *) *data, length);
+
+  *data += length;
+
+  return string;
+}
+
+static gboolean
+gimp_tag_cache_load_binary (GimpTagCache  *cache,
+                            const gchar   *filename,
+                            GError       **error)
+{
+  gchar        *contents;
+  gsize         length;
+  const guchar *data;
+  const guchar *end;
+  guint32       version;
+  guint32       n_records;
+  gboolean      valid = TRUE;
+  guint32       i;
+
+  if (! g_file_get_contents (filename, &contents, &length, error))
+    return FALSE;
+
+  data = (const guchar *) contents;
+  end  = data + length;
+
+  if (length < strlen (GIMP_TAG_CACHE_MAGIC) ||
+      memcmp (data, GIMP_TAG_CACHE_MAGIC, strlen (GIMP_TAG_CACHE_MAGIC)))
+    {
+      g_set_error (error, gimp_tag_cache_get_error_domain (), 1003,
+                   "'%s' is not a tag cache file.",
+                   gimp_filename_to_utf8 (filename));
+      g_free (contents);
+      return FALSE;
+    }
+
+  data += strlen (GIMP_TAG_CACHE_MAGIC);
+
+  if (! gimp_tag_cache_read_uint32 (&data, end, &version) ||
+      version != GIMP_TAG_CACHE_VERSION)
+    {
+      g_set_error (error, gimp_tag_cache_get_error_domain (), 1004,
+                   "Unknown version of tag cache file '%s'.",
+                   gimp_filename_to_utf8 (filename));
+      g_free (contents);
+      return FALSE;
+    }
+
+  gimp_tag_cache_clear_records (cache);
+
+  if (! gimp_tag_cache_read_uint32 (&data, end, &n_records))
+    valid = FALSE;
+
+  for (i = 0; valid && i < n_records; i++)
+    {
+      GimpTagCacheRecord  rec = { 0, };
+      gchar              *identifier;
+      gchar              *checksum;
+      guint32             n_tags;
+      guint32             j;
+
+      identifier = gimp_tag_cache_read_string (&data, end, &valid);
+      checksum   = gimp_tag_cache_read_string (&data, end, &valid);
+
+      rec.identifier = g_quark_from_string (identifier);
+      rec.checksum   = g_quark_from_string (checksum);
+
+      g_free (identifier);
+      g_free (checksum);
+
+      if (! valid || ! gimp_tag_cache_read_uint32 (&data, end, &n_tags))
+        {
+          valid = FALSE;
+          break;
+        }
+
+      for (j = 0; valid && j < n_tags; j++)
+        {
+          gchar   *name = gimp_tag_cache_read_string (&data, end, &valid);
+          GimpTag *tag  = NULL;
+
+          if (name)
+            tag = gimp_tag_new (name);
+
+          if (tag)
+            {
+              rec.tags = g_list_prepend (rec.tags, tag);
+            }
+          else if (valid)
+            {
+              g_warning ("dropping invalid tag '%s' from '%s'\n",
+                         name ? name : "",
+                         g_quark_to_string (rec.identifier));
+            }
+
+          g_free (name);
+        }
+
+      rec.tags = g_list_reverse (rec.tags);
+
+      cache->priv->records = g_array_append_val (cache->priv->records, rec);
+    }
+
+  g_free (contents);
+
+  if (! valid || data != end)
+    {
+      gimp_tag_cache_clear_records (cache);
+
+      g_set_error (error, gimp_tag_cache_get_error_domain (), 1005,
+                   "Tag cache file '%s' is corrupt.",
+                   gimp_filename_to_utf8 (filename));
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+static void
+gimp_tag_cache_load_xml (GimpTagCache *cache,
+                         const gchar  *filename)
+{
   GError                *error = NULL;
   GMarkupParser          markup_parser;
   GimpXmlParser         *xml_parser;
   GimpTagCacheParseData  parse_data;
 
-  g_return_if_fail (GIMP_IS_TAG_CACHE (cache));
-
   /* clear any previous priv->records */
-  cache->priv->records = g_array_set_size (cache->priv->records, 0);
-
-  filename = g_build_filename (gimp_directory (), GIMP_TAG_CACHE_FILE, NULL);
+  gimp_tag_cache_clear_records (cache);
 
   parse_data.records = g_array_new (FALSE, FALSE, sizeof (GimpTagCacheRecord));
   memset (&parse_data.current_record, 0, sizeof (GimpTagCacheRecord));
@@ -497,7 +923,6 @@ gimp_tag_cache_load (GimpTagCache *cache)
                   error ? error->message : NULL);
     }
 
-  g_free (filename);
   gimp_xml_parser_free (xml_parser);
   g_array_free (parse_data.records, TRUE);
 }
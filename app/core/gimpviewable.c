@@ -273,17 +273,7 @@ static gint64
 gimp_viewable_get_memsize (GimpObject *object,
                            gint64     *gui_size)
 {
-  GimpViewablePrivate *private = GET_PRIVATE (object);
-
-  *gui_size += gimp_temp_buf_get_memsize (private->preview_temp_buf);
-
-  if (private->preview_pixbuf)
-    {
-      *gui_size +=
-        (gimp_g_object_get_memsize (G_OBJECT (private->preview_pixbuf)) +
-         (gsize) gdk_pixbuf_get_height (private->preview_pixbuf) *
-         gdk_pixbuf_get_rowstride (private->preview_pixbuf));
-    }
+  *gui_size += gimp_viewable_get_preview_memsize (GIMP_VIEWABLE (object));
 
   return GIMP_OBJECT_CLASS (parent_class)->get_memsize (object, gui_size);
 }
@@ -1005,6 +995,38 @@ gimp_viewable_get_dummy_pixbuf (GimpViewable  *viewable,
   return pixbuf;
 }
 
+/**
+ * gimp_viewable_get_preview_memsize:
+ * @viewable: a #GimpViewable
+ *
+ * Returns the memory used by the cached preview of @viewable alone,
+ * not including the previews of its children.
+ *
+ * Return value: the size of the cached preview in bytes.
+ **/
+gint64
+gimp_viewable_get_preview_memsize (GimpViewable *viewable)
+{
+  GimpViewablePrivate *private;
+  gint64               memsize = 0;
+
+  g_return_val_if_fail (GIMP_IS_VIEWABLE (viewable), 0);
+
+  private = GET_PRIVATE (viewable);
+
+  memsize += gimp_temp_buf_get_memsize (private->preview_temp_buf);
+
+  if (private->preview_pixbuf)
+    {
+      memsize +=
+        (gimp_g_object_get_memsize (G_OBJECT (private->preview_pixbuf)) +
+         (gsize) gdk_pixbuf_get_height (private->preview_pixbuf) *
+         gdk_pixbuf_get_rowstride (private->preview_pixbuf));
+    }
+
+  return memsize;
+}
+
 /**
  * gimp_viewable_get_description:
  * @viewable: viewable object for which to retrieve a description.
@@ -164,6 +164,8 @@ GdkPixbuf     * gimp_viewable_get_dummy_pixbuf   (GimpViewable  *viewable,
                                                   gint           height,
                                                   gboolean       with_alpha);
 
+gint64          gimp_viewable_get_preview_memsize (GimpViewable *viewable);
+
 gchar         * gimp_viewable_get_description    (GimpViewable  *viewable,
                                                   gchar        **tooltip);
 
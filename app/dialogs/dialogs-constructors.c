@@ -48,6 +48,7 @@
 #include "widgets/gimphistogrameditor.h"
 #include "widgets/gimpimageview.h"
 #include "widgets/gimplayertreeview.h"
+#include "widgets/gimpmemoryeditor.h"
 #include "widgets/gimpmenudock.h"
 #include "widgets/gimppaletteeditor.h"
 #include "widgets/gimppatternfactoryview.h"
@@ -706,6 +707,15 @@ dialogs_sample_point_editor_new (GimpDialogFactory *factory,
   return gimp_sample_point_editor_new (gimp_dialog_factory_get_menu_factory (factory));
 }
 
+GtkWidget *
+dialogs_memory_editor_new (GimpDialogFactory *factory,
+                           GimpContext       *context,
+                           GimpUIManager     *ui_manager,
+                           gint               view_size)
+{
+  return gimp_memory_editor_new ();
+}
+
 
 /*****  display related dialogs  *****/
 
@@ -246,6 +246,10 @@ GtkWidget * dialogs_sample_point_editor_new(GimpDialogFactory *factory,
                                             GimpContext       *context,
                                             GimpUIManager     *ui_manager,
                                             gint               view_size);
+GtkWidget * dialogs_memory_editor_new      (GimpDialogFactory *factory,
+                                            GimpContext       *context,
+                                            GimpUIManager     *ui_manager,
+                                            gint               view_size);
 
 GtkWidget * dialogs_navigation_editor_new  (GimpDialogFactory *factory,
                                             GimpContext       *context,
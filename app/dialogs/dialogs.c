@@ -375,6 +375,10 @@ static const GimpDialogFactoryEntry entries[] =
             N_("Sample Points"), N_("Sample Points"), GIMP_STOCK_SAMPLE_POINT,
             GIMP_HELP_SAMPLE_POINT_DIALOG,
             dialogs_sample_point_editor_new, 0, FALSE),
+  DOCKABLE ("gimp-memory-editor",
+            N_("Memory"), N_("Memory Usage"), GIMP_STOCK_INFO,
+            GIMP_HELP_MEMORY_DIALOG,
+            dialogs_memory_editor_new, 0, FALSE),
 
   /*  display related  */
   DOCKABLE ("gimp-navigation-view",
@@ -42,6 +42,8 @@
 #include "gimpdisplayshell-render.h"
 #include "gimpdisplayshell-scroll.h"
 
+#include "gimp-trace.h"
+
 
 void
 gimp_display_shell_render (GimpDisplayShell *shell,
@@ -63,6 +65,8 @@ gimp_display_shell_render (GimpDisplayShell *shell,
   g_return_if_fail (cr != NULL);
   g_return_if_fail (w > 0 && h > 0);
 
+  GIMP_TRACE_BEGIN ("gimp_display_shell_render");
+
   image      = gimp_display_get_image (shell->display);
   projection = gimp_image_get_projection (image);
   buffer     = gimp_pickable_get_buffer (GIMP_PICKABLE (projection));
@@ -149,4 +153,6 @@ gimp_display_shell_render (GimpDisplayShell *shell,
 #endif
 
   cairo_restore (cr);
+
+  GIMP_TRACE_END ("gimp_display_shell_render");
 }
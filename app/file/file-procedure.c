@@ -49,6 +49,13 @@
 #include "gimp-intl.h"
 
 
+/*  the number of procedure lists indices are kept for, list heads
+ *  change while procedures are registered and old ones are dropped
+ *  once this many piled up
+ */
+#define FILE_PROCEDURE_MAX_INDICES 8
+
+
 typedef enum
 {
   FILE_MATCH_NONE,
@@ -57,32 +64,97 @@ typedef enum
 } FileMatchType;
 
 
+typedef struct _FileMagic           FileMagic;
+typedef struct _FileProcedureMagics FileProcedureMagics;
+typedef struct _FileProcedureIndex  FileProcedureIndex;
+
+/*  a single "offset,type,value" test, parsed once  */
+struct _FileMagic
+{
+  gboolean  valid;     /*  FALSE if the test can never match       */
+  gboolean  and;       /*  ANDed with the following test           */
+  glong     offset;
+  gint      numbytes;  /*  1, 2, 4, 5 for the file size, 0 for strings  */
+  gchar     num_test;  /*  '=', '<' or '>'                         */
+  gboolean  has_mask;
+  gulong    mask;
+  gulong    value;
+  gchar    *string;
+  gint      string_len;
+};
+
+struct _FileProcedureMagics
+{
+  GimpPlugInProcedure *proc;
+  FileMagic           *magics;
+  gint                 n_magics;
+};
+
+/*  what file_procedure_find() needs to know about a list of procedures,
+ *  rebuilt whenever the list or one of its procedures changes
+ */
+struct _FileProcedureIndex
+{
+  gint                  n_procs;
+  GimpPlugInProcedure **procs;
+  guint                *stamps;
+
+  gint                  n_magic_procs;
+  FileProcedureMagics  *magic_procs;
+
+  /*  ascending indices into magic_procs, of the procedures which can
+   *  only match files starting with a given byte, and of all others
+   */
+  GArray               *by_first_byte[256];
+  GArray               *any_first_byte;
+
+  /*  lowercase extension -> first procedure registering it  */
+  GHashTable           *extensions;
+  GHashTable           *magicless_extensions;
+};
+
+
 /*  local function prototypes  */
 
-static GimpPlugInProcedure * file_proc_find_by_prefix    (GSList       *procs,
-                                                          const gchar  *uri,
-                                                          gboolean      skip_magic);
-static GimpPlugInProcedure * file_proc_find_by_extension (GSList       *procs,
-                                                          const gchar  *uri,
-                                                          gboolean      skip_magic);
-static GimpPlugInProcedure * file_proc_find_by_name      (GSList       *procs,
-                                                          const gchar  *uri,
-                                                          gboolean      skip_magic);
-
-static void                  file_convert_string         (const gchar  *instr,
-                                                          gchar        *outmem,
-                                                          gint          maxmem,
-                                                          gint         *nmem);
-static FileMatchType         file_check_single_magic     (const gchar  *offset,
-                                                          const gchar  *type,
-                                                          const gchar  *value,
-                                                          const guchar *file_head,
-                                                          gint          headsize,
-                                                          FILE         *ifp);
-static FileMatchType         file_check_magic_list       (GSList       *magics_list,
-                                                          const guchar *head,
-                                                          gint          headsize,
-                                                          FILE         *ifp);
+static GimpPlugInProcedure * file_proc_find_by_prefix        (GSList              *procs,
+                                                              const gchar         *uri,
+                                                              gboolean             skip_magic);
+static GimpPlugInProcedure * file_proc_find_by_extension     (FileProcedureIndex  *index,
+                                                              const gchar         *uri,
+                                                              gboolean             skip_magic);
+static GimpPlugInProcedure * file_proc_find_by_name          (FileProcedureIndex  *index,
+                                                              GSList              *procs,
+                                                              const gchar         *uri,
+                                                              gboolean             skip_magic);
+
+static FileProcedureIndex  * file_procedure_index_get        (GSList              *procs);
+static FileProcedureIndex  * file_procedure_index_new        (GSList              *procs);
+static void                  file_procedure_index_free       (FileProcedureIndex  *index);
+static gboolean              file_procedure_index_is_valid   (FileProcedureIndex  *index,
+                                                              GSList              *procs);
+static void                  file_procedure_index_add_magics (FileProcedureIndex  *index,
+                                                              GimpPlugInProcedure *proc);
+
+static void                  file_convert_string             (const gchar         *instr,
+                                                              gchar               *outmem,
+                                                              gint                 maxmem,
+                                                              gint                *nmem);
+static void                  file_compile_single_magic       (FileMagic           *magic,
+                                                              const gchar         *offset,
+                                                              const gchar         *type,
+                                                              const gchar         *value);
+static gint                  file_single_magic_first_byte    (const FileMagic     *magic);
+static FileMatchType         file_check_single_magic         (const FileMagic     *magic,
+                                                              const guchar        *file_head,
+                                                              gint                 headsize,
+                                                              FILE                *ifp);
+static FileMatchType         file_check_magics               (FileProcedureMagics *magics,
+                                                              const guchar        *head,
+                                                              gint                 headsize,
+                                                              FILE                *ifp);
+
+
+static GHashTable *file_procedure_indices = NULL;
 
 
 /*  public functions  */
@@ -93,72 +165,85 @@ file_procedure_find (GSList       *procs,
                      GError      **error)
 {
   GimpPlugInProcedure *file_proc;
-  GSList              *all_procs = procs;
+  FileProcedureIndex  *index;
   gchar               *filename;
 
   g_return_val_if_fail (procs != NULL, NULL);
   g_return_val_if_fail (uri != NULL, NULL);
   g_return_val_if_fail (error == NULL || *error == NULL, NULL);
 
+  index = file_procedure_index_get (procs);
+
   /* First, check magicless prefixes/suffixes */
-  file_proc = file_proc_find_by_name (all_procs, uri, TRUE);
+  file_proc = file_proc_find_by_name (index, procs, uri, TRUE);
 
   if (file_proc)
     return file_proc;
 
   filename = file_utils_filename_from_uri (uri);
 
-  /* Then look for magics */
-  if (filename)
+  /* Then look for magics, reading the file's head only once and
+   * only trying the procedures whose magics can match its first byte
+   */
+  if (filename && index->n_magic_procs > 0)
     {
       GimpPlugInProcedure *size_matched_proc = NULL;
       FILE                *ifp               = NULL;
-      gboolean             opened            = FALSE;
       gint                 head_size         = 0;
       gint                 size_match_count  = 0;
       guchar               head[256];
 
-      while (procs)
+      ifp = g_fopen (filename, "rb");
+
+      if (ifp != NULL)
+        head_size = fread ((gchar *) head, 1, sizeof (head), ifp);
+      else
+        g_set_error_literal (error,
+                             G_FILE_ERROR,
+                             g_file_error_from_errno (errno),
+                             g_strerror (errno));
+
+      if (head_size >= 4)
         {
-          file_proc = procs->data;
-          procs = procs->next;
+          GArray *keyed = index->by_first_byte[head[0]];
+          GArray *any   = index->any_first_byte;
+          guint   k     = 0;
+          guint   a     = 0;
 
-          if (file_proc->magics_list)
+          /*  merge both candidate lists, keeping the procedures' order  */
+          while ((keyed && k < keyed->len) || a < any->len)
             {
-              if (G_UNLIKELY (!opened))
+              FileProcedureMagics *magics;
+              FileMatchType        match_val;
+              gint                 i;
+
+              if (keyed && k < keyed->len &&
+                  (a >= any->len ||
+                   g_array_index (keyed, gint, k) < g_array_index (any, gint, a)))
+                {
+                  i = g_array_index (keyed, gint, k++);
+                }
+              else
                 {
-                  ifp = g_fopen (filename, "rb");
-                  if (ifp != NULL)
-                    head_size = fread ((gchar *) head, 1, sizeof (head), ifp);
-                  else
-                    g_set_error_literal (error,
-                                         G_FILE_ERROR,
-                                         g_file_error_from_errno (errno),
-                                         g_strerror (errno));
-                  opened = TRUE;
+                  i = g_array_index (any, gint, a++);
                 }
 
-              if (head_size >= 4)
+              magics = &index->magic_procs[i];
+
+              match_val = file_check_magics (magics, head, head_size, ifp);
+
+              if (match_val == FILE_MATCH_SIZE)
                 {
-                  FileMatchType match_val;
-
-                  match_val = file_check_magic_list (file_proc->magics_list,
-                                                     head, head_size,
-                                                     ifp);
-
-                  if (match_val == FILE_MATCH_SIZE)
-                    {
-                      /* Use it only if no other magic matches */
-                      size_match_count++;
-                      size_matched_proc = file_proc;
-                    }
-                  else if (match_val != FILE_MATCH_NONE)
-                    {
-                      fclose (ifp);
-                      g_free (filename);
-
-                      return file_proc;
-                    }
+                  /* Use it only if no other magic matches */
+                  size_match_count++;
+                  size_matched_proc = magics->proc;
+                }
+              else if (match_val != FILE_MATCH_NONE)
+                {
+                  fclose (ifp);
+                  g_free (filename);
+
+                  return magics->proc;
                 }
             }
         }
@@ -178,9 +263,13 @@ file_procedure_find (GSList       *procs,
       if (size_match_count == 1)
         return size_matched_proc;
     }
+  else
+    {
+      g_free (filename);
+    }
 
   /* As a last resort, try matching by name */
-  file_proc = file_proc_find_by_name (all_procs, uri, FALSE);
+  file_proc = file_proc_find_by_name (index, procs, uri, FALSE);
 
   if (file_proc)
     {
@@ -213,7 +302,8 @@ file_procedure_find_by_extension (GSList      *procs,
 {
   g_return_val_if_fail (uri != NULL, NULL);
 
-  return file_proc_find_by_extension (procs, uri, FALSE);
+  return file_proc_find_by_extension (file_procedure_index_get (procs),
+                                      uri, FALSE);
 }
 
 gboolean
@@ -283,65 +373,264 @@ file_proc_find_by_prefix (GSList      *procs,
 }
 
 static GimpPlugInProcedure *
-file_proc_find_by_extension (GSList      *procs,
-                             const gchar *uri,
-                             gboolean     skip_magic)
+file_proc_find_by_extension (FileProcedureIndex *index,
+                             const gchar        *uri,
+                             gboolean            skip_magic)
 {
-  GSList      *p;
-  const gchar *ext;
+  GimpPlugInProcedure *proc = NULL;
+  const gchar         *ext;
+
+  if (! index)
+    return NULL;
 
   ext = strrchr (uri, '.');
 
   if (ext)
-    ext++;
+    {
+      gchar *lower = g_ascii_strdown (ext + 1, -1);
 
-  for (p = procs; p; p = g_slist_next (p))
+      proc = g_hash_table_lookup (skip_magic ?
+                                  index->magicless_extensions :
+                                  index->extensions,
+                                  lower);
+
+      g_free (lower);
+    }
+
+  return proc;
+}
+
+static GimpPlugInProcedure *
+file_proc_find_by_name (FileProcedureIndex *index,
+                        GSList             *procs,
+                        const gchar        *uri,
+                        gboolean            skip_magic)
+{
+  GimpPlugInProcedure *proc;
+
+  proc = file_proc_find_by_prefix (procs, uri, skip_magic);
+
+  if (! proc)
+    proc = file_proc_find_by_extension (index, uri, skip_magic);
+
+  return proc;
+}
+
+static FileProcedureIndex *
+file_procedure_index_get (GSList *procs)
+{
+  FileProcedureIndex *index;
+
+  if (! procs)
+    return NULL;
+
+  if (! file_procedure_indices)
+    file_procedure_indices =
+      g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL,
+                             (GDestroyNotify) file_procedure_index_free);
+
+  index = g_hash_table_lookup (file_procedure_indices, procs);
+
+  if (index && file_procedure_index_is_valid (index, procs))
+    return index;
+
+  if (! index &&
+      g_hash_table_size (file_procedure_indices) >= FILE_PROCEDURE_MAX_INDICES)
+    g_hash_table_remove_all (file_procedure_indices);
+
+  index = file_procedure_index_new (procs);
+
+  g_hash_table_insert (file_procedure_indices, procs, index);
+
+  return index;
+}
+
+static FileProcedureIndex *
+file_procedure_index_new (GSList *procs)
+{
+  FileProcedureIndex *index = g_slice_new0 (FileProcedureIndex);
+  GSList             *list;
+  gint                i;
+
+  index->n_procs = g_slist_length (procs);
+  index->procs   = g_new (GimpPlugInProcedure *, index->n_procs);
+  index->stamps  = g_new (guint, index->n_procs);
+
+  /*  room for all, only the ones with magics are used  */
+  index->magic_procs = g_new0 (FileProcedureMagics, index->n_procs);
+
+  index->any_first_byte = g_array_new (FALSE, FALSE, sizeof (gint));
+
+  index->extensions =
+    g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  index->magicless_extensions =
+    g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+  for (list = procs, i = 0; list; list = g_slist_next (list), i++)
     {
-      GimpPlugInProcedure *proc = p->data;
+      GimpPlugInProcedure *proc = list->data;
       GSList              *extensions;
 
+      index->procs[i]  = proc;
+      index->stamps[i] = proc->file_proc_stamp;
+
+      if (proc->magics_list)
+        file_procedure_index_add_magics (index, proc);
+
       for (extensions = proc->extensions_list;
-           ext && extensions;
+           extensions;
            extensions = g_slist_next (extensions))
         {
-          const gchar *p1 = ext;
-          const gchar *p2 = extensions->data;
-
-          if (skip_magic && proc->magics_list)
-            continue;
+          gchar *ext = g_ascii_strdown (extensions->data, -1);
 
-          while (*p1 && *p2)
-            {
-              if (g_ascii_tolower (*p1) != g_ascii_tolower (*p2))
-                break;
+          /*  the first procedure in the list wins  */
+          if (! g_hash_table_contains (index->extensions, ext))
+            g_hash_table_insert (index->extensions, g_strdup (ext), proc);
 
-              p1++;
-              p2++;
-            }
+          if (! proc->magics_list &&
+              ! g_hash_table_contains (index->magicless_extensions, ext))
+            g_hash_table_insert (index->magicless_extensions,
+                                 g_strdup (ext), proc);
 
-          if (!(*p1) && !(*p2))
-            return proc;
+          g_free (ext);
         }
     }
 
-  return NULL;
+  return index;
 }
 
-static GimpPlugInProcedure *
-file_proc_find_by_name (GSList      *procs,
-                        const gchar *uri,
-                        gboolean     skip_magic)
+static void
+file_procedure_index_free (FileProcedureIndex *index)
 {
-  GimpPlugInProcedure *proc;
+  gint i, j;
 
-  proc = file_proc_find_by_prefix (procs, uri, skip_magic);
+  for (i = 0; i < index->n_magic_procs; i++)
+    {
+      FileProcedureMagics *magics = &index->magic_procs[i];
 
-  if (! proc)
-    proc = file_proc_find_by_extension (procs, uri, skip_magic);
+      for (j = 0; j < magics->n_magics; j++)
+        g_free (magics->magics[j].string);
 
-  return proc;
+      g_free (magics->magics);
+    }
+
+  for (i = 0; i < G_N_ELEMENTS (index->by_first_byte); i++)
+    if (index->by_first_byte[i])
+      g_array_free (index->by_first_byte[i], TRUE);
+
+  g_array_free (index->any_first_byte, TRUE);
+
+  g_hash_table_unref (index->extensions);
+  g_hash_table_unref (index->magicless_extensions);
+
+  g_free (index->magic_procs);
+  g_free (index->stamps);
+  g_free (index->procs);
+
+  g_slice_free (FileProcedureIndex, index);
+}
+
+/*  the index is up to date if the list holds the same procedures, in
+ *  the same order, and none of them changed its file info since
+ */
+static gboolean
+file_procedure_index_is_valid (FileProcedureIndex *index,
+                               GSList             *procs)
+{
+  GSList *list;
+  gint    i;
+
+  for (list = procs, i = 0; list; list = g_slist_next (list), i++)
+    {
+      GimpPlugInProcedure *proc = list->data;
+
+      if (i >= index->n_procs          ||
+          index->procs[i]  != proc     ||
+          index->stamps[i] != proc->file_proc_stamp)
+        return FALSE;
+    }
+
+  return (i == index->n_procs);
 }
 
+static void
+file_procedure_index_add_magics (FileProcedureIndex  *index,
+                                 GimpPlugInProcedure *proc)
+{
+  FileProcedureMagics *magics;
+  GArray              *array;
+  GSList              *magics_list;
+  gboolean             first_bytes[256] = { FALSE, };
+  gboolean             any_first_byte   = FALSE;
+  gint                 chain_first_byte = -1;
+  gint                 i;
+
+  array = g_array_new (FALSE, TRUE, sizeof (FileMagic));
+
+  for (magics_list = proc->magics_list; magics_list; )
+    {
+      const gchar *offset;
+      const gchar *type;
+      const gchar *value;
+      FileMagic    magic = { 0, };
+
+      if ((offset      = magics_list->data) == NULL) break;
+      if ((magics_list = magics_list->next) == NULL) break;
+      if ((type        = magics_list->data) == NULL) break;
+      if ((magics_list = magics_list->next) == NULL) break;
+      if ((value       = magics_list->data) == NULL) break;
+
+      magics_list = magics_list->next;
+
+      file_compile_single_magic (&magic, offset, type, value);
+
+      g_array_append_val (array, magic);
+
+      /*  a chain of ANDed tests can only match files starting with
+       *  the first byte one of its tests requires
+       */
+      if (chain_first_byte < 0)
+        chain_first_byte = file_single_magic_first_byte (&magic);
+
+      if (! magic.and)
+        {
+          if (chain_first_byte < 0)
+            any_first_byte = TRUE;
+          else
+            first_bytes[chain_first_byte] = TRUE;
+
+          chain_first_byte = -1;
+        }
+    }
+
+  magics = &index->magic_procs[index->n_magic_procs];
+
+  magics->proc     = proc;
+  magics->n_magics = array->len;
+  magics->magics   = (FileMagic *) g_array_free (array, FALSE);
+
+  if (any_first_byte)
+    {
+      g_array_append_val (index->any_first_byte, index->n_magic_procs);
+    }
+  else
+    {
+      for (i = 0; i < G_N_ELEMENTS (first_bytes); i++)
+        {
+          if (! first_bytes[i])
+            continue;
+
+          if (! index->by_first_byte[i])
+            index->by_first_byte[i] = g_array_new (FALSE, FALSE,
+                                                   sizeof (gint));
+
+          g_array_append_val (index->by_first_byte[i],
+                              index->n_magic_procs);
+        }
+    }
+
+  index->n_magic_procs++;
+}
 
 static void
 file_convert_string (const gchar *instr,
@@ -400,57 +689,48 @@ file_convert_string (const gchar *instr,
   *nmem = ((gchar *) uout) - outmem;
 }
 
-static FileMatchType
-file_check_single_magic (const gchar  *offset,
-                         const gchar  *type,
-                         const gchar  *value,
-                         const guchar *file_head,
-                         gint          headsize,
-                         FILE         *ifp)
-
+static void
+file_compile_single_magic (FileMagic   *magic,
+                           const gchar *offset,
+                           const gchar *type,
+                           const gchar *value)
 {
-  FileMatchType found = FILE_MATCH_NONE;
-  glong         offs;
-  gulong        num_testval;
-  gulong        num_operatorval;
-  gint          numbytes, k;
-  const gchar  *num_operator_ptr;
-  gchar         num_operator;
+  const gchar *num_operator_ptr = NULL;
+
+  magic->and      = (strchr (offset, '&') != NULL);
+  magic->num_test = '=';
 
   /* Check offset */
-  if (sscanf (offset, "%ld", &offs) != 1)
-    return FILE_MATCH_NONE;
+  if (sscanf (offset, "%ld", &magic->offset) != 1)
+    return;
 
   /* Check type of test */
-  num_operator_ptr = NULL;
-  num_operator     = '\0';
-
   if (g_str_has_prefix (type, "byte"))
     {
-      numbytes = 1;
+      magic->numbytes = 1;
       num_operator_ptr = type + strlen ("byte");
     }
   else if (g_str_has_prefix (type, "short"))
     {
-      numbytes = 2;
+      magic->numbytes = 2;
       num_operator_ptr = type + strlen ("short");
     }
   else if (g_str_has_prefix (type, "long"))
     {
-      numbytes = 4;
+      magic->numbytes = 4;
       num_operator_ptr = type + strlen ("long");
     }
   else if (g_str_has_prefix (type, "size"))
     {
-      numbytes = 5;
+      magic->numbytes = 5;
     }
   else if (strcmp (type, "string") == 0)
     {
-      numbytes = 0;
+      magic->numbytes = 0;
     }
   else
     {
-      return FILE_MATCH_NONE;
+      return;
     }
 
   /* Check numerical operator value if present */
@@ -458,6 +738,8 @@ file_check_single_magic (const gchar  *offset,
     {
       if (g_ascii_isdigit (num_operator_ptr[1]))
         {
+          gulong num_operatorval = 0;
+
           if (num_operator_ptr[1] != '0')      /* decimal */
             sscanf (num_operator_ptr+1, "%lu", &num_operatorval);
           else if (num_operator_ptr[2] == 'x') /* hexadecimal */
@@ -465,27 +747,91 @@ file_check_single_magic (const gchar  *offset,
           else                                 /* octal */
             sscanf (num_operator_ptr+2, "%lo", &num_operatorval);
 
-          num_operator = *num_operator_ptr;
+          magic->has_mask = TRUE;
+          magic->mask     = num_operatorval;
         }
     }
 
-  if (numbytes > 0)   /* Numerical test ? */
+  if (magic->numbytes > 0)   /* Numerical test ? */
     {
-      gchar   num_test = '=';
-      gulong  fileval  = 0;
-
       /* Check test value */
       if ((value[0] == '>') || (value[0] == '<'))
         {
-          num_test = value[0];
+          magic->num_test = value[0];
           value++;
         }
 
       errno = 0;
-      num_testval = strtol (value, NULL, 0);
+      magic->value = strtol (value, NULL, 0);
 
       if (errno != 0)
-        return FILE_MATCH_NONE;
+        return;
+    }
+  else /* String test */
+    {
+      gchar mem_testval[256];
+      gint  numbytes;
+
+      file_convert_string (value,
+                           mem_testval, sizeof (mem_testval),
+                           &numbytes);
+
+      if (numbytes <= 0)
+        return;
+
+      magic->string     = g_memdup (mem_testval, numbytes);
+      magic->string_len = numbytes;
+    }
+
+  magic->valid = TRUE;
+}
+
+/*  returns the first byte of the file @magic requires, or -1  */
+static gint
+file_single_magic_first_byte (const FileMagic *magic)
+{
+  if (! magic->valid || magic->offset != 0)
+    return -1;
+
+  if (magic->numbytes == 0)
+    return (guchar) magic->string[0];
+
+  if (magic->numbytes <= 4   &&
+      magic->num_test == '=' &&
+      ! magic->has_mask)
+    {
+      gint shift = 8 * (magic->numbytes - 1);
+
+      /*  a value wider than the test never matches, don't bother  */
+      if ((magic->value >> shift) > 0xff)
+        return -1;
+
+      return (magic->value >> shift) & 0xff;
+    }
+
+  return -1;
+}
+
+static FileMatchType
+file_check_single_magic (const FileMagic *magic,
+                         const guchar    *file_head,
+                         gint             headsize,
+                         FILE            *ifp)
+
+{
+  FileMatchType found = FILE_MATCH_NONE;
+  glong         offs  = magic->offset;
+  gint          numbytes;
+  gint          k;
+
+  if (! magic->valid)
+    return FILE_MATCH_NONE;
+
+  numbytes = magic->numbytes;
+
+  if (numbytes > 0)   /* Numerical test ? */
+    {
+      gulong fileval = 0;
 
       if (numbytes == 5)    /* Check for file size ? */
         {
@@ -516,34 +862,27 @@ file_check_single_magic (const gchar  *offset,
             return FILE_MATCH_NONE;
         }
 
-      if (num_operator == '&')
-        fileval &= num_operatorval;
+      if (magic->has_mask)
+        fileval &= magic->mask;
 
-      if (num_test == '<')
-        found = (fileval < num_testval);
-      else if (num_test == '>')
-        found = (fileval > num_testval);
+      if (magic->num_test == '<')
+        found = (fileval < magic->value);
+      else if (magic->num_test == '>')
+        found = (fileval > magic->value);
       else
-        found = (fileval == num_testval);
+        found = (fileval == magic->value);
 
       if (found && (numbytes == 5))
         found = FILE_MATCH_SIZE;
     }
-  else if (numbytes == 0) /* String test */
+  else /* String test */
     {
-      gchar mem_testval[256];
-
-      file_convert_string (value,
-                           mem_testval, sizeof (mem_testval),
-                           &numbytes);
-
-      if (numbytes <= 0)
-        return FILE_MATCH_NONE;
+      numbytes = magic->string_len;
 
       if (offs >= 0 &&
           (offs + numbytes <= headsize)) /* We have it in memory ? */
         {
-          found = (memcmp (mem_testval, file_head + offs, numbytes) == 0);
+          found = (memcmp (magic->string, file_head + offs, numbytes) == 0);
         }
       else   /* Read it from file */
         {
@@ -556,7 +895,7 @@ file_check_single_magic (const gchar  *offset,
             {
               gint c = getc (ifp);
 
-              found = (c != EOF) && (c == (gint) mem_testval[k]);
+              found = (c != EOF) && (c == (gint) magic->string[k]);
             }
         }
     }
@@ -565,38 +904,33 @@ file_check_single_magic (const gchar  *offset,
 }
 
 static FileMatchType
-file_check_magic_list (GSList       *magics_list,
-                       const guchar *head,
-                       gint          headsize,
-                       FILE         *ifp)
+file_check_magics (FileProcedureMagics *magics,
+                   const guchar        *head,
+                   gint                 headsize,
+                   FILE                *ifp)
 
 {
-  const gchar   *offset;
-  const gchar   *type;
-  const gchar   *value;
-  gboolean       and   = FALSE;
-  gboolean       found = FALSE;
-  FileMatchType  match_val;
-
-  while (magics_list)
+  gboolean      and   = FALSE;
+  gboolean      found = FALSE;
+  FileMatchType match_val;
+  gint          i;
+
+  for (i = 0; i < magics->n_magics; i++)
     {
-      if ((offset      = magics_list->data) == NULL) break;
-      if ((magics_list = magics_list->next) == NULL) break;
-      if ((type        = magics_list->data) == NULL) break;
-      if ((magics_list = magics_list->next) == NULL) break;
-      if ((value       = magics_list->data) == NULL) break;
+      const FileMagic *magic = &magics->magics[i];
 
-      magics_list = magics_list->next;
+      /*  don't touch the file for a chain that failed already  */
+      if (and && ! found)
+        match_val = FILE_MATCH_NONE;
+      else
+        match_val = file_check_single_magic (magic, head, headsize, ifp);
 
-      match_val = file_check_single_magic (offset, type, value,
-                                           head, headsize,
-                                           ifp);
       if (and)
         found = found && (match_val != FILE_MATCH_NONE);
       else
         found = (match_val != FILE_MATCH_NONE);
 
-      and = (strchr (offset, '&') != NULL);
+      and = magic->and;
 
       if (! and && found)
         return match_val;
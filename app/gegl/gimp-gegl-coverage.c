@@ -0,0 +1,323 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimp-gegl-coverage.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Remembers, for the squares of a fixed grid over a buffer, whether
+ * they are fully transparent or fully opaque, so compositing can skip
+ * work that can't change its result.  A square's state is found on
+ * demand and forgotten when the square is invalidated, which the
+ * buffer's owner must do on every write, so only buffers which opted
+ * in with gimp_gegl_buffer_track_coverage() are ever answered for.
+ */
+
+#include "config.h"
+
+#include <gegl.h>
+
+#include "gimp-gegl-types.h"
+
+#include "gimp-gegl-coverage.h"
+
+
+/*  the size of the squares the coverage is kept for  */
+#define TILE_SIZE 64
+
+
+typedef enum
+{
+  COVERAGE_UNKNOWN,
+  COVERAGE_MIXED,
+  COVERAGE_TRANSPARENT,
+  COVERAGE_OPAQUE
+} GimpGeglCoverageState;
+
+typedef struct _GimpGeglCoverage GimpGeglCoverage;
+
+struct _GimpGeglCoverage
+{
+  GeglRectangle  extent;
+  gint           n_tiles_x;
+  gint           n_tiles_y;
+  guint8        *tiles;
+};
+
+
+static GimpGeglCoverage * gimp_gegl_coverage_get      (GeglBuffer          *buffer);
+static void               gimp_gegl_coverage_free     (GimpGeglCoverage    *coverage);
+static gboolean           gimp_gegl_coverage_is       (GeglBuffer          *buffer,
+                                                       GimpGeglCoverage    *coverage,
+                                                       const GeglRectangle *rect,
+                                                       guint8               state);
+static guint8             gimp_gegl_coverage_tile_get (GimpGeglCoverage    *coverage,
+                                                       GeglBuffer          *buffer,
+                                                       gint                 tile_x,
+                                                       gint                 tile_y);
+
+
+static GQuark coverage_quark = 0;
+
+
+/**
+ * gimp_gegl_buffer_track_coverage:
+ * @buffer: a #GeglBuffer
+ *
+ * Makes gimp_gegl_buffer_is_transparent() and
+ * gimp_gegl_buffer_is_opaque() answer for @buffer.  The caller
+ * promises to call gimp_gegl_buffer_invalidate_coverage() for
+ * every area of @buffer it changes afterwards.
+ **/
+void
+gimp_gegl_buffer_track_coverage (GeglBuffer *buffer)
+{
+  g_return_if_fail (GEGL_IS_BUFFER (buffer));
+
+  if (! coverage_quark)
+    coverage_quark = g_quark_from_static_string ("gimp-gegl-coverage");
+
+  if (! g_object_get_qdata (G_OBJECT (buffer), coverage_quark))
+    gimp_gegl_coverage_get (buffer);
+}
+
+/**
+ * gimp_gegl_buffer_invalidate_coverage:
+ * @buffer: a #GeglBuffer
+ * @rect:   the changed area, or %NULL for all of @buffer
+ *
+ * Forgets the coverage of all squares intersecting @rect.
+ **/
+void
+gimp_gegl_buffer_invalidate_coverage (GeglBuffer          *buffer,
+                                      const GeglRectangle *rect)
+{
+  GimpGeglCoverage *coverage;
+  GeglRectangle     area;
+  gint              tile_x, tile_y;
+
+  g_return_if_fail (GEGL_IS_BUFFER (buffer));
+
+  if (! coverage_quark)
+    return;
+
+  coverage = g_object_get_qdata (G_OBJECT (buffer), coverage_quark);
+
+  if (! coverage)
+    return;
+
+  if (! rect)
+    rect = &coverage->extent;
+
+  if (! gegl_rectangle_intersect (&area, rect, &coverage->extent))
+    return;
+
+  area.x -= coverage->extent.x;
+  area.y -= coverage->extent.y;
+
+  for (tile_y = area.y / TILE_SIZE;
+       tile_y <= (area.y + area.height - 1) / TILE_SIZE;
+       tile_y++)
+    for (tile_x = area.x / TILE_SIZE;
+         tile_x <= (area.x + area.width - 1) / TILE_SIZE;
+         tile_x++)
+      {
+        coverage->tiles[tile_y * coverage->n_tiles_x + tile_x] =
+          COVERAGE_UNKNOWN;
+      }
+}
+
+/**
+ * gimp_gegl_buffer_is_transparent:
+ * @buffer: a #GeglBuffer
+ * @rect:   the area to check
+ *
+ * Returns: %TRUE if all of @rect is known to be fully transparent,
+ *          the parts outside of @buffer's extent count as such if
+ *          @buffer has alpha.  Always %FALSE unless
+ *          gimp_gegl_buffer_track_coverage() was called for @buffer.
+ **/
+gboolean
+gimp_gegl_buffer_is_transparent (GeglBuffer          *buffer,
+                                 const GeglRectangle *rect)
+{
+  GimpGeglCoverage *coverage;
+  GeglRectangle     area;
+
+  g_return_val_if_fail (GEGL_IS_BUFFER (buffer), FALSE);
+  g_return_val_if_fail (rect != NULL, FALSE);
+
+  if (! coverage_quark ||
+      ! g_object_get_qdata (G_OBJECT (buffer), coverage_quark))
+    return FALSE;
+
+  /*  without alpha, even the abyss is opaque  */
+  if (! babl_format_has_alpha (gegl_buffer_get_format (buffer)))
+    return FALSE;
+
+  coverage = gimp_gegl_coverage_get (buffer);
+
+  if (! gegl_rectangle_intersect (&area, rect, &coverage->extent))
+    return TRUE;
+
+  return gimp_gegl_coverage_is (buffer, coverage, &area,
+                                COVERAGE_TRANSPARENT);
+}
+
+/**
+ * gimp_gegl_buffer_is_opaque:
+ * @buffer: a #GeglBuffer
+ * @rect:   the area to check
+ *
+ * Returns: %TRUE if @rect lies within @buffer's extent and all of it
+ *          is known to be fully opaque.  Always %FALSE unless
+ *          gimp_gegl_buffer_track_coverage() was called for @buffer.
+ **/
+gboolean
+gimp_gegl_buffer_is_opaque (GeglBuffer          *buffer,
+                            const GeglRectangle *rect)
+{
+  GimpGeglCoverage *coverage;
+
+  g_return_val_if_fail (GEGL_IS_BUFFER (buffer), FALSE);
+  g_return_val_if_fail (rect != NULL, FALSE);
+
+  if (! coverage_quark ||
+      ! g_object_get_qdata (G_OBJECT (buffer), coverage_quark))
+    return FALSE;
+
+  coverage = gimp_gegl_coverage_get (buffer);
+
+  if (rect->width <= 0 || rect->height <= 0 ||
+      ! gegl_rectangle_contains (&coverage->extent, rect))
+    return FALSE;
+
+  if (! babl_format_has_alpha (gegl_buffer_get_format (buffer)))
+    return TRUE;
+
+  return gimp_gegl_coverage_is (buffer, coverage, rect,
+                                COVERAGE_OPAQUE);
+}
+
+
+/*  private functions  */
+
+static GimpGeglCoverage *
+gimp_gegl_coverage_get (GeglBuffer *buffer)
+{
+  GimpGeglCoverage    *coverage;
+  const GeglRectangle *extent = gegl_buffer_get_extent (buffer);
+
+  coverage = g_object_get_qdata (G_OBJECT (buffer), coverage_quark);
+
+  if (coverage && gegl_rectangle_equal (&coverage->extent, extent))
+    return coverage;
+
+  coverage = g_slice_new0 (GimpGeglCoverage);
+
+  coverage->extent    = *extent;
+  coverage->n_tiles_x = (extent->width  + TILE_SIZE - 1) / TILE_SIZE;
+  coverage->n_tiles_y = (extent->height + TILE_SIZE - 1) / TILE_SIZE;
+  coverage->tiles     = g_new0 (guint8,
+                                coverage->n_tiles_x * coverage->n_tiles_y);
+
+  g_object_set_qdata_full (G_OBJECT (buffer), coverage_quark, coverage,
+                           (GDestroyNotify) gimp_gegl_coverage_free);
+
+  return coverage;
+}
+
+static void
+gimp_gegl_coverage_free (GimpGeglCoverage *coverage)
+{
+  g_free (coverage->tiles);
+
+  g_slice_free (GimpGeglCoverage, coverage);
+}
+
+/*  @rect must lie within the coverage's extent  */
+static gboolean
+gimp_gegl_coverage_is (GeglBuffer          *buffer,
+                       GimpGeglCoverage    *coverage,
+                       const GeglRectangle *rect,
+                       guint8               state)
+{
+  gint x1 = rect->x - coverage->extent.x;
+  gint y1 = rect->y - coverage->extent.y;
+  gint x2 = x1 + rect->width  - 1;
+  gint y2 = y1 + rect->height - 1;
+  gint tile_x, tile_y;
+
+  for (tile_y = y1 / TILE_SIZE; tile_y <= y2 / TILE_SIZE; tile_y++)
+    for (tile_x = x1 / TILE_SIZE; tile_x <= x2 / TILE_SIZE; tile_x++)
+      {
+        if (gimp_gegl_coverage_tile_get (coverage, buffer,
+                                         tile_x, tile_y) != state)
+          return FALSE;
+      }
+
+  return TRUE;
+}
+
+static guint8
+gimp_gegl_coverage_tile_get (GimpGeglCoverage *coverage,
+                             GeglBuffer       *buffer,
+                             gint              tile_x,
+                             gint              tile_y)
+{
+  guint8 *tile = &coverage->tiles[tile_y * coverage->n_tiles_x + tile_x];
+  gfloat *alpha;
+  gint    width;
+  gint    height;
+  gint    n_transparent = 0;
+  gint    n_opaque      = 0;
+  gint    i;
+
+  if (*tile != COVERAGE_UNKNOWN)
+    return *tile;
+
+  width  = MIN (TILE_SIZE, coverage->extent.width  - tile_x * TILE_SIZE);
+  height = MIN (TILE_SIZE, coverage->extent.height - tile_y * TILE_SIZE);
+
+  alpha = g_new (gfloat, width * height);
+
+  gegl_buffer_get (buffer,
+                   GEGL_RECTANGLE (coverage->extent.x + tile_x * TILE_SIZE,
+                                   coverage->extent.y + tile_y * TILE_SIZE,
+                                   width, height),
+                   1.0, babl_format ("A float"), alpha,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  for (i = 0; i < width * height; i++)
+    {
+      if (alpha[i] <= 0.0f)
+        n_transparent++;
+      else if (alpha[i] >= 1.0f)
+        n_opaque++;
+      else
+        break;
+    }
+
+  g_free (alpha);
+
+  if (n_transparent == width * height)
+    *tile = COVERAGE_TRANSPARENT;
+  else if (n_opaque == width * height)
+    *tile = COVERAGE_OPAQUE;
+  else
+    *tile = COVERAGE_MIXED;
+
+  return *tile;
+}
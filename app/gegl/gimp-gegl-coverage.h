@@ -0,0 +1,34 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimp-gegl-coverage.h
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GIMP_GEGL_COVERAGE_H__
+#define __GIMP_GEGL_COVERAGE_H__
+
+
+void       gimp_gegl_buffer_track_coverage      (GeglBuffer          *buffer);
+void       gimp_gegl_buffer_invalidate_coverage (GeglBuffer          *buffer,
+                                                 const GeglRectangle *rect);
+
+gboolean   gimp_gegl_buffer_is_transparent      (GeglBuffer          *buffer,
+                                                 const GeglRectangle *rect);
+gboolean   gimp_gegl_buffer_is_opaque           (GeglBuffer          *buffer,
+                                                 const GeglRectangle *rect);
+
+
+#endif /* __GIMP_GEGL_COVERAGE_H__ */
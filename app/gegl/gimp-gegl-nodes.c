@@ -228,6 +228,28 @@ gimp_gegl_create_apply_buffer_node (GeglBuffer           *buffer,
   return node;
 }
 
+GeglNode *
+gimp_gegl_create_scale_node (gdouble               scale_x,
+                             gdouble               scale_y,
+                             GimpInterpolationType interpolation_type)
+{
+  GeglNode *node;
+
+  node = gegl_node_new ();
+
+  gegl_node_set (node,
+                 "operation",  "gegl:scale",
+                 "origin-x",   0.0,
+                 "origin-y",   0.0,
+                 "filter",     gimp_interpolation_to_gegl_filter (interpolation_type),
+                 "hard-edges", TRUE,
+                 "x",          scale_x,
+                 "y",          scale_y,
+                 NULL);
+
+  return node;
+}
+
 GeglNode *
 gimp_gegl_add_buffer_source (GeglNode   *parent,
                              GeglBuffer *buffer,
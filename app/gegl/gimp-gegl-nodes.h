@@ -40,6 +40,9 @@ GeglNode * gimp_gegl_create_apply_buffer_node  (GeglBuffer           *buffer,
                                                 gdouble               opacity,
                                                 GimpLayerModeEffects  mode,
                                                 GimpComponentMask     affect);
+GeglNode * gimp_gegl_create_scale_node         (gdouble               scale_x,
+                                                gdouble               scale_y,
+                                                GimpInterpolationType interpolation_type);
 
 GeglNode * gimp_gegl_add_buffer_source         (GeglNode             *parent,
                                                 GeglBuffer           *buffer,
@@ -20,15 +20,46 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include <gegl.h>
+#include <gegl-buffer-backend.h>
+
+#include "libgimpcolor/gimpcolor.h"
 
 #include "gimp-gegl-types.h"
 
 #include "core/gimpprogress.h"
 
+#include "gimp-gegl-loops.h"
 #include "gimp-gegl-utils.h"
 
 
+static inline gint  gimp_gegl_tile_index       (gint        coordinate,
+                                                gint        tile_size);
+static gboolean     gimp_gegl_buffer_get_tiles (GeglBuffer *buffer,
+                                                gint       *x1,
+                                                gint       *y1,
+                                                gint       *x2,
+                                                gint       *y2,
+                                                gint64     *tile_size);
+static inline gint  gimp_gegl_mod              (gint        a,
+                                                gint        b);
+static void         gimp_gegl_fill_tile        (guchar       *data,
+                                                gint          width,
+                                                gint          height,
+                                                gint          bpp,
+                                                const guchar *pattern,
+                                                gint          pattern_width,
+                                                gint          pattern_height,
+                                                gint          phase_x,
+                                                gint          phase_y);
+static gboolean     gimp_gegl_mask_get_coverage
+                                               (GeglBuffer          *mask,
+                                                const GeglRectangle *rect,
+                                                gboolean            *opaque);
+
+
 const gchar *
 gimp_interpolation_to_gegl_filter (GimpInterpolationType interpolation)
 {
@@ -45,6 +76,25 @@ gimp_interpolation_to_gegl_filter (GimpInterpolationType interpolation)
   return "nearest";
 }
 
+/*  the sampler gegl:transform and gegl:scale use for the filter
+ *  returned by gimp_interpolation_to_gegl_filter()
+ */
+GeglSamplerType
+gimp_interpolation_to_gegl_sampler (GimpInterpolationType interpolation)
+{
+  switch (interpolation)
+    {
+    case GIMP_INTERPOLATION_NONE:    return GEGL_SAMPLER_NEAREST;
+    case GIMP_INTERPOLATION_LINEAR:  return GEGL_SAMPLER_LINEAR;
+    case GIMP_INTERPOLATION_CUBIC:   return GEGL_SAMPLER_CUBIC;
+    case GIMP_INTERPOLATION_LOHALO:  return GEGL_SAMPLER_LOHALO;
+    default:
+      break;
+    }
+
+  return GEGL_SAMPLER_NEAREST;
+}
+
 GeglColor *
 gimp_gegl_color_new (const GimpRGB *rgb)
 {
@@ -112,3 +162,607 @@ gimp_gegl_progress_connect (GeglNode     *node,
 
   g_object_unref (operation);
 }
+
+/**
+ * gimp_gegl_buffer_new_shifted:
+ * @buffer: a #GeglBuffer
+ * @rect:   the area of @buffer the new buffer shows
+ * @fill:   the color for the parts of @rect outside @buffer, or %NULL
+ *
+ * Returns a buffer of @rect's size whose pixel (x, y) is @buffer's
+ * pixel (@rect->x + x, @rect->y + y), without copying pixel data: the
+ * new buffer is a shifted view of a copy-on-write duplicate of
+ * @buffer's tiles, so writing to either buffer leaves the other one
+ * unchanged. The parts of @rect outside @buffer's extent are filled
+ * with @fill, or left transparent black if @fill is %NULL.
+ *
+ * Tiles are only shared if the duplicate's tile grid lines up with
+ * @buffer's, which is why its shift is carried over; GEGL falls back
+ * to copying pixels otherwise.
+ *
+ * Returns: a new #GeglBuffer with its extent at (0, 0).
+ **/
+GeglBuffer *
+gimp_gegl_buffer_new_shifted (GeglBuffer          *buffer,
+                              const GeglRectangle *rect,
+                              GeglColor           *fill)
+{
+  const GeglRectangle *extent;
+  GeglRectangle        bounds;
+  GeglRectangle        isect;
+  GeglBuffer          *storage;
+  GeglBuffer          *shifted;
+  gint                 shift_x;
+  gint                 shift_y;
+
+  g_return_val_if_fail (GEGL_IS_BUFFER (buffer), NULL);
+  g_return_val_if_fail (rect != NULL, NULL);
+  g_return_val_if_fail (fill == NULL || GEGL_IS_COLOR (fill), NULL);
+
+  extent = gegl_buffer_get_extent (buffer);
+
+  g_object_get (buffer,
+                "shift-x", &shift_x,
+                "shift-y", &shift_y,
+                NULL);
+
+  /*  the storage must be large enough for the whole view, writes
+   *  outside of a buffer's abyss are dropped
+   */
+  gegl_rectangle_bounding_box (&bounds, extent, rect);
+
+  storage = g_object_new (GEGL_TYPE_BUFFER,
+                          "x",       bounds.x,
+                          "y",       bounds.y,
+                          "width",   bounds.width,
+                          "height",  bounds.height,
+                          "shift-x", shift_x,
+                          "shift-y", shift_y,
+                          "format",  gegl_buffer_get_format (buffer),
+                          NULL);
+
+  if (gegl_rectangle_intersect (&isect, extent, rect))
+    gegl_buffer_copy (buffer, &isect, storage, &isect);
+
+  shifted = g_object_new (GEGL_TYPE_BUFFER,
+                          "source",  storage,
+                          "x",       0,
+                          "y",       0,
+                          "width",   rect->width,
+                          "height",  rect->height,
+                          "shift-x", rect->x,
+                          "shift-y", rect->y,
+                          NULL);
+  g_object_unref (storage);
+
+  if (fill)
+    {
+      GeglRectangle strips[4];
+      gint          n_strips = 0;
+      gint          i;
+
+      if (isect.width > 0 && isect.height > 0)
+        {
+          /*  the intersection in the new buffer's coordinates  */
+          isect.x -= rect->x;
+          isect.y -= rect->y;
+
+          /*  above, below, left and right of the intersection  */
+          gegl_rectangle_set (&strips[n_strips++],
+                              0, 0,
+                              rect->width, isect.y);
+          gegl_rectangle_set (&strips[n_strips++],
+                              0, isect.y + isect.height,
+                              rect->width,
+                              rect->height - isect.y - isect.height);
+          gegl_rectangle_set (&strips[n_strips++],
+                              0, isect.y,
+                              isect.x, isect.height);
+          gegl_rectangle_set (&strips[n_strips++],
+                              isect.x + isect.width, isect.y,
+                              rect->width - isect.x - isect.width,
+                              isect.height);
+        }
+      else
+        {
+          gegl_rectangle_set (&strips[n_strips++],
+                              0, 0, rect->width, rect->height);
+        }
+
+      for (i = 0; i < n_strips; i++)
+        if (strips[i].width > 0 && strips[i].height > 0)
+          gegl_buffer_set_color (shifted, &strips[i], fill);
+    }
+
+  return shifted;
+}
+
+/**
+ * gimp_gegl_buffer_new_fill:
+ * @rect:             the extent of the new buffer
+ * @format:           the format of the new buffer
+ * @color:            the color to fill with, or %NULL
+ * @pattern:          the pattern to fill with if @color is %NULL
+ * @pattern_offset_x: x coordinate of @pattern's origin
+ * @pattern_offset_y: y coordinate of @pattern's origin
+ * @mask:             a mask to apply to the fill, or %NULL
+ * @mask_offset_x:    x coordinate of the buffer's origin in @mask
+ * @mask_offset_y:    y coordinate of the buffer's origin in @mask
+ *
+ * Returns a buffer filled the way gegl_buffer_set_color() or
+ * gegl_buffer_set_pattern() would fill it, with its alpha multiplied
+ * by @mask if one is given.
+ *
+ * Only one tile is filled for every phase of the pattern, just one
+ * for a color, and it is shared copy-on-write by all tiles starting
+ * at that phase. Tiles where @mask is empty are left out, and only
+ * tiles where @mask is partially opaque get pixels of their own.
+ *
+ * Returns: a new #GeglBuffer.
+ **/
+GeglBuffer *
+gimp_gegl_buffer_new_fill (const GeglRectangle *rect,
+                           const Babl          *format,
+                           const GimpRGB       *color,
+                           GeglBuffer          *pattern,
+                           gint                 pattern_offset_x,
+                           gint                 pattern_offset_y,
+                           GeglBuffer          *mask,
+                           gint                 mask_offset_x,
+                           gint                 mask_offset_y)
+{
+  GeglBuffer *buffer;
+  GHashTable *tiles;
+  guchar     *pixels;
+  gint        pattern_width  = 1;
+  gint        pattern_height = 1;
+  gint        tile_width;
+  gint        tile_height;
+  gint        shift_x;
+  gint        shift_y;
+  gint        bpp;
+  gint        x1, y1;
+  gint        x2, y2;
+  gint        x, y;
+
+  g_return_val_if_fail (rect != NULL, NULL);
+  g_return_val_if_fail (format != NULL, NULL);
+  g_return_val_if_fail (color != NULL || GEGL_IS_BUFFER (pattern), NULL);
+  g_return_val_if_fail (mask == NULL || GEGL_IS_BUFFER (mask), NULL);
+
+  buffer = gegl_buffer_new (rect, format);
+
+  if (rect->width < 1 || rect->height < 1)
+    return buffer;
+
+  g_object_get (buffer,
+                "tile-width",  &tile_width,
+                "tile-height", &tile_height,
+                "shift-x",     &shift_x,
+                "shift-y",     &shift_y,
+                NULL);
+
+  bpp = babl_format_get_bytes_per_pixel (format);
+
+  if (color)
+    {
+      pixels = g_malloc (bpp);
+
+      gimp_rgba_get_pixel (color, format, pixels);
+    }
+  else
+    {
+      pattern_width  = gegl_buffer_get_width  (pattern);
+      pattern_height = gegl_buffer_get_height (pattern);
+
+      pixels = g_malloc ((gsize) pattern_width * pattern_height * bpp);
+
+      gegl_buffer_get (pattern, NULL, 1.0, format, pixels,
+                       GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+    }
+
+  /*  the filled tiles, by their phase within the pattern  */
+  tiles = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                 NULL, (GDestroyNotify) g_object_unref);
+
+  x1 = gimp_gegl_tile_index (rect->x + shift_x, tile_width);
+  y1 = gimp_gegl_tile_index (rect->y + shift_y, tile_height);
+  x2 = gimp_gegl_tile_index (rect->x + rect->width  - 1 + shift_x,
+                             tile_width);
+  y2 = gimp_gegl_tile_index (rect->y + rect->height - 1 + shift_y,
+                             tile_height);
+
+  for (y = y1; y <= y2; y++)
+    for (x = x1; x <= x2; x++)
+      {
+        GeglRectangle  tile_rect;
+        GeglRectangle  dest_rect;
+        GeglRectangle  mask_rect;
+        GeglBuffer    *tile;
+        gboolean       partial = FALSE;
+        gint           phase_x;
+        gint           phase_y;
+        gint           key;
+
+        tile_rect.x      = x * tile_width  - shift_x;
+        tile_rect.y      = y * tile_height - shift_y;
+        tile_rect.width  = tile_width;
+        tile_rect.height = tile_height;
+
+        gegl_rectangle_intersect (&dest_rect, &tile_rect, rect);
+
+        if (mask)
+          {
+            gboolean opaque;
+
+            mask_rect = dest_rect;
+
+            mask_rect.x += mask_offset_x;
+            mask_rect.y += mask_offset_y;
+
+            if (! gimp_gegl_mask_get_coverage (mask, &mask_rect, &opaque))
+              continue;
+
+            partial = ! opaque;
+          }
+
+        phase_x = gimp_gegl_mod (tile_rect.x - pattern_offset_x,
+                                 pattern_width);
+        phase_y = gimp_gegl_mod (tile_rect.y - pattern_offset_y,
+                                 pattern_height);
+
+        key = phase_y * pattern_width + phase_x;
+
+        tile = g_hash_table_lookup (tiles, GINT_TO_POINTER (key));
+
+        if (! tile)
+          {
+            guchar *data = g_malloc ((gsize) tile_width * tile_height * bpp);
+
+            gimp_gegl_fill_tile (data, tile_width, tile_height, bpp,
+                                 pixels, pattern_width, pattern_height,
+                                 phase_x, phase_y);
+
+            tile = gegl_buffer_new (GEGL_RECTANGLE (0, 0,
+                                                    tile_width, tile_height),
+                                    format);
+
+            gegl_buffer_set (tile, NULL, 0, format, data,
+                             GEGL_AUTO_ROWSTRIDE);
+
+            g_free (data);
+
+            g_hash_table_insert (tiles, GINT_TO_POINTER (key), tile);
+          }
+
+        /*  whole tiles are shared with @tile, not copied  */
+        gegl_buffer_copy (tile,
+                          GEGL_RECTANGLE (dest_rect.x - tile_rect.x,
+                                          dest_rect.y - tile_rect.y,
+                                          dest_rect.width,
+                                          dest_rect.height),
+                          buffer, &dest_rect);
+
+        if (partial)
+          gimp_gegl_apply_mask (mask, &mask_rect, buffer, &dest_rect, 1.0);
+      }
+
+  g_hash_table_unref (tiles);
+  g_free (pixels);
+
+  return buffer;
+}
+
+/**
+ * gimp_gegl_buffer_dup:
+ * @buffer: a #GeglBuffer
+ *
+ * Like gegl_buffer_dup(), but the duplicate has the same tile grid as
+ * @buffer, including its shift, so it is created by sharing @buffer's
+ * tiles copy-on-write instead of copying pixels. Only the tiles later
+ * written to, in either buffer, are actually copied.
+ *
+ * Returns: a new #GeglBuffer with the same extent and format as @buffer.
+ **/
+GeglBuffer *
+gimp_gegl_buffer_dup (GeglBuffer *buffer)
+{
+  const GeglRectangle *extent;
+  GeglBuffer          *dup;
+  gint                 shift_x;
+  gint                 shift_y;
+
+  g_return_val_if_fail (GEGL_IS_BUFFER (buffer), NULL);
+
+  extent = gegl_buffer_get_extent (buffer);
+
+  g_object_get (buffer,
+                "shift-x", &shift_x,
+                "shift-y", &shift_y,
+                NULL);
+
+  dup = g_object_new (GEGL_TYPE_BUFFER,
+                      "x",       extent->x,
+                      "y",       extent->y,
+                      "width",   extent->width,
+                      "height",  extent->height,
+                      "shift-x", shift_x,
+                      "shift-y", shift_y,
+                      "format",  gegl_buffer_get_format (buffer),
+                      NULL);
+
+  gegl_buffer_copy (buffer, extent, dup, extent);
+
+  return dup;
+}
+
+/**
+ * gimp_gegl_buffer_get_unshared_memsize:
+ * @buffer: a #GeglBuffer, or %NULL
+ * @tiles:  a set of tile data pointers already accounted for
+ *
+ * Returns the memory used by those of @buffer's tiles which are not yet in
+ * @tiles, and adds them, so calling this for several buffers with the
+ * same @tiles counts tiles shared copy-on-write between them only once.
+ *
+ * Only tiles in the tile cache can be told apart; tiles swapped out
+ * are counted as if they weren't shared, and are never loaded.
+ *
+ * Returns: the size in bytes.
+ **/
+gint64
+gimp_gegl_buffer_get_unshared_memsize (GeglBuffer *buffer,
+                                       GHashTable *tiles)
+{
+  GeglTileSource *source;
+  gint            x1, y1, x2, y2;
+  gint            x, y;
+  gint64          tile_size;
+  gint64          memsize = 0;
+
+  g_return_val_if_fail (buffer == NULL || GEGL_IS_BUFFER (buffer), 0);
+  g_return_val_if_fail (tiles != NULL, 0);
+
+  if (! gimp_gegl_buffer_get_tiles (buffer, &x1, &y1, &x2, &y2, &tile_size))
+    return 0;
+
+  source = GEGL_TILE_SOURCE (buffer);
+
+  for (y = y1; y <= y2; y++)
+    for (x = x1; x <= x2; x++)
+      {
+        GeglTile *tile;
+        gpointer  data;
+
+        if (! gegl_tile_source_command (source, GEGL_TILE_IS_CACHED,
+                                        x, y, 0, NULL))
+          {
+            if (gegl_tile_source_command (source, GEGL_TILE_EXIST,
+                                          x, y, 0, NULL))
+              memsize += tile_size;
+
+            continue;
+          }
+
+        tile = gegl_tile_source_command (source, GEGL_TILE_GET,
+                                         x, y, 0, NULL);
+
+        if (! tile)
+          continue;
+
+        data = gegl_tile_get_data (tile);
+
+        if (! g_hash_table_lookup_extended (tiles, data, NULL, NULL))
+          {
+            g_hash_table_add (tiles, data);
+
+            memsize += tile_size;
+          }
+
+        gegl_tile_unref (tile);
+      }
+
+  return memsize;
+}
+
+/**
+ * gimp_gegl_buffer_get_allocated_memsize:
+ * @buffer: a #GeglBuffer, or %NULL
+ *
+ * Returns the memory used by @buffer's tiles which are in the tile
+ * cache or swapped out. Unlike gimp_gegl_buffer_get_memsize(), tiles
+ * never written or rendered to are not counted. The tiles are never
+ * fetched, so this is safe on buffers which render their tiles on
+ * demand, like projections.
+ *
+ * Returns: the size in bytes.
+ **/
+gint64
+gimp_gegl_buffer_get_allocated_memsize (GeglBuffer *buffer)
+{
+  GeglTileSource *source;
+  gint            x1, y1, x2, y2;
+  gint            x, y;
+  gint64          tile_size;
+  gint64          memsize = 0;
+
+  g_return_val_if_fail (buffer == NULL || GEGL_IS_BUFFER (buffer), 0);
+
+  if (! gimp_gegl_buffer_get_tiles (buffer, &x1, &y1, &x2, &y2, &tile_size))
+    return 0;
+
+  source = GEGL_TILE_SOURCE (buffer);
+
+  for (y = y1; y <= y2; y++)
+    for (x = x1; x <= x2; x++)
+      {
+        if (gegl_tile_source_command (source, GEGL_TILE_IS_CACHED,
+                                      x, y, 0, NULL) ||
+            gegl_tile_source_command (source, GEGL_TILE_EXIST,
+                                      x, y, 0, NULL))
+          {
+            memsize += tile_size;
+          }
+      }
+
+  return memsize;
+}
+
+
+/*  private functions  */
+
+static inline gint
+gimp_gegl_tile_index (gint coordinate,
+                      gint tile_size)
+{
+  if (coordinate >= 0)
+    return coordinate / tile_size;
+
+  return ((coordinate + 1) / tile_size) - 1;
+}
+
+/*  the range of tile indices covering @buffer's extent, in its
+ *  storage's grid, and the size of one tile
+ */
+static gboolean
+gimp_gegl_buffer_get_tiles (GeglBuffer *buffer,
+                            gint       *x1,
+                            gint       *y1,
+                            gint       *x2,
+                            gint       *y2,
+                            gint64     *tile_size)
+{
+  const GeglRectangle *extent;
+  gint                 tile_width;
+  gint                 tile_height;
+  gint                 shift_x;
+  gint                 shift_y;
+
+  if (! buffer)
+    return FALSE;
+
+  extent = gegl_buffer_get_extent (buffer);
+
+  if (extent->width < 1 || extent->height < 1)
+    return FALSE;
+
+  g_object_get (buffer,
+                "tile-width",  &tile_width,
+                "tile-height", &tile_height,
+                "shift-x",     &shift_x,
+                "shift-y",     &shift_y,
+                NULL);
+
+  *tile_size = ((gint64) tile_width * tile_height *
+                babl_format_get_bytes_per_pixel (gegl_buffer_get_format (buffer)));
+
+  *x1 = gimp_gegl_tile_index (extent->x + shift_x, tile_width);
+  *y1 = gimp_gegl_tile_index (extent->y + shift_y, tile_height);
+  *x2 = gimp_gegl_tile_index (extent->x + extent->width  - 1 + shift_x,
+                              tile_width);
+  *y2 = gimp_gegl_tile_index (extent->y + extent->height - 1 + shift_y,
+                              tile_height);
+
+  return TRUE;
+}
+
+static inline gint
+gimp_gegl_mod (gint a,
+               gint b)
+{
+  gint m = a % b;
+
+  return m < 0 ? m + b : m;
+}
+
+/*  fills a tile's pixels with @pattern repeated, starting at
+ *  (@phase_x, @phase_y) within it
+ */
+static void
+gimp_gegl_fill_tile (guchar       *data,
+                     gint          width,
+                     gint          height,
+                     gint          bpp,
+                     const guchar *pattern,
+                     gint          pattern_width,
+                     gint          pattern_height,
+                     gint          phase_x,
+                     gint          phase_y)
+{
+  gint row_size       = width * bpp;
+  gint pattern_stride = pattern_width * bpp;
+  gint row;
+
+  for (row = 0; row < height; row++)
+    {
+      guchar *dest = data + row * row_size;
+      gint    pattern_row;
+      gint    head;
+      gint    done;
+
+      /*  rows repeat with the pattern's height, reuse them once filled  */
+      if (row >= pattern_height)
+        {
+          memcpy (dest, dest - pattern_height * row_size, row_size);
+          continue;
+        }
+
+      pattern_row = (phase_y + row) % pattern_height;
+
+      /*  lay down one period of the pattern starting at the tile's
+       *  phase, then keep doubling it until the row is full
+       */
+      head = MIN (pattern_width - phase_x, width);
+
+      memcpy (dest,
+              pattern + pattern_row * pattern_stride + phase_x * bpp,
+              head * bpp);
+
+      if (head < width && phase_x > 0)
+        memcpy (dest + head * bpp,
+                pattern + pattern_row * pattern_stride,
+                MIN (phase_x, width - head) * bpp);
+
+      for (done = MIN (pattern_stride, row_size);
+           done < row_size;
+           done *= 2)
+        {
+          memcpy (dest + done, dest, MIN (done, row_size - done));
+        }
+    }
+}
+
+/*  returns whether @mask has any opaque pixel within @rect, and in
+ *  @opaque whether all of them are fully opaque
+ */
+static gboolean
+gimp_gegl_mask_get_coverage (GeglBuffer          *mask,
+                             const GeglRectangle *rect,
+                             gboolean            *opaque)
+{
+  GeglBufferIterator *iter;
+  gboolean            any = FALSE;
+
+  *opaque = TRUE;
+
+  iter = gegl_buffer_iterator_new (mask, rect, 0, babl_format ("Y float"),
+                                   GEGL_BUFFER_READ, GEGL_ABYSS_NONE);
+
+  while (gegl_buffer_iterator_next (iter))
+    {
+      const gfloat *data = iter->data[0];
+
+      while (iter->length--)
+        {
+          if (*data > 0.0)
+            any = TRUE;
+
+          if (*data < 1.0)
+            *opaque = FALSE;
+
+          data++;
+        }
+    }
+
+  return any;
+}
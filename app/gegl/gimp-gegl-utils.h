@@ -23,6 +23,9 @@
 
 
 const gchar * gimp_interpolation_to_gegl_filter (GimpInterpolationType  interpolation) G_GNUC_CONST;
+GeglSamplerType
+              gimp_interpolation_to_gegl_sampler
+                                                (GimpInterpolationType  interpolation) G_GNUC_CONST;
 
 GeglColor   * gimp_gegl_color_new               (const GimpRGB         *rgb);
 
@@ -30,5 +33,25 @@ void          gimp_gegl_progress_connect        (GeglNode              *node,
                                                  GimpProgress          *progress,
                                                  const gchar           *text);
 
+GeglBuffer  * gimp_gegl_buffer_new_shifted      (GeglBuffer            *buffer,
+                                                 const GeglRectangle   *rect,
+                                                 GeglColor             *fill);
+GeglBuffer  * gimp_gegl_buffer_new_fill         (const GeglRectangle   *rect,
+                                                 const Babl            *format,
+                                                 const GimpRGB         *color,
+                                                 GeglBuffer            *pattern,
+                                                 gint                   pattern_offset_x,
+                                                 gint                   pattern_offset_y,
+                                                 GeglBuffer            *mask,
+                                                 gint                   mask_offset_x,
+                                                 gint                   mask_offset_y);
+GeglBuffer  * gimp_gegl_buffer_dup              (GeglBuffer            *buffer);
+
+gint64        gimp_gegl_buffer_get_unshared_memsize
+                                                (GeglBuffer            *buffer,
+                                                 GHashTable            *tiles);
+gint64        gimp_gegl_buffer_get_allocated_memsize
+                                                (GeglBuffer            *buffer);
+
 
 #endif /* __GIMP_GEGL_UTILS_H__ */
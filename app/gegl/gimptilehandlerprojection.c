@@ -24,6 +24,8 @@
 
 #include "gimptilehandlerprojection.h"
 
+#include "gimp-trace.h"
+
 
 enum
 {
@@ -194,6 +196,8 @@ gimp_tile_handler_projection_validate (GeglTileSource *source,
       gint n_rects;
       gint i;
 
+      GIMP_TRACE_BEGIN ("gimp_tile_handler_projection_validate");
+
       if (! tile)
         tile = gegl_tile_handler_create_tile (GEGL_TILE_HANDLER (source),
                                               x, y, 0);
@@ -232,13 +236,15 @@ gimp_tile_handler_projection_validate (GeglTileSource *source,
                                           blit_rect.height),
                           projection->format,
                           gegl_tile_get_data (tile) +
-                          (blit_rect.y % projection->tile_height) * tile_stride +
-                          (blit_rect.x % projection->tile_width)  * tile_bpp,
+                          (blit_rect.y - tile_rect.y) * tile_stride +
+                          (blit_rect.x - tile_rect.x) * tile_bpp,
                           tile_stride,
                           GEGL_ABYSS_NONE);
         }
 
       gegl_tile_unlock (tile);
+
+      GIMP_TRACE_END ("gimp_tile_handler_projection_validate");
     }
 
   cairo_region_destroy (tile_region);
@@ -278,6 +284,16 @@ gimp_tile_handler_projection_new (GeglNode *graph)
   return GEGL_TILE_HANDLER (projection);
 }
 
+/*  rounds towards negative infinity, buffers other than the
+ *  projection's can extend to negative coordinates
+ */
+static inline gint
+gimp_tile_handler_projection_div (gint a,
+                                  gint b)
+{
+  return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
 static void
 gimp_tile_handler_projection_void_pyramid (GeglTileSource *source,
                                            gint            x,
@@ -309,10 +325,10 @@ gimp_tile_handler_projection_invalidate (GimpTileHandlerProjection *projection,
 
   cairo_region_union_rectangle (projection->dirty_region, &rect);
 
-  tile_x1 = x / projection->tile_width;
-  tile_y1 = y / projection->tile_height;
-  tile_x2 = (x + width)  / projection->tile_width;
-  tile_y2 = (y + height) / projection->tile_height;
+  tile_x1 = gimp_tile_handler_projection_div (x, projection->tile_width);
+  tile_y1 = gimp_tile_handler_projection_div (y, projection->tile_height);
+  tile_x2 = gimp_tile_handler_projection_div (x + width,  projection->tile_width);
+  tile_y2 = gimp_tile_handler_projection_div (y + height, projection->tile_height);
 
   for (tile_y = tile_y1; tile_y <= tile_y2; tile_y++)
     {
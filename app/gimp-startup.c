@@ -0,0 +1,148 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimp-startup.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Records a timeline of the phases GIMP goes through until its first
+ * window is up.  Each phase lasts until the next one starts.  The
+ * timeline is printed with --verbose, and written as tab-separated
+ * "phase, start, duration" lines in milliseconds to the file named
+ * by GIMP_STARTUP_TIMELINE, or to "startup-timeline" in the user's
+ * gimp directory with --verbose.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+
+#include <glib/gstdio.h>
+
+#include "libgimpbase/gimpbase.h"
+
+#include "gimp-startup.h"
+#include "gimp-trace.h"
+
+
+typedef struct
+{
+  const gchar *name;
+  gint64       start;
+} GimpStartupPhase;
+
+
+static GArray   *startup_phases   = NULL;
+static gint64    startup_time     = 0;
+static gboolean  startup_finished = FALSE;
+
+
+void
+gimp_startup_phase (const gchar *name)
+{
+  GimpStartupPhase phase;
+
+  g_return_if_fail (name != NULL);
+
+  if (startup_finished)
+    return;
+
+  if (! startup_phases)
+    {
+      startup_phases = g_array_new (FALSE, FALSE, sizeof (GimpStartupPhase));
+      startup_time   = g_get_monotonic_time ();
+    }
+  else
+    {
+      GIMP_TRACE_END (g_array_index (startup_phases, GimpStartupPhase,
+                                     startup_phases->len - 1).name);
+    }
+
+  phase.name  = name;
+  phase.start = g_get_monotonic_time ();
+
+  g_array_append_val (startup_phases, phase);
+
+  GIMP_TRACE_BEGIN (name);
+}
+
+void
+gimp_startup_finish (gboolean be_verbose)
+{
+  const gchar *env_filename;
+  gchar       *filename = NULL;
+  FILE        *file     = NULL;
+  gint64       end;
+  gint         i;
+
+  if (startup_finished || ! startup_phases)
+    return;
+
+  startup_finished = TRUE;
+
+  end = g_get_monotonic_time ();
+
+  GIMP_TRACE_END (g_array_index (startup_phases, GimpStartupPhase,
+                                 startup_phases->len - 1).name);
+
+  env_filename = g_getenv ("GIMP_STARTUP_TIMELINE");
+
+  if (env_filename && *env_filename)
+    filename = g_strdup (env_filename);
+  else if (be_verbose)
+    filename = gimp_personal_rc_file ("startup-timeline");
+
+  if (filename)
+    {
+      file = g_fopen (filename, "w");
+
+      if (! file)
+        g_printerr ("Could not write startup timeline to '%s'\n",
+                    gimp_filename_to_utf8 (filename));
+
+      g_free (filename);
+    }
+
+  if (be_verbose)
+    g_print ("\nStartup timeline:\n");
+
+  for (i = 0; i < startup_phases->len; i++)
+    {
+      GimpStartupPhase *phase = &g_array_index (startup_phases,
+                                                GimpStartupPhase, i);
+      gdouble           start;
+      gdouble           duration;
+
+      start    = (phase->start - startup_time) / 1000.0;
+      duration = ((i + 1 < startup_phases->len ?
+                   phase[1].start : end) - phase->start) / 1000.0;
+
+      if (file)
+        fprintf (file, "%s\t%.3f\t%.3f\n", phase->name, start, duration);
+
+      if (be_verbose)
+        g_print ("  %-24s %9.1f ms %9.1f ms\n", phase->name, start, duration);
+    }
+
+  if (file)
+    fclose (file);
+
+  if (be_verbose)
+    g_print ("  %-24s %9.1f ms\n\n",
+             "total", (end - startup_time) / 1000.0);
+
+  g_array_free (startup_phases, TRUE);
+  startup_phases = NULL;
+}
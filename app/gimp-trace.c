@@ -0,0 +1,322 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimp-trace.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#include <glib-object.h>
+#include <glib/gstdio.h>
+
+#ifdef G_OS_WIN32
+#include <process.h>
+#define getpid _getpid
+#endif
+
+#include "libgimpbase/gimpbase.h"
+
+#include "gimp-trace.h"
+
+#include "gimp-intl.h"
+
+
+/*  A very small span tracer.  Every thread records its events into its
+ *  own buffer, so recording only ever takes an uncontended lock; the
+ *  buffers are merged when the trace is written in the Chrome
+ *  trace-event JSON format, which can be loaded into chrome://tracing.
+ *
+ *  Recording is started at startup if GIMP_TRACE is set (its value is
+ *  the file the trace is written to on exit), or at runtime from the
+ *  debug menu.
+ */
+
+
+typedef struct _GimpTraceEvent  GimpTraceEvent;
+typedef struct _GimpTraceThread GimpTraceThread;
+
+struct _GimpTraceEvent
+{
+  const gchar *name;
+  gint64       time;
+  gchar        phase;
+};
+
+struct _GimpTraceThread
+{
+  GMutex  mutex;
+  gint    id;
+  GArray *events;
+};
+
+
+static GimpTraceThread * gimp_trace_get_thread (void);
+static void              gimp_trace_add_event  (const gchar *name,
+                                                gchar        phase);
+static void              gimp_trace_write_name (FILE        *file,
+                                                const gchar *name);
+
+
+volatile gboolean gimp_trace_enabled = FALSE;
+
+static GPrivate   trace_thread_key = G_PRIVATE_INIT (NULL);
+static GMutex     trace_mutex;
+static GSList    *trace_threads    = NULL;
+static gint       trace_n_threads  = 0;
+static gint64     trace_start_time = 0;
+static gchar     *trace_filename   = NULL;
+
+
+void
+gimp_trace_init (void)
+{
+  const gchar *env_trace_val = g_getenv ("GIMP_TRACE");
+
+  if (env_trace_val && *env_trace_val)
+    {
+      trace_filename = g_strdup (env_trace_val);
+
+      gimp_trace_start ();
+    }
+}
+
+void
+gimp_trace_exit (void)
+{
+  if (gimp_trace_is_active ())
+    {
+      GError *error = NULL;
+
+      if (! gimp_trace_stop (NULL, &error))
+        {
+          g_printerr ("%s\n", error->message);
+          g_clear_error (&error);
+        }
+    }
+}
+
+void
+gimp_trace_start (void)
+{
+  GSList *list;
+
+  g_mutex_lock (&trace_mutex);
+
+  for (list = trace_threads; list; list = g_slist_next (list))
+    {
+      GimpTraceThread *thread = list->data;
+
+      g_mutex_lock (&thread->mutex);
+      g_array_set_size (thread->events, 0);
+      g_mutex_unlock (&thread->mutex);
+    }
+
+  trace_start_time   = g_get_monotonic_time ();
+  gimp_trace_enabled = TRUE;
+
+  g_mutex_unlock (&trace_mutex);
+}
+
+/**
+ * gimp_trace_stop:
+ * @filename: the file to write the trace to, or %NULL
+ * @error:    return location for an error
+ *
+ * Stops recording and writes all recorded spans to @filename.  If
+ * @filename is %NULL, the file name given by GIMP_TRACE, or else a
+ * file in the temporary directory is used; see
+ * gimp_trace_get_filename().
+ *
+ * Return value: %TRUE if the trace could be written.
+ **/
+gboolean
+gimp_trace_stop (const gchar  *filename,
+                 GError      **error)
+{
+  FILE     *file;
+  GSList   *list;
+  gboolean  first = TRUE;
+
+  g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  gimp_trace_enabled = FALSE;
+
+  if (! filename)
+    filename = gimp_trace_get_filename ();
+
+  file = g_fopen (filename, "w");
+
+  if (! file)
+    {
+      g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errno),
+                   _("Could not open '%s' for writing: %s"),
+                   gimp_filename_to_utf8 (filename), g_strerror (errno));
+      return FALSE;
+    }
+
+  fprintf (file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+
+  g_mutex_lock (&trace_mutex);
+
+  for (list = trace_threads; list; list = g_slist_next (list))
+    {
+      GimpTraceThread *thread = list->data;
+      gint             i;
+
+      g_mutex_lock (&thread->mutex);
+
+      for (i = 0; i < thread->events->len; i++)
+        {
+          GimpTraceEvent *event = &g_array_index (thread->events,
+                                                  GimpTraceEvent, i);
+
+          fprintf (file, "%s\n{\"name\":\"", first ? "" : ",");
+          gimp_trace_write_name (file, event->name);
+          fprintf (file,
+                   "\",\"cat\":\"gimp\",\"ph\":\"%c\","
+                   "\"ts\":%" G_GINT64_FORMAT ",\"pid\":%d,\"tid\":%d}",
+                   event->phase,
+                   event->time - trace_start_time,
+                   (gint) getpid (),
+                   thread->id);
+
+          first = FALSE;
+        }
+
+      g_array_set_size (thread->events, 0);
+
+      g_mutex_unlock (&thread->mutex);
+    }
+
+  g_mutex_unlock (&trace_mutex);
+
+  fprintf (file, "\n]}\n");
+
+  if (fclose (file) != 0)
+    {
+      g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errno),
+                   _("Error writing '%s': %s"),
+                   gimp_filename_to_utf8 (filename), g_strerror (errno));
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+gboolean
+gimp_trace_is_active (void)
+{
+  return gimp_trace_enabled;
+}
+
+const gchar *
+gimp_trace_get_filename (void)
+{
+  if (! trace_filename)
+    {
+      gchar *basename = g_strdup_printf ("gimp-trace-%d.json",
+                                         (gint) getpid ());
+
+      trace_filename = g_build_filename (g_get_tmp_dir (), basename, NULL);
+
+      g_free (basename);
+    }
+
+  return trace_filename;
+}
+
+void
+gimp_trace_begin (const gchar *name)
+{
+  gimp_trace_add_event (name, 'B');
+}
+
+void
+gimp_trace_end (const gchar *name)
+{
+  gimp_trace_add_event (name, 'E');
+}
+
+
+/*  private functions  */
+
+static GimpTraceThread *
+gimp_trace_get_thread (void)
+{
+  GimpTraceThread *thread = g_private_get (&trace_thread_key);
+
+  if (! thread)
+    {
+      /*  thread records are never freed, threads that exit keep their
+       *  events until the next trace is written
+       */
+      thread = g_slice_new0 (GimpTraceThread);
+
+      g_mutex_init (&thread->mutex);
+      thread->events = g_array_sized_new (FALSE, FALSE,
+                                          sizeof (GimpTraceEvent), 4096);
+
+      g_mutex_lock (&trace_mutex);
+
+      thread->id    = ++trace_n_threads;
+      trace_threads = g_slist_append (trace_threads, thread);
+
+      g_mutex_unlock (&trace_mutex);
+
+      g_private_set (&trace_thread_key, thread);
+    }
+
+  return thread;
+}
+
+static void
+gimp_trace_add_event (const gchar *name,
+                      gchar        phase)
+{
+  GimpTraceThread *thread = gimp_trace_get_thread ();
+  GimpTraceEvent   event;
+
+  event.name  = name;
+  event.time  = g_get_monotonic_time ();
+  event.phase = phase;
+
+  g_mutex_lock (&thread->mutex);
+  g_array_append_val (thread->events, event);
+  g_mutex_unlock (&thread->mutex);
+}
+
+static void
+gimp_trace_write_name (FILE        *file,
+                       const gchar *name)
+{
+  const gchar *p;
+
+  for (p = name; *p; p++)
+    {
+      if (*p == '"' || *p == '\\')
+        fputc ('\\', file);
+
+      fputc (*p, file);
+    }
+}
@@ -0,0 +1,57 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimp-trace.h
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GIMP_TRACE_H__
+#define __GIMP_TRACE_H__
+
+
+/*  span names passed to the tracer must be static strings, they are
+ *  stored by pointer and only resolved when the trace is written
+ */
+
+extern volatile gboolean gimp_trace_enabled;
+
+
+void          gimp_trace_init         (void);
+void          gimp_trace_exit         (void);
+
+void          gimp_trace_start        (void);
+gboolean      gimp_trace_stop         (const gchar  *filename,
+                                       GError      **error);
+gboolean      gimp_trace_is_active    (void);
+const gchar * gimp_trace_get_filename (void);
+
+void          gimp_trace_begin        (const gchar  *name);
+void          gimp_trace_end          (const gchar  *name);
+
+
+#define GIMP_TRACE_BEGIN(name) \
+        G_STMT_START { \
+        if (gimp_trace_enabled) \
+          gimp_trace_begin (name); \
+        } G_STMT_END
+
+#define GIMP_TRACE_END(name) \
+        G_STMT_START { \
+        if (gimp_trace_enabled) \
+          gimp_trace_end (name); \
+        } G_STMT_END
+
+
+#endif /* __GIMP_TRACE_H__ */
@@ -80,6 +80,7 @@
 #include "ige-mac-menu.h"
 #endif /* GDK_WINDOWING_QUARTZ */
 
+#include "gimp-startup.h"
 #include "gimp-intl.h"
 
 
@@ -398,12 +399,17 @@ gui_restore_callback (Gimp               *gimp,
                     NULL);
     }
 
+  gimp_startup_phase ("actions");
   actions_init (gimp);
+
+  gimp_startup_phase ("menus");
   menus_init (gimp, global_action_factory);
   gimp_render_init (gimp);
 
+  gimp_startup_phase ("dialogs");
   dialogs_init (gimp, global_menu_factory);
 
+  gimp_startup_phase ("devices and session");
   gimp_clipboard_init (gimp);
   gimp_clipboard_set_buffer (gimp, gimp->global_buffer);
 
@@ -418,9 +424,11 @@ gui_restore_callback (Gimp               *gimp,
   g_type_class_unref (g_type_class_ref (GIMP_TYPE_COLOR_SELECTOR_PALETTE));
 
   /*  initialize the document history  */
+  gimp_startup_phase ("documents");
   status_callback (NULL, _("Documents"), 0.9);
   gimp_recent_list_load (gimp);
 
+  gimp_startup_phase ("tool options");
   status_callback (NULL, _("Tool Options"), 1.0);
   gimp_tools_restore (gimp);
 }
@@ -453,6 +461,8 @@ gui_restore_after_callback (Gimp               *gimp,
 
   gimp->message_handler = GIMP_MESSAGE_BOX;
 
+  gimp_startup_phase ("image menus");
+
   if (gui_config->restore_accels)
     menus_restore (gimp);
 
@@ -541,6 +551,8 @@ gui_restore_after_callback (Gimp               *gimp,
     {
       GimpDisplayShell *shell;
 
+      gimp_startup_phase ("first display");
+
       /*  create the empty display  */
       display = GIMP_DISPLAY (gimp_create_display (gimp,
                                                    NULL,
@@ -71,6 +71,7 @@
 #endif
 
 #include "gimp-log.h"
+#include "gimp-trace.h"
 #include "gimp-intl.h"
 
 
@@ -329,6 +330,7 @@ main (int    argc,
   gimp_env_init (FALSE);
 
   gimp_log_init ();
+  gimp_trace_init ();
 
   gimp_init_i18n ();
 
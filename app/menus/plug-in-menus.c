@@ -49,9 +49,20 @@ struct _PlugInMenuEntry
   const gchar         *menu_path;
 };
 
+typedef struct _PlugInMenusSetup PlugInMenusSetup;
+
+struct _PlugInMenusSetup
+{
+  GimpUIManager *manager;
+  const gchar   *ui_path;
+  GSList        *procedures;  /* the procedures to add entries for */
+};
+
 
 /*  local function prototypes  */
 
+static gboolean plug_in_menus_setup_idle          (PlugInMenusSetup    *setup);
+
 static void    plug_in_menus_register_procedure   (GimpPDB             *pdb,
                                                    GimpProcedure       *procedure,
                                                    GimpUIManager       *manager);
@@ -86,7 +97,7 @@ plug_in_menus_setup (GimpUIManager *manager,
                      const gchar   *ui_path)
 {
   GimpPlugInManager *plug_in_manager;
-  GTree             *menu_entries;
+  PlugInMenusSetup  *setup;
   GSList            *list;
   guint              merge_id;
   gint               i;
@@ -116,9 +127,15 @@ plug_in_menus_setup (GimpUIManager *manager,
       g_free (action_path);
     }
 
-  menu_entries = g_tree_new_full ((GCompareDataFunc) strcmp, NULL,
-                                  g_free,
-                                  (GDestroyNotify) plug_in_menu_entry_free);
+  /*  building the entries of a thousand procedures is what makes the
+   *  first window slow to show up, so they are only added once the
+   *  main loop is idle. Procedures registered until then are added
+   *  by plug_in_menus_register_procedure() like later ones.
+   */
+  setup = g_slice_new0 (PlugInMenusSetup);
+
+  setup->manager = g_object_ref (manager);
+  setup->ui_path = ui_path;
 
   for (list = plug_in_manager->plug_in_procedures;
        list;
@@ -126,8 +143,50 @@ plug_in_menus_setup (GimpUIManager *manager,
     {
       GimpPlugInProcedure *plug_in_proc = list->data;
 
-      if (! plug_in_proc->prog)
-        continue;
+      if (plug_in_proc->prog)
+        setup->procedures = g_slist_prepend (setup->procedures,
+                                             g_object_ref (plug_in_proc));
+    }
+
+  g_object_set_data (G_OBJECT (manager), "plug-in-menus-pending",
+                     g_slist_prepend (g_object_get_data (G_OBJECT (manager),
+                                                         "plug-in-menus-pending"),
+                                      setup));
+
+  g_idle_add_full (G_PRIORITY_LOW,
+                   (GSourceFunc) plug_in_menus_setup_idle, setup,
+                   NULL);
+
+  g_signal_connect_object (manager->gimp->pdb, "register-procedure",
+                           G_CALLBACK (plug_in_menus_register_procedure),
+                           manager, 0);
+  g_signal_connect_object (manager->gimp->pdb, "unregister-procedure",
+                           G_CALLBACK (plug_in_menus_unregister_procedure),
+                           manager, 0);
+}
+
+
+/*  private functions  */
+
+static gboolean
+plug_in_menus_setup_idle (PlugInMenusSetup *setup)
+{
+  GimpUIManager     *manager         = setup->manager;
+  GimpPlugInManager *plug_in_manager = manager->gimp->plug_in_manager;
+  GTree             *menu_entries;
+  GSList            *list;
+  GSList            *pending;
+
+  GIMP_LOG (MENUS, "adding %d procedures to %s",
+            g_slist_length (setup->procedures), setup->ui_path);
+
+  menu_entries = g_tree_new_full ((GCompareDataFunc) strcmp, NULL,
+                                  g_free,
+                                  (GDestroyNotify) plug_in_menu_entry_free);
+
+  for (list = setup->procedures; list; list = g_slist_next (list))
+    {
+      GimpPlugInProcedure *plug_in_proc = list->data;
 
       g_signal_connect_object (plug_in_proc, "menu-path-added",
                                G_CALLBACK (plug_in_menus_menu_path_added),
@@ -181,7 +240,8 @@ plug_in_menus_setup (GimpUIManager *manager,
         }
     }
 
-  g_object_set_data (G_OBJECT (manager), "ui-path", (gpointer) ui_path);
+  g_object_set_data (G_OBJECT (manager), "ui-path",
+                     (gpointer) setup->ui_path);
 
   g_tree_foreach (menu_entries,
                   (GTraverseFunc) plug_in_menus_tree_traverse,
@@ -191,16 +251,17 @@ plug_in_menus_setup (GimpUIManager *manager,
 
   g_tree_destroy (menu_entries);
 
-  g_signal_connect_object (manager->gimp->pdb, "register-procedure",
-                           G_CALLBACK (plug_in_menus_register_procedure),
-                           manager, 0);
-  g_signal_connect_object (manager->gimp->pdb, "unregister-procedure",
-                           G_CALLBACK (plug_in_menus_unregister_procedure),
-                           manager, 0);
-}
+  pending = g_object_get_data (G_OBJECT (manager), "plug-in-menus-pending");
+  g_object_set_data (G_OBJECT (manager), "plug-in-menus-pending",
+                     g_slist_remove (pending, setup));
 
+  g_slist_free_full (setup->procedures, (GDestroyNotify) g_object_unref);
+  g_object_unref (setup->manager);
 
-/*  private functions  */
+  g_slice_free (PlugInMenusSetup, setup);
+
+  return FALSE;
+}
 
 static void
 plug_in_menus_register_procedure (GimpPDB       *pdb,
@@ -238,6 +299,23 @@ plug_in_menus_unregister_procedure (GimpPDB       *pdb,
   if (GIMP_IS_PLUG_IN_PROCEDURE (procedure))
     {
       GimpPlugInProcedure *plug_in_proc = GIMP_PLUG_IN_PROCEDURE (procedure);
+      GSList              *pending;
+
+      /*  don't add entries for it if the menus aren't built yet  */
+      for (pending = g_object_get_data (G_OBJECT (manager),
+                                        "plug-in-menus-pending");
+           pending;
+           pending = g_slist_next (pending))
+        {
+          PlugInMenusSetup *setup = pending->data;
+
+          if (g_slist_find (setup->procedures, plug_in_proc))
+            {
+              setup->procedures = g_slist_remove (setup->procedures,
+                                                  plug_in_proc);
+              g_object_unref (plug_in_proc);
+            }
+        }
 
       g_signal_handlers_disconnect_by_func (plug_in_proc,
                                             plug_in_menus_menu_path_added,
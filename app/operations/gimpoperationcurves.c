@@ -34,16 +34,17 @@
 #include "gimpoperationcurves.h"
 
 
-static gboolean gimp_operation_curves_process (GeglOperation       *operation,
-                                               void                *in_buf,
-                                               void                *out_buf,
-                                               glong                samples,
-                                               const GeglRectangle *roi,
-                                               gint                 level);
+static gboolean gimp_operation_curves_is_identity (GimpOperationPointLut *lut,
+                                                   GObject               *config,
+                                                   gint                   channel);
+static gfloat   gimp_operation_curves_map         (GimpOperationPointLut *lut,
+                                                   GObject               *config,
+                                                   gint                   channel,
+                                                   gfloat                 value);
 
 
 G_DEFINE_TYPE (GimpOperationCurves, gimp_operation_curves,
-               GIMP_TYPE_OPERATION_POINT_FILTER)
+               GIMP_TYPE_OPERATION_POINT_LUT)
 
 #define parent_class gimp_operation_curves_parent_class
 
@@ -51,11 +52,11 @@ G_DEFINE_TYPE (GimpOperationCurves, gimp_operation_curves,
 static void
 gimp_operation_curves_class_init (GimpOperationCurvesClass *klass)
 {
-  GObjectClass                  *object_class    = G_OBJECT_CLASS (klass);
-  GeglOperationClass            *operation_class = GEGL_OPERATION_CLASS (klass);
-  GeglOperationPointFilterClass *point_class     = GEGL_OPERATION_POINT_FILTER_CLASS (klass);
+  GObjectClass               *object_class    = G_OBJECT_CLASS (klass);
+  GeglOperationClass         *operation_class = GEGL_OPERATION_CLASS (klass);
+  GimpOperationPointLutClass *lut_class       = GIMP_OPERATION_POINT_LUT_CLASS (klass);
 
-  object_class->set_property   = gimp_operation_point_filter_set_property;
+  object_class->set_property   = gimp_operation_point_lut_set_property;
   object_class->get_property   = gimp_operation_point_filter_get_property;
 
   gegl_operation_class_set_keys (operation_class,
@@ -64,7 +65,8 @@ gimp_operation_curves_class_init (GimpOperationCurvesClass *klass)
                                  "description", "GIMP Curves operation",
                                  NULL);
 
-  point_class->process = gimp_operation_curves_process;
+  lut_class->is_identity = gimp_operation_curves_is_identity;
+  lut_class->map         = gimp_operation_curves_map;
 
   g_object_class_install_property (object_class,
                                    GIMP_OPERATION_POINT_FILTER_PROP_CONFIG,
@@ -82,26 +84,33 @@ gimp_operation_curves_init (GimpOperationCurves *self)
 }
 
 static gboolean
-gimp_operation_curves_process (GeglOperation       *operation,
-                               void                *in_buf,
-                               void                *out_buf,
-                               glong                samples,
-                               const GeglRectangle *roi,
-                               gint                 level)
+gimp_operation_curves_is_identity (GimpOperationPointLut *lut,
+                                   GObject               *config,
+                                   gint                   channel)
 {
-  GimpOperationPointFilter *point  = GIMP_OPERATION_POINT_FILTER (operation);
-  GimpCurvesConfig         *config = GIMP_CURVES_CONFIG (point->config);
-  gfloat                   *src    = in_buf;
-  gfloat                   *dest   = out_buf;
+  GimpCurvesConfig *curves = GIMP_CURVES_CONFIG (config);
 
-  if (! config)
-    return FALSE;
+  /* don't apply the colors curve to the alpha channel */
+  if (channel == ALPHA)
+    return gimp_curve_is_identity (curves->curve[GIMP_HISTOGRAM_ALPHA]);
 
-  gimp_curve_map_pixels (config->curve[0],
-                         config->curve[1],
-                         config->curve[2],
-                         config->curve[3],
-                         config->curve[4], src, dest, samples);
+  return (gimp_curve_is_identity (curves->curve[GIMP_HISTOGRAM_VALUE]) &&
+          gimp_curve_is_identity (curves->curve[channel + 1]));
+}
+
+static gfloat
+gimp_operation_curves_map (GimpOperationPointLut *lut,
+                           GObject               *config,
+                           gint                   channel,
+                           gfloat                 value)
+{
+  GimpCurvesConfig *curves = GIMP_CURVES_CONFIG (config);
+
+  /* don't apply the colors curve to the alpha channel */
+  if (channel == ALPHA)
+    return gimp_curve_map_value (curves->curve[GIMP_HISTOGRAM_ALPHA], value);
 
-  return TRUE;
+  return gimp_curve_map_value (curves->curve[GIMP_HISTOGRAM_VALUE],
+                               gimp_curve_map_value (curves->curve[channel + 1],
+                                                     value));
 }
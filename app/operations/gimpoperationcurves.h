@@ -22,7 +22,7 @@
 #define __GIMP_OPERATION_CURVES_H__
 
 
-#include "gimpoperationpointfilter.h"
+#include "gimpoperationpointlut.h"
 
 
 #define GIMP_TYPE_OPERATION_CURVES            (gimp_operation_curves_get_type ())
@@ -38,12 +38,12 @@ typedef struct _GimpOperationCurvesClass GimpOperationCurvesClass;
 
 struct _GimpOperationCurves
 {
-  GimpOperationPointFilter  parent_instance;
+  GimpOperationPointLut  parent_instance;
 };
 
 struct _GimpOperationCurvesClass
 {
-  GimpOperationPointFilterClass  parent_class;
+  GimpOperationPointLutClass  parent_class;
 };
 
 
@@ -31,16 +31,17 @@
 #include "gimpoperationlevels.h"
 
 
-static gboolean gimp_operation_levels_process (GeglOperation       *operation,
-                                               void                *in_buf,
-                                               void                *out_buf,
-                                               glong                samples,
-                                               const GeglRectangle *roi,
-                                               gint                 level);
+static gboolean gimp_operation_levels_is_identity (GimpOperationPointLut *lut,
+                                                   GObject               *config,
+                                                   gint                   channel);
+static gfloat   gimp_operation_levels_map_value   (GimpOperationPointLut *lut,
+                                                   GObject               *config,
+                                                   gint                   channel,
+                                                   gfloat                 value);
 
 
 G_DEFINE_TYPE (GimpOperationLevels, gimp_operation_levels,
-               GIMP_TYPE_OPERATION_POINT_FILTER)
+               GIMP_TYPE_OPERATION_POINT_LUT)
 
 #define parent_class gimp_operation_levels_parent_class
 
@@ -48,11 +49,11 @@ G_DEFINE_TYPE (GimpOperationLevels, gimp_operation_levels,
 static void
 gimp_operation_levels_class_init (GimpOperationLevelsClass *klass)
 {
-  GObjectClass                  *object_class    = G_OBJECT_CLASS (klass);
-  GeglOperationClass            *operation_class = GEGL_OPERATION_CLASS (klass);
-  GeglOperationPointFilterClass *point_class     = GEGL_OPERATION_POINT_FILTER_CLASS (klass);
+  GObjectClass               *object_class    = G_OBJECT_CLASS (klass);
+  GeglOperationClass         *operation_class = GEGL_OPERATION_CLASS (klass);
+  GimpOperationPointLutClass *lut_class       = GIMP_OPERATION_POINT_LUT_CLASS (klass);
 
-  object_class->set_property   = gimp_operation_point_filter_set_property;
+  object_class->set_property   = gimp_operation_point_lut_set_property;
   object_class->get_property   = gimp_operation_point_filter_get_property;
 
   gegl_operation_class_set_keys (operation_class,
@@ -61,7 +62,8 @@ gimp_operation_levels_class_init (GimpOperationLevelsClass *klass)
                                  "description", "GIMP Levels operation",
                                  NULL);
 
-  point_class->process = gimp_operation_levels_process;
+  lut_class->is_identity = gimp_operation_levels_is_identity;
+  lut_class->map         = gimp_operation_levels_map_value;
 
   g_object_class_install_property (object_class,
                                    GIMP_OPERATION_POINT_FILTER_PROP_CONFIG,
@@ -105,62 +107,58 @@ gimp_operation_levels_map (gdouble value,
 }
 
 static gboolean
-gimp_operation_levels_process (GeglOperation       *operation,
-                               void                *in_buf,
-                               void                *out_buf,
-                               glong                samples,
-                               const GeglRectangle *roi,
-                               gint                 level)
+gimp_operation_levels_channel_is_identity (GimpLevelsConfig *config,
+                                           gint              channel)
 {
-  GimpOperationPointFilter *point  = GIMP_OPERATION_POINT_FILTER (operation);
-  GimpLevelsConfig         *config = GIMP_LEVELS_CONFIG (point->config);
-  gfloat                   *src    = in_buf;
-  gfloat                   *dest   = out_buf;
-  gfloat                    inv_gamma[5];
-  gint                      channel;
-
-  if (! config)
+  return (config->gamma[channel]       == 1.0 &&
+          config->low_input[channel]   == 0.0 &&
+          config->high_input[channel]  == 1.0 &&
+          config->low_output[channel]  == 0.0 &&
+          config->high_output[channel] == 1.0);
+}
+
+static gboolean
+gimp_operation_levels_is_identity (GimpOperationPointLut *lut,
+                                   GObject               *config,
+                                   gint                   channel)
+{
+  GimpLevelsConfig *levels = GIMP_LEVELS_CONFIG (config);
+
+  if (! gimp_operation_levels_channel_is_identity (levels, channel + 1))
     return FALSE;
 
-  for (channel = 0; channel < 5; channel++)
-    {
-      g_return_val_if_fail (config->gamma[channel] != 0.0, FALSE);
-
-      inv_gamma[channel] = 1.0 / config->gamma[channel];
-    }
-
-  while (samples--)
-    {
-      for (channel = 0; channel < 4; channel++)
-        {
-          gdouble value;
-
-          value = gimp_operation_levels_map (src[channel],
-                                             inv_gamma[channel + 1],
-                                             config->low_input[channel + 1],
-                                             config->high_input[channel + 1],
-                                             config->low_output[channel + 1],
-                                             config->high_output[channel + 1]);
-
-          /* don't apply the overall curve to the alpha channel */
-          if (channel != ALPHA)
-            value = gimp_operation_levels_map (value,
-                                               inv_gamma[0],
-                                               config->low_input[0],
-                                               config->high_input[0],
-                                               config->low_output[0],
-                                               config->high_output[0]);
-
-          dest[channel] = value;
-        }
-
-      src  += 4;
-      dest += 4;
-    }
-
-  return TRUE;
+  /* don't apply the overall curve to the alpha channel */
+  return (channel == ALPHA ||
+          gimp_operation_levels_channel_is_identity (levels, 0));
 }
 
+static gfloat
+gimp_operation_levels_map_value (GimpOperationPointLut *lut,
+                                 GObject               *config,
+                                 gint                   channel,
+                                 gfloat                 value)
+{
+  GimpLevelsConfig *levels = GIMP_LEVELS_CONFIG (config);
+  gdouble           result;
+
+  result = gimp_operation_levels_map (value,
+                                      1.0 / levels->gamma[channel + 1],
+                                      levels->low_input[channel + 1],
+                                      levels->high_input[channel + 1],
+                                      levels->low_output[channel + 1],
+                                      levels->high_output[channel + 1]);
+
+  /* don't apply the overall curve to the alpha channel */
+  if (channel != ALPHA)
+    result = gimp_operation_levels_map (result,
+                                        1.0 / levels->gamma[0],
+                                        levels->low_input[0],
+                                        levels->high_input[0],
+                                        levels->low_output[0],
+                                        levels->high_output[0]);
+
+  return result;
+}
 
 /*  public functions  */
 
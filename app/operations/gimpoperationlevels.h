@@ -22,7 +22,7 @@
 #define __GIMP_OPERATION_LEVELS_H__
 
 
-#include "gimpoperationpointfilter.h"
+#include "gimpoperationpointlut.h"
 
 
 #define GIMP_TYPE_OPERATION_LEVELS            (gimp_operation_levels_get_type ())
@@ -38,12 +38,12 @@ typedef struct _GimpOperationLevelsClass GimpOperationLevelsClass;
 
 struct _GimpOperationLevels
 {
-  GimpOperationPointFilter  parent_instance;
+  GimpOperationPointLut  parent_instance;
 };
 
 struct _GimpOperationLevelsClass
 {
-  GimpOperationPointFilterClass  parent_class;
+  GimpOperationPointLutClass  parent_class;
 };
 
 
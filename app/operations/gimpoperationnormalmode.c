@@ -21,26 +21,41 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include <gegl-plugin.h>
 
 #include "operations-types.h"
 
+#include "gegl/gimp-gegl-coverage.h"
+
 #include "gimpoperationnormalmode.h"
 
 
-static gboolean gimp_operation_normal_parent_process (GeglOperation        *operation,
-                                                      GeglOperationContext *context,
-                                                      const gchar          *output_prop,
-                                                      const GeglRectangle  *result,
-                                                      gint                  level);
-static gboolean gimp_operation_normal_mode_process   (GeglOperation        *operation,
-                                                      void                 *in_buf,
-                                                      void                 *aux_buf,
-                                                      void                 *aux2_buf,
-                                                      void                 *out_buf,
-                                                      glong                 samples,
-                                                      const GeglRectangle  *roi,
-                                                      gint                  level);
+static GeglRectangle gimp_operation_normal_get_required_for_output (GeglOperation        *operation,
+                                                                    const gchar          *input_pad,
+                                                                    const GeglRectangle  *roi);
+static gboolean      gimp_operation_normal_parent_process          (GeglOperation        *operation,
+                                                                    GeglOperationContext *context,
+                                                                    const gchar          *output_prop,
+                                                                    const GeglRectangle  *result,
+                                                                    gint                  level);
+static gboolean      gimp_operation_normal_mode_process            (GeglOperation        *operation,
+                                                                    void                 *in_buf,
+                                                                    void                 *aux_buf,
+                                                                    void                 *aux2_buf,
+                                                                    void                 *out_buf,
+                                                                    glong                 samples,
+                                                                    const GeglRectangle  *roi,
+                                                                    gint                  level);
+
+static GeglBuffer *  gimp_operation_normal_get_aux_buffer          (GeglOperation        *operation,
+                                                                    gint                 *offset_x,
+                                                                    gint                 *offset_y);
+static gboolean      gimp_operation_normal_aux_is_opaque           (GeglOperation        *operation,
+                                                                    const GeglRectangle  *rect);
+static gboolean      gimp_operation_normal_aux_is_empty            (GeglOperation        *operation,
+                                                                    const GeglRectangle  *rect);
 
 
 G_DEFINE_TYPE (GimpOperationNormalMode, gimp_operation_normal_mode,
@@ -81,9 +96,10 @@ gimp_operation_normal_mode_class_init (GimpOperationNormalModeClass *klass)
                                  "reference-composition", reference_xml,
                                  NULL);
 
-  operation_class->process     = gimp_operation_normal_parent_process;
+  operation_class->get_required_for_output = gimp_operation_normal_get_required_for_output;
+  operation_class->process                 = gimp_operation_normal_parent_process;
 
-  point_class->process         = gimp_operation_normal_mode_process;
+  point_class->process                     = gimp_operation_normal_mode_process;
 }
 
 static void
@@ -91,6 +107,25 @@ gimp_operation_normal_mode_init (GimpOperationNormalMode *self)
 {
 }
 
+/*  nothing below an opaque layer shows through  */
+static GeglRectangle
+gimp_operation_normal_get_required_for_output (GeglOperation       *operation,
+                                               const gchar         *input_pad,
+                                               const GeglRectangle *roi)
+{
+  if (! strcmp (input_pad, "input") &&
+      gimp_operation_normal_aux_is_opaque (operation, roi))
+    {
+      GeglRectangle empty = { 0, 0, 0, 0 };
+
+      return empty;
+    }
+
+  return GEGL_OPERATION_CLASS (parent_class)->get_required_for_output (operation,
+                                                                      input_pad,
+                                                                      roi);
+}
+
 static gboolean
 gimp_operation_normal_parent_process (GeglOperation        *operation,
                                       GeglOperationContext *context,
@@ -107,6 +142,21 @@ gimp_operation_normal_parent_process (GeglOperation        *operation,
   input = gegl_operation_context_get_object (context, "input");
   aux   = gegl_operation_context_get_object (context, "aux");
 
+  /* pass aux through where it covers the input completely, and
+   * input where aux is empty
+   */
+  if (aux && gimp_operation_normal_aux_is_opaque (operation, result))
+    {
+      gegl_operation_context_set_object (context, "output", aux);
+      return TRUE;
+    }
+
+  if (input && gimp_operation_normal_aux_is_empty (operation, result))
+    {
+      gegl_operation_context_set_object (context, "output", input);
+      return TRUE;
+    }
+
   /* pass the input/aux buffers directly through if they are not
    * overlapping
    */
@@ -226,3 +276,126 @@ gimp_operation_normal_mode_process (GeglOperation       *operation,
 
   return TRUE;
 }
+
+/*  returns the buffer the aux pad is fed from, if that is a drawable's
+ *  buffer moved by whole pixels only, so its coverage can be asked
+ */
+static GeglBuffer *
+gimp_operation_normal_get_aux_buffer (GeglOperation *operation,
+                                      gint          *offset_x,
+                                      gint          *offset_y)
+{
+  GeglNode *node = gegl_operation_get_source_node (operation, "aux");
+
+  *offset_x = 0;
+  *offset_y = 0;
+
+  while (node)
+    {
+      const gchar *name = gegl_node_get_operation (node);
+      GObject     *source;
+
+      if (! name)
+        return NULL;
+
+      if (! strcmp (name, "gegl:buffer-source"))
+        {
+          GeglBuffer *buffer = NULL;
+
+          gegl_node_get (node,
+                         "buffer", &buffer,
+                         NULL);
+
+          return buffer;
+        }
+      else if (! strcmp (name, "gegl:translate"))
+        {
+          gdouble x, y;
+
+          gegl_node_get (node,
+                         "x", &x,
+                         "y", &y,
+                         NULL);
+
+          if (x != (gint) x || y != (gint) y)
+            return NULL;
+
+          *offset_x += (gint) x;
+          *offset_y += (gint) y;
+        }
+      else if (strcmp (name, "gegl:nop"))
+        {
+          return NULL;
+        }
+
+      g_object_get (node,
+                    "gegl-operation", &source,
+                    NULL);
+
+      if (! source)
+        return NULL;
+
+      node = gegl_operation_get_source_node (GEGL_OPERATION (source), "input");
+
+      g_object_unref (source);
+    }
+
+  return NULL;
+}
+
+static gboolean
+gimp_operation_normal_aux_is_opaque (GeglOperation       *operation,
+                                     const GeglRectangle *rect)
+{
+  GimpOperationPointLayerMode *point = GIMP_OPERATION_POINT_LAYER_MODE (operation);
+  GeglBuffer                  *buffer;
+  gint                         offset_x;
+  gint                         offset_y;
+  gboolean                     opaque;
+
+  if (point->opacity < 1.0 ||
+      gegl_operation_source_get_bounding_box (operation, "aux2"))
+    return FALSE;
+
+  buffer = gimp_operation_normal_get_aux_buffer (operation,
+                                                 &offset_x, &offset_y);
+
+  if (! buffer)
+    return FALSE;
+
+  opaque = gimp_gegl_buffer_is_opaque (buffer,
+                                       GEGL_RECTANGLE (rect->x - offset_x,
+                                                       rect->y - offset_y,
+                                                       rect->width,
+                                                       rect->height));
+
+  g_object_unref (buffer);
+
+  return opaque;
+}
+
+static gboolean
+gimp_operation_normal_aux_is_empty (GeglOperation       *operation,
+                                    const GeglRectangle *rect)
+{
+  GeglBuffer *buffer;
+  gint        offset_x;
+  gint        offset_y;
+  gboolean    empty;
+
+  buffer = gimp_operation_normal_get_aux_buffer (operation,
+                                                 &offset_x, &offset_y);
+
+  if (! buffer)
+    return FALSE;
+
+  empty = gimp_gegl_buffer_is_transparent (buffer,
+                                           GEGL_RECTANGLE (rect->x - offset_x,
+                                                           rect->y - offset_y,
+                                                           rect->width,
+                                                           rect->height));
+
+  g_object_unref (buffer);
+
+  return empty;
+}
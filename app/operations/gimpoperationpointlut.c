@@ -0,0 +1,430 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimpoperationpointlut.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Base class for operations mapping each channel through a fixed
+ * function of its value alone, like curves and levels.  Instead of
+ * evaluating the function for every pixel, it is compiled into one
+ * table per channel whenever the config changes:
+ *
+ *  - for u8 and u16 input, the operation works in that precision, and
+ *    the tables hold the exact result for every possible value;
+ *
+ *  - otherwise the tables hold samples of the function which are
+ *    interpolated linearly, and are only used if they reproduce the
+ *    function closely enough, and for values in [0..1].
+ */
+
+#include "config.h"
+
+#include <math.h>
+
+#include <gegl.h>
+
+#include "operations-types.h"
+
+#include "gegl/gimp-babl.h"
+
+#include "gimpoperationpointlut.h"
+
+
+/*  the number of intervals of the float tables  */
+#define LUT_SIZE       4096
+
+/*  how far the interpolated tables may be off at the intervals'
+ *  middles, which is at least half as far as anywhere else
+ */
+#define LUT_TOLERANCE  (1.0f / 65535.0f)
+
+
+static void     gimp_operation_point_lut_finalize      (GObject               *object);
+
+static void     gimp_operation_point_lut_prepare       (GeglOperation         *operation);
+static gboolean gimp_operation_point_lut_process       (GeglOperation         *operation,
+                                                        void                  *in_buf,
+                                                        void                  *out_buf,
+                                                        glong                  samples,
+                                                        const GeglRectangle   *roi,
+                                                        gint                   level);
+
+static void     gimp_operation_point_lut_config_notify (GObject               *config,
+                                                        const GParamSpec      *pspec,
+                                                        GimpOperationPointLut *lut);
+static void     gimp_operation_point_lut_invalidate    (GimpOperationPointLut *lut);
+static void     gimp_operation_point_lut_compile       (GimpOperationPointLut *lut,
+                                                        const Babl            *format);
+static gfloat * gimp_operation_point_lut_compile_float (GimpOperationPointLut *lut,
+                                                        GObject               *config,
+                                                        gint                   channel);
+static gpointer gimp_operation_point_lut_compile_int   (GimpOperationPointLut *lut,
+                                                        GObject               *config,
+                                                        const Babl            *format);
+
+
+G_DEFINE_ABSTRACT_TYPE (GimpOperationPointLut, gimp_operation_point_lut,
+                        GIMP_TYPE_OPERATION_POINT_FILTER)
+
+#define parent_class gimp_operation_point_lut_parent_class
+
+
+static void
+gimp_operation_point_lut_class_init (GimpOperationPointLutClass *klass)
+{
+  GObjectClass                  *object_class    = G_OBJECT_CLASS (klass);
+  GeglOperationClass            *operation_class = GEGL_OPERATION_CLASS (klass);
+  GeglOperationPointFilterClass *point_class     = GEGL_OPERATION_POINT_FILTER_CLASS (klass);
+
+  object_class->finalize   = gimp_operation_point_lut_finalize;
+
+  operation_class->prepare = gimp_operation_point_lut_prepare;
+
+  point_class->process     = gimp_operation_point_lut_process;
+}
+
+static void
+gimp_operation_point_lut_init (GimpOperationPointLut *self)
+{
+}
+
+static void
+gimp_operation_point_lut_finalize (GObject *object)
+{
+  gimp_operation_point_lut_invalidate (GIMP_OPERATION_POINT_LUT (object));
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+void
+gimp_operation_point_lut_set_property (GObject      *object,
+                                       guint         property_id,
+                                       const GValue *value,
+                                       GParamSpec   *pspec)
+{
+  GimpOperationPointFilter *filter = GIMP_OPERATION_POINT_FILTER (object);
+  GimpOperationPointLut    *lut    = GIMP_OPERATION_POINT_LUT (object);
+
+  if (property_id == GIMP_OPERATION_POINT_FILTER_PROP_CONFIG && filter->config)
+    g_signal_handlers_disconnect_by_func (filter->config,
+                                          gimp_operation_point_lut_config_notify,
+                                          lut);
+
+  gimp_operation_point_filter_set_property (object, property_id, value, pspec);
+
+  if (property_id == GIMP_OPERATION_POINT_FILTER_PROP_CONFIG)
+    {
+      if (filter->config)
+        g_signal_connect_object (filter->config, "notify",
+                                 G_CALLBACK (gimp_operation_point_lut_config_notify),
+                                 lut, 0);
+
+      gimp_operation_point_lut_invalidate (lut);
+    }
+}
+
+static void
+gimp_operation_point_lut_prepare (GeglOperation *operation)
+{
+  GimpOperationPointLut *lut    = GIMP_OPERATION_POINT_LUT (operation);
+  const Babl            *source = gegl_operation_get_source_format (operation,
+                                                                    "input");
+  const Babl            *format = babl_format ("R'G'B'A float");
+
+  /*  work in the input's precision where the tables can be exact  */
+  if (source)
+    {
+      GimpPrecision precisions[] = { GIMP_PRECISION_U8, GIMP_PRECISION_U16 };
+      gint          i;
+
+      for (i = 0; i < G_N_ELEMENTS (precisions); i++)
+        {
+          if (source == gimp_babl_format (GIMP_RGB,  precisions[i], TRUE)  ||
+              source == gimp_babl_format (GIMP_RGB,  precisions[i], FALSE) ||
+              source == gimp_babl_format (GIMP_GRAY, precisions[i], TRUE)  ||
+              source == gimp_babl_format (GIMP_GRAY, precisions[i], FALSE))
+            {
+              format = gimp_babl_format (GIMP_RGB, precisions[i], TRUE);
+              break;
+            }
+        }
+    }
+
+  gegl_operation_set_format (operation, "input",  format);
+  gegl_operation_set_format (operation, "output", format);
+
+  if (! lut->valid || lut->format != format)
+    {
+      gimp_operation_point_lut_invalidate (lut);
+      gimp_operation_point_lut_compile (lut, format);
+    }
+}
+
+static inline gfloat
+gimp_operation_point_lut_map_float (GimpOperationPointLut      *lut,
+                                    GimpOperationPointLutClass *klass,
+                                    GObject                    *config,
+                                    gint                        channel,
+                                    gfloat                      value)
+{
+  const gfloat *table = lut->table[channel];
+
+  if (lut->identity[channel])
+    return value;
+
+  if (table && value >= 0.0f && value <= 1.0f)
+    {
+      gfloat x = value * LUT_SIZE;
+      gint   i = MIN ((gint) x, LUT_SIZE - 1);
+
+      return table[i] + (x - i) * (table[i + 1] - table[i]);
+    }
+
+  return klass->map (lut, config, channel, value);
+}
+
+static gboolean
+gimp_operation_point_lut_process (GeglOperation       *operation,
+                                  void                *in_buf,
+                                  void                *out_buf,
+                                  glong                samples,
+                                  const GeglRectangle *roi,
+                                  gint                 level)
+{
+  GimpOperationPointLut      *lut    = GIMP_OPERATION_POINT_LUT (operation);
+  GimpOperationPointLutClass *klass  = GIMP_OPERATION_POINT_LUT_GET_CLASS (lut);
+  GObject                    *config = GIMP_OPERATION_POINT_FILTER (lut)->config;
+
+  if (! config)
+    return FALSE;
+
+  /*  the config may have changed since the operation was prepared  */
+  if (! lut->valid)
+    gimp_operation_point_lut_compile (lut, lut->format);
+
+  if (lut->int_table &&
+      lut->format == gimp_babl_format (GIMP_RGB, GIMP_PRECISION_U8, TRUE))
+    {
+      const guint8 *table = lut->int_table;
+      const guint8 *src   = in_buf;
+      guint8       *dest  = out_buf;
+
+      while (samples--)
+        {
+          dest[0] = table[src[0] * 4 + 0];
+          dest[1] = table[src[1] * 4 + 1];
+          dest[2] = table[src[2] * 4 + 2];
+          dest[3] = table[src[3] * 4 + 3];
+
+          src  += 4;
+          dest += 4;
+        }
+    }
+  else if (lut->int_table)
+    {
+      const guint16 *table = lut->int_table;
+      const guint16 *src   = in_buf;
+      guint16       *dest  = out_buf;
+
+      while (samples--)
+        {
+          dest[0] = table[src[0] * 4 + 0];
+          dest[1] = table[src[1] * 4 + 1];
+          dest[2] = table[src[2] * 4 + 2];
+          dest[3] = table[src[3] * 4 + 3];
+
+          src  += 4;
+          dest += 4;
+        }
+    }
+  else
+    {
+      const gfloat *src  = in_buf;
+      gfloat       *dest = out_buf;
+
+      while (samples--)
+        {
+          gint channel;
+
+          for (channel = 0; channel < 4; channel++)
+            dest[channel] = gimp_operation_point_lut_map_float (lut, klass,
+                                                                config, channel,
+                                                                src[channel]);
+
+          src  += 4;
+          dest += 4;
+        }
+    }
+
+  return TRUE;
+}
+
+static void
+gimp_operation_point_lut_config_notify (GObject               *config,
+                                        const GParamSpec      *pspec,
+                                        GimpOperationPointLut *lut)
+{
+  gimp_operation_point_lut_invalidate (lut);
+}
+
+static void
+gimp_operation_point_lut_invalidate (GimpOperationPointLut *lut)
+{
+  gint channel;
+
+  for (channel = 0; channel < 4; channel++)
+    {
+      if (lut->table[channel])
+        {
+          g_free (lut->table[channel]);
+          lut->table[channel] = NULL;
+        }
+    }
+
+  if (lut->int_table)
+    {
+      g_free (lut->int_table);
+      lut->int_table = NULL;
+    }
+
+  lut->valid = FALSE;
+}
+
+static void
+gimp_operation_point_lut_compile (GimpOperationPointLut *lut,
+                                  const Babl            *format)
+{
+  GimpOperationPointLutClass *klass  = GIMP_OPERATION_POINT_LUT_GET_CLASS (lut);
+  GObject                    *config = GIMP_OPERATION_POINT_FILTER (lut)->config;
+  gint                        channel;
+
+  if (! config)
+    return;
+
+  for (channel = 0; channel < 4; channel++)
+    lut->identity[channel] = klass->is_identity (lut, config, channel);
+
+  if (format == babl_format ("R'G'B'A float"))
+    {
+      for (channel = 0; channel < 4; channel++)
+        {
+          if (! lut->identity[channel])
+            lut->table[channel] =
+              gimp_operation_point_lut_compile_float (lut, config, channel);
+        }
+    }
+  else
+    {
+      lut->int_table = gimp_operation_point_lut_compile_int (lut, config,
+                                                             format);
+    }
+
+  lut->format = format;
+  lut->valid  = TRUE;
+}
+
+static gfloat *
+gimp_operation_point_lut_compile_float (GimpOperationPointLut *lut,
+                                        GObject               *config,
+                                        gint                   channel)
+{
+  GimpOperationPointLutClass *klass = GIMP_OPERATION_POINT_LUT_GET_CLASS (lut);
+  gfloat                     *table;
+  gint                        i;
+
+  table = g_new (gfloat, LUT_SIZE + 1);
+
+  for (i = 0; i <= LUT_SIZE; i++)
+    table[i] = klass->map (lut, config, channel, (gfloat) i / LUT_SIZE);
+
+  for (i = 0; i < LUT_SIZE; i++)
+    {
+      gfloat exact = klass->map (lut, config, channel,
+                                 (i + 0.5f) / LUT_SIZE);
+
+      /*  also catches NaN  */
+      if (! (fabsf (exact - 0.5f * (table[i] + table[i + 1])) <=
+             LUT_TOLERANCE))
+        {
+          g_free (table);
+
+          return NULL;
+        }
+    }
+
+  return table;
+}
+
+/*  runs every value through the function, converting it to and from
+ *  R'G'B'A float the way babl would convert the whole buffer
+ */
+static gpointer
+gimp_operation_point_lut_compile_int (GimpOperationPointLut *lut,
+                                      GObject               *config,
+                                      const Babl            *format)
+{
+  GimpOperationPointLutClass *klass        = GIMP_OPERATION_POINT_LUT_GET_CLASS (lut);
+  const Babl                 *float_format = babl_format ("R'G'B'A float");
+  gboolean                    is_u8;
+  gint                        n_values;
+  gpointer                    table;
+  gfloat                     *values;
+  gint                        i, channel;
+
+  is_u8    = (format == gimp_babl_format (GIMP_RGB, GIMP_PRECISION_U8, TRUE));
+  n_values = is_u8 ? 256 : 65536;
+
+  table  = g_malloc (n_values * babl_format_get_bytes_per_pixel (format));
+  values = g_new (gfloat, n_values * 4);
+
+  for (i = 0; i < n_values; i++)
+    for (channel = 0; channel < 4; channel++)
+      {
+        if (is_u8)
+          ((guint8 *) table)[i * 4 + channel] = i;
+        else
+          ((guint16 *) table)[i * 4 + channel] = i;
+      }
+
+  babl_process (babl_fish (format, float_format), table, values, n_values);
+
+  for (i = 0; i < n_values; i++)
+    for (channel = 0; channel < 4; channel++)
+      {
+        if (! lut->identity[channel])
+          values[i * 4 + channel] = klass->map (lut, config, channel,
+                                                values[i * 4 + channel]);
+      }
+
+  babl_process (babl_fish (float_format, format), values, table, n_values);
+
+  /*  don't let the round trip touch the channels left alone  */
+  for (i = 0; i < n_values; i++)
+    for (channel = 0; channel < 4; channel++)
+      {
+        if (! lut->identity[channel])
+          continue;
+
+        if (is_u8)
+          ((guint8 *) table)[i * 4 + channel] = i;
+        else
+          ((guint16 *) table)[i * 4 + channel] = i;
+      }
+
+  g_free (values);
+
+  return table;
+}
@@ -0,0 +1,81 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimpoperationpointlut.h
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GIMP_OPERATION_POINT_LUT_H__
+#define __GIMP_OPERATION_POINT_LUT_H__
+
+
+#include "gimpoperationpointfilter.h"
+
+
+#define GIMP_TYPE_OPERATION_POINT_LUT            (gimp_operation_point_lut_get_type ())
+#define GIMP_OPERATION_POINT_LUT(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), GIMP_TYPE_OPERATION_POINT_LUT, GimpOperationPointLut))
+#define GIMP_OPERATION_POINT_LUT_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass),  GIMP_TYPE_OPERATION_POINT_LUT, GimpOperationPointLutClass))
+#define GIMP_IS_OPERATION_POINT_LUT(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GIMP_TYPE_OPERATION_POINT_LUT))
+#define GIMP_IS_OPERATION_POINT_LUT_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass),  GIMP_TYPE_OPERATION_POINT_LUT))
+#define GIMP_OPERATION_POINT_LUT_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj),  GIMP_TYPE_OPERATION_POINT_LUT, GimpOperationPointLutClass))
+
+
+typedef struct _GimpOperationPointLutClass GimpOperationPointLutClass;
+
+struct _GimpOperationPointLut
+{
+  GimpOperationPointFilter  parent_instance;
+
+  /*  the tables are compiled from the config when the operation is
+   *  prepared, and dropped whenever the config changes
+   */
+  gboolean                  valid;
+  const Babl               *format;
+
+  gboolean                  identity[4];
+  gfloat                   *table[4];    /*  float: samples of the mapping,
+                                          *  or NULL if they don't match it
+                                          */
+  gpointer                  int_table;   /*  u8 and u16: the mapped value
+                                          *  of each value, interleaved
+                                          */
+};
+
+struct _GimpOperationPointLutClass
+{
+  GimpOperationPointFilterClass  parent_class;
+
+  /*  whether @channel is left alone  */
+  gboolean (* is_identity) (GimpOperationPointLut *lut,
+                            GObject               *config,
+                            gint                   channel);
+
+  /*  maps the R'G'B'A float @value of @channel  */
+  gfloat   (* map)         (GimpOperationPointLut *lut,
+                            GObject               *config,
+                            gint                   channel,
+                            gfloat                 value);
+};
+
+
+GType   gimp_operation_point_lut_get_type     (void) G_GNUC_CONST;
+
+void    gimp_operation_point_lut_set_property (GObject      *object,
+                                               guint         property_id,
+                                               const GValue *value,
+                                               GParamSpec   *pspec);
+
+
+#endif /* __GIMP_OPERATION_POINT_LUT_H__ */
@@ -182,135 +182,244 @@ gimp_operation_shapeburst_get_cached_region (GeglOperation       *self,
   return *gegl_operation_source_get_bounding_box (self, "input");
 }
 
-static gboolean
-gimp_operation_shapeburst_process (GeglOperation       *operation,
-                                   GeglBuffer          *input,
-                                   GeglBuffer          *output,
-                                   const GeglRectangle *roi,
-                                   gint                 level)
+/*  The distance map is an exact Euclidean distance transform after
+ *  Meijster et al., "A General Algorithm for Computing Distance
+ *  Transforms in Linear Time": a pass down and up every column finds
+ *  the nearest unselected pixel within the column, a pass along every
+ *  row then picks the nearest of these.  Everything outside the input
+ *  counts as unselected.  Both passes only ever look at one column or
+ *  row at a time, so they run over plain linear buffers.
+ *
+ *  As before, each distance is followed by the selection of the pixel
+ *  where the way to the nearest unselected pixel crosses the edge, in
+ *  1/256ths, which keeps the fraction of partially selected edges.
+ *
+ *  Whole distances along straight edges are the same as before.  The
+ *  previous implementation measured diagonal edges in city block steps
+ *  and lowered the fraction by 1/256 per pixel away from the top and
+ *  left edges, neither of which is kept.
+ */
+
+static inline gint64
+gimp_operation_shapeburst_f (gint64 x,
+                             gint64 i,
+                             gint64 g)
 {
-  const Babl *input_format   = babl_format ("Y u8");
-  const Babl *output_format  = babl_format ("Y float");
-  gfloat      max_iterations = 0.0;
-  gfloat     *distp_cur;
-  gfloat     *distp_prev;
-  gfloat     *memory;
-  gint        length;
+  return (x - i) * (x - i) + g * g;
+}
+
+/*  the first x from which column @u is at least as near as column @i  */
+static inline gint64
+gimp_operation_shapeburst_sep (gint64 i,
+                               gint64 u,
+                               gint64 g_i,
+                               gint64 g_u)
+{
+  gint64 num = u * u - i * i + g_u * g_u - g_i * g_i;
+  gint64 den = 2 * (u - i);
+
+  /*  round towards minus infinity  */
+  if (num >= 0)
+    return num / den;
+  else
+    return - ((- num + den - 1) / den);
+}
+
+/*  @nearest holds, per pixel, the row of the nearest unselected pixel
+ *  in its column, -1 or @height if that is outside of the input.  The
+ *  row is padded with an unselected column on either side, @g, @s and
+ *  @t need room for @width + 2 values.
+ */
+static gfloat
+gimp_operation_shapeburst_row (const guchar *src,
+                               const gint   *nearest,
+                               gint         *g,
+                               gint         *s,
+                               gint         *t,
+                               gfloat       *dest,
+                               gint          width,
+                               gint          height,
+                               gint          y)
+{
+  const gint *row = nearest + y * width;
+  gint        n   = width + 2;
+  gint        q   = 0;
+  gfloat      max = 0.0;
   gint        i;
 
-  length = roi->width + 1;
-  memory = g_new (gfloat, length * 2);
+  g[0]     = 0;
+  g[n - 1] = 0;
 
-  distp_prev = memory;
-  for (i = 0; i < length; i++)
-    distp_prev[i] = 0.0;
+  for (i = 1; i < n - 1; i++)
+    g[i] = ABS (y - row[i - 1]);
 
-  distp_prev += 1;
-  distp_cur = distp_prev + length;
+  /*  the lower envelope of the columns' distance parabolas  */
+  s[0] = 0;
+  t[0] = 0;
 
-  for (i = 0; i < roi->height; i++)
+  for (i = 1; i < n; i++)
     {
-      gfloat *tmp;
-      gint    src = 0;
-      gint    j;
+      while (q >= 0 &&
+             gimp_operation_shapeburst_f (t[q], s[q], g[s[q]]) >
+             gimp_operation_shapeburst_f (t[q], i,    g[i]))
+        q--;
 
-      /*  set the current dist row to 0's  */
-      memset (distp_cur - 1, 0, sizeof (gfloat) * (length - 1));
-
-      for (j = 0; j < roi->width; j++)
+      if (q < 0)
         {
-          gfloat float_tmp;
-          gfloat min_prev = MIN (distp_cur[j-1], distp_prev[j]);
-          gint   min_left = MIN ((roi->width - j - 1), (roi->height - i - 1));
-          gint   min      = (gint) MIN (min_left, min_prev);
-          gint   fraction = 255;
-          gint   k;
-
-          /*  This might need to be changed to 0
-              instead of k = (min) ? (min - 1) : 0  */
+          q    = 0;
+          s[0] = i;
+        }
+      else
+        {
+          gint64 w = 1 + gimp_operation_shapeburst_sep (s[q], i,
+                                                        g[s[q]], g[i]);
 
-          for (k = (min) ? (min - 1) : 0; k <= min; k++)
+          if (w < n)
             {
-              gint x   = j;
-              gint y   = i + k;
-              gint end = y - k;
-
-              while (y >= end)
-                {
-                  guchar src_uchar;
-
-#if 1
-                  /* FIXME: this should be much faster, it converts
-                   * to 32 bit rgba intermediately, bah...
-                   */
-                  gegl_buffer_sample (input, x, y, NULL, &src_uchar,
-                                      input_format,
-                                      GEGL_SAMPLER_NEAREST, GEGL_ABYSS_NONE);
-#else
-                  gegl_buffer_get (input, GEGL_RECTANGLE (x, y, 1, 1), 1.0,
-                                   input_format, &src_uchar,
-                                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
-#endif
-
-                  src = src_uchar;
-
-                  if (src == 0)
-                    {
-                      min = k;
-                      y = -1;
-                      break;
-                    }
-
-                  if (src < fraction)
-                    fraction = src;
-
-                  x++;
-                  y--;
-                }
+              q++;
+              s[q] = i;
+              t[q] = w;
             }
+        }
+    }
 
-          if (src != 0)
+  for (i = n - 1; i >= 1; i--)
+    {
+      if (i <= width)
+        {
+          gint   x    = i - 1;
+          gint   u    = s[q] - 1;
+          gint   v    = (u < 0 || u >= width) ? y : row[u];
+          gint   dx   = x - u;
+          gint   dy   = y - v;
+          gfloat value;
+
+          if (dx == 0 && dy == 0)
             {
-              /*  If min_left != min_prev use the previous fraction
-               *   if it is less than the one found
-               */
-              if (min_left != min)
-                {
-                  gint prev_frac = (int) (255 * (min_prev - min));
-
-                  if (prev_frac == 255)
-                    prev_frac = 0;
+              value = 255 / 256.0;
+            }
+          else
+            {
+              gdouble dist = sqrt ((gdouble) dx * dx + (gdouble) dy * dy);
+              gint    edge_x;
+              gint    edge_y;
 
-                  fraction = MIN (fraction, prev_frac);
-                }
+              /*  one step from the unselected pixel towards this one  */
+              edge_x = CLAMP (u + (gint) RINT (dx / dist), 0, width  - 1);
+              edge_y = CLAMP (v + (gint) RINT (dy / dist), 0, height - 1);
 
-              min++;
+              value = dist + src[edge_y * width + edge_x] / 256.0;
             }
 
-          float_tmp = distp_cur[j] = min + fraction / 256.0;
+          dest[x] = value;
 
-          if (float_tmp > max_iterations)
-            max_iterations = float_tmp;
+          if (value > max)
+            max = value;
         }
 
+      if (i == t[q])
+        q--;
+    }
+
+  return max;
+}
+
+static gboolean
+gimp_operation_shapeburst_process (GeglOperation       *operation,
+                                   GeglBuffer          *input,
+                                   GeglBuffer          *output,
+                                   const GeglRectangle *roi,
+                                   gint                 level)
+{
+  const Babl *input_format   = babl_format ("Y u8");
+  const Babl *output_format  = babl_format ("Y float");
+  gint        width          = roi->width;
+  gint        height         = roi->height;
+  gfloat      max_iterations = 0.0;
+  guchar     *src;
+  gint       *nearest;
+  gint       *below;
+  gint       *g;
+  gint       *s;
+  gint       *t;
+  gfloat     *dest;
+  gint        x, y;
+
+  if (width < 1 || height < 1)
+    return TRUE;
+
+  src     = g_new (guchar, width * height);
+  nearest = g_new (gint,   width * height);
+  below   = g_new (gint,   width);
+  g       = g_new (gint,   width + 2);
+  s       = g_new (gint,   width + 2);
+  t       = g_new (gint,   width + 2);
+  dest    = g_new (gfloat, width);
+
+  gegl_buffer_get (input, roi, 1.0, input_format, src,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  /*  the column passes, going down and up all columns at once  */
+  for (y = 0; y < height; y++)
+    {
+      const guchar *s_row = src     + y * width;
+      gint         *n_row = nearest + y * width;
+
+      for (x = 0; x < width; x++)
+        {
+          if (s_row[x] == 0)
+            n_row[x] = y;
+          else
+            n_row[x] = (y > 0) ? n_row[x - width] : -1;
+        }
+    }
+
+  for (x = 0; x < width; x++)
+    below[x] = height;
+
+  for (y = height - 1; y >= 0; y--)
+    {
+      const guchar *s_row = src     + y * width;
+      gint         *n_row = nearest + y * width;
+
+      for (x = 0; x < width; x++)
+        {
+          if (s_row[x] == 0)
+            below[x] = y;
+
+          if (below[x] - y < y - n_row[x])
+            n_row[x] = below[x];
+        }
+    }
+
+  /*  the row passes  */
+  for (y = 0; y < height; y++)
+    {
+      gfloat max = gimp_operation_shapeburst_row (src, nearest, g, s, t,
+                                                  dest, width, height, y);
+
+      if (max > max_iterations)
+        max_iterations = max;
+
       /*  set the dist row  */
       gegl_buffer_set (output,
-                       GEGL_RECTANGLE (roi->x, roi->y + i,
-                                       roi->width, 1),
-                       1.0, output_format, distp_cur,
+                       GEGL_RECTANGLE (roi->x, roi->y + y,
+                                       width, 1),
+                       1.0, output_format, dest,
                        GEGL_AUTO_ROWSTRIDE);
 
-      /*  swap pointers around  */
-      tmp = distp_prev;
-      distp_prev = distp_cur;
-      distp_cur = tmp;
-
       g_object_set (operation,
-                    "progress", (gdouble) i / roi->height,
+                    "progress", (gdouble) y / height,
                     NULL);
     }
 
-  g_free (memory);
+  g_free (dest);
+  g_free (t);
+  g_free (s);
+  g_free (g);
+  g_free (below);
+  g_free (nearest);
+  g_free (src);
 
   g_object_set (operation,
                 "max-iterations", (gdouble) max_iterations,
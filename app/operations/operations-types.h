@@ -27,6 +27,7 @@
 /*  operations  */
 
 typedef struct _GimpOperationPointFilter        GimpOperationPointFilter;
+typedef struct _GimpOperationPointLut           GimpOperationPointLut;
 typedef struct _GimpOperationPointLayerMode     GimpOperationPointLayerMode;
 
 
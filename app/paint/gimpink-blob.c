@@ -20,6 +20,8 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include <glib-object.h>
 
 #include "libgimpmath/gimpmath.h"
@@ -37,14 +39,22 @@ typedef enum
 } EdgeType;
 
 
+/*  a blob's storage is followed by one byte of EdgeType flags per
+ *  span, the scratch space for scan converting into it
+ */
+#define BLOB_PRESENT(b) ((guchar *) ((b)->data + (b)->n_allocated))
+
+
 /*  local function prototypes  */
 
-static GimpBlob * gimp_blob_new            (gint      y,
+static GimpBlob * gimp_blob_new            (GimpBlob *blob,
+                                            gint      y,
                                             gint      height);
+static guchar   * gimp_blob_get_present    (GimpBlob *b);
 static void       gimp_blob_fill           (GimpBlob *b,
-                                            EdgeType *present);
+                                            guchar   *present);
 static void       gimp_blob_make_convex    (GimpBlob *b,
-                                            EdgeType *present);
+                                            guchar   *present);
 
 #if 0
 static void       gimp_blob_line_add_pixel (GimpBlob *b,
@@ -60,14 +70,22 @@ static void       gimp_blob_line           (GimpBlob *b,
 
 /*  public functions  */
 
+/* The functions returning a new blob take a @blob whose storage is
+ * reused for the result, or NULL. The storage only grows when it is
+ * too small, so a caller which keeps passing its old blobs back stops
+ * allocating once they are large enough. @blob must not be one of the
+ * other arguments, and is invalid after the call.
+ */
+
 /* Return blob for the given (convex) polygon
  */
 GimpBlob *
 gimp_blob_polygon (GimpBlobPoint *points,
-                   gint           n_points)
+                   gint           n_points,
+                   GimpBlob      *blob)
 {
   GimpBlob *result;
-  EdgeType *present;
+  guchar   *present;
   gint      i;
   gint      im1;
   gint      ip1;
@@ -84,8 +102,8 @@ gimp_blob_polygon (GimpBlobPoint *points,
         ymin = points[i].y;
     }
 
-  result = gimp_blob_new (ymin, ymax - ymin + 1);
-  present = g_new0 (EdgeType, result->height);
+  result  = gimp_blob_new (blob, ymin, ymax - ymin + 1);
+  present = gimp_blob_get_present (result);
 
   im1 = n_points - 1;
   i = 0;
@@ -139,7 +157,6 @@ gimp_blob_polygon (GimpBlobPoint *points,
     }
 
   gimp_blob_fill (result, present);
-  g_free (present);
 
   return result;
 }
@@ -148,12 +165,13 @@ gimp_blob_polygon (GimpBlobPoint *points,
  * axes, and by center into a blob
  */
 GimpBlob *
-gimp_blob_square (gdouble xc,
-                  gdouble yc,
-                  gdouble xp,
-                  gdouble yp,
-                  gdouble xq,
-                  gdouble yq)
+gimp_blob_square (gdouble   xc,
+                  gdouble   yc,
+                  gdouble   xp,
+                  gdouble   yp,
+                  gdouble   xq,
+                  gdouble   yq,
+                  GimpBlob *blob)
 {
   GimpBlobPoint points[4];
 
@@ -174,19 +192,20 @@ gimp_blob_square (gdouble xc,
   points[3].x = xc - xp + xq;
   points[3].y = yc - yp + yq;
 
-  return gimp_blob_polygon (points, 4);
+  return gimp_blob_polygon (points, 4, blob);
 }
 
 /* Scan convert a diamond specified by _offsets_ of major and minor
  * axes, and by center into a blob
  */
 GimpBlob *
-gimp_blob_diamond (gdouble xc,
-                   gdouble yc,
-                   gdouble xp,
-                   gdouble yp,
-                   gdouble xq,
-                   gdouble yq)
+gimp_blob_diamond (gdouble   xc,
+                   gdouble   yc,
+                   gdouble   xp,
+                   gdouble   yp,
+                   gdouble   xq,
+                   gdouble   yq,
+                   GimpBlob *blob)
 {
   GimpBlobPoint points[4];
 
@@ -207,7 +226,7 @@ gimp_blob_diamond (gdouble xc,
   points[3].x = xc + xq;
   points[3].y = yc + yq;
 
-  return gimp_blob_polygon (points, 4);
+  return gimp_blob_polygon (points, 4, blob);
 }
 
 
@@ -245,15 +264,16 @@ static gint     trig_table[TABLE_SIZE];
  * minor axes, and by center into a blob
  */
 GimpBlob *
-gimp_blob_ellipse (gdouble xc,
-                   gdouble yc,
-                   gdouble xp,
-                   gdouble yp,
-                   gdouble xq,
-                   gdouble yq)
+gimp_blob_ellipse (gdouble   xc,
+                   gdouble   yc,
+                   gdouble   xp,
+                   gdouble   yp,
+                   gdouble   xq,
+                   gdouble   yq,
+                   GimpBlob *blob)
 {
   GimpBlob *result;
-  EdgeType *present;
+  guchar   *present;
   gint      i;
   gdouble   r1, r2;
   gint      maxy, miny;
@@ -286,8 +306,8 @@ gimp_blob_ellipse (gdouble xc,
   maxy = ceil  (yc + fabs (yp) + fabs (yq));
   miny = floor (yc - fabs (yp) - fabs (yq));
 
-  result = gimp_blob_new (miny, maxy - miny + 1);
-  present = g_new0 (EdgeType, result->height);
+  result  = gimp_blob_new (blob, miny, maxy - miny + 1);
+  present = gimp_blob_get_present (result);
 
   xc_base = floor (xc);
   yc_base = floor (yc);
@@ -354,7 +374,6 @@ gimp_blob_ellipse (gdouble xc,
   /* Now fill in missing points */
 
   gimp_blob_fill (result, present);
-  g_free (present);
 
   return result;
 }
@@ -402,22 +421,26 @@ gimp_blob_bounds (GimpBlob *b,
 
 GimpBlob *
 gimp_blob_convex_union (GimpBlob *b1,
-                        GimpBlob *b2)
+                        GimpBlob *b2,
+                        GimpBlob *blob)
 {
   GimpBlob *result;
   gint      y;
   gint      i, j;
-  EdgeType *present;
+  guchar   *present;
+
+  g_return_val_if_fail (blob == NULL || (blob != b1 && blob != b2), NULL);
 
   /* Create the storage for the result */
 
   y = MIN (b1->y, b2->y);
-  result = gimp_blob_new (y, MAX (b1->y + b1->height, b2->y + b2->height)-y);
+  result = gimp_blob_new (blob,
+                          y, MAX (b1->y + b1->height, b2->y + b2->height) - y);
 
   if (result->height == 0)
     return result;
 
-  present = g_new0 (EdgeType, result->height);
+  present = gimp_blob_get_present (result);
 
   /* Initialize spans from original objects */
 
@@ -453,17 +476,21 @@ gimp_blob_convex_union (GimpBlob *b1,
 
   gimp_blob_make_convex (result, present);
 
-  g_free (present);
-
   return result;
 }
 
 GimpBlob *
 gimp_blob_duplicate (GimpBlob *b)
 {
+  GimpBlob *result;
+
   g_return_val_if_fail (b != NULL, NULL);
 
-  return g_memdup (b, sizeof (GimpBlob) +  sizeof (GimpBlobSpan) * (b->height - 1));
+  result = gimp_blob_new (NULL, b->y, b->height);
+
+  memcpy (result->data, b->data, sizeof (GimpBlobSpan) * b->height);
+
+  return result;
 }
 
 #if 0
@@ -489,22 +516,45 @@ gimp_blob_dump (GimpBlob *b)
 /*  private functions  */
 
 static GimpBlob *
-gimp_blob_new (gint y,
-               gint height)
+gimp_blob_new (GimpBlob *blob,
+               gint      y,
+               gint      height)
 {
-  GimpBlob *result;
+  if (! blob || blob->n_allocated < height)
+    {
+      gint n_allocated = MAX (height, 1);
 
-  result = g_malloc (sizeof (GimpBlob) +  sizeof (GimpBlobSpan) * (height - 1));
+      /*  grow geometrically, blobs of a stroke tend to get larger  */
+      if (blob)
+        n_allocated = MAX (n_allocated, 2 * blob->n_allocated);
 
-  result->y      = y;
-  result->height = height;
+      blob = g_realloc (blob,
+                        sizeof (GimpBlob) +
+                        sizeof (GimpBlobSpan) * (n_allocated - 1) +
+                        n_allocated);
 
-  return result;
+      blob->n_allocated = n_allocated;
+    }
+
+  blob->y      = y;
+  blob->height = height;
+
+  return blob;
+}
+
+static guchar *
+gimp_blob_get_present (GimpBlob *b)
+{
+  guchar *present = BLOB_PRESENT (b);
+
+  memset (present, EDGE_NONE, b->height);
+
+  return present;
 }
 
 static void
 gimp_blob_fill (GimpBlob *b,
-                EdgeType *present)
+                guchar   *present)
 {
   gint start;
   gint x1, x2, i1, i2;
@@ -665,7 +715,7 @@ gimp_blob_fill (GimpBlob *b,
 
 static void
 gimp_blob_make_convex (GimpBlob *b,
-                       EdgeType *present)
+                       guchar   *present)
 {
   gint x1, x2, y1, y2, i1, i2;
   gint i;
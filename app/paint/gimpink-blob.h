@@ -27,12 +27,13 @@ typedef struct _GimpBlobPoint GimpBlobPoint;
 typedef struct _GimpBlobSpan  GimpBlobSpan;
 typedef struct _GimpBlob      GimpBlob;
 
-typedef GimpBlob * (* GimpBlobFunc) (gdouble xc,
-                                     gdouble yc,
-                                     gdouble xp,
-                                     gdouble yp,
-                                     gdouble xq,
-                                     gdouble yq);
+typedef GimpBlob * (* GimpBlobFunc) (gdouble   xc,
+                                     gdouble   yc,
+                                     gdouble   xp,
+                                     gdouble   yp,
+                                     gdouble   xq,
+                                     gdouble   yq,
+                                     GimpBlob *blob);
 
 struct _GimpBlobPoint
 {
@@ -50,38 +51,43 @@ struct _GimpBlob
 {
   gint         y;
   gint         height;
+  gint         n_allocated;  /*  number of spans there is room for  */
   GimpBlobSpan data[1];
 };
 
 
 GimpBlob * gimp_blob_polygon      (GimpBlobPoint *points,
-                                   gint           n_points);
+                                   gint           n_points,
+                                   GimpBlob      *blob);
 GimpBlob * gimp_blob_square       (gdouble        xc,
                                    gdouble        yc,
                                    gdouble        xp,
                                    gdouble        yp,
                                    gdouble        xq,
-                                   gdouble        yq);
+                                   gdouble        yq,
+                                   GimpBlob      *blob);
 GimpBlob * gimp_blob_diamond      (gdouble        xc,
                                    gdouble        yc,
                                    gdouble        xp,
                                    gdouble        yp,
                                    gdouble        xq,
-                                   gdouble        yq);
+                                   gdouble        yq,
+                                   GimpBlob      *blob);
 GimpBlob * gimp_blob_ellipse      (gdouble        xc,
                                    gdouble        yc,
                                    gdouble        xp,
                                    gdouble        yp,
                                    gdouble        xq,
-                                   gdouble        yq);
+                                   gdouble        yq,
+                                   GimpBlob      *blob);
 void       gimp_blob_bounds       (GimpBlob      *b,
                                    gint          *x,
                                    gint          *y,
                                    gint          *width,
                                    gint          *height);
 GimpBlob * gimp_blob_convex_union (GimpBlob      *b1,
-                                   GimpBlob      *b2);
+                                   GimpBlob      *b2,
+                                   GimpBlob      *blob);
 GimpBlob * gimp_blob_duplicate    (GimpBlob      *b);
 
-
 #endif /* __GIMP_INK_BLOB_H__ */
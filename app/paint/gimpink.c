@@ -17,8 +17,6 @@
 
 #include "config.h"
 
-#include <string.h>
-
 #include <gegl.h>
 
 #include "libgimpmath/gimpmath.h"
@@ -75,9 +73,11 @@ static GimpBlob   * ink_pen_ellipse           (GimpInkOptions   *options,
                                                gdouble           pressure,
                                                gdouble           xtilt,
                                                gdouble           ytilt,
-                                               gdouble           velocity);
+                                               gdouble           velocity,
+                                               GimpBlob         *blob);
 
-static void         render_blob               (GeglBuffer       *buffer,
+static void         render_blob               (GimpInk          *ink,
+                                               GeglBuffer       *buffer,
                                                GeglRectangle    *rect,
                                                GimpBlob         *blob);
 
@@ -134,6 +134,25 @@ gimp_ink_finalize (GObject *object)
       ink->last_blob = NULL;
     }
 
+  if (ink->spare_blob)
+    {
+      g_free (ink->spare_blob);
+      ink->spare_blob = NULL;
+    }
+
+  if (ink->union_blob)
+    {
+      g_free (ink->union_blob);
+      ink->union_blob = NULL;
+    }
+
+  if (ink->coverage)
+    {
+      g_free (ink->coverage);
+      ink->coverage      = NULL;
+      ink->coverage_size = 0;
+    }
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -262,7 +281,6 @@ gimp_ink_motion (GimpPaintCore    *paint_core,
   GimpInk        *ink        = GIMP_INK (paint_core);
   GimpInkOptions *options    = GIMP_INK_OPTIONS (paint_options);
   GimpContext    *context    = GIMP_CONTEXT (paint_options);
-  GimpBlob       *blob_union = NULL;
   GimpBlob       *blob_to_render;
   GeglBuffer     *paint_buffer;
   gint            paint_buffer_x;
@@ -278,7 +296,9 @@ gimp_ink_motion (GimpPaintCore    *paint_core,
                                         coords->pressure,
                                         coords->xtilt,
                                         coords->ytilt,
-                                        100);
+                                        100,
+                                        ink->spare_blob);
+      ink->spare_blob = NULL;
 
       if (ink->start_blob)
         g_free (ink->start_blob);
@@ -295,14 +315,17 @@ gimp_ink_motion (GimpPaintCore    *paint_core,
                                         coords->pressure,
                                         coords->xtilt,
                                         coords->ytilt,
-                                        coords->velocity * 100);
+                                        coords->velocity * 100,
+                                        ink->spare_blob);
 
-      blob_union = gimp_blob_convex_union (ink->last_blob, blob);
+      ink->union_blob = gimp_blob_convex_union (ink->last_blob, blob,
+                                                ink->union_blob);
 
-      g_free (ink->last_blob);
-      ink->last_blob = blob;
+      /*  keep the last blob's storage around for the next one  */
+      ink->spare_blob = ink->last_blob;
+      ink->last_blob  = blob;
 
-      blob_to_render = blob_union;
+      blob_to_render = ink->union_blob;
     }
 
   /* Get the buffer */
@@ -323,7 +346,8 @@ gimp_ink_motion (GimpPaintCore    *paint_core,
   g_object_unref (color);
 
   /*  draw the blob directly to the canvas_buffer  */
-  render_blob (paint_core->canvas_buffer,
+  render_blob (ink,
+               paint_core->canvas_buffer,
                GEGL_RECTANGLE (paint_core->paint_buffer_x,
                                paint_core->paint_buffer_y,
                                gegl_buffer_get_width  (paint_core->paint_buffer),
@@ -342,9 +366,6 @@ gimp_ink_motion (GimpPaintCore    *paint_core,
                          gimp_context_get_opacity (context),
                          gimp_context_get_paint_mode (context),
                          GIMP_PAINT_CONSTANT);
-
-  if (blob_union)
-    g_free (blob_union);
 }
 
 static GimpBlob *
@@ -354,7 +375,8 @@ ink_pen_ellipse (GimpInkOptions *options,
                  gdouble         pressure,
                  gdouble         xtilt,
                  gdouble         ytilt,
-                 gdouble         velocity)
+                 gdouble         velocity,
+                 GimpBlob       *blob)
 {
   GimpBlobFunc blob_function;
   gdouble      size;
@@ -462,7 +484,8 @@ ink_pen_ellipse (GimpInkOptions *options,
                             radmin * aspect * tcos,
                             radmin * aspect * tsin,
                             -radmin * tsin,
-                            radmin * tcos);
+                            radmin * tcos,
+                            blob);
 }
 
 
@@ -479,176 +502,104 @@ ink_pen_ellipse (GimpInkOptions *options,
  * do things. But it wouldn't be hard to implement at all.
  */
 
-enum
-{
-  ROW_START,
-  ROW_STOP
-};
-
-/* The insertion sort here, for SUBSAMPLE = 8, tends to beat out
- * qsort() by 4x with CFLAGS=-O2, 2x with CFLAGS=-g
+/* A pixel row gets the exact area of the blob's SUBSAMPLE subrows
+ * over each of its pixels, in 1 / (SUBSAMPLE * SUBSAMPLE) units. The
+ * pixels between the ends of a span are fully covered by it, so they
+ * are only marked in a difference array which is summed up while
+ * writing the row, and just the end pixels get partial coverage.
+ *
+ * @coverage holds 2 * (@width + 1) zeros, and is left zeroed again.
  */
-static void
-insert_sort (gint *data,
-             gint  n)
-{
-  gint i, j, k;
-
-  for (i = 2; i < 2 * n; i += 2)
-    {
-      gint tmp1 = data[i];
-      gint tmp2 = data[i + 1];
-
-      j = 0;
-
-      while (data[j] < tmp1)
-        j += 2;
-
-      for (k = i; k > j; k -= 2)
-        {
-          data[k]     = data[k - 2];
-          data[k + 1] = data[k - 1];
-        }
-
-      data[j]     = tmp1;
-      data[j + 1] = tmp2;
-    }
-}
-
-static void
-fill_run (guchar *dest,
-          guchar  alpha,
-          gint    w)
-{
-  if (alpha == 255)
-    {
-      memset (dest, 255, w);
-    }
-  else
-    {
-      while (w--)
-        {
-          *dest = MAX (*dest, alpha);
-          dest++;
-        }
-    }
-}
-
 static void
 render_blob_line (GimpBlob *blob,
+                  gint     *coverage,
                   guchar   *dest,
                   gint      x,
                   gint      y,
                   gint      width)
 {
-  gint  buf[4 * SUBSAMPLE];
-  gint *data    = buf;
-  gint  n       = 0;
+  gint *partial = coverage;
+  gint *delta   = coverage + width + 1;
+  gint  x0      = x * SUBSAMPLE;
+  gint  x1      = (x + width) * SUBSAMPLE;
+  gint  first   = width + 1;
+  gint  last    = -1;
+  gint  full    = 0;
   gint  i, j;
-  gint  current = 0;  /* number of filled rows at this point
-                       * in the scan line
-                       */
-  gint last_x;
-
-  /* Sort start and ends for all lines */
 
   j = y * SUBSAMPLE - blob->y;
-  for (i = 0; i < SUBSAMPLE; i++)
-    {
-      if (j >= blob->height)
-        break;
 
-      if ((j > 0) && (blob->data[j].left <= blob->data[j].right))
-        {
-          data[2 * n]                     = blob->data[j].left;
-          data[2 * n + 1]                 = ROW_START;
-          data[2 * SUBSAMPLE + 2 * n]     = blob->data[j].right;
-          data[2 * SUBSAMPLE + 2 * n + 1] = ROW_STOP;
-          n++;
-        }
-      j++;
-    }
-
-  /*   If we have less than SUBSAMPLE rows, compress */
-  if (n < SUBSAMPLE)
+  for (i = 0; i < SUBSAMPLE && j < blob->height; i++, j++)
     {
-      for (i = 0; i < 2 * n; i++)
-        data[2 * n + i] = data[2 * SUBSAMPLE + i];
-    }
+      gint left, right;
+      gint l, r;
 
-  /*   Now count start and end separately */
-  n *= 2;
+      if (j < 0)
+        continue;
 
-  insert_sort (data, n);
+      /*  a span covers the subsamples from left to right inclusively  */
+      left  = MAX (blob->data[j].left,      x0) - x0;
+      right = MIN (blob->data[j].right + 1, x1) - x0;
 
-  /* Discard portions outside of tile */
+      if (left >= right)
+        continue;
 
-  while ((n > 0) && (data[0] < SUBSAMPLE*x))
-    {
-      if (data[1] == ROW_START)
-        current++;
-      else
-        current--;
-      data += 2;
-      n--;
-    }
+      l = left  / SUBSAMPLE;
+      r = right / SUBSAMPLE;
 
-  while ((n > 0) && (data[2*(n-1)] >= SUBSAMPLE*(x+width)))
-    n--;
+      if (l == r)
+        {
+          partial[l] += right - left;
+        }
+      else
+        {
+          partial[l]   += (l + 1) * SUBSAMPLE - left;
+          delta[l + 1] += SUBSAMPLE;
+          delta[r]     -= SUBSAMPLE;
+          partial[r]   += right - r * SUBSAMPLE;
+        }
 
-  /* Render the row */
+      first = MIN (first, l);
+      last  = MAX (last,  r);
+    }
 
-  last_x = 0;
-  for (i = 0; i < n;)
+  for (i = first; i <= last; i++)
     {
-      gint cur_x = data[2 * i] / SUBSAMPLE - x;
-      gint pixel;
+      gint value;
 
-      /* Fill in portion leading up to this pixel */
-      if (current && cur_x != last_x)
-        fill_run (dest + last_x, (255 * current) / SUBSAMPLE, cur_x - last_x);
+      full += delta[i];
+      value = full + partial[i];
 
-      /* Compute the value for this pixel */
-      pixel = current * SUBSAMPLE;
+      partial[i] = 0;
+      delta[i]   = 0;
 
-      while (i<n)
+      if (value && i < width)
         {
-          gint tmp_x = data[2 * i] / SUBSAMPLE;
-
-          if (tmp_x - x != cur_x)
-            break;
+          guchar alpha = ((value * 255 + SUBSAMPLE * SUBSAMPLE / 2) /
+                          (SUBSAMPLE * SUBSAMPLE));
 
-          if (data[2 * i + 1] == ROW_START)
-            {
-              current++;
-              pixel += ((tmp_x + 1) * SUBSAMPLE) - data[2 * i];
-            }
-          else
-            {
-              current--;
-              pixel -= ((tmp_x + 1) * SUBSAMPLE) - data[2 * i];
-            }
-
-          i++;
+          dest[i] = MAX (dest[i], alpha);
         }
-
-      dest[cur_x] = MAX (dest[cur_x], (pixel * 255) / (SUBSAMPLE * SUBSAMPLE));
-
-      last_x = cur_x + 1;
     }
-
-  if (current != 0)
-    fill_run (dest + last_x, (255 * current)/ SUBSAMPLE, width - last_x);
 }
 
 static void
-render_blob (GeglBuffer    *buffer,
+render_blob (GimpInk       *ink,
+             GeglBuffer    *buffer,
              GeglRectangle *rect,
              GimpBlob      *blob)
 {
   GeglBufferIterator *iter;
   GeglRectangle      *roi;
 
+  if (ink->coverage_size < 2 * (rect->width + 1))
+    {
+      g_free (ink->coverage);
+
+      ink->coverage_size = 2 * (rect->width + 1);
+      ink->coverage      = g_new0 (gint, ink->coverage_size);
+    }
+
   iter = gegl_buffer_iterator_new (buffer, rect, 0, babl_format ("Y u8"),
                                    GEGL_BUFFER_READWRITE, GEGL_ABYSS_NONE);
   roi = &iter->roi[0];
@@ -661,7 +612,8 @@ render_blob (GeglBuffer    *buffer,
 
       for (y = 0; y < h; y++, d += roi->width * 1)
         {
-          render_blob_line (blob, d, roi->x, roi->y + y, roi->width);
+          render_blob_line (blob, ink->coverage,
+                            d, roi->x, roi->y + y, roi->width);
         }
     }
 }
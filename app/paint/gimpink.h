@@ -41,6 +41,12 @@ struct _GimpInk
 
   GimpBlob      *cur_blob;     /*  current blob                   */
   GimpBlob      *last_blob;    /*  blob for last cursor position  */
+
+  GimpBlob      *spare_blob;   /*  storage for the next blob      */
+  GimpBlob      *union_blob;   /*  storage for the rendered blob  */
+
+  gint          *coverage;     /*  rasterizer scratch space       */
+  gint           coverage_size;
 };
 
 struct _GimpInkClass
@@ -47,6 +47,8 @@
 
 #include "gimpairbrush.h"
 
+#include "gimp-trace.h"
+
 #include "gimp-intl.h"
 
 
@@ -298,6 +300,8 @@ gimp_paint_core_paint (GimpPaintCore    *core,
 
   core_class = GIMP_PAINT_CORE_GET_CLASS (core);
 
+  GIMP_TRACE_BEGIN ("gimp_paint_core_paint");
+
   if (core_class->pre_paint (core, drawable,
                              paint_options,
                              paint_state, time))
@@ -319,6 +323,8 @@ gimp_paint_core_paint (GimpPaintCore    *core,
                               paint_options,
                               paint_state, time);
     }
+
+  GIMP_TRACE_END ("gimp_paint_core_paint");
 }
 
 gboolean
@@ -364,7 +370,8 @@ gimp_paint_core_start (GimpPaintCore     *core,
   if (core->undo_buffer)
     g_object_unref (core->undo_buffer);
 
-  core->undo_buffer = gegl_buffer_dup (gimp_drawable_get_buffer (drawable));
+  core->undo_buffer =
+    gimp_gegl_buffer_dup (gimp_drawable_get_buffer (drawable));
 
   /*  Allocate the saved proj structure  */
   if (core->saved_proj_buffer)
@@ -378,7 +385,7 @@ gimp_paint_core_start (GimpPaintCore     *core,
       GimpPickable *pickable = GIMP_PICKABLE (gimp_image_get_projection (image));
       GeglBuffer   *buffer   = gimp_pickable_get_buffer (pickable);
 
-      core->saved_proj_buffer = gegl_buffer_dup (buffer);
+      core->saved_proj_buffer = gimp_gegl_buffer_dup (buffer);
     }
 
   /*  Allocate the canvas blocks structure  */
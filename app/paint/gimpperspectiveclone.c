@@ -27,7 +27,6 @@
 
 #include "paint-types.h"
 
-#include "gegl/gimp-gegl-nodes.h"
 #include "gegl/gimp-gegl-utils.h"
 
 #include "core/gimp.h"
@@ -187,36 +186,14 @@ gimp_perspective_clone_paint (GimpPaintCore    *paint_core,
                 orig_buffer = gimp_paint_core_get_orig_image (paint_core);
             }
 
-          clone->node = gegl_node_new ();
-
-          g_object_set (clone->node,
-                        "dont-cache", TRUE,
-                        NULL);
-
-          clone->src_node =
-            gegl_node_new_child (clone->node,
-                                 "operation", "gegl:buffer-source",
-                                 "buffer",    orig_buffer,
-                                  NULL);
-
-          clone->transform_node =
-            gegl_node_new_child (clone->node,
-                                 "operation",  "gegl:transform",
-                                 "filter",     gimp_interpolation_to_gegl_filter (GIMP_INTERPOLATION_LINEAR),
-                                 "hard-edges", TRUE,
-                                 NULL);
-
-          clone->dest_node =
-            gegl_node_new_child (clone->node,
-                                 "operation", "gegl:write-buffer",
-                                 NULL);
-
-          gegl_node_link_many (clone->src_node,
-                               clone->transform_node,
-                               clone->dest_node,
-                               NULL);
-
-          clone->processor = gegl_node_new_processor (clone->dest_node, NULL);
+          /*  the dabs are sampled straight from the source, the
+           *  sampler keeps the source pixels around the last sample
+           *  so consecutive pixels and dabs mostly hit its cache
+           */
+          clone->sampler =
+            gegl_buffer_sampler_new (orig_buffer,
+                                     gimp_pickable_get_format_with_alpha (src_pickable),
+                                     gimp_interpolation_to_gegl_sampler (GIMP_INTERPOLATION_LINEAR));
         }
       break;
 
@@ -277,15 +254,16 @@ gimp_perspective_clone_paint (GimpPaintCore    *paint_core,
       break;
 
     case GIMP_PAINT_STATE_FINISH:
-      if (clone->node)
+      if (clone->sampler)
         {
-          g_object_unref (clone->node);
-          g_object_unref (clone->processor);
-          clone->node = NULL;
-          clone->src_node = NULL;
-          clone->transform_node = NULL;
-          clone->dest_node = NULL;
-          clone->processor = NULL;
+          g_object_unref (clone->sampler);
+          clone->sampler = NULL;
+        }
+
+      if (clone->dab_buffer)
+        {
+          g_object_unref (clone->dab_buffer);
+          clone->dab_buffer = NULL;
         }
       break;
 
@@ -315,16 +293,21 @@ gimp_perspective_clone_get_source (GimpSourceCore   *source_core,
 {
   GimpPerspectiveClone *clone = GIMP_PERSPECTIVE_CLONE (source_core);
   GeglBuffer           *src_buffer;
-  GeglBuffer           *dest_buffer;
   const Babl           *src_format_alpha;
+  GeglBufferIterator   *iter;
+  gint                  bpp;
   gint                  x1d, y1d, x2d, y2d;
   gdouble               x1s, y1s, x2s, y2s, x3s, y3s, x4s, y4s;
   gint                  xmin, ymin, xmax, ymax;
-  GimpMatrix3           matrix;
-  GimpMatrix3           gegl_matrix;
+  gint                  src_width, src_height;
+  GimpMatrix3           inverse;
 
   src_buffer       = gimp_pickable_get_buffer (src_pickable);
   src_format_alpha = gimp_pickable_get_format_with_alpha (src_pickable);
+  bpp              = babl_format_get_bytes_per_pixel (src_format_alpha);
+
+  src_width  = gegl_buffer_get_width  (src_buffer);
+  src_height = gegl_buffer_get_height (src_buffer);
 
   /* Destination coordinates that will be painted */
   x1d = paint_buffer_x;
@@ -349,37 +332,94 @@ gimp_perspective_clone_get_source (GimpSourceCore   *source_core,
   if (! gimp_rectangle_intersect (xmin, ymin,
                                   xmax - xmin, ymax - ymin,
                                   0, 0,
-                                  gegl_buffer_get_width  (src_buffer),
-                                  gegl_buffer_get_height (src_buffer),
+                                  src_width, src_height,
                                   NULL, NULL, NULL, NULL))
     {
       /* if the source area is completely out of the image */
       return FALSE;
     }
 
-  dest_buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, x2d - x1d, y2d - y1d),
-                                 src_format_alpha);
+  /*  the dab buffer is kept for the whole stroke, and only replaced
+   *  when a dab doesn't fit
+   */
+  if (! clone->dab_buffer                                      ||
+      gegl_buffer_get_width  (clone->dab_buffer) < x2d - x1d ||
+      gegl_buffer_get_height (clone->dab_buffer) < y2d - y1d)
+    {
+      gint width  = x2d - x1d;
+      gint height = y2d - y1d;
+
+      if (clone->dab_buffer)
+        {
+          width  = MAX (width,  gegl_buffer_get_width  (clone->dab_buffer));
+          height = MAX (height, gegl_buffer_get_height (clone->dab_buffer));
 
-  gimp_perspective_clone_get_matrix (clone, &matrix);
+          g_object_unref (clone->dab_buffer);
+        }
 
-  gimp_matrix3_identity (&gegl_matrix);
-  gimp_matrix3_mult (&matrix, &gegl_matrix);
-  gimp_matrix3_translate (&gegl_matrix, -x1d, -y1d);
+      clone->dab_buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0,
+                                                           width, height),
+                                           src_format_alpha);
+    }
 
-  gimp_gegl_node_set_matrix (clone->transform_node, &gegl_matrix);
+  /*  map each destination pixel's center back to the source  */
+  gimp_perspective_clone_get_matrix (clone, &inverse);
+  gimp_matrix3_invert (&inverse);
 
-  gegl_node_set (clone->dest_node,
-                 "buffer", dest_buffer,
-                 NULL);
+  iter = gegl_buffer_iterator_new (clone->dab_buffer,
+                                   GEGL_RECTANGLE (0, 0,
+                                                   x2d - x1d, y2d - y1d),
+                                   0, src_format_alpha,
+                                   GEGL_BUFFER_WRITE, GEGL_ABYSS_NONE);
 
-  gegl_processor_set_rectangle (clone->processor,
-                                GEGL_RECTANGLE (0, 0,
-                                                x2d - x1d, y2d - y1d));
-  while (gegl_processor_work (clone->processor, NULL));
+  while (gegl_buffer_iterator_next (iter))
+    {
+      const GeglRectangle *roi  = &iter->roi[0];
+      guchar              *dest = iter->data[0];
+      gint                 y;
+
+      for (y = roi->y; y < roi->y + roi->height; y++)
+        {
+          gdouble dx = x1d + roi->x + 0.5;
+          gdouble dy = y1d + y + 0.5;
+          gdouble u  = (inverse.coeff[0][0] * dx +
+                        inverse.coeff[0][1] * dy +
+                        inverse.coeff[0][2]);
+          gdouble v  = (inverse.coeff[1][0] * dx +
+                        inverse.coeff[1][1] * dy +
+                        inverse.coeff[1][2]);
+          gdouble w  = (inverse.coeff[2][0] * dx +
+                        inverse.coeff[2][1] * dy +
+                        inverse.coeff[2][2]);
+          gint    x;
+
+          for (x = 0; x < roi->width; x++, dest += bpp)
+            {
+              gdouble sx = u / w;
+              gdouble sy = v / w;
+
+              /*  farther out, the sampler would only see the abyss  */
+              if (sx > -1.0 && sx < src_width  + 1.0 &&
+                  sy > -1.0 && sy < src_height + 1.0)
+                {
+                  gegl_sampler_get (clone->sampler, sx, sy, NULL, dest,
+                                    GEGL_ABYSS_NONE);
+                }
+              else
+                {
+                  memset (dest, 0, bpp);
+                }
+
+              u += inverse.coeff[0][0];
+              v += inverse.coeff[1][0];
+              w += inverse.coeff[2][0];
+            }
+        }
+    }
 
   *src_rect = *GEGL_RECTANGLE (0, 0, x2d - x1d, y2d - y1d);
 
-  return dest_buffer;
+  return g_object_ref (clone->dab_buffer);
 }
 
 
@@ -45,11 +45,8 @@ struct _GimpPerspectiveClone
   GimpMatrix3    transform;
   GimpMatrix3    transform_inv;
 
-  GeglNode      *node;
-  GeglNode      *src_node;
-  GeglNode      *transform_node;
-  GeglNode      *dest_node;
-  GeglProcessor *processor;
+  GeglSampler   *sampler;      /* samples the source during a stroke */
+  GeglBuffer    *dab_buffer;   /* the transformed source of a dab     */
 };
 
 struct _GimpPerspectiveCloneClass
@@ -41,6 +41,7 @@
 #include "core/gimpimage-crop.h"
 #include "core/gimpimage-duplicate.h"
 #include "core/gimpimage-flip.h"
+#include "core/gimpimage-memory.h"
 #include "core/gimpimage-merge.h"
 #include "core/gimpimage-pick-color.h"
 #include "core/gimpimage-pick-layer.h"
@@ -2868,6 +2869,68 @@ image_get_parasite_list_invoker (GimpProcedure         *procedure,
   return return_vals;
 }
 
+static GimpValueArray *
+image_get_memory_usage_invoker (GimpProcedure         *procedure,
+                                Gimp                  *gimp,
+                                GimpContext           *context,
+                                GimpProgress          *progress,
+                                const GimpValueArray  *args,
+                                GError               **error)
+{
+  gboolean success = TRUE;
+  GimpValueArray *return_vals;
+  GimpImage *image;
+  gdouble total = 0.0;
+  gdouble layers = 0.0;
+  gdouble layer_masks = 0.0;
+  gdouble channels = 0.0;
+  gdouble selection = 0.0;
+  gdouble projections = 0.0;
+  gdouble shadows = 0.0;
+  gdouble undo = 0.0;
+  gdouble redo = 0.0;
+  gdouble previews = 0.0;
+
+  image = gimp_value_get_image (gimp_value_array_index (args, 0), gimp);
+
+  if (success)
+    {
+      GimpImageMemoryUsage usage;
+
+      gimp_image_get_memory_usage (image, &usage);
+
+      total       = gimp_image_memory_usage_get_total (&usage);
+      layers      = usage.layers;
+      layer_masks = usage.layer_masks;
+      channels    = usage.channels;
+      selection   = usage.selection;
+      projections = usage.projections;
+      shadows     = usage.shadows;
+      undo        = usage.undo;
+      redo        = usage.redo;
+      previews    = usage.previews;
+    }
+
+  return_vals = gimp_procedure_get_return_values (procedure, success,
+                                                  error ? *error : NULL);
+
+  if (success)
+    {
+      g_value_set_double (gimp_value_array_index (return_vals, 1), total);
+      g_value_set_double (gimp_value_array_index (return_vals, 2), layers);
+      g_value_set_double (gimp_value_array_index (return_vals, 3), layer_masks);
+      g_value_set_double (gimp_value_array_index (return_vals, 4), channels);
+      g_value_set_double (gimp_value_array_index (return_vals, 5), selection);
+      g_value_set_double (gimp_value_array_index (return_vals, 6), projections);
+      g_value_set_double (gimp_value_array_index (return_vals, 7), shadows);
+      g_value_set_double (gimp_value_array_index (return_vals, 8), undo);
+      g_value_set_double (gimp_value_array_index (return_vals, 9), redo);
+      g_value_set_double (gimp_value_array_index (return_vals, 10), previews);
+    }
+
+  return return_vals;
+}
+
 void
 register_image_procs (GimpPDB *pdb)
 {
@@ -5748,4 +5811,87 @@ register_image_procs (GimpPDB *pdb)
                                                                  GIMP_PARAM_READWRITE));
   gimp_pdb_register_procedure (pdb, procedure);
   g_object_unref (procedure);
+
+  /*
+   * gimp-image-get-memory-usage
+   */
+  procedure = gimp_procedure_new (image_get_memory_usage_invoker);
+  gimp_object_set_static_name (GIMP_OBJECT (procedure),
+                               "gimp-image-get-memory-usage");
+  gimp_procedure_set_static_strings (procedure,
+                                     "gimp-image-get-memory-usage",
+                                     "Returns the memory used by the specified image.",
+                                     "This procedure returns the memory used by the specified image, broken down by what it is used for. Every buffer is attributed to exactly one category, so the categories add up to the total. Sizes are returned as floating point numbers because they may exceed the range of a 32-bit integer.",
+                                     "agent",
+                                     "agent",
+                                     "2026",
+                                     NULL);
+  gimp_procedure_add_argument (procedure,
+                               gimp_param_spec_image_id ("image",
+                                                         "image",
+                                                         "The image",
+                                                         pdb->gimp, FALSE,
+                                                         GIMP_PARAM_READWRITE));
+  gimp_procedure_add_return_value (procedure,
+                                   g_param_spec_double ("total",
+                                                        "total",
+                                                        "The total memory used by the image, in bytes",
+                                                        0, G_MAXDOUBLE, 0,
+                                                        GIMP_PARAM_READWRITE));
+  gimp_procedure_add_return_value (procedure,
+                                   g_param_spec_double ("layers",
+                                                        "layers",
+                                                        "Memory used by layer buffers, in bytes",
+                                                        0, G_MAXDOUBLE, 0,
+                                                        GIMP_PARAM_READWRITE));
+  gimp_procedure_add_return_value (procedure,
+                                   g_param_spec_double ("layer-masks",
+                                                        "layer masks",
+                                                        "Memory used by layer mask buffers, in bytes",
+                                                        0, G_MAXDOUBLE, 0,
+                                                        GIMP_PARAM_READWRITE));
+  gimp_procedure_add_return_value (procedure,
+                                   g_param_spec_double ("channels",
+                                                        "channels",
+                                                        "Memory used by channel buffers, in bytes",
+                                                        0, G_MAXDOUBLE, 0,
+                                                        GIMP_PARAM_READWRITE));
+  gimp_procedure_add_return_value (procedure,
+                                   g_param_spec_double ("selection",
+                                                        "selection",
+                                                        "Memory used by the selection mask, in bytes",
+                                                        0, G_MAXDOUBLE, 0,
+                                                        GIMP_PARAM_READWRITE));
+  gimp_procedure_add_return_value (procedure,
+                                   g_param_spec_double ("projections",
+                                                        "projections",
+                                                        "Memory used by the rendered tiles of the image and group layer projections, in bytes",
+                                                        0, G_MAXDOUBLE, 0,
+                                                        GIMP_PARAM_READWRITE));
+  gimp_procedure_add_return_value (procedure,
+                                   g_param_spec_double ("shadows",
+                                                        "shadows",
+                                                        "Memory used by shadow buffers, in bytes",
+                                                        0, G_MAXDOUBLE, 0,
+                                                        GIMP_PARAM_READWRITE));
+  gimp_procedure_add_return_value (procedure,
+                                   g_param_spec_double ("undo",
+                                                        "undo",
+                                                        "Memory used by the undo stack, in bytes",
+                                                        0, G_MAXDOUBLE, 0,
+                                                        GIMP_PARAM_READWRITE));
+  gimp_procedure_add_return_value (procedure,
+                                   g_param_spec_double ("redo",
+                                                        "redo",
+                                                        "Memory used by the redo stack, in bytes",
+                                                        0, G_MAXDOUBLE, 0,
+                                                        GIMP_PARAM_READWRITE));
+  gimp_procedure_add_return_value (procedure,
+                                   g_param_spec_double ("previews",
+                                                        "previews",
+                                                        "Memory used by cached previews, in bytes",
+                                                        0, G_MAXDOUBLE, 0,
+                                                        GIMP_PARAM_READWRITE));
+  gimp_pdb_register_procedure (pdb, procedure);
+  g_object_unref (procedure);
 }
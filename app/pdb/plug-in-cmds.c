@@ -34,6 +34,7 @@
 
 #include "core/gimp.h"
 #include "core/gimpparamspecs.h"
+#include "plug-in/gimpplugin-stats.h"
 #include "plug-in/gimpplugin.h"
 #include "plug-in/gimpplugindef.h"
 #include "plug-in/gimppluginmanager-menu-branch.h"
@@ -400,6 +401,86 @@ plugin_precision_enabled_invoker (GimpProcedure         *procedure,
   return return_vals;
 }
 
+static GimpValueArray *
+plugin_get_ipc_stats_invoker (GimpProcedure         *procedure,
+                              Gimp                  *gimp,
+                              GimpContext           *context,
+                              GimpProgress          *progress,
+                              const GimpValueArray  *args,
+                              GError               **error)
+{
+  gboolean success = TRUE;
+  GimpValueArray *return_vals;
+  const gchar *plugin;
+  gint32 message_type;
+  gint32 n_runs = 0;
+  gdouble time_running = 0.0;
+  gdouble time_blocked = 0.0;
+  gdouble time_handling = 0.0;
+  gint32 n_messages = 0;
+  gdouble pipe_bytes = 0.0;
+  gdouble shm_bytes = 0.0;
+  gint32 num_buckets = 0;
+  gdouble *latency = NULL;
+
+  plugin = g_value_get_string (gimp_value_array_index (args, 0));
+  message_type = g_value_get_int (gimp_value_array_index (args, 1));
+
+  if (success)
+    {
+      const GimpPlugInStats *stats;
+
+      stats = gimp_plug_in_manager_get_stats (gimp->plug_in_manager, plugin);
+
+      if (stats)
+        {
+          GimpPlugInMessageStats message;
+          gint                   i;
+
+          if (message_type < 0)
+            gimp_plug_in_stats_get_totals (stats, &message);
+          else
+            message = stats->messages[message_type];
+
+          n_runs        = stats->n_runs;
+          time_running  = stats->time_running / 1000000.0;
+          time_blocked  = (stats->time_reading + stats->time_writing) / 1000000.0;
+          time_handling = message.time_handling / 1000000.0;
+          n_messages    = message.n_received + message.n_sent;
+          pipe_bytes    = message.bytes_received + message.bytes_sent;
+          shm_bytes     = message.shm_bytes;
+
+          num_buckets = GIMP_PLUG_IN_STATS_N_BUCKETS;
+          latency     = g_new (gdouble, num_buckets);
+
+          for (i = 0; i < num_buckets; i++)
+            latency[i] = message.latency[i];
+        }
+      else
+        {
+          success = FALSE;
+        }
+    }
+
+  return_vals = gimp_procedure_get_return_values (procedure, success,
+                                                  error ? *error : NULL);
+
+  if (success)
+    {
+      g_value_set_int (gimp_value_array_index (return_vals, 1), n_runs);
+      g_value_set_double (gimp_value_array_index (return_vals, 2), time_running);
+      g_value_set_double (gimp_value_array_index (return_vals, 3), time_blocked);
+      g_value_set_double (gimp_value_array_index (return_vals, 4), time_handling);
+      g_value_set_int (gimp_value_array_index (return_vals, 5), n_messages);
+      g_value_set_double (gimp_value_array_index (return_vals, 6), pipe_bytes);
+      g_value_set_double (gimp_value_array_index (return_vals, 7), shm_bytes);
+      g_value_set_int (gimp_value_array_index (return_vals, 8), num_buckets);
+      gimp_value_take_floatarray (gimp_value_array_index (return_vals, 9), latency, num_buckets);
+    }
+
+  return return_vals;
+}
+
 void
 register_plug_in_procs (GimpPDB *pdb)
 {
@@ -748,4 +829,87 @@ register_plug_in_procs (GimpPDB *pdb)
                                                          GIMP_PARAM_READWRITE));
   gimp_pdb_register_procedure (pdb, procedure);
   g_object_unref (procedure);
+
+  /*
+   * gimp-plugin-get-ipc-stats
+   */
+  procedure = gimp_procedure_new (plugin_get_ipc_stats_invoker);
+  gimp_object_set_static_name (GIMP_OBJECT (procedure),
+                               "gimp-plugin-get-ipc-stats");
+  gimp_procedure_set_static_strings (procedure,
+                                     "gimp-plugin-get-ipc-stats",
+                                     "Returns statistics about the communication with a plug-in.",
+                                     "This procedure returns what GIMP measured while talking to the plug-in executable @plugin, summed over all its runs in this session. If @message_type is -1, the message counts, byte counts and handling times are summed over all wire protocol message types, otherwise they are restricted to the given type (0 = QUIT, ..., 12 = HAS_INIT). Times are in seconds. The latency histogram counts how long GIMP took to handle each received message: bucket n counts messages that took less than 2^n microseconds. Byte counts are returned as floating point numbers because they may exceed the range of a 32-bit integer.\n\nSet GIMP_LOG=plug-in-stats to have these statistics printed every time a plug-in exits.",
+                                     "agent",
+                                     "agent",
+                                     "2026",
+                                     NULL);
+  gimp_procedure_add_argument (procedure,
+                               gimp_param_spec_string ("plugin",
+                                                       "plugin",
+                                                       "The plug-in executable's name, e.g. \"blur\"",
+                                                       FALSE, FALSE, TRUE,
+                                                       NULL,
+                                                       GIMP_PARAM_READWRITE));
+  gimp_procedure_add_argument (procedure,
+                               gimp_param_spec_int32 ("message-type",
+                                                      "message type",
+                                                      "The wire protocol message type, or -1 for all types",
+                                                      -1, 12, -1,
+                                                      GIMP_PARAM_READWRITE));
+  gimp_procedure_add_return_value (procedure,
+                                   gimp_param_spec_int32 ("n-runs",
+                                                          "n runs",
+                                                          "The number of times the plug-in was run",
+                                                          G_MININT32, G_MAXINT32, 0,
+                                                          GIMP_PARAM_READWRITE));
+  gimp_procedure_add_return_value (procedure,
+                                   g_param_spec_double ("time-running",
+                                                        "time running",
+                                                        "The time the plug-in was running",
+                                                        0, G_MAXDOUBLE, 0,
+                                                        GIMP_PARAM_READWRITE));
+  gimp_procedure_add_return_value (procedure,
+                                   g_param_spec_double ("time-blocked",
+                                                        "time blocked",
+                                                        "The time GIMP was blocked reading from or writing to the plug-in",
+                                                        0, G_MAXDOUBLE, 0,
+                                                        GIMP_PARAM_READWRITE));
+  gimp_procedure_add_return_value (procedure,
+                                   g_param_spec_double ("time-handling",
+                                                        "time handling",
+                                                        "The time GIMP spent handling messages from the plug-in",
+                                                        0, G_MAXDOUBLE, 0,
+                                                        GIMP_PARAM_READWRITE));
+  gimp_procedure_add_return_value (procedure,
+                                   gimp_param_spec_int32 ("n-messages",
+                                                          "n messages",
+                                                          "The number of messages received and sent",
+                                                          G_MININT32, G_MAXINT32, 0,
+                                                          GIMP_PARAM_READWRITE));
+  gimp_procedure_add_return_value (procedure,
+                                   g_param_spec_double ("pipe-bytes",
+                                                        "pipe bytes",
+                                                        "The number of bytes received and sent through the pipe",
+                                                        0, G_MAXDOUBLE, 0,
+                                                        GIMP_PARAM_READWRITE));
+  gimp_procedure_add_return_value (procedure,
+                                   g_param_spec_double ("shm-bytes",
+                                                        "shm bytes",
+                                                        "The number of bytes of tile data passed in shared memory",
+                                                        0, G_MAXDOUBLE, 0,
+                                                        GIMP_PARAM_READWRITE));
+  gimp_procedure_add_return_value (procedure,
+                                   gimp_param_spec_int32 ("num-buckets",
+                                                          "num buckets",
+                                                          "The number of histogram buckets",
+                                                          0, G_MAXINT32, 0,
+                                                          GIMP_PARAM_READWRITE));
+  gimp_procedure_add_return_value (procedure,
+                                   gimp_param_spec_float_array ("latency",
+                                                                "latency",
+                                                                "The handling latency histogram",
+                                                                GIMP_PARAM_READWRITE));
+  gimp_pdb_register_procedure (pdb, procedure);
+  g_object_unref (procedure);
 }
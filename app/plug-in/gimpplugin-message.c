@@ -44,6 +44,7 @@
 #include "gimpplugin.h"
 #include "gimpplugin-cleanup.h"
 #include "gimpplugin-message.h"
+#include "gimpplugin-stats.h"
 #include "gimppluginmanager.h"
 #include "gimpplugindef.h"
 #include "gimppluginshm.h"
@@ -82,10 +83,18 @@ void
 gimp_plug_in_handle_message (GimpPlugIn      *plug_in,
                              GimpWireMessage *msg)
 {
+  guint32 type;
+  gint64  start;
+
   g_return_if_fail (GIMP_IS_PLUG_IN (plug_in));
   g_return_if_fail (plug_in->open == TRUE);
   g_return_if_fail (msg != NULL);
 
+  type  = msg->type;
+  start = g_get_monotonic_time ();
+
+  gimp_plug_in_stats_received (plug_in, type);
+
   switch (msg->type)
     {
     case GP_QUIT:
@@ -160,6 +169,8 @@ gimp_plug_in_handle_message (GimpPlugIn      *plug_in,
       gimp_plug_in_handle_has_init (plug_in);
       break;
     }
+
+  gimp_plug_in_stats_handled (plug_in, type, g_get_monotonic_time () - start);
 }
 
 
@@ -212,6 +223,8 @@ gimp_plug_in_handle_tile_put (GimpPlugIn *plug_in,
       return;
     }
 
+  gimp_plug_in_stats_sent (plug_in, GP_TILE_DATA);
+
   if (! gimp_wire_read_msg (plug_in->my_read, &msg, plug_in))
     {
       gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
@@ -220,6 +233,8 @@ gimp_plug_in_handle_tile_put (GimpPlugIn *plug_in,
       return;
     }
 
+  gimp_plug_in_stats_received (plug_in, msg.type);
+
   if (msg.type != GP_TILE_DATA)
     {
       gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
@@ -324,6 +339,10 @@ gimp_plug_in_handle_tile_put (GimpPlugIn *plug_in,
       gegl_buffer_set (buffer, &tile_rect, 0, format,
                        gimp_plug_in_shm_get_addr (plug_in->manager->shm),
                        GEGL_AUTO_ROWSTRIDE);
+
+      gimp_plug_in_stats_shm (plug_in, GP_TILE_DATA,
+                              babl_format_get_bytes_per_pixel (format) *
+                              tile_rect.width * tile_rect.height);
     }
   else
     {
@@ -341,6 +360,8 @@ gimp_plug_in_handle_tile_put (GimpPlugIn *plug_in,
       gimp_plug_in_close (plug_in, TRUE);
       return;
     }
+
+  gimp_plug_in_stats_sent (plug_in, GP_TILE_ACK);
 }
 
 static void
@@ -431,6 +452,8 @@ gimp_plug_in_handle_tile_get (GimpPlugIn *plug_in,
       gegl_buffer_get (buffer, &tile_rect, 1.0, format,
                        gimp_plug_in_shm_get_addr (plug_in->manager->shm),
                        GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+      gimp_plug_in_stats_shm (plug_in, GP_TILE_DATA, tile_size);
     }
   else
     {
@@ -449,6 +472,8 @@ gimp_plug_in_handle_tile_get (GimpPlugIn *plug_in,
       return;
     }
 
+  gimp_plug_in_stats_sent (plug_in, GP_TILE_DATA);
+
   if (! gimp_wire_read_msg (plug_in->my_read, &msg, plug_in))
     {
       gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
@@ -457,6 +482,8 @@ gimp_plug_in_handle_tile_get (GimpPlugIn *plug_in,
       return;
     }
 
+  gimp_plug_in_stats_received (plug_in, msg.type);
+
   if (msg.type != GP_TILE_ACK)
     {
       gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
@@ -628,6 +655,10 @@ gimp_plug_in_handle_proc_run (GimpPlugIn *plug_in,
                         "%s: ERROR", G_STRFUNC);
           gimp_plug_in_close (plug_in, TRUE);
         }
+      else
+        {
+          gimp_plug_in_stats_sent (plug_in, GP_PROC_RETURN);
+        }
 
       g_free (proc_return.params);
     }
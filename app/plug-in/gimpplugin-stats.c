@@ -0,0 +1,261 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimpplugin-stats.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <gegl.h>
+
+#include "libgimpbase/gimpprotocol.h"
+
+#include "plug-in-types.h"
+
+#include "gimpplugin.h"
+#include "gimpplugin-stats.h"
+
+
+G_STATIC_ASSERT (GIMP_PLUG_IN_STATS_N_MESSAGES == GP_HAS_INIT + 1);
+
+
+static const gchar * const message_names[GIMP_PLUG_IN_STATS_N_MESSAGES] =
+{
+  "QUIT",
+  "CONFIG",
+  "TILE_REQ",
+  "TILE_ACK",
+  "TILE_DATA",
+  "PROC_RUN",
+  "PROC_RETURN",
+  "TEMP_PROC_RUN",
+  "TEMP_PROC_RETURN",
+  "PROC_INSTALL",
+  "PROC_UNINSTALL",
+  "EXTENSION_ACK",
+  "HAS_INIT"
+};
+
+
+GimpPlugInStats *
+gimp_plug_in_stats_new (void)
+{
+  return g_slice_new0 (GimpPlugInStats);
+}
+
+void
+gimp_plug_in_stats_free (GimpPlugInStats *stats)
+{
+  g_return_if_fail (stats != NULL);
+
+  g_slice_free (GimpPlugInStats, stats);
+}
+
+void
+gimp_plug_in_stats_merge (GimpPlugInStats       *stats,
+                          const GimpPlugInStats *other)
+{
+  gint i, j;
+
+  g_return_if_fail (stats != NULL);
+  g_return_if_fail (other != NULL);
+
+  stats->n_runs       += other->n_runs;
+  stats->time_running += other->time_running;
+  stats->time_reading += other->time_reading;
+  stats->time_writing += other->time_writing;
+
+  for (i = 0; i < GIMP_PLUG_IN_STATS_N_MESSAGES; i++)
+    {
+      GimpPlugInMessageStats       *dest = &stats->messages[i];
+      const GimpPlugInMessageStats *src  = &other->messages[i];
+
+      dest->n_received     += src->n_received;
+      dest->n_sent         += src->n_sent;
+      dest->bytes_received += src->bytes_received;
+      dest->bytes_sent     += src->bytes_sent;
+      dest->shm_bytes      += src->shm_bytes;
+      dest->time_handling  += src->time_handling;
+
+      for (j = 0; j < GIMP_PLUG_IN_STATS_N_BUCKETS; j++)
+        dest->latency[j] += src->latency[j];
+    }
+}
+
+void
+gimp_plug_in_stats_get_totals (const GimpPlugInStats  *stats,
+                               GimpPlugInMessageStats *totals)
+{
+  gint i, j;
+
+  g_return_if_fail (stats != NULL);
+  g_return_if_fail (totals != NULL);
+
+  memset (totals, 0, sizeof (GimpPlugInMessageStats));
+
+  for (i = 0; i < GIMP_PLUG_IN_STATS_N_MESSAGES; i++)
+    {
+      const GimpPlugInMessageStats *message = &stats->messages[i];
+
+      totals->n_received     += message->n_received;
+      totals->n_sent         += message->n_sent;
+      totals->bytes_received += message->bytes_received;
+      totals->bytes_sent     += message->bytes_sent;
+      totals->shm_bytes      += message->shm_bytes;
+      totals->time_handling  += message->time_handling;
+
+      for (j = 0; j < GIMP_PLUG_IN_STATS_N_BUCKETS; j++)
+        totals->latency[j] += message->latency[j];
+    }
+}
+
+void
+gimp_plug_in_stats_dump (const GimpPlugInStats *stats,
+                         const gchar           *name)
+{
+  GimpPlugInMessageStats totals;
+  gint                   i, j;
+
+  g_return_if_fail (stats != NULL);
+  g_return_if_fail (name != NULL);
+
+  gimp_plug_in_stats_get_totals (stats, &totals);
+
+  g_printerr ("\nIPC statistics for plug-in '%s' (%" G_GINT64_FORMAT " runs)\n"
+              "  running: %.3f s, blocked reading: %.3f s, "
+              "blocked writing: %.3f s, handling: %.3f s\n"
+              "  pipe: %" G_GINT64_FORMAT " bytes in, "
+              "%" G_GINT64_FORMAT " bytes out, "
+              "shm: %" G_GINT64_FORMAT " bytes\n\n",
+              name, stats->n_runs,
+              stats->time_running / 1000000.0,
+              stats->time_reading / 1000000.0,
+              stats->time_writing / 1000000.0,
+              totals.time_handling / 1000000.0,
+              totals.bytes_received,
+              totals.bytes_sent,
+              totals.shm_bytes);
+
+  g_printerr ("  %-16s %8s %8s %12s %12s %12s %10s  %s\n",
+              "message", "recv", "sent", "bytes in", "bytes out",
+              "shm bytes", "handle ms", "latency histogram (2^n us)");
+
+  for (i = 0; i < GIMP_PLUG_IN_STATS_N_MESSAGES; i++)
+    {
+      const GimpPlugInMessageStats *message = &stats->messages[i];
+
+      if (message->n_received == 0 && message->n_sent == 0)
+        continue;
+
+      g_printerr ("  %-16s %8" G_GINT64_FORMAT " %8" G_GINT64_FORMAT
+                  " %12" G_GINT64_FORMAT " %12" G_GINT64_FORMAT
+                  " %12" G_GINT64_FORMAT " %10.3f ",
+                  message_names[i],
+                  message->n_received,
+                  message->n_sent,
+                  message->bytes_received,
+                  message->bytes_sent,
+                  message->shm_bytes,
+                  message->time_handling / 1000.0);
+
+      for (j = 0; j < GIMP_PLUG_IN_STATS_N_BUCKETS; j++)
+        if (message->latency[j])
+          g_printerr (" %d:%" G_GINT64_FORMAT, j, message->latency[j]);
+
+      g_printerr ("\n");
+    }
+}
+
+/*  called right after a message of @type was read from the plug-in,
+ *  before it is handled, so nested messages don't steal its bytes
+ */
+void
+gimp_plug_in_stats_received (GimpPlugIn *plug_in,
+                             guint32     type)
+{
+  GimpPlugInMessageStats *message;
+
+  g_return_if_fail (GIMP_IS_PLUG_IN (plug_in));
+
+  if (type >= GIMP_PLUG_IN_STATS_N_MESSAGES)
+    return;
+
+  message = &plug_in->stats->messages[type];
+
+  message->n_received++;
+  message->bytes_received += plug_in->unaccounted_read;
+
+  plug_in->unaccounted_read = 0;
+}
+
+void
+gimp_plug_in_stats_handled (GimpPlugIn *plug_in,
+                            guint32     type,
+                            gint64      time)
+{
+  GimpPlugInMessageStats *message;
+  gint                    bucket;
+
+  g_return_if_fail (GIMP_IS_PLUG_IN (plug_in));
+
+  if (type >= GIMP_PLUG_IN_STATS_N_MESSAGES)
+    return;
+
+  message = &plug_in->stats->messages[type];
+
+  message->time_handling += time;
+
+  for (bucket = 0; bucket < GIMP_PLUG_IN_STATS_N_BUCKETS - 1; bucket++)
+    if (time < ((gint64) 1 << bucket))
+      break;
+
+  message->latency[bucket]++;
+}
+
+/*  called right after a message of @type was written to the plug-in  */
+void
+gimp_plug_in_stats_sent (GimpPlugIn *plug_in,
+                         guint32     type)
+{
+  GimpPlugInMessageStats *message;
+
+  g_return_if_fail (GIMP_IS_PLUG_IN (plug_in));
+
+  if (type >= GIMP_PLUG_IN_STATS_N_MESSAGES)
+    return;
+
+  message = &plug_in->stats->messages[type];
+
+  message->n_sent++;
+  message->bytes_sent += plug_in->unaccounted_written;
+
+  plug_in->unaccounted_written = 0;
+}
+
+void
+gimp_plug_in_stats_shm (GimpPlugIn *plug_in,
+                        guint32     type,
+                        gint64      bytes)
+{
+  g_return_if_fail (GIMP_IS_PLUG_IN (plug_in));
+
+  if (type >= GIMP_PLUG_IN_STATS_N_MESSAGES)
+    return;
+
+  plug_in->stats->messages[type].shm_bytes += bytes;
+}
@@ -0,0 +1,79 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimpplugin-stats.h
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GIMP_PLUG_IN_STATS_H__
+#define __GIMP_PLUG_IN_STATS_H__
+
+
+/*  one slot per wire protocol message type, GP_QUIT .. GP_HAS_INIT  */
+#define GIMP_PLUG_IN_STATS_N_MESSAGES  13
+
+/*  log2 latency buckets: bucket n counts handling times below 2^n µs,
+ *  the last bucket takes everything slower
+ */
+#define GIMP_PLUG_IN_STATS_N_BUCKETS   24
+
+
+typedef struct _GimpPlugInMessageStats GimpPlugInMessageStats;
+
+struct _GimpPlugInMessageStats
+{
+  gint64  n_received;
+  gint64  n_sent;
+  gint64  bytes_received;  /*  bytes through the pipe        */
+  gint64  bytes_sent;
+  gint64  shm_bytes;       /*  tile data through shared mem  */
+  gint64  time_handling;   /*  µs spent handling in the app  */
+  gint64  latency[GIMP_PLUG_IN_STATS_N_BUCKETS];
+};
+
+struct _GimpPlugInStats
+{
+  gint64                  n_runs;
+  gint64                  time_running;  /*  µs between open and close     */
+  gint64                  time_reading;  /*  µs blocked reading the pipe   */
+  gint64                  time_writing;  /*  µs blocked flushing the pipe  */
+
+  GimpPlugInMessageStats  messages[GIMP_PLUG_IN_STATS_N_MESSAGES];
+};
+
+
+GimpPlugInStats * gimp_plug_in_stats_new        (void);
+void              gimp_plug_in_stats_free       (GimpPlugInStats        *stats);
+
+void              gimp_plug_in_stats_merge      (GimpPlugInStats        *stats,
+                                                 const GimpPlugInStats  *other);
+void              gimp_plug_in_stats_get_totals (const GimpPlugInStats  *stats,
+                                                 GimpPlugInMessageStats *totals);
+void              gimp_plug_in_stats_dump       (const GimpPlugInStats  *stats,
+                                                 const gchar            *name);
+
+void              gimp_plug_in_stats_received   (GimpPlugIn             *plug_in,
+                                                 guint32                 type);
+void              gimp_plug_in_stats_handled    (GimpPlugIn             *plug_in,
+                                                 guint32                 type,
+                                                 gint64                  time);
+void              gimp_plug_in_stats_sent       (GimpPlugIn             *plug_in,
+                                                 guint32                 type);
+void              gimp_plug_in_stats_shm        (GimpPlugIn             *plug_in,
+                                                 guint32                 type,
+                                                 gint64                  bytes);
+
+
+#endif /* __GIMP_PLUG_IN_STATS_H__ */
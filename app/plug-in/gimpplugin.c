@@ -88,6 +88,7 @@
 #include "gimpplugin.h"
 #include "gimpplugin-message.h"
 #include "gimpplugin-progress.h"
+#include "gimpplugin-stats.h"
 #include "gimpplugindebug.h"
 #include "gimpplugindef.h"
 #include "gimppluginmanager.h"
@@ -96,11 +97,18 @@
 #include "gimptemporaryprocedure.h"
 #include "plug-in-params.h"
 
+#include "gimp-log.h"
+#include "gimp-trace.h"
+
 #include "gimp-intl.h"
 
 
 static void       gimp_plug_in_finalize      (GObject      *object);
 
+static gboolean   gimp_plug_in_read          (GIOChannel   *channel,
+                                              const guint8 *buf,
+                                              gulong        count,
+                                              gpointer      data);
 static gboolean   gimp_plug_in_write         (GIOChannel   *channel,
                                               const guint8 *buf,
                                               gulong        count,
@@ -135,6 +143,7 @@ gimp_plug_in_class_init (GimpPlugInClass *klass)
    *  write handlers.
    */
   gp_init ();
+  gimp_wire_set_reader (gimp_plug_in_read);
   gimp_wire_set_writer (gimp_plug_in_write);
   gimp_wire_set_flusher (gimp_plug_in_flush);
 }
@@ -158,6 +167,8 @@ gimp_plug_in_init (GimpPlugIn *plug_in)
   plug_in->input_id           = 0;
   plug_in->write_buffer_index = 0;
 
+  plug_in->stats              = gimp_plug_in_stats_new ();
+
   plug_in->temp_procedures    = NULL;
 
   plug_in->ext_main_loop      = NULL;
@@ -174,6 +185,8 @@ gimp_plug_in_finalize (GObject *object)
 
   g_free (plug_in->prog);
 
+  gimp_plug_in_stats_free (plug_in->stats);
+
   gimp_plug_in_proc_frame_dispose (&plug_in->main_proc_frame, plug_in);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
@@ -399,6 +412,7 @@ gimp_plug_in_open (GimpPlugIn         *plug_in,
 
   plug_in->open      = TRUE;
   plug_in->call_mode = call_mode;
+  plug_in->open_time = g_get_monotonic_time ();
 
   gimp_plug_in_manager_add_open_plug_in (plug_in->manager, plug_in);
 
@@ -438,6 +452,7 @@ gimp_plug_in_close (GimpPlugIn *plug_in,
       if (kill_it && ! plug_in->hup)
         {
           gp_quit_write (plug_in->my_write, plug_in);
+          gimp_plug_in_stats_sent (plug_in, GP_QUIT);
 
           /*  give the plug-in some time (10 ms)  */
           g_usleep (10000);
@@ -578,6 +593,17 @@ gimp_plug_in_close (GimpPlugIn *plug_in,
   while (plug_in->temp_procedures)
     gimp_plug_in_remove_temp_proc (plug_in, plug_in->temp_procedures->data);
 
+  plug_in->stats->n_runs++;
+  plug_in->stats->time_running += g_get_monotonic_time () - plug_in->open_time;
+
+  if (gimp_log_flags & GIMP_LOG_PLUG_IN_STATS)
+    gimp_plug_in_stats_dump (plug_in->stats, gimp_object_get_name (plug_in));
+
+  gimp_plug_in_manager_add_stats (plug_in->manager,
+                                  gimp_object_get_name (plug_in),
+                                  plug_in->stats);
+  memset (plug_in->stats, 0, sizeof (GimpPlugInStats));
+
   gimp_plug_in_manager_remove_open_plug_in (plug_in->manager, plug_in);
 }
 
@@ -605,16 +631,24 @@ gimp_plug_in_recv_message (GIOChannel   *channel,
   if (cond & (G_IO_IN | G_IO_PRI))
     {
       GimpWireMessage msg;
+      gboolean        success;
 
       memset (&msg, 0, sizeof (GimpWireMessage));
 
-      if (! gimp_wire_read_msg (plug_in->my_read, &msg, plug_in))
+      GIMP_TRACE_BEGIN ("gimp_wire_read_msg");
+      success = gimp_wire_read_msg (plug_in->my_read, &msg, plug_in);
+      GIMP_TRACE_END ("gimp_wire_read_msg");
+
+      if (! success)
         {
           gimp_plug_in_close (plug_in, TRUE);
         }
       else
         {
+          GIMP_TRACE_BEGIN ("gimp_plug_in_handle_message");
           gimp_plug_in_handle_message (plug_in, &msg);
+          GIMP_TRACE_END ("gimp_plug_in_handle_message");
+
           gimp_wire_destroy (&msg);
           got_message = TRUE;
         }
@@ -649,6 +683,30 @@ gimp_plug_in_recv_message (GIOChannel   *channel,
   return TRUE;
 }
 
+static gboolean
+gimp_plug_in_read (GIOChannel   *channel,
+                   const guint8 *buf,
+                   gulong        count,
+                   gpointer      data)
+{
+  GimpPlugIn *plug_in = data;
+  gint64      start   = g_get_monotonic_time ();
+  gboolean    success;
+
+  plug_in->unaccounted_read += count;
+
+  /*  only account for the read, and let gimpwire's default reader
+   *  do the actual reading
+   */
+  gimp_wire_set_reader (NULL);
+  success = gimp_wire_read (channel, (guint8 *) buf, count, NULL);
+  gimp_wire_set_reader (gimp_plug_in_read);
+
+  plug_in->stats->time_reading += g_get_monotonic_time () - start;
+
+  return success;
+}
+
 static gboolean
 gimp_plug_in_write (GIOChannel   *channel,
                     const guint8 *buf,
@@ -658,6 +716,8 @@ gimp_plug_in_write (GIOChannel   *channel,
   GimpPlugIn *plug_in = data;
   gulong      bytes;
 
+  plug_in->unaccounted_written += count;
+
   while (count > 0)
     {
       if ((plug_in->write_buffer_index + count) >= WRITE_BUFFER_SIZE)
@@ -696,6 +756,9 @@ gimp_plug_in_flush (GIOChannel *channel,
       GError    *error = NULL;
       gint       count;
       gsize      bytes;
+      gint64     start = g_get_monotonic_time ();
+
+      GIMP_TRACE_BEGIN ("gimp_plug_in_flush");
 
       count = 0;
       while (count != plug_in->write_buffer_index)
@@ -726,6 +789,10 @@ gimp_plug_in_flush (GIOChannel *channel,
                              gimp_filename_to_utf8 (g_get_prgname ()));
                 }
 
+              plug_in->stats->time_writing += g_get_monotonic_time () - start;
+
+              GIMP_TRACE_END ("gimp_plug_in_flush");
+
               return FALSE;
             }
 
@@ -733,6 +800,10 @@ gimp_plug_in_flush (GIOChannel *channel,
         }
 
       plug_in->write_buffer_index = 0;
+
+      plug_in->stats->time_writing += g_get_monotonic_time () - start;
+
+      GIMP_TRACE_END ("gimp_plug_in_flush");
     }
 
   return TRUE;
@@ -60,6 +60,11 @@ struct _GimpPlugIn
   gchar                write_buffer[WRITE_BUFFER_SIZE]; /* Buffer for writing */
   gint                 write_buffer_index;              /* Buffer index       */
 
+  GimpPlugInStats     *stats;           /*  IPC statistics of this run        */
+  gint64               open_time;
+  gint64               unaccounted_read;    /*  bytes of the current message  */
+  gint64               unaccounted_written;
+
   GSList              *temp_procedures; /*  Temporary procedures              */
 
   GMainLoop           *ext_main_loop;   /*  for waiting for extension_ack     */
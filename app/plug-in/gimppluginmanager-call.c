@@ -36,6 +36,7 @@
 
 #include "gimpplugin.h"
 #include "gimpplugin-message.h"
+#include "gimpplugin-stats.h"
 #include "gimpplugindef.h"
 #include "gimppluginerror.h"
 #include "gimppluginmanager.h"
@@ -45,6 +46,8 @@
 #include "gimptemporaryprocedure.h"
 #include "plug-in-params.h"
 
+#include "gimp-trace.h"
+
 #include "gimp-intl.h"
 
 
@@ -149,6 +152,8 @@ gimp_plug_in_manager_call_run (GimpPlugInManager   *manager,
   g_return_val_if_fail (args != NULL, NULL);
   g_return_val_if_fail (display == NULL || GIMP_IS_OBJECT (display), NULL);
 
+  GIMP_TRACE_BEGIN ("gimp_plug_in_manager_call_run");
+
   plug_in = gimp_plug_in_new (manager, context, progress, procedure, NULL);
 
   if (plug_in)
@@ -160,6 +165,7 @@ gimp_plug_in_manager_call_run (GimpPlugInManager   *manager,
       GPProcRun          proc_run;
       gint               display_ID;
       gint               monitor;
+      gboolean           success;
 
       if (! gimp_plug_in_open (plug_in, GIMP_PLUG_IN_CALL_RUN, FALSE))
         {
@@ -175,6 +181,8 @@ gimp_plug_in_manager_call_run (GimpPlugInManager   *manager,
                                                           FALSE, error);
           g_error_free (error);
 
+          GIMP_TRACE_END ("gimp_plug_in_manager_call_run");
+
           return return_vals;
         }
 
@@ -212,9 +220,14 @@ gimp_plug_in_manager_call_run (GimpPlugInManager   *manager,
       proc_run.nparams = gimp_value_array_length (args);
       proc_run.params  = plug_in_args_to_params (args, FALSE);
 
-      if (! gp_config_write (plug_in->my_write, &config, plug_in)     ||
-          ! gp_proc_run_write (plug_in->my_write, &proc_run, plug_in) ||
-          ! gimp_wire_flush (plug_in->my_write, plug_in))
+      success = gp_config_write (plug_in->my_write, &config, plug_in);
+      gimp_plug_in_stats_sent (plug_in, GP_CONFIG);
+
+      success = (success &&
+                 gp_proc_run_write (plug_in->my_write, &proc_run, plug_in));
+      gimp_plug_in_stats_sent (plug_in, GP_PROC_RUN);
+
+      if (! success || ! gimp_wire_flush (plug_in->my_write, plug_in))
         {
           const gchar *name  = gimp_object_get_name (plug_in);
           GError      *error = g_error_new (GIMP_PLUG_IN_ERROR,
@@ -231,6 +244,8 @@ gimp_plug_in_manager_call_run (GimpPlugInManager   *manager,
                                                           FALSE, error);
           g_error_free (error);
 
+          GIMP_TRACE_END ("gimp_plug_in_manager_call_run");
+
           return return_vals;
         }
 
@@ -278,6 +293,8 @@ gimp_plug_in_manager_call_run (GimpPlugInManager   *manager,
       g_object_unref (plug_in);
     }
 
+  GIMP_TRACE_END ("gimp_plug_in_manager_call_run");
+
   return return_vals;
 }
 
@@ -330,6 +347,8 @@ gimp_plug_in_manager_call_run_temp (GimpPlugInManager      *manager,
           return return_vals;
         }
 
+      gimp_plug_in_stats_sent (plug_in, GP_TEMP_PROC_RUN);
+
       g_free (proc_run.params);
 
       g_object_ref (plug_in);
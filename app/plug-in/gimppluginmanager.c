@@ -39,6 +39,7 @@
 #include "gimpenvirontable.h"
 #include "gimpinterpreterdb.h"
 #include "gimpplugin.h"
+#include "gimpplugin-stats.h"
 #include "gimpplugindebug.h"
 #include "gimpplugindef.h"
 #include "gimppluginmanager.h"
@@ -157,6 +158,10 @@ gimp_plug_in_manager_init (GimpPlugInManager *manager)
   manager->environ_table      = gimp_environ_table_new ();
   manager->debug              = NULL;
   manager->data_list          = NULL;
+  manager->stats              = g_hash_table_new_full (g_str_hash,
+                                                       g_str_equal,
+                                                       (GDestroyNotify) g_free,
+                                                       (GDestroyNotify) gimp_plug_in_stats_free);
 }
 
 static void
@@ -224,6 +229,12 @@ gimp_plug_in_manager_finalize (GObject *object)
       manager->debug = NULL;
     }
 
+  if (manager->stats)
+    {
+      g_hash_table_unref (manager->stats);
+      manager->stats = NULL;
+    }
+
   gimp_plug_in_manager_menu_branch_exit (manager);
   gimp_plug_in_manager_locale_domain_exit (manager);
   gimp_plug_in_manager_help_domain_exit (manager);
@@ -485,3 +496,39 @@ gimp_plug_in_manager_history_changed (GimpPlugInManager *manager)
 
   g_signal_emit (manager, manager_signals[HISTORY_CHANGED], 0);
 }
+
+void
+gimp_plug_in_manager_add_stats (GimpPlugInManager     *manager,
+                                const gchar           *name,
+                                const GimpPlugInStats *stats)
+{
+  GimpPlugInStats *total;
+
+  g_return_if_fail (GIMP_IS_PLUG_IN_MANAGER (manager));
+  g_return_if_fail (name != NULL);
+  g_return_if_fail (stats != NULL);
+
+  total = g_hash_table_lookup (manager->stats, name);
+
+  if (! total)
+    {
+      total = gimp_plug_in_stats_new ();
+
+      g_hash_table_insert (manager->stats, g_strdup (name), total);
+    }
+
+  gimp_plug_in_stats_merge (total, stats);
+}
+
+/*  returns the IPC statistics accumulated over all runs of the plug-in
+ *  executable @name, or %NULL if it was never run
+ */
+const GimpPlugInStats *
+gimp_plug_in_manager_get_stats (GimpPlugInManager *manager,
+                                const gchar       *name)
+{
+  g_return_val_if_fail (GIMP_IS_PLUG_IN_MANAGER (manager), NULL);
+  g_return_val_if_fail (name != NULL, NULL);
+
+  return g_hash_table_lookup (manager->stats, name);
+}
@@ -62,6 +62,7 @@ struct _GimpPlugInManager
   GimpEnvironTable  *environ_table;
   GimpPlugInDebug   *debug;
   GList             *data_list;
+  GHashTable        *stats;
 };
 
 struct _GimpPlugInManagerClass
@@ -112,5 +113,12 @@ void    gimp_plug_in_manager_plug_in_pop          (GimpPlugInManager   *manager)
 
 void    gimp_plug_in_manager_history_changed      (GimpPlugInManager   *manager);
 
+void    gimp_plug_in_manager_add_stats            (GimpPlugInManager     *manager,
+                                                   const gchar           *name,
+                                                   const GimpPlugInStats *stats);
+const GimpPlugInStats *
+        gimp_plug_in_manager_get_stats            (GimpPlugInManager   *manager,
+                                                   const gchar         *name);
+
 
 #endif  /* __GIMP_PLUG_IN_MANAGER_H__ */
@@ -678,48 +678,40 @@ gimp_plug_in_procedure_get_help_id (const GimpPlugInProcedure *proc)
   return g_strdup (gimp_object_get_name (proc));
 }
 
-gboolean
-gimp_plug_in_procedure_get_sensitive (const GimpPlugInProcedure *proc,
-                                      GimpDrawable              *drawable)
+/*  the image_types_val bit a drawable's type matches, 0 without a
+ *  drawable
+ */
+GimpPlugInImageType
+gimp_plug_in_procedure_get_drawable_type (GimpDrawable *drawable)
 {
-  GimpImageType image_type = -1;
-  gboolean      sensitive  = FALSE;
+  g_return_val_if_fail (drawable == NULL || GIMP_IS_DRAWABLE (drawable), 0);
 
-  g_return_val_if_fail (GIMP_IS_PLUG_IN_PROCEDURE (proc), FALSE);
-  g_return_val_if_fail (drawable == NULL || GIMP_IS_DRAWABLE (drawable), FALSE);
+  if (! drawable)
+    return 0;
 
-  if (drawable)
+  switch (gimp_babl_format_get_image_type (gimp_drawable_get_format (drawable)))
     {
-      const Babl *format = gimp_drawable_get_format (drawable);
-
-      image_type = gimp_babl_format_get_image_type (format);
+    case GIMP_RGB_IMAGE:      return GIMP_PLUG_IN_RGB_IMAGE;
+    case GIMP_RGBA_IMAGE:     return GIMP_PLUG_IN_RGBA_IMAGE;
+    case GIMP_GRAY_IMAGE:     return GIMP_PLUG_IN_GRAY_IMAGE;
+    case GIMP_GRAYA_IMAGE:    return GIMP_PLUG_IN_GRAYA_IMAGE;
+    case GIMP_INDEXED_IMAGE:  return GIMP_PLUG_IN_INDEXED_IMAGE;
+    case GIMP_INDEXEDA_IMAGE: return GIMP_PLUG_IN_INDEXEDA_IMAGE;
+    default:                  break;
     }
 
-  switch (image_type)
-    {
-    case GIMP_RGB_IMAGE:
-      sensitive = proc->image_types_val & GIMP_PLUG_IN_RGB_IMAGE;
-      break;
-    case GIMP_RGBA_IMAGE:
-      sensitive = proc->image_types_val & GIMP_PLUG_IN_RGBA_IMAGE;
-      break;
-    case GIMP_GRAY_IMAGE:
-      sensitive = proc->image_types_val & GIMP_PLUG_IN_GRAY_IMAGE;
-      break;
-    case GIMP_GRAYA_IMAGE:
-      sensitive = proc->image_types_val & GIMP_PLUG_IN_GRAYA_IMAGE;
-      break;
-    case GIMP_INDEXED_IMAGE:
-      sensitive = proc->image_types_val & GIMP_PLUG_IN_INDEXED_IMAGE;
-      break;
-    case GIMP_INDEXEDA_IMAGE:
-      sensitive = proc->image_types_val & GIMP_PLUG_IN_INDEXEDA_IMAGE;
-      break;
-    default:
-      break;
-    }
+  return 0;
+}
 
-  return sensitive ? TRUE : FALSE;
+gboolean
+gimp_plug_in_procedure_get_sensitive (const GimpPlugInProcedure *proc,
+                                      GimpDrawable              *drawable)
+{
+  g_return_val_if_fail (GIMP_IS_PLUG_IN_PROCEDURE (proc), FALSE);
+  g_return_val_if_fail (drawable == NULL || GIMP_IS_DRAWABLE (drawable), FALSE);
+
+  return (proc->image_types_val &
+          gimp_plug_in_procedure_get_drawable_type (drawable)) != 0;
 }
 
 static GimpPlugInImageType
@@ -928,6 +920,8 @@ gimp_plug_in_procedure_set_file_proc (GimpPlugInProcedure *proc,
     g_slist_free_full (proc->magics_list, (GDestroyNotify) g_free);
 
   proc->magics_list = extensions_parse (proc->magics);
+
+  proc->file_proc_stamp++;
 }
 
 void
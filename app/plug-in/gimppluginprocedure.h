@@ -65,6 +65,7 @@ struct _GimpPlugInProcedure
   GSList              *extensions_list;
   GSList              *prefixes_list;
   GSList              *magics_list;
+  guint                file_proc_stamp;  /*  changes with the above  */
   gchar               *thumb_loader;
 };
 
@@ -115,6 +116,9 @@ GdkPixbuf   * gimp_plug_in_procedure_get_pixbuf      (const GimpPlugInProcedure
 
 gchar       * gimp_plug_in_procedure_get_help_id     (const GimpPlugInProcedure *proc);
 
+GimpPlugInImageType
+              gimp_plug_in_procedure_get_drawable_type
+                                                     (GimpDrawable              *drawable);
 gboolean      gimp_plug_in_procedure_get_sensitive   (const GimpPlugInProcedure *proc,
                                                       GimpDrawable              *drawable);
 
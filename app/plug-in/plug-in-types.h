@@ -35,6 +35,7 @@ typedef struct _GimpPlugInManager    GimpPlugInManager;
 typedef struct _GimpPlugInMenuBranch GimpPlugInMenuBranch;
 typedef struct _GimpPlugInProcFrame  GimpPlugInProcFrame;
 typedef struct _GimpPlugInShm        GimpPlugInShm;
+typedef struct _GimpPlugInStats      GimpPlugInStats;
 
 
 #endif /* __PLUG_IN_TYPES_H__ */
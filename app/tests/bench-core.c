@@ -0,0 +1,252 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gegl.h>
+#include <gtk/gtk.h>
+
+#include "libgimpbase/gimpbase.h"
+
+#include "widgets/widgets-types.h"
+
+#include "core/gimp.h"
+#include "core/gimpchannel.h"
+#include "core/gimpchannel-select.h"
+#include "core/gimpcontext.h"
+#include "core/gimpdrawable-blend.h"
+#include "core/gimpdrawable-histogram.h"
+#include "core/gimphistogram.h"
+#include "core/gimpimage.h"
+#include "core/gimpimage-crop.h"
+#include "core/gimplayer.h"
+
+#include "tests.h"
+
+#include "gimp-app-test-utils.h"
+
+
+#define GIMP_BENCH_IMAGE_SIZE  4096
+#define GIMP_BENCH_ITERATIONS  10
+#define GIMP_BENCH_N_LAYERS    16
+
+
+typedef struct
+{
+  Gimp         *gimp;
+  GimpImage    *image;
+  GimpDrawable *drawable;
+} GimpBenchCore;
+
+
+static void
+bench_core_clear_selection (gpointer data)
+{
+  GimpBenchCore *bench = data;
+
+  gimp_channel_clear (gimp_image_get_mask (bench->image), NULL, FALSE);
+}
+
+static void
+bench_core_fuzzy_select (gpointer data)
+{
+  GimpBenchCore *bench = data;
+
+  gimp_channel_select_fuzzy (gimp_image_get_mask (bench->image),
+                             bench->drawable,
+                             FALSE /*sample_merged*/,
+                             GIMP_BENCH_IMAGE_SIZE / 2,
+                             GIMP_BENCH_IMAGE_SIZE / 2,
+                             0.5 /*threshold*/,
+                             FALSE /*select_transparent*/,
+                             GIMP_SELECT_CRITERION_COMPOSITE,
+                             GIMP_CHANNEL_OP_REPLACE,
+                             TRUE /*antialias*/,
+                             FALSE /*feather*/,
+                             0.0, 0.0);
+}
+
+static void
+bench_core_invalidate_histogram (gpointer data)
+{
+  GimpBenchCore *bench = data;
+
+  gimp_drawable_invalidate_histogram (bench->drawable,
+                                      0, 0,
+                                      GIMP_BENCH_IMAGE_SIZE,
+                                      GIMP_BENCH_IMAGE_SIZE);
+}
+
+/*  what painting a single dab costs the histogram  */
+static void
+bench_core_invalidate_histogram_dab (gpointer data)
+{
+  GimpBenchCore *bench = data;
+
+  gimp_drawable_invalidate_histogram (bench->drawable,
+                                      GIMP_BENCH_IMAGE_SIZE / 2,
+                                      GIMP_BENCH_IMAGE_SIZE / 2,
+                                      64, 64);
+}
+
+static void
+bench_core_histogram (gpointer data)
+{
+  GimpBenchCore *bench     = data;
+  GimpHistogram *histogram = gimp_histogram_new ();
+
+  gimp_drawable_calculate_histogram (bench->drawable, histogram);
+
+  gimp_histogram_unref (histogram);
+}
+
+static void
+bench_core_blend (gpointer data)
+{
+  GimpBenchCore *bench = data;
+
+  gimp_drawable_blend (bench->drawable,
+                       gimp_get_user_context (bench->gimp),
+                       GIMP_FG_BG_RGB_MODE,
+                       GIMP_NORMAL_MODE,
+                       GIMP_GRADIENT_RADIAL,
+                       1.0 /*opacity*/,
+                       0.0 /*offset*/,
+                       GIMP_REPEAT_NONE,
+                       FALSE /*reverse*/,
+                       FALSE /*supersample*/,
+                       0 /*max_depth*/,
+                       0.0 /*threshold*/,
+                       TRUE /*dither*/,
+                       GIMP_BENCH_IMAGE_SIZE / 2,
+                       GIMP_BENCH_IMAGE_SIZE / 2,
+                       GIMP_BENCH_IMAGE_SIZE,
+                       GIMP_BENCH_IMAGE_SIZE,
+                       NULL /*progress*/);
+}
+
+/*  shave one pixel off each side of every layer  */
+static void
+bench_core_crop (gpointer data)
+{
+  GimpBenchCore *bench = data;
+
+  gimp_image_crop (bench->image,
+                   gimp_get_user_context (bench->gimp),
+                   1, 1,
+                   gimp_image_get_width  (bench->image) - 1,
+                   gimp_image_get_height (bench->image) - 1,
+                   FALSE /*active_layer_only*/,
+                   TRUE /*crop_layers*/);
+}
+
+static void
+bench_core (Gimp          *gimp,
+            GimpPrecision  precision)
+{
+  GimpBenchCore  bench;
+  GEnumClass    *enum_class;
+  GEnumValue    *precision_value;
+  gint           n_iterations;
+  gchar         *name;
+
+  enum_class      = g_type_class_ref (GIMP_TYPE_PRECISION);
+  precision_value = g_enum_get_value (enum_class, precision);
+  g_type_class_unref (enum_class);
+
+  n_iterations = gimp_test_utils_bench_iterations (GIMP_BENCH_ITERATIONS);
+
+  bench.gimp     = gimp;
+  bench.image    = gimp_test_utils_create_layer_stack (gimp,
+                                                       GIMP_BENCH_IMAGE_SIZE,
+                                                       GIMP_BENCH_IMAGE_SIZE,
+                                                       precision,
+                                                       1,
+                                                       GIMP_NORMAL_MODE);
+  bench.drawable = GIMP_DRAWABLE (gimp_image_get_active_layer (bench.image));
+
+  name = g_strdup_printf ("fuzzy-select/%s", precision_value->value_nick);
+  gimp_test_utils_bench (name, n_iterations,
+                         bench_core_clear_selection,
+                         bench_core_fuzzy_select,
+                         &bench);
+  g_free (name);
+
+  bench_core_clear_selection (&bench);
+
+  name = g_strdup_printf ("histogram/%s", precision_value->value_nick);
+  gimp_test_utils_bench (name, n_iterations,
+                         bench_core_invalidate_histogram,
+                         bench_core_histogram,
+                         &bench);
+  g_free (name);
+
+  name = g_strdup_printf ("histogram-incremental/%s",
+                          precision_value->value_nick);
+  gimp_test_utils_bench (name, n_iterations,
+                         bench_core_invalidate_histogram_dab,
+                         bench_core_histogram,
+                         &bench);
+  g_free (name);
+
+  name = g_strdup_printf ("blend/%s", precision_value->value_nick);
+  gimp_test_utils_bench (name, n_iterations,
+                         NULL,
+                         bench_core_blend,
+                         &bench);
+  g_free (name);
+
+  g_object_unref (bench.image);
+
+  bench.image    = gimp_test_utils_create_layer_stack (gimp,
+                                                       GIMP_BENCH_IMAGE_SIZE / 4,
+                                                       GIMP_BENCH_IMAGE_SIZE / 4,
+                                                       precision,
+                                                       GIMP_BENCH_N_LAYERS,
+                                                       GIMP_NORMAL_MODE);
+  bench.drawable = NULL;
+
+  name = g_strdup_printf ("crop/%s/%d-layers",
+                          precision_value->value_nick,
+                          GIMP_BENCH_N_LAYERS);
+  gimp_test_utils_bench (name, n_iterations,
+                         NULL,
+                         bench_core_crop,
+                         &bench);
+  g_free (name);
+
+  g_object_unref (bench.image);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  Gimp *gimp;
+
+  g_type_init ();
+
+  gimp_test_utils_set_gimp2_directory ("GIMP_TESTING_ABS_TOP_SRCDIR",
+                                       "app/tests/gimpdir");
+
+  gimp = gimp_init_for_testing ();
+
+  bench_core (gimp, GIMP_PRECISION_U8);
+  bench_core (gimp, GIMP_PRECISION_FLOAT);
+
+  gimp_exit (gimp, TRUE);
+
+  return 0;
+}
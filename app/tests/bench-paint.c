@@ -0,0 +1,358 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <gegl.h>
+#include <gtk/gtk.h>
+
+#include "libgimpbase/gimpbase.h"
+#include "libgimpcolor/gimpcolor.h"
+#include "libgimpmath/gimpmath.h"
+
+#include "paint/paint-types.h"
+
+#include "paint/gimppaintcore.h"
+#include "paint/gimppaintcore-stroke.h"
+#include "paint/gimppaintoptions.h"
+
+#include "core/gimp.h"
+#include "core/gimpcontainer.h"
+#include "core/gimpcontext.h"
+#include "core/gimpdrawable.h"
+#include "core/gimpimage.h"
+#include "core/gimpimage-undo.h"
+#include "core/gimplayer.h"
+#include "core/gimppaintinfo.h"
+
+#include "tests.h"
+
+#include "gimp-app-test-utils.h"
+
+
+#define GIMP_BENCH_IMAGE_SIZE  2048
+#define GIMP_BENCH_ITERATIONS  10
+#define GIMP_BENCH_N_COORDS    2000
+
+
+typedef struct
+{
+  GimpLayer        *layer;
+  GimpPaintOptions *options;
+  GimpCoords       *coords;
+  gint              n_coords;
+} GimpBenchPaint;
+
+typedef struct
+{
+  GimpBenchPaint   *paint;
+  GimpPaintCore    *core;
+  gint              index;
+} GimpBenchPaintEvents;
+
+
+/**
+ * bench_paint_load_stroke:
+ * @n_coords: return location for the number of coordinates
+ *
+ * Returns the stroke to replay. If GIMP_BENCH_STROKE names a file,
+ * the stroke is read from it, one event per line as
+ *
+ *   x y pressure xtilt ytilt velocity
+ *
+ * where all but x and y are optional, e.g. a stroke recorded from a
+ * tablet. Otherwise, a synthetic spiral stroke with varying pressure
+ * is generated.
+ *
+ * Returns: a newly allocated array of #GimpCoords.
+ **/
+static GimpCoords *
+bench_paint_load_stroke (gint *n_coords)
+{
+  const gchar *filename = g_getenv ("GIMP_BENCH_STROKE");
+  GArray      *array;
+  gint         i;
+
+  array = g_array_new (FALSE, TRUE, sizeof (GimpCoords));
+
+  if (filename)
+    {
+      gchar  *contents;
+      GError *error = NULL;
+
+      if (g_file_get_contents (filename, &contents, NULL, &error))
+        {
+          gchar **lines = g_strsplit (contents, "\n", -1);
+
+          for (i = 0; lines[i]; i++)
+            {
+              GimpCoords coords = { 0.0, 0.0, 1.0, 0.5, 0.5, 0.5, 0.0, 0.0 };
+              gint       n;
+
+              n = sscanf (lines[i], "%lf %lf %lf %lf %lf %lf",
+                          &coords.x, &coords.y, &coords.pressure,
+                          &coords.xtilt, &coords.ytilt, &coords.velocity);
+
+              if (n >= 2)
+                g_array_append_val (array, coords);
+            }
+
+          g_strfreev (lines);
+          g_free (contents);
+        }
+      else
+        {
+          g_printerr ("%s\n", error->message);
+          g_clear_error (&error);
+        }
+    }
+
+  if (array->len == 0)
+    {
+      for (i = 0; i < GIMP_BENCH_N_COORDS; i++)
+        {
+          GimpCoords coords = { 0.0, 0.0, 1.0, 0.5, 0.5, 0.5, 0.0, 0.0 };
+          gdouble    t      = (gdouble) i / GIMP_BENCH_N_COORDS;
+          gdouble    radius = GIMP_BENCH_IMAGE_SIZE * (0.05 + 0.4 * t);
+
+          coords.x        = GIMP_BENCH_IMAGE_SIZE / 2 + radius * cos (t * 8 * G_PI);
+          coords.y        = GIMP_BENCH_IMAGE_SIZE / 2 + radius * sin (t * 8 * G_PI);
+          coords.pressure = 0.5 + 0.5 * sin (t * 16 * G_PI);
+          coords.velocity = 0.5;
+
+          g_array_append_val (array, coords);
+        }
+    }
+
+  *n_coords = array->len;
+
+  return (GimpCoords *) g_array_free (array, FALSE);
+}
+
+static void
+bench_paint_clear (gpointer data)
+{
+  GimpBenchPaint *bench = data;
+  GimpRGB         white = { 1.0, 1.0, 1.0, 1.0 };
+
+  gimp_drawable_fill (GIMP_DRAWABLE (bench->layer), &white, NULL);
+}
+
+static void
+bench_paint_stroke (gpointer data)
+{
+  GimpBenchPaint *bench = data;
+  GimpPaintInfo  *paint_info;
+  GimpPaintCore  *core;
+
+  paint_info = bench->options->paint_info;
+  core       = g_object_new (paint_info->paint_type, NULL);
+
+  gimp_paint_core_stroke (core, GIMP_DRAWABLE (bench->layer),
+                          bench->options,
+                          bench->coords, bench->n_coords,
+                          FALSE /*push_undo*/,
+                          NULL /*error*/);
+
+  g_object_unref (core);
+}
+
+static void
+bench_paint_events_finish (GimpBenchPaintEvents *events)
+{
+  GimpBenchPaint *bench    = events->paint;
+  GimpDrawable   *drawable = GIMP_DRAWABLE (bench->layer);
+
+  if (! events->core)
+    return;
+
+  gimp_paint_core_paint (events->core, drawable, bench->options,
+                         GIMP_PAINT_STATE_FINISH, 0);
+  gimp_paint_core_finish (events->core, drawable, FALSE /*push_undo*/);
+  gimp_paint_core_cleanup (events->core);
+
+  g_object_unref (events->core);
+  events->core = NULL;
+}
+
+/*  starts the stroke over once all of its events are replayed  */
+static void
+bench_paint_events_setup (gpointer data)
+{
+  GimpBenchPaintEvents *events   = data;
+  GimpBenchPaint       *bench    = events->paint;
+  GimpDrawable         *drawable = GIMP_DRAWABLE (bench->layer);
+  GimpPaintCore        *core;
+
+  if (events->core && events->index < bench->n_coords)
+    return;
+
+  bench_paint_events_finish (events);
+  bench_paint_clear (bench);
+
+  core = g_object_new (bench->options->paint_info->paint_type, NULL);
+
+  if (! gimp_paint_core_start (core, drawable, bench->options,
+                               &bench->coords[0], NULL))
+    g_error ("failed to start the paint core");
+
+  core->start_coords = bench->coords[0];
+  core->last_coords  = bench->coords[0];
+
+  gimp_paint_core_paint (core, drawable, bench->options,
+                         GIMP_PAINT_STATE_INIT, 0);
+  gimp_paint_core_paint (core, drawable, bench->options,
+                         GIMP_PAINT_STATE_MOTION, 0);
+
+  events->core  = core;
+  events->index = 1;
+}
+
+static void
+bench_paint_event (gpointer data)
+{
+  GimpBenchPaintEvents *events = data;
+  GimpBenchPaint       *bench  = events->paint;
+
+  gimp_paint_core_interpolate (events->core,
+                               GIMP_DRAWABLE (bench->layer),
+                               bench->options,
+                               &bench->coords[events->index++], 0);
+}
+
+static void
+bench_paint (Gimp          *gimp,
+             GimpPrecision  precision,
+             const gchar   *paint_info_name,
+             gdouble        brush_size)
+{
+  GimpBenchPaint        bench;
+  GimpBenchPaintEvents  events = { &bench, NULL, 0 };
+  GimpPaintInfo        *paint_info;
+  GimpImage            *image;
+  GEnumClass           *enum_class;
+  GEnumValue           *precision_value;
+  gchar                *name;
+
+  paint_info = (GimpPaintInfo *)
+    gimp_container_get_child_by_name (gimp->paint_info_list, paint_info_name);
+
+  g_return_if_fail (GIMP_IS_PAINT_INFO (paint_info));
+
+  enum_class      = g_type_class_ref (GIMP_TYPE_PRECISION);
+  precision_value = g_enum_get_value (enum_class, precision);
+  g_type_class_unref (enum_class);
+
+  image = gimp_image_new (gimp,
+                          GIMP_BENCH_IMAGE_SIZE, GIMP_BENCH_IMAGE_SIZE,
+                          GIMP_RGB, precision);
+  gimp_image_undo_disable (image);
+
+  bench.layer = gimp_layer_new (image,
+                                GIMP_BENCH_IMAGE_SIZE,
+                                GIMP_BENCH_IMAGE_SIZE,
+                                gimp_image_get_layer_format (image, TRUE),
+                                "paint",
+                                1.0,
+                                GIMP_NORMAL_MODE);
+  gimp_image_add_layer (image, bench.layer, NULL, 0, FALSE);
+
+  bench.options = gimp_paint_options_new (paint_info);
+  gimp_context_define_properties (GIMP_CONTEXT (bench.options),
+                                  GIMP_CONTEXT_PAINT_PROPS_MASK,
+                                  FALSE);
+  gimp_context_set_parent (GIMP_CONTEXT (bench.options),
+                           gimp_get_user_context (gimp));
+  g_object_set (bench.options,
+                "brush-size", brush_size,
+                NULL);
+
+  /*  the ink tool has a blob instead of a brush  */
+  if (g_object_class_find_property (G_OBJECT_GET_CLASS (bench.options),
+                                    "size"))
+    g_object_set (bench.options,
+                  "size", brush_size,
+                  NULL);
+
+  bench.coords = bench_paint_load_stroke (&bench.n_coords);
+
+  name = g_strdup_printf ("paint/%s/%s/size-%d/%d-events",
+                          precision_value->value_nick,
+                          paint_info_name,
+                          (gint) brush_size,
+                          bench.n_coords);
+
+  gimp_test_utils_bench (name,
+                         gimp_test_utils_bench_iterations (GIMP_BENCH_ITERATIONS),
+                         bench_paint_clear,
+                         bench_paint_stroke,
+                         &bench);
+
+  g_free (name);
+
+  /*  the latency of the single events of the stroke, which is what
+   *  makes painting lag behind the pointer
+   */
+  if (bench.n_coords > 1)
+    {
+      name = g_strdup_printf ("paint-event/%s/%s/size-%d",
+                              precision_value->value_nick,
+                              paint_info_name,
+                              (gint) brush_size);
+
+      gimp_test_utils_bench (name,
+                             gimp_test_utils_bench_iterations (bench.n_coords - 1),
+                             bench_paint_events_setup,
+                             bench_paint_event,
+                             &events);
+
+      bench_paint_events_finish (&events);
+
+      g_free (name);
+    }
+
+  g_free (bench.coords);
+  g_object_unref (bench.options);
+  g_object_unref (image);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  Gimp *gimp;
+
+  g_type_init ();
+
+  gimp_test_utils_set_gimp2_directory ("GIMP_TESTING_ABS_TOP_SRCDIR",
+                                       "app/tests/gimpdir");
+
+  gimp = gimp_init_for_testing ();
+
+  bench_paint (gimp, GIMP_PRECISION_U8,    "gimp-paintbrush", 20.0);
+  bench_paint (gimp, GIMP_PRECISION_U8,    "gimp-paintbrush", 200.0);
+  bench_paint (gimp, GIMP_PRECISION_FLOAT, "gimp-paintbrush", 200.0);
+  bench_paint (gimp, GIMP_PRECISION_U8,    "gimp-airbrush",   100.0);
+  bench_paint (gimp, GIMP_PRECISION_U8,    "gimp-smudge",     100.0);
+  bench_paint (gimp, GIMP_PRECISION_U8,    "gimp-ink",        20.0);
+  bench_paint (gimp, GIMP_PRECISION_U8,    "gimp-ink",        100.0);
+
+  gimp_exit (gimp, TRUE);
+
+  return 0;
+}
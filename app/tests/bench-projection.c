@@ -0,0 +1,264 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gegl.h>
+#include <gtk/gtk.h>
+
+#include "libgimpbase/gimpbase.h"
+
+#include "widgets/widgets-types.h"
+
+#include "core/gimp.h"
+#include "core/gimpimage.h"
+#include "core/gimpimage-merge.h"
+#include "core/gimppickable.h"
+#include "core/gimpprojectable.h"
+#include "core/gimpprojection.h"
+
+#include "tests.h"
+
+#include "gimp-app-test-utils.h"
+
+
+#define GIMP_BENCH_IMAGE_SIZE  1024
+#define GIMP_BENCH_ITERATIONS  10
+
+#define GIMP_BENCH_FLATTEN_SIZE 512
+
+
+typedef struct
+{
+  GimpImage *image;
+  guchar    *pixels;
+} GimpBenchProjection;
+
+typedef struct
+{
+  Gimp                 *gimp;
+  GimpImage            *image;
+  GimpPrecision         precision;
+  gint                  n_layers;
+  GimpLayerModeEffects  mode;
+} GimpBenchFlatten;
+
+
+/**
+ * bench_projection_invalidate:
+ * @data:
+ *
+ * Invalidates the whole projection so the next run has to composite
+ * the complete layer stack again.
+ **/
+static void
+bench_projection_invalidate (gpointer data)
+{
+  GimpBenchProjection *bench = data;
+
+  gimp_projectable_invalidate (GIMP_PROJECTABLE (bench->image),
+                               0, 0,
+                               GIMP_BENCH_IMAGE_SIZE,
+                               GIMP_BENCH_IMAGE_SIZE);
+}
+
+/**
+ * bench_projection_composite:
+ * @data:
+ *
+ * Flushes the pending invalidation and reads back the full
+ * projection, which validates every projection tile.
+ **/
+static void
+bench_projection_composite (gpointer data)
+{
+  GimpBenchProjection *bench      = data;
+  GimpProjection      *projection = gimp_image_get_projection (bench->image);
+
+  gimp_projection_flush_now (projection);
+
+  gegl_buffer_get (gimp_pickable_get_buffer (GIMP_PICKABLE (projection)),
+                   GEGL_RECTANGLE (0, 0,
+                                   GIMP_BENCH_IMAGE_SIZE,
+                                   GIMP_BENCH_IMAGE_SIZE),
+                   1.0,
+                   babl_format ("R'G'B'A u8"),
+                   bench->pixels,
+                   GEGL_AUTO_ROWSTRIDE,
+                   GEGL_ABYSS_NONE);
+}
+
+/**
+ * bench_flatten_setup:
+ * @data:
+ *
+ * Replaces the image with a fresh layer stack and validates its
+ * projection, the way it is after being shown in a display.
+ **/
+static void
+bench_flatten_setup (gpointer data)
+{
+  GimpBenchFlatten   *bench = data;
+  GimpProjection     *projection;
+  GeglBufferIterator *iter;
+
+  if (bench->image)
+    g_object_unref (bench->image);
+
+  bench->image = gimp_test_utils_create_layer_stack (bench->gimp,
+                                                     GIMP_BENCH_FLATTEN_SIZE,
+                                                     GIMP_BENCH_FLATTEN_SIZE,
+                                                     bench->precision,
+                                                     bench->n_layers,
+                                                     bench->mode);
+
+  projection = gimp_image_get_projection (bench->image);
+
+  gimp_projection_flush_now (projection);
+
+  iter = gegl_buffer_iterator_new (gimp_pickable_get_buffer (GIMP_PICKABLE (projection)),
+                                   NULL, 0, NULL,
+                                   GEGL_BUFFER_READ, GEGL_ABYSS_NONE);
+
+  while (gegl_buffer_iterator_next (iter));
+}
+
+/**
+ * bench_flatten:
+ * @data:
+ *
+ * Flattens the image.
+ **/
+static void
+bench_flatten (gpointer data)
+{
+  GimpBenchFlatten *bench = data;
+
+  gimp_image_flatten (bench->image, gimp_get_user_context (bench->gimp));
+}
+
+static void
+bench_projection (Gimp                 *gimp,
+                  GimpPrecision         precision,
+                  gint                  n_layers,
+                  GimpLayerModeEffects  mode)
+{
+  GimpBenchProjection  bench;
+  GEnumClass          *enum_class;
+  GEnumValue          *mode_value;
+  GEnumValue          *precision_value;
+  gchar               *name;
+
+  enum_class = g_type_class_ref (GIMP_TYPE_LAYER_MODE_EFFECTS);
+  mode_value = g_enum_get_value (enum_class, mode);
+  g_type_class_unref (enum_class);
+
+  enum_class      = g_type_class_ref (GIMP_TYPE_PRECISION);
+  precision_value = g_enum_get_value (enum_class, precision);
+  g_type_class_unref (enum_class);
+
+  bench.image  = gimp_test_utils_create_layer_stack (gimp,
+                                                     GIMP_BENCH_IMAGE_SIZE,
+                                                     GIMP_BENCH_IMAGE_SIZE,
+                                                     precision,
+                                                     n_layers,
+                                                     mode);
+  bench.pixels = g_malloc (GIMP_BENCH_IMAGE_SIZE * GIMP_BENCH_IMAGE_SIZE * 4);
+
+  name = g_strdup_printf ("projection/%s/%s/%d-layers",
+                          precision_value->value_nick,
+                          mode_value->value_nick,
+                          n_layers);
+
+  gimp_test_utils_bench (name,
+                         gimp_test_utils_bench_iterations (GIMP_BENCH_ITERATIONS),
+                         bench_projection_invalidate,
+                         bench_projection_composite,
+                         &bench);
+
+  g_free (name);
+  g_free (bench.pixels);
+  g_object_unref (bench.image);
+}
+
+static void
+bench_projection_flatten (Gimp                 *gimp,
+                          GimpPrecision         precision,
+                          gint                  n_layers,
+                          GimpLayerModeEffects  mode)
+{
+  GimpBenchFlatten  bench = { gimp, NULL, precision, n_layers, mode };
+  GEnumClass       *enum_class;
+  GEnumValue       *mode_value;
+  GEnumValue       *precision_value;
+  gchar            *name;
+
+  enum_class = g_type_class_ref (GIMP_TYPE_LAYER_MODE_EFFECTS);
+  mode_value = g_enum_get_value (enum_class, mode);
+  g_type_class_unref (enum_class);
+
+  enum_class      = g_type_class_ref (GIMP_TYPE_PRECISION);
+  precision_value = g_enum_get_value (enum_class, precision);
+  g_type_class_unref (enum_class);
+
+  name = g_strdup_printf ("flatten/%s/%s/%d-layers",
+                          precision_value->value_nick,
+                          mode_value->value_nick,
+                          n_layers);
+
+  gimp_test_utils_bench (name,
+                         gimp_test_utils_bench_iterations (GIMP_BENCH_ITERATIONS),
+                         bench_flatten_setup,
+                         bench_flatten,
+                         &bench);
+
+  g_free (name);
+
+  if (bench.image)
+    g_object_unref (bench.image);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  Gimp *gimp;
+  gint  mode;
+
+  g_type_init ();
+
+  gimp_test_utils_set_gimp2_directory ("GIMP_TESTING_ABS_TOP_SRCDIR",
+                                       "app/tests/gimpdir");
+
+  gimp = gimp_init_for_testing ();
+
+  /*  every layer mode on a moderately deep stack  */
+  for (mode = GIMP_NORMAL_MODE; mode <= GIMP_COLOR_ERASE_MODE; mode++)
+    bench_projection (gimp, GIMP_PRECISION_U8, 16, mode);
+
+  /*  depth scaling of the common case, in integer and float  */
+  bench_projection (gimp, GIMP_PRECISION_U8,    1,   GIMP_NORMAL_MODE);
+  bench_projection (gimp, GIMP_PRECISION_U8,    64,  GIMP_NORMAL_MODE);
+  bench_projection (gimp, GIMP_PRECISION_FLOAT, 16,  GIMP_NORMAL_MODE);
+  bench_projection (gimp, GIMP_PRECISION_FLOAT, 64,  GIMP_NORMAL_MODE);
+
+  /*  flattening a deep stack, from the projection and in one pass  */
+  bench_projection_flatten (gimp, GIMP_PRECISION_U8, 200, GIMP_NORMAL_MODE);
+  bench_projection_flatten (gimp, GIMP_PRECISION_U8, 200, GIMP_MULTIPLY_MODE);
+
+  gimp_exit (gimp, TRUE);
+
+  return 0;
+}
@@ -0,0 +1,182 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib/gstdio.h>
+
+#include <gegl.h>
+#include <gtk/gtk.h>
+
+#include "libgimpbase/gimpbase.h"
+
+#include "widgets/widgets-types.h"
+
+#include "core/gimp.h"
+#include "core/gimpcontext.h"
+#include "core/gimpimage.h"
+
+#include "file/file-open.h"
+#include "file/file-procedure.h"
+#include "file/file-save.h"
+
+#include "plug-in/gimppluginmanager.h"
+
+#include "tests.h"
+
+#include "gimp-app-test-utils.h"
+
+
+#define GIMP_BENCH_ITERATIONS  5
+
+
+typedef struct
+{
+  Gimp                *gimp;
+  GimpImage           *image;
+  GimpImage           *loaded_image;
+  GimpPlugInProcedure *save_proc;
+  GimpPlugInProcedure *load_proc;
+  gchar               *uri;
+} GimpBenchXcf;
+
+
+static void
+bench_xcf_save (gpointer data)
+{
+  GimpBenchXcf *bench = data;
+
+  file_save (bench->gimp,
+             bench->image,
+             NULL /*progress*/,
+             bench->uri,
+             bench->save_proc,
+             GIMP_RUN_NONINTERACTIVE,
+             FALSE /*change_saved_state*/,
+             FALSE /*export_backward*/,
+             FALSE /*export_forward*/,
+             NULL /*error*/);
+}
+
+static void
+bench_xcf_unload (gpointer data)
+{
+  GimpBenchXcf *bench = data;
+
+  if (bench->loaded_image)
+    {
+      g_object_unref (bench->loaded_image);
+      bench->loaded_image = NULL;
+    }
+}
+
+static void
+bench_xcf_load (gpointer data)
+{
+  GimpBenchXcf      *bench    = data;
+  GimpPDBStatusType  not_used = 0;
+
+  bench->loaded_image = file_open_image (bench->gimp,
+                                         gimp_get_user_context (bench->gimp),
+                                         NULL /*progress*/,
+                                         bench->uri,
+                                         "irrelevant" /*entered_filename*/,
+                                         FALSE /*as_new*/,
+                                         bench->load_proc,
+                                         GIMP_RUN_NONINTERACTIVE,
+                                         &not_used /*status*/,
+                                         NULL /*mime_type*/,
+                                         NULL /*error*/);
+}
+
+static void
+bench_xcf (Gimp          *gimp,
+           GimpPrecision  precision,
+           gint           size,
+           gint           n_layers)
+{
+  GimpBenchXcf  bench = { 0, };
+  GEnumClass   *enum_class;
+  GEnumValue   *precision_value;
+  gchar        *name;
+
+  enum_class      = g_type_class_ref (GIMP_TYPE_PRECISION);
+  precision_value = g_enum_get_value (enum_class, precision);
+  g_type_class_unref (enum_class);
+
+  bench.gimp  = gimp;
+  bench.image = gimp_test_utils_create_layer_stack (gimp, size, size,
+                                                    precision, n_layers,
+                                                    GIMP_NORMAL_MODE);
+  bench.uri   = g_build_filename (g_get_tmp_dir (), "gimp-bench.xcf", NULL);
+
+  bench.save_proc = file_procedure_find (gimp->plug_in_manager->save_procs,
+                                         bench.uri, NULL /*error*/);
+  bench.load_proc = file_procedure_find (gimp->plug_in_manager->load_procs,
+                                         bench.uri, NULL /*error*/);
+
+  name = g_strdup_printf ("xcf-save/%s/%dx%d/%d-layers",
+                          precision_value->value_nick,
+                          size, size, n_layers);
+  gimp_test_utils_bench (name,
+                         gimp_test_utils_bench_iterations (GIMP_BENCH_ITERATIONS),
+                         NULL,
+                         bench_xcf_save,
+                         &bench);
+  g_free (name);
+
+  name = g_strdup_printf ("xcf-load/%s/%dx%d/%d-layers",
+                          precision_value->value_nick,
+                          size, size, n_layers);
+  gimp_test_utils_bench (name,
+                         gimp_test_utils_bench_iterations (GIMP_BENCH_ITERATIONS),
+                         bench_xcf_unload,
+                         bench_xcf_load,
+                         &bench);
+  g_free (name);
+
+  bench_xcf_unload (&bench);
+
+  g_unlink (bench.uri);
+  g_free (bench.uri);
+  g_object_unref (bench.image);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  Gimp *gimp;
+
+  g_type_init ();
+
+  gimp_test_utils_set_gimp2_directory ("GIMP_TESTING_ABS_TOP_SRCDIR",
+                                       "app/tests/gimpdir");
+
+  gimp = gimp_init_for_testing ();
+
+  /* Don't write files to the source dir */
+  gimp_test_utils_set_gimp2_directory ("GIMP_TESTING_ABS_TOP_BUILDDIR",
+                                       "app/tests/gimpdir-output");
+
+  bench_xcf (gimp, GIMP_PRECISION_U8,    2048, 32);
+  bench_xcf (gimp, GIMP_PRECISION_U16,   2048, 32);
+  bench_xcf (gimp, GIMP_PRECISION_FLOAT, 2048, 8);
+  bench_xcf (gimp, GIMP_PRECISION_U8,    8192, 4);
+
+  gimp_exit (gimp, TRUE);
+
+  return 0;
+}
@@ -17,6 +17,11 @@
 
 #include "config.h"
 
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <glib/gstdio.h>
 #include <gegl.h>
 #include <gtk/gtk.h>
 
@@ -30,7 +35,10 @@
 #include "widgets/gimpdialogfactory.h"
 
 #include "core/gimp.h"
+#include "core/gimpcontext.h"
+#include "core/gimpdrawable-blend.h"
 #include "core/gimpimage.h"
+#include "core/gimpimage-undo.h"
 #include "core/gimplayer.h"
 
 #include "tests.h"
@@ -254,3 +262,202 @@ gimp_test_utils_create_image_from_dialog (Gimp *gimp)
   return image;
 }
 
+
+/**
+ * gimp_test_utils_create_layer_stack:
+ * @gimp:      The #Gimp instance.
+ * @width:     Width of image and layers
+ * @height:    Height of image and layers
+ * @precision: Precision of the image
+ * @n_layers:  Number of layers to create
+ * @mode:      Layer mode of all but the bottom layer
+ *
+ * Creates a new image without display and with undo disabled,
+ * holding @n_layers layers filled with semi-transparent gradients of
+ * different directions, suitable for compositing benchmarks.
+ *
+ * Returns: The new #GimpImage.
+ **/
+GimpImage *
+gimp_test_utils_create_layer_stack (Gimp                 *gimp,
+                                    gint                  width,
+                                    gint                  height,
+                                    GimpPrecision         precision,
+                                    gint                  n_layers,
+                                    GimpLayerModeEffects  mode)
+{
+  GimpContext *context = gimp_get_user_context (gimp);
+  GimpImage   *image;
+  gint         i;
+
+  image = gimp_image_new (gimp, width, height, GIMP_RGB, precision);
+
+  gimp_image_undo_disable (image);
+
+  for (i = 0; i < n_layers; i++)
+    {
+      GimpLayer *layer;
+      gchar     *name  = g_strdup_printf ("layer%d", i);
+      gdouble    angle = G_PI * i / MAX (n_layers, 1);
+
+      layer = gimp_layer_new (image,
+                              width,
+                              height,
+                              gimp_image_get_layer_format (image, TRUE),
+                              name,
+                              1.0,
+                              i == 0 ? GIMP_NORMAL_MODE : mode);
+      g_free (name);
+
+      gimp_image_add_layer (image,
+                            layer,
+                            NULL /*parent*/,
+                            0 /*position*/,
+                            FALSE /*push_undo*/);
+
+      gimp_drawable_blend (GIMP_DRAWABLE (layer),
+                           context,
+                           i == 0 ? GIMP_FG_BG_RGB_MODE : GIMP_FG_TRANSPARENT_MODE,
+                           GIMP_NORMAL_MODE,
+                           GIMP_GRADIENT_LINEAR,
+                           1.0 /*opacity*/,
+                           0.0 /*offset*/,
+                           GIMP_REPEAT_TRIANGULAR,
+                           i % 2 /*reverse*/,
+                           FALSE /*supersample*/,
+                           0 /*max_depth*/,
+                           0.0 /*threshold*/,
+                           FALSE /*dither*/,
+                           width  / 2.0,
+                           height / 2.0,
+                           width  / 2.0 + cos (angle) * width  / 4.0,
+                           height / 2.0 + sin (angle) * height / 4.0,
+                           NULL /*progress*/);
+    }
+
+  return image;
+}
+
+/**
+ * gimp_test_utils_bench_iterations:
+ * @default_iterations: Number of iterations to use by default
+ *
+ * Returns the number of iterations a benchmark should run,
+ * @default_iterations unless overridden by GIMP_BENCH_ITERATIONS.
+ *
+ * Returns: The number of iterations.
+ **/
+gint
+gimp_test_utils_bench_iterations (gint default_iterations)
+{
+  const gchar *env = g_getenv ("GIMP_BENCH_ITERATIONS");
+
+  if (env && atoi (env) > 0)
+    return atoi (env);
+
+  return default_iterations;
+}
+
+static gint
+gimp_test_utils_bench_compare (const gdouble *a,
+                               const gdouble *b)
+{
+  return *a < *b ? -1 : *a > *b ? 1 : 0;
+}
+
+static gdouble
+gimp_test_utils_bench_percentile (const gdouble *samples,
+                                  gint           n_samples,
+                                  gdouble        percentile)
+{
+  gint index = (gint) ceil (percentile / 100.0 * n_samples) - 1;
+
+  return samples[CLAMP (index, 0, n_samples - 1)];
+}
+
+/**
+ * gimp_test_utils_bench:
+ * @name:         Name of the benchmark, e.g. "projection/normal/16"
+ * @n_iterations: Number of timed iterations
+ * @setup:        Untimed function to call before each iteration, or %NULL
+ * @run:          The function to time
+ * @data:         Data to pass to @setup and @run
+ *
+ * Calls @run @n_iterations times after one untimed warm-up run and
+ * prints a line of tab separated timing statistics in milliseconds:
+ *
+ *   name  iterations  min  mean  p50  p90  p99  max
+ *
+ * to stdout. If GIMP_BENCH_OUTPUT is set, the line is also appended
+ * to that file so results can be collected across benchmark programs
+ * and builds.
+ **/
+void
+gimp_test_utils_bench (const gchar       *name,
+                       gint               n_iterations,
+                       GimpTestBenchFunc  setup,
+                       GimpTestBenchFunc  run,
+                       gpointer           data)
+{
+  const gchar *output = g_getenv ("GIMP_BENCH_OUTPUT");
+  gdouble     *samples;
+  gdouble      sum = 0.0;
+  gchar       *line;
+  gint         i;
+
+  g_return_if_fail (name != NULL);
+  g_return_if_fail (n_iterations > 0);
+  g_return_if_fail (run != NULL);
+
+  samples = g_new (gdouble, n_iterations);
+
+  if (setup)
+    setup (data);
+  run (data);
+
+  for (i = 0; i < n_iterations; i++)
+    {
+      gint64 start;
+
+      if (setup)
+        setup (data);
+
+      start = g_get_monotonic_time ();
+      run (data);
+      samples[i] = (g_get_monotonic_time () - start) / 1000.0;
+
+      sum += samples[i];
+    }
+
+  qsort (samples, n_iterations, sizeof (gdouble),
+         (GCompareFunc) gimp_test_utils_bench_compare);
+
+  line = g_strdup_printf ("%s\t%d\t%.3f\t%.3f\t%.3f\t%.3f\t%.3f\t%.3f\n",
+                          name, n_iterations,
+                          samples[0],
+                          sum / n_iterations,
+                          gimp_test_utils_bench_percentile (samples, n_iterations, 50.0),
+                          gimp_test_utils_bench_percentile (samples, n_iterations, 90.0),
+                          gimp_test_utils_bench_percentile (samples, n_iterations, 99.0),
+                          samples[n_iterations - 1]);
+
+  g_print ("%s", line);
+
+  if (output)
+    {
+      FILE *file = g_fopen (output, "a");
+
+      if (file)
+        {
+          fputs (line, file);
+          fclose (file);
+        }
+      else
+        {
+          g_printerr ("Could not open '%s' for writing\n", output);
+        }
+    }
+
+  g_free (line);
+  g_free (samples);
+}
@@ -19,6 +19,9 @@
 #define  __GIMP_APP_TEST_UTILS_H__
 
 
+typedef void (* GimpTestBenchFunc) (gpointer data);
+
+
 void            gimp_test_utils_set_env_to_subpath   (const gchar *root_env_var,
                                                       const gchar *subdir,
                                                       const gchar *target_env_var);
@@ -33,6 +36,18 @@ void            gimp_test_utils_synthesize_key_event (GtkWidget   *widget,
 GimpUIManager * gimp_test_utils_get_ui_manager       (Gimp        *gimp);
 GimpImage     * gimp_test_utils_create_image_from_dialog
                                                      (Gimp        *gimp);
+GimpImage     * gimp_test_utils_create_layer_stack   (Gimp                 *gimp,
+                                                      gint                  width,
+                                                      gint                  height,
+                                                      GimpPrecision         precision,
+                                                      gint                  n_layers,
+                                                      GimpLayerModeEffects  mode);
+gint            gimp_test_utils_bench_iterations     (gint         default_iterations);
+void            gimp_test_utils_bench                (const gchar       *name,
+                                                      gint               n_iterations,
+                                                      GimpTestBenchFunc  setup,
+                                                      GimpTestBenchFunc  run,
+                                                      gpointer           data);
 
 
 #endif /* __GIMP_APP_TEST_UTILS_H__ */
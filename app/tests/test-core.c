@@ -0,0 +1,688 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 2009 Martin Nordholts
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gegl.h>
+#include <gtk/gtk.h>
+
+#include "libgimpmath/gimpmath.h"
+
+#include "widgets/widgets-types.h"
+
+#include "widgets/gimpuimanager.h"
+
+#include "core/gimp.h"
+#include "core/gimp-apply-operation.h"
+#include "core/gimpchannel.h"
+#include "core/gimpcontext.h"
+#include "core/gimpdrawable-foreground-extract.h"
+#include "core/gimpimage.h"
+#include "core/gimplayer.h"
+
+#include "tests.h"
+
+#include "gimp-app-test-utils.h"
+
+
+#define GIMP_TEST_IMAGE_SIZE 100
+
+#define ADD_IMAGE_TEST(function) \
+  g_test_add ("/gimp-core/" #function, \
+              GimpTestFixture, \
+              gimp, \
+              gimp_test_image_setup, \
+              function, \
+              gimp_test_image_teardown);
+
+#define ADD_TEST(function) \
+  g_test_add ("/gimp-core/" #function, \
+              GimpTestFixture, \
+              gimp, \
+              NULL, \
+              function, \
+              NULL);
+
+
+typedef struct
+{
+  GimpImage *image;
+} GimpTestFixture;
+
+
+static void gimp_test_image_setup    (GimpTestFixture *fixture,
+                                      gconstpointer    data);
+static void gimp_test_image_teardown (GimpTestFixture *fixture,
+                                      gconstpointer    data);
+
+
+/**
+ * gimp_test_image_setup:
+ * @fixture:
+ * @data:
+ *
+ * Test fixture setup for a single image.
+ **/
+static void
+gimp_test_image_setup (GimpTestFixture *fixture,
+                       gconstpointer    data)
+{
+  Gimp *gimp = GIMP (data);
+
+  fixture->image = gimp_image_new (gimp,
+                                   GIMP_TEST_IMAGE_SIZE,
+                                   GIMP_TEST_IMAGE_SIZE,
+                                   GIMP_RGB,
+                                   GIMP_PRECISION_FLOAT);
+}
+
+/**
+ * gimp_test_image_teardown:
+ * @fixture:
+ * @data:
+ *
+ * Test fixture teardown for a single image.
+ **/
+static void
+gimp_test_image_teardown (GimpTestFixture *fixture,
+                          gconstpointer    data)
+{
+  g_object_unref (fixture->image);
+}
+
+/**
+ * rotate_non_overlapping:
+ * @fixture:
+ * @data:
+ *
+ * Super basic test that makes sure we can add a layer
+ * and call gimp_item_rotate with center at (0, -10)
+ * without triggering a failed assertion .
+ **/
+static void
+rotate_non_overlapping (GimpTestFixture *fixture,
+                        gconstpointer    data)
+{
+  Gimp        *gimp    = GIMP (data);
+  GimpImage   *image   = fixture->image;
+  GimpLayer   *layer;
+  GimpContext *context = gimp_context_new (gimp, "Test", NULL /*template*/);
+  gboolean     result;
+
+  g_assert_cmpint (gimp_image_get_n_layers (image), ==, 0);
+
+  layer = gimp_layer_new (image,
+                          GIMP_TEST_IMAGE_SIZE,
+                          GIMP_TEST_IMAGE_SIZE,
+                          babl_format ("R'G'B'A u8"),
+                          "Test Layer",
+                          1.0,
+                          GIMP_NORMAL_MODE);
+
+  g_assert_cmpint (GIMP_IS_LAYER (layer), ==, TRUE);
+
+  result = gimp_image_add_layer (image,
+                                 layer,
+                                 GIMP_IMAGE_ACTIVE_PARENT,
+                                 0,
+                                 FALSE);
+
+  gimp_item_rotate (GIMP_ITEM (layer), context, GIMP_ROTATE_90, 0., -10., TRUE);
+
+  g_assert_cmpint (result, ==, TRUE);
+  g_assert_cmpint (gimp_image_get_n_layers (image), ==, 1);
+  g_object_unref (context);
+}
+
+/**
+ * add_layer:
+ * @fixture:
+ * @data:
+ *
+ * Super basic test that makes sure we can add a layer.
+ **/
+static void
+add_layer (GimpTestFixture *fixture,
+           gconstpointer    data)
+{
+  GimpImage *image = fixture->image;
+  GimpLayer *layer;
+  gboolean   result;
+
+  g_assert_cmpint (gimp_image_get_n_layers (image), ==, 0);
+
+  layer = gimp_layer_new (image,
+                          GIMP_TEST_IMAGE_SIZE,
+                          GIMP_TEST_IMAGE_SIZE,
+                          babl_format ("R'G'B'A u8"),
+                          "Test Layer",
+                          1.0,
+                          GIMP_NORMAL_MODE);
+
+  g_assert_cmpint (GIMP_IS_LAYER (layer), ==, TRUE);
+
+  result = gimp_image_add_layer (image,
+                                 layer,
+                                 GIMP_IMAGE_ACTIVE_PARENT,
+                                 0,
+                                 FALSE);
+
+  g_assert_cmpint (result, ==, TRUE);
+  g_assert_cmpint (gimp_image_get_n_layers (image), ==, 1);
+}
+
+/**
+ * remove_layer:
+ * @fixture:
+ * @data:
+ *
+ * Super basic test that makes sure we can remove a layer.
+ **/
+static void
+remove_layer (GimpTestFixture *fixture,
+              gconstpointer    data)
+{
+  GimpImage *image = fixture->image;
+  GimpLayer *layer;
+  gboolean   result;
+
+  g_assert_cmpint (gimp_image_get_n_layers (image), ==, 0);
+
+  layer = gimp_layer_new (image,
+                          GIMP_TEST_IMAGE_SIZE,
+                          GIMP_TEST_IMAGE_SIZE,
+                          babl_format ("R'G'B'A u8"),
+                          "Test Layer",
+                          1.0,
+                          GIMP_NORMAL_MODE);
+
+  g_assert_cmpint (GIMP_IS_LAYER (layer), ==, TRUE);
+
+  result = gimp_image_add_layer (image,
+                                 layer,
+                                 GIMP_IMAGE_ACTIVE_PARENT,
+                                 0,
+                                 FALSE);
+
+  g_assert_cmpint (result, ==, TRUE);
+  g_assert_cmpint (gimp_image_get_n_layers (image), ==, 1);
+
+  gimp_image_remove_layer (image,
+                           layer,
+                           FALSE,
+                           NULL);
+
+  g_assert_cmpint (gimp_image_get_n_layers (image), ==, 0);
+}
+
+static gfloat *
+shapeburst_apply (const guchar *src,
+                  gint          width,
+                  gint          height,
+                  gdouble      *max)
+{
+  GeglBuffer *src_buffer;
+  GeglBuffer *dist_buffer;
+  GeglNode   *shapeburst;
+  gfloat     *dist = g_new (gfloat, width * height);
+
+  src_buffer  = gegl_buffer_new (GEGL_RECTANGLE (0, 0, width, height),
+                                 babl_format ("Y u8"));
+  dist_buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, width, height),
+                                 babl_format ("Y float"));
+
+  gegl_buffer_set (src_buffer, NULL, 1.0, NULL, src, GEGL_AUTO_ROWSTRIDE);
+
+  shapeburst = gegl_node_new_child (NULL,
+                                    "operation", "gimp:shapeburst",
+                                    NULL);
+
+  gimp_apply_operation (src_buffer, NULL, NULL,
+                        shapeburst,
+                        dist_buffer, NULL);
+
+  gegl_node_get (shapeburst, "max-iterations", max, NULL);
+
+  gegl_buffer_get (dist_buffer, NULL, 1.0, NULL, dist,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  g_object_unref (shapeburst);
+  g_object_unref (dist_buffer);
+  g_object_unref (src_buffer);
+
+  return dist;
+}
+
+/*  compares @dist to a brute force search for the nearest unselected
+ *  pixel, counting everything outside of @src as unselected; where
+ *  several unselected pixels are equally near, the fraction may come
+ *  from the edge towards any of them
+ */
+static void
+shapeburst_check (const guchar *src,
+                  const gfloat *dist,
+                  gint          width,
+                  gint          height,
+                  gdouble       max)
+{
+  gfloat expected_max = 0.0;
+  gint   x, y;
+
+  for (y = 0; y < height; y++)
+    for (x = 0; x < width; x++)
+      {
+        gint     i      = y * width + x;
+        gint     min_d2 = G_MAXINT;
+        gboolean found  = FALSE;
+        gint     u, v;
+
+        if (src[i] == 0)
+          {
+            g_assert_cmpfloat (dist[i], ==, (gfloat) (255 / 256.0));
+
+            expected_max = MAX (expected_max, dist[i]);
+            continue;
+          }
+
+        for (v = -1; v <= height; v++)
+          for (u = -1; u <= width; u++)
+            {
+              gint dx = x - u;
+              gint dy = y - v;
+              gint d2 = dx * dx + dy * dy;
+
+              if (u >= 0 && u < width && v >= 0 && v < height &&
+                  src[v * width + u] != 0)
+                continue;
+
+              if (d2 < min_d2)
+                {
+                  min_d2 = d2;
+                  found  = FALSE;
+                }
+
+              if (d2 == min_d2 && ! found)
+                {
+                  gdouble d      = sqrt ((gdouble) d2);
+                  gint    edge_x = CLAMP (u + (gint) RINT (dx / d), 0, width  - 1);
+                  gint    edge_y = CLAMP (v + (gint) RINT (dy / d), 0, height - 1);
+                  gfloat  value  = d + src[edge_y * width + edge_x] / 256.0;
+
+                  found = (dist[i] == value);
+                }
+            }
+
+        g_assert (found);
+
+        expected_max = MAX (expected_max, dist[i]);
+      }
+
+  g_assert_cmpfloat (max, ==, expected_max);
+}
+
+/**
+ * shapeburst_axis_aligned:
+ * @fixture:
+ * @data:
+ *
+ * Makes sure the shapeburst distance map of rectangles with a partially
+ * selected edge, one of them touching the image edges, is the exact
+ * Euclidean distance to the nearest unselected pixel.
+ **/
+static void
+shapeburst_axis_aligned (GimpTestFixture *fixture,
+                         gconstpointer    data)
+{
+  const gint  width  = GIMP_TEST_IMAGE_SIZE;
+  const gint  height = GIMP_TEST_IMAGE_SIZE - 20;
+  guchar     *src    = g_new0 (guchar, width * height);
+  gfloat     *dist;
+  gdouble     max;
+  gint        x, y;
+
+  /*  one rectangle inside, one touching the right and bottom edges  */
+  for (y = 0; y < height; y++)
+    for (x = 0; x < width; x++)
+      {
+        if (x >= 10 && x < 50 && y >= 5 && y < 60)
+          src[y * width + x] = (x == 10 || x == 49 ||
+                                y == 5  || y == 59) ? 128 : 255;
+        else if (x >= 60 && y >= 30)
+          src[y * width + x] = (x == 60 || y == 30) ? 64 : 255;
+      }
+
+  dist = shapeburst_apply (src, width, height, &max);
+
+  shapeburst_check (src, dist, width, height, max);
+
+  /*  the centre of the inner rectangle is 20 pixels from its sides  */
+  g_assert_cmpfloat (dist[32 * width + 29], ==, (gfloat) (20.0 + 128 / 256.0));
+
+  g_free (dist);
+  g_free (src);
+}
+
+/**
+ * shapeburst_disc:
+ * @fixture:
+ * @data:
+ *
+ * Makes sure the shapeburst distance map of an antialiased disc, where
+ * diagonal edges are as far away as straight ones, is the exact
+ * Euclidean distance to the nearest unselected pixel.
+ **/
+static void
+shapeburst_disc (GimpTestFixture *fixture,
+                 gconstpointer    data)
+{
+  const gint  size = GIMP_TEST_IMAGE_SIZE;
+  guchar     *src  = g_new0 (guchar, size * size);
+  gfloat     *dist;
+  gdouble     max;
+  gint        x, y;
+
+  for (y = 0; y < size; y++)
+    for (x = 0; x < size; x++)
+      {
+        gdouble r = sqrt (SQR (x - 45.5) + SQR (y - 52.5));
+
+        src[y * size + x] = 255 * CLAMP (40.0 - r, 0.0, 1.0);
+      }
+
+  dist = shapeburst_apply (src, size, size, &max);
+
+  shapeburst_check (src, dist, size, size, max);
+
+  g_free (dist);
+  g_free (src);
+}
+
+/**
+ * shapeburst_old_agreement:
+ * @fixture:
+ * @data:
+ *
+ * Makes sure the shapeburst distance map keeps what the previous
+ * city block implementation produced for a rectangle with hard edges.
+ * Both find the same whole distances everywhere, and both give
+ * unselected pixels 255/256 and the pixels whose nearest unselected
+ * pixel is only below or to the right a fraction of 255/256.
+ *
+ * The differences are intended: the old implementation lowered the
+ * fraction by 1/256 for every pixel away from the top and left edges,
+ * ending up at n + (255 - n) / 256 there, and it measured diagonal
+ * edges in city block steps, see shapeburst_disc.
+ **/
+static void
+shapeburst_old_agreement (GimpTestFixture *fixture,
+                          gconstpointer    data)
+{
+  const gint  size = GIMP_TEST_IMAGE_SIZE;
+  const gint  x1   = 10;
+  const gint  y1   = 5;
+  const gint  x2   = 50;
+  const gint  y2   = 60;
+  guchar     *src  = g_new0 (guchar, size * size);
+  gfloat     *dist;
+  gdouble     max;
+  gint        x, y;
+
+  for (y = y1; y < y2; y++)
+    for (x = x1; x < x2; x++)
+      src[y * size + x] = 255;
+
+  dist = shapeburst_apply (src, size, size, &max);
+
+  for (y = 0; y < size; y++)
+    for (x = 0; x < size; x++)
+      {
+        gfloat d = dist[y * size + x];
+        gint   left, top, right, bottom;
+        gint   n;
+
+        if (! src[y * size + x])
+          {
+            g_assert_cmpfloat (d, ==, (gfloat) (255 / 256.0));
+            continue;
+          }
+
+        left   = x - x1 + 1;
+        top    = y - y1 + 1;
+        right  = x2 - x;
+        bottom = y2 - y;
+
+        n = MIN (MIN (left, top), MIN (right, bottom));
+
+        g_assert_cmpint ((gint) d, ==, n);
+
+        if (left > n && top > n)
+          g_assert_cmpfloat (d, ==, (gfloat) (n + 255 / 256.0));
+      }
+
+  /*  the centre is 20 pixels from the left and right sides  */
+  g_assert_cmpfloat (max, ==, 20 + 255 / 256.0);
+
+  g_free (dist);
+  g_free (src);
+}
+
+/*  the foreground of foreground_extract_*: a disc, red on the left and
+ *  green on the right, on a blue background, all shaded and noisy
+ */
+static gboolean
+foreground_extract_truth (gint x,
+                          gint y)
+{
+  return SQR (x - 50) + SQR (y - 50) < SQR (25);
+}
+
+/*  runs without smoothing, which would round off the disc's corners  */
+static guchar *
+foreground_extract_run (GimpChannel  *mask,
+                        SioxState    *state,
+                        const guchar *trimap)
+{
+  const gint     size           = GIMP_TEST_IMAGE_SIZE;
+  const gdouble  sensitivity[3] = { SIOX_DEFAULT_SENSITIVITY_L,
+                                    SIOX_DEFAULT_SENSITIVITY_A,
+                                    SIOX_DEFAULT_SENSITIVITY_B };
+  GeglBuffer    *buffer         = gimp_drawable_get_buffer (GIMP_DRAWABLE (mask));
+  guchar        *result         = g_new (guchar, size * size);
+
+  gegl_buffer_set (buffer, NULL, 1.0, babl_format ("Y u8"), trimap,
+                   GEGL_AUTO_ROWSTRIDE);
+
+  gimp_drawable_foreground_extract_siox (GIMP_DRAWABLE (mask), state,
+                                         SIOX_REFINEMENT_ADD_FOREGROUND,
+                                         0,
+                                         sensitivity,
+                                         FALSE,
+                                         NULL);
+
+  gegl_buffer_get (buffer, NULL, 1.0, babl_format ("Y u8"), result,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  return result;
+}
+
+/**
+ * foreground_extract_refinement:
+ * @fixture:
+ * @data:
+ *
+ * Makes sure that refining a foreground extraction with another
+ * stroke gives nearly the same result as extracting with all strokes
+ * at once, and that both find the foreground. The colors vary enough
+ * for the refined signatures to differ from those of a full run, see
+ * siox_update_signature(), so up to one percent of the pixels may
+ * differ.
+ **/
+static void
+foreground_extract_refinement (GimpTestFixture *fixture,
+                               gconstpointer    data)
+{
+  const gint    size   = GIMP_TEST_IMAGE_SIZE;
+  GimpImage    *image  = fixture->image;
+  GimpLayer    *layer;
+  GimpChannel  *mask;
+  SioxState    *state;
+  guchar       *pixels = g_new (guchar, size * size * 4);
+  guchar       *trimap = g_new (guchar, size * size);
+  guchar       *refined;
+  guchar       *result;
+  gint          n_differ = 0;
+  gint          n_wrong  = 0;
+  gint          x, y;
+
+  layer = gimp_layer_new (image, size, size,
+                          babl_format ("R'G'B'A u8"),
+                          "Test Layer",
+                          1.0,
+                          GIMP_NORMAL_MODE);
+
+  gimp_image_add_layer (image, layer, GIMP_IMAGE_ACTIVE_PARENT, 0, FALSE);
+
+  for (y = 0; y < size; y++)
+    for (x = 0; x < size; x++)
+      {
+        guchar *p     = pixels + 4 * (y * size + x);
+        gint    noise = (x * 73 + y * 151 + x * y * 7) % 17 * 3;
+
+        if (! foreground_extract_truth (x, y))
+          {
+            p[0] = 40 + noise;
+            p[1] = 60 + y / 2;
+            p[2] = 200 - x / 2;
+          }
+        else if (x < 50)
+          {
+            p[0] = 230 - y;
+            p[1] = 30 + noise;
+            p[2] = 20 + x / 2;
+          }
+        else
+          {
+            p[0] = 30 + x / 2;
+            p[1] = 200 - y;
+            p[2] = 50 + noise;
+          }
+
+        p[3] = 255;
+
+        /*  a rough outline, and a stroke on the red half  */
+        if (x >= 15 && x < 85 && y >= 15 && y < 85)
+          trimap[y * size + x] = 128;
+        else
+          trimap[y * size + x] = 0;
+
+        if (y >= 48 && y < 52 && x >= 30 && x < 45)
+          trimap[y * size + x] = 255;
+      }
+
+  gegl_buffer_set (gimp_drawable_get_buffer (GIMP_DRAWABLE (layer)), NULL,
+                   1.0, babl_format ("R'G'B'A u8"), pixels,
+                   GEGL_AUTO_ROWSTRIDE);
+
+  mask = gimp_channel_new (image, size, size, "trimap", NULL);
+
+  state = gimp_drawable_foreground_extract_siox_init (GIMP_DRAWABLE (layer),
+                                                      0, 0, size, size,
+                                                      NULL);
+  g_assert (state != NULL);
+
+  result = foreground_extract_run (mask, state, trimap);
+
+  g_assert_cmpint (result[50 * size + 40], ==, 255);
+  g_assert_cmpint (result[20 * size + 20], ==, 0);
+
+  g_free (result);
+
+  /*  add a stroke on the green half  */
+  for (y = 48; y < 52; y++)
+    for (x = 55; x < 70; x++)
+      trimap[y * size + x] = 255;
+
+  refined = foreground_extract_run (mask, state, trimap);
+
+  gimp_drawable_foreground_extract_siox_done (state);
+
+  state = gimp_drawable_foreground_extract_siox_init (GIMP_DRAWABLE (layer),
+                                                      0, 0, size, size,
+                                                      NULL);
+
+  result = foreground_extract_run (mask, state, trimap);
+
+  gimp_drawable_foreground_extract_siox_done (state);
+
+  for (y = 0; y < size; y++)
+    for (x = 0; x < size; x++)
+      {
+        gint i = y * size + x;
+
+        if (refined[i] != result[i])
+          n_differ++;
+
+        if (result[i] != (foreground_extract_truth (x, y) ? 255 : 0))
+          n_wrong++;
+      }
+
+  g_assert_cmpint (n_differ, <=, size * size / 100);
+  g_assert_cmpint (n_wrong,  <=, size * size / 100);
+
+  g_object_unref (mask);
+
+  g_free (result);
+  g_free (refined);
+  g_free (trimap);
+  g_free (pixels);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  Gimp *gimp;
+  int   result;
+
+  g_type_init ();
+  g_test_init (&argc, &argv, NULL);
+
+  gimp_test_utils_set_gimp2_directory ("GIMP_TESTING_ABS_TOP_SRCDIR",
+                                       "app/tests/gimpdir");
+
+  /* We share the same application instance across all tests */
+  gimp = gimp_init_for_testing ();
+
+  /* Add tests */
+  ADD_IMAGE_TEST (add_layer);
+  ADD_IMAGE_TEST (remove_layer);
+  ADD_IMAGE_TEST (rotate_non_overlapping);
+  ADD_TEST (shapeburst_axis_aligned);
+  ADD_TEST (shapeburst_disc);
+  ADD_TEST (shapeburst_old_agreement);
+  ADD_IMAGE_TEST (foreground_extract_refinement);
+
+  /* Run the tests */
+  result = g_test_run ();
+
+  /* Don't write files to the source dir */
+  gimp_test_utils_set_gimp2_directory ("GIMP_TESTING_ABS_TOP_BUILDDIR",
+                                       "app/tests/gimpdir-output");
+
+  /* Exit so we don't break script-fu plug-in wire */
+  gimp_exit (gimp, TRUE);
+
+  return result;
+}
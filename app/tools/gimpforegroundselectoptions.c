@@ -15,8 +15,6 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-#if 0
-
 #include "config.h"
 
 #include <gegl.h>
@@ -28,7 +26,7 @@
 
 #include "tools-types.h"
 
-#include "base/siox.h"
+#include "core/gimpdrawable-foreground-extract.h"
 
 #include "widgets/gimpwidgets-utils.h"
 
@@ -399,5 +397,3 @@ gimp_foreground_select_options_get_mask_color (GimpForegroundSelectOptions *opti
       break;
     }
 }
-
-#endif
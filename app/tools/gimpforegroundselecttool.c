@@ -18,8 +18,6 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-#if 0
-
 #include "config.h"
 
 #include <string.h>
@@ -666,8 +664,9 @@ gimp_foreground_select_tool_select (GimpFreeSelectTool *free_sel,
     }
   else
     {
-      gint x1, y1;
-      gint x2, y2;
+      GError *error = NULL;
+      gint    x1, y1;
+      gint    x2, y2;
 
       g_object_set (options, "background", FALSE, NULL);
 
@@ -678,7 +677,15 @@ gimp_foreground_select_tool_select (GimpFreeSelectTool *free_sel,
 
       fg_select->state =
         gimp_drawable_foreground_extract_siox_init (drawable,
-                                                    x1, y1, x2 - x1, y2 - y1);
+                                                    x1, y1, x2 - x1, y2 - y1,
+                                                    &error);
+
+      if (! fg_select->state)
+        {
+          gimp_tool_message_literal (GIMP_TOOL (fg_select), display,
+                                     error->message);
+          g_clear_error (&error);
+        }
     }
 
   gimp_foreground_select_tool_set_mask (fg_select, display, mask);
@@ -890,5 +897,3 @@ gimp_foreground_select_options_notify (GimpForegroundSelectOptions *options,
         }
     }
 }
-
-#endif
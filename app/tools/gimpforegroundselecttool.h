@@ -15,8 +15,6 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-#if 0
-
 #ifndef __GIMP_FOREGROUND_SELECT_TOOL_H__
 #define __GIMP_FOREGROUND_SELECT_TOOL_H__
 
@@ -63,5 +61,3 @@ GType   gimp_foreground_select_tool_get_type (void) G_GNUC_CONST;
 
 
 #endif  /*  __GIMP_FOREGROUND_SELECT_TOOL_H__  */
-
-#endif
@@ -355,7 +355,8 @@ gimp_blob_editor_draw_blob (GimpBlobEditor *editor,
                    radius * cos (editor->angle),
                    radius * sin (editor->angle),
                    (- (radius / editor->aspect) * sin (editor->angle)),
-                   (  (radius / editor->aspect) * cos (editor->angle)));
+                   (  (radius / editor->aspect) * cos (editor->angle)),
+                   NULL);
 
   for (i = 0; i < blob->height; i++)
     if (blob->data[i].left <= blob->data[i].right)
@@ -476,6 +476,8 @@
 #define GIMP_HELP_SAMPLE_POINT_DIALOG             "gimp-sample-point-dialog"
 #define GIMP_HELP_SAMPLE_POINT_SAMPLE_MERGED      "gimp-sample-point-sample-merged"
 
+#define GIMP_HELP_MEMORY_DIALOG                   "gimp-memory-dialog"
+
 #define GIMP_HELP_DOCK                            "gimp-dock"
 #define GIMP_HELP_DOCK_CLOSE                      "gimp-dock-close"
 #define GIMP_HELP_DOCK_IMAGE_MENU                 "gimp-dock-image-menu"
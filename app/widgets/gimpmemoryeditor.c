@@ -0,0 +1,293 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimpmemoryeditor.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <gegl.h>
+#include <gtk/gtk.h>
+
+#include "libgimpwidgets/gimpwidgets.h"
+
+#include "widgets-types.h"
+
+#include "core/gimp.h"
+#include "core/gimpcontext.h"
+#include "core/gimpimage.h"
+#include "core/gimpimage-memory.h"
+
+#include "gimpmemoryeditor.h"
+
+#include "gimp-intl.h"
+
+
+#define UPDATE_INTERVAL 1000 /* milliseconds */
+
+
+enum
+{
+  LABEL_LAYERS,
+  LABEL_LAYER_MASKS,
+  LABEL_CHANNELS,
+  LABEL_SELECTION,
+  LABEL_PROJECTIONS,
+  LABEL_SHADOWS,
+  LABEL_UNDO,
+  LABEL_REDO,
+  LABEL_PREVIEWS,
+  LABEL_TOTAL,
+  LABEL_ALL_IMAGES
+};
+
+
+static void       gimp_memory_editor_dispose   (GObject          *object);
+
+static void       gimp_memory_editor_map       (GtkWidget        *widget);
+static void       gimp_memory_editor_unmap     (GtkWidget        *widget);
+
+static void       gimp_memory_editor_set_image (GimpImageEditor  *editor,
+                                                GimpImage        *image);
+
+static void       gimp_memory_editor_set_label (GimpMemoryEditor *editor,
+                                                gint              index,
+                                                gint64            memsize);
+static gboolean   gimp_memory_editor_update    (GimpMemoryEditor *editor);
+
+
+G_DEFINE_TYPE (GimpMemoryEditor, gimp_memory_editor, GIMP_TYPE_IMAGE_EDITOR)
+
+#define parent_class gimp_memory_editor_parent_class
+
+
+static void
+gimp_memory_editor_class_init (GimpMemoryEditorClass *klass)
+{
+  GObjectClass         *object_class       = G_OBJECT_CLASS (klass);
+  GtkWidgetClass       *widget_class       = GTK_WIDGET_CLASS (klass);
+  GimpImageEditorClass *image_editor_class = GIMP_IMAGE_EDITOR_CLASS (klass);
+
+  object_class->dispose         = gimp_memory_editor_dispose;
+
+  widget_class->map             = gimp_memory_editor_map;
+  widget_class->unmap           = gimp_memory_editor_unmap;
+
+  image_editor_class->set_image = gimp_memory_editor_set_image;
+}
+
+static void
+gimp_memory_editor_init (GimpMemoryEditor *editor)
+{
+  GtkWidget *table;
+  gint       i;
+
+  const gchar *gimp_memory_editor_labels[] =
+    {
+      N_("Layers:"),
+      N_("Layer masks:"),
+      N_("Channels:"),
+      N_("Selection:"),
+      N_("Projections:"),
+      N_("Shadow buffers:"),
+      N_("Undo:"),
+      N_("Redo:"),
+      N_("Previews:"),
+      N_("Image total:"),
+      N_("All images:")
+    };
+
+  gimp_editor_set_show_name (GIMP_EDITOR (editor), TRUE);
+
+  table = gtk_table_new (G_N_ELEMENTS (gimp_memory_editor_labels), 2, FALSE);
+  gtk_table_set_col_spacings (GTK_TABLE (table), 6);
+  gtk_table_set_row_spacings (GTK_TABLE (table), 3);
+  gtk_table_set_row_spacing (GTK_TABLE (table), LABEL_PREVIEWS, 12);
+  gtk_box_pack_start (GTK_BOX (editor), table, FALSE, FALSE, 0);
+  gtk_widget_show (table);
+
+  for (i = 0; i < G_N_ELEMENTS (gimp_memory_editor_labels); i++)
+    {
+      GtkWidget *label;
+
+      label = g_object_new (GTK_TYPE_LABEL,
+                            "label",  gettext (gimp_memory_editor_labels[i]),
+                            "xalign", 1.0,
+                            "yalign", 0.5,
+                            NULL);
+
+      if (i >= LABEL_TOTAL)
+        gimp_label_set_attributes (GTK_LABEL (label),
+                                   PANGO_ATTR_WEIGHT, PANGO_WEIGHT_BOLD,
+                                   -1);
+
+      gtk_table_attach (GTK_TABLE (table), label, 0, 1, i, i + 1,
+                        GTK_FILL, GTK_FILL, 0, 0);
+      gtk_widget_show (label);
+
+      editor->labels[i] = g_object_new (GTK_TYPE_LABEL,
+                                        "xalign",     0.0,
+                                        "yalign",     0.5,
+                                        "selectable", TRUE,
+                                        NULL);
+      gtk_table_attach (GTK_TABLE (table), editor->labels[i], 1, 2, i, i + 1,
+                        GTK_FILL | GTK_EXPAND, GTK_FILL, 0, 0);
+      gtk_widget_show (editor->labels[i]);
+    }
+}
+
+static void
+gimp_memory_editor_dispose (GObject *object)
+{
+  GimpMemoryEditor *editor = GIMP_MEMORY_EDITOR (object);
+
+  if (editor->timeout_id)
+    {
+      g_source_remove (editor->timeout_id);
+      editor->timeout_id = 0;
+    }
+
+  G_OBJECT_CLASS (parent_class)->dispose (object);
+}
+
+/*  the sizes are only polled while the editor is visible
+ */
+static void
+gimp_memory_editor_map (GtkWidget *widget)
+{
+  GimpMemoryEditor *editor = GIMP_MEMORY_EDITOR (widget);
+
+  GTK_WIDGET_CLASS (parent_class)->map (widget);
+
+  if (! editor->timeout_id)
+    editor->timeout_id =
+      g_timeout_add (UPDATE_INTERVAL,
+                     (GSourceFunc) gimp_memory_editor_update,
+                     editor);
+
+  gimp_memory_editor_update (editor);
+}
+
+static void
+gimp_memory_editor_unmap (GtkWidget *widget)
+{
+  GimpMemoryEditor *editor = GIMP_MEMORY_EDITOR (widget);
+
+  if (editor->timeout_id)
+    {
+      g_source_remove (editor->timeout_id);
+      editor->timeout_id = 0;
+    }
+
+  GTK_WIDGET_CLASS (parent_class)->unmap (widget);
+}
+
+static void
+gimp_memory_editor_set_image (GimpImageEditor *image_editor,
+                              GimpImage       *image)
+{
+  GimpMemoryEditor *editor = GIMP_MEMORY_EDITOR (image_editor);
+
+  GIMP_IMAGE_EDITOR_CLASS (parent_class)->set_image (image_editor, image);
+
+  if (gtk_widget_get_mapped (GTK_WIDGET (editor)))
+    gimp_memory_editor_update (editor);
+}
+
+
+/*  public functions  */
+
+GtkWidget *
+gimp_memory_editor_new (void)
+{
+  return g_object_new (GIMP_TYPE_MEMORY_EDITOR, NULL);
+}
+
+
+/*  private functions  */
+
+static void
+gimp_memory_editor_set_label (GimpMemoryEditor *editor,
+                              gint              index,
+                              gint64            memsize)
+{
+  if (memsize >= 0)
+    {
+      gchar *str = g_format_size (memsize);
+
+      gtk_label_set_text (GTK_LABEL (editor->labels[index]), str);
+      g_free (str);
+    }
+  else
+    {
+      gtk_label_set_text (GTK_LABEL (editor->labels[index]), NULL);
+    }
+}
+
+static gboolean
+gimp_memory_editor_update (GimpMemoryEditor *editor)
+{
+  GimpImageEditor *image_editor = GIMP_IMAGE_EDITOR (editor);
+  gint64           all_images   = -1;
+
+  if (image_editor->image)
+    {
+      GimpImageMemoryUsage usage;
+
+      gimp_image_get_memory_usage (image_editor->image, &usage);
+
+      gimp_memory_editor_set_label (editor, LABEL_LAYERS,      usage.layers);
+      gimp_memory_editor_set_label (editor, LABEL_LAYER_MASKS, usage.layer_masks);
+      gimp_memory_editor_set_label (editor, LABEL_CHANNELS,    usage.channels);
+      gimp_memory_editor_set_label (editor, LABEL_SELECTION,   usage.selection);
+      gimp_memory_editor_set_label (editor, LABEL_PROJECTIONS, usage.projections);
+      gimp_memory_editor_set_label (editor, LABEL_SHADOWS,     usage.shadows);
+      gimp_memory_editor_set_label (editor, LABEL_UNDO,        usage.undo);
+      gimp_memory_editor_set_label (editor, LABEL_REDO,        usage.redo);
+      gimp_memory_editor_set_label (editor, LABEL_PREVIEWS,    usage.previews);
+      gimp_memory_editor_set_label (editor, LABEL_TOTAL,
+                                    gimp_image_memory_usage_get_total (&usage));
+    }
+  else
+    {
+      gint i;
+
+      for (i = 0; i < LABEL_ALL_IMAGES; i++)
+        gimp_memory_editor_set_label (editor, i, -1);
+    }
+
+  if (image_editor->context)
+    {
+      GList *list;
+
+      all_images = 0;
+
+      for (list = gimp_get_image_iter (image_editor->context->gimp);
+           list;
+           list = g_list_next (list))
+        {
+          GimpImageMemoryUsage usage;
+
+          gimp_image_get_memory_usage (list->data, &usage);
+
+          all_images += gimp_image_memory_usage_get_total (&usage);
+        }
+    }
+
+  gimp_memory_editor_set_label (editor, LABEL_ALL_IMAGES, all_images);
+
+  return TRUE;
+}
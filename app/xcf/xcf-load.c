@@ -67,11 +67,41 @@
 #include "xcf-read.h"
 #include "xcf-seek.h"
 
+#include "gimp-trace.h"
+
 #include "gimp-intl.h"
 
 
 /* #define GIMP_XCF_PATH_DEBUG */
 
+/* how many RLE tiles per thread are decoded ahead of the buffer writes */
+#define XCF_TILES_IN_FLIGHT 16
+
+
+typedef struct _XcfTileQueue XcfTileQueue;
+typedef struct _XcfTileJob   XcfTileJob;
+
+struct _XcfTileQueue
+{
+  GMutex mutex;
+  GCond  cond;   /* signalled when a job is done */
+};
+
+struct _XcfTileJob
+{
+  GeglRectangle  rect;
+  gint           bpp;
+  guint32        offset;
+  const guchar  *src;
+  gint           src_length;
+  gboolean       skip;
+
+  guchar        *tile_data;  /* decoded, NULL for skipped tiles */
+  gboolean       success;
+  gboolean       done;
+};
+
+
 static void            xcf_load_add_masks     (GimpImage     *image);
 static gboolean        xcf_load_image_props   (XcfInfo       *info,
                                                GimpImage     *image);
@@ -101,6 +131,16 @@ static gboolean        xcf_load_buffer        (XcfInfo       *info,
                                                GeglBuffer    *buffer);
 static gboolean        xcf_load_level         (XcfInfo       *info,
                                                GeglBuffer    *buffer);
+static gboolean        xcf_load_level_tiles   (XcfInfo       *info,
+                                               GeglBuffer    *buffer,
+                                               const guint32 *offsets,
+                                               gint           ntiles);
+static gboolean        xcf_load_level_mapped  (XcfInfo       *info,
+                                               GeglBuffer    *buffer,
+                                               const guint32 *offsets,
+                                               gint           ntiles);
+static void            xcf_load_tile_job      (XcfTileJob    *job,
+                                               XcfTileQueue  *queue);
 static gboolean        xcf_load_tile          (XcfInfo       *info,
                                                GeglBuffer    *buffer,
                                                GeglRectangle *tile_rect,
@@ -110,6 +150,11 @@ static gboolean        xcf_load_tile_rle      (XcfInfo       *info,
                                                GeglRectangle *tile_rect,
                                                const Babl    *format,
                                                gint           data_length);
+static gboolean        xcf_decode_tile_rle    (const guchar  *xcfdata,
+                                               gint           data_length,
+                                               guchar        *tile_data,
+                                               gint           bpp,
+                                               gint           n_pixels);
 static GimpParasite  * xcf_load_parasite      (XcfInfo       *info);
 static gboolean        xcf_load_old_paths     (XcfInfo       *info,
                                                GimpImage     *image);
@@ -145,6 +190,7 @@ xcf_load_image (Gimp     *gimp,
   gint                image_type;
   gint                precision = GIMP_PRECISION_U8;
   gint                num_successful_elements = 0;
+  gboolean            success;
 
   /* read in the image width, height and type */
   info->cp += xcf_read_int32 (info->fp, (guint32 *) &width, 1);
@@ -162,7 +208,11 @@ xcf_load_image (Gimp     *gimp,
   xcf_progress_update (info);
 
   /* read the image properties */
-  if (! xcf_load_image_props (info, image))
+  GIMP_TRACE_BEGIN ("xcf_load_image_props");
+  success = xcf_load_image_props (info, image);
+  GIMP_TRACE_END ("xcf_load_image_props");
+
+  if (! success)
     goto hard_error;
 
   /* check for a GimpGrid parasite */
@@ -210,7 +260,10 @@ xcf_load_image (Gimp     *gimp,
         goto error;
 
       /* read in the layer */
+      GIMP_TRACE_BEGIN ("xcf_load_layer");
       layer = xcf_load_layer (info, image, &item_path);
+      GIMP_TRACE_END ("xcf_load_layer");
+
       if (!layer)
         goto error;
 
@@ -294,7 +347,10 @@ xcf_load_image (Gimp     *gimp,
         goto error;
 
       /* read in the channel */
+      GIMP_TRACE_BEGIN ("xcf_load_channel");
       channel = xcf_load_channel (info, image);
+      GIMP_TRACE_END ("xcf_load_channel");
+
       if (!channel)
         goto error;
 
@@ -1433,18 +1489,15 @@ static gboolean
 xcf_load_level (XcfInfo    *info,
                 GeglBuffer *buffer)
 {
-  const Babl *format;
-  guint32     saved_pos;
-  guint32     offset, offset2;
-  gint        n_tile_rows;
-  gint        n_tile_cols;
-  guint       ntiles;
-  gint        width;
-  gint        height;
-  gint        i;
-  gint        fail;
-
-  format = gegl_buffer_get_format (buffer);
+  guint32  saved_pos;
+  guint32 *offsets;
+  gint     n_tile_rows;
+  gint     n_tile_cols;
+  guint    ntiles;
+  gint     width;
+  gint     height;
+  gint     i;
+  gboolean success;
 
   info->cp += xcf_read_int32 (info->fp, (guint32 *) &width, 1);
   info->cp += xcf_read_int32 (info->fp, (guint32 *) &height, 1);
@@ -1453,50 +1506,106 @@ xcf_load_level (XcfInfo    *info,
       height != gegl_buffer_get_height (buffer))
     return FALSE;
 
-  /* read in the first tile offset.
-   *  if it is '0', then this tile level is empty
-   *  and we can simply return.
-   */
-  info->cp += xcf_read_int32 (info->fp, &offset, 1);
-  if (offset == 0)
-    return TRUE;
-
   n_tile_rows = gimp_gegl_buffer_get_n_tile_rows (buffer, XCF_TILE_HEIGHT);
   n_tile_cols = gimp_gegl_buffer_get_n_tile_cols (buffer, XCF_TILE_WIDTH);
 
   ntiles = n_tile_rows * n_tile_cols;
-  for (i = 0; i < ntiles; i++)
-    {
-      GeglRectangle rect;
 
-      fail = FALSE;
+  /* read in the whole offset table first, the tiles can then be
+   *  loaded without seeking back and forth.
+   *  if the first offset is '0', then this tile level is empty
+   *  and we can simply return.
+   */
+  offsets = g_new (guint32, ntiles + 1);
+
+  info->cp += xcf_read_int32 (info->fp, &offsets[0], 1);
+  if (offsets[0] == 0)
+    {
+      g_free (offsets);
+      return TRUE;
+    }
 
-      if (offset == 0)
+  for (i = 0; i < ntiles; i++)
+    {
+      if (offsets[i] == 0)
         {
           gimp_message_literal (info->gimp, G_OBJECT (info->progress),
 				GIMP_MESSAGE_ERROR,
 				"not enough tiles found in level");
+          g_free (offsets);
           return FALSE;
         }
 
-      /* save the current position as it is where the
-       *  next tile offset is stored.
+      info->cp += xcf_read_int32 (info->fp, &offsets[i + 1], 1);
+    }
+
+  if (offsets[ntiles] != 0)
+    {
+      gimp_message (info->gimp, G_OBJECT (info->progress), GIMP_MESSAGE_ERROR,
+                    "encountered garbage after reading level: %d",
+                    offsets[ntiles]);
+      g_free (offsets);
+      return FALSE;
+    }
+
+  /* save the current position, the end of the offset table */
+  saved_pos = info->cp;
+
+  if (info->mapped &&
+      (info->compression == COMPRESS_NONE ||
+       info->compression == COMPRESS_RLE))
+    {
+      success = xcf_load_level_mapped (info, buffer, offsets, ntiles);
+    }
+  else
+    {
+      success = xcf_load_level_tiles (info, buffer, offsets, ntiles);
+
+      /* restore the saved position so we'll be ready to
+       *  read what follows the level.
        */
-      saved_pos = info->cp;
+      if (success && ! xcf_seek_pos (info, saved_pos, NULL))
+        success = FALSE;
+    }
 
-      /* read in the offset of the next tile so we can calculate the amount
-         of data needed for this tile*/
-      info->cp += xcf_read_int32 (info->fp, &offset2, 1);
+  g_free (offsets);
 
-      /* if the offset is 0 then we need to read in the maximum possible
-         allowing for negative compression */
-      if (offset2 == 0)
-        offset2 = offset + XCF_TILE_WIDTH * XCF_TILE_WIDTH * 4 * 1.5;
+  return success;
+}
+
+/* the amount of compressed data for tile @i */
+static gint
+xcf_load_tile_data_length (const guint32 *offsets,
+                           gint           i)
+{
+  guint32 offset2 = offsets[i + 1];
+
+  /* if the offset is 0 then we need to read in the maximum possible
+     allowing for negative compression */
+  if (offset2 == 0)
+    offset2 = offsets[i] + XCF_TILE_WIDTH * XCF_TILE_WIDTH * 4 * 1.5;
                                         /* 1.5 is probably more
                                            than we need to allow */
 
+  return offset2 - offsets[i];
+}
+
+static gboolean
+xcf_load_level_tiles (XcfInfo       *info,
+                      GeglBuffer    *buffer,
+                      const guint32 *offsets,
+                      gint           ntiles)
+{
+  const Babl *format = gegl_buffer_get_format (buffer);
+  gint        i;
+
+  for (i = 0; i < ntiles; i++)
+    {
+      GeglRectangle rect;
+      gboolean      fail = FALSE;
+
       /* seek to the tile offset */
-      if (! xcf_seek_pos (info, offset, NULL))
+      if (! xcf_seek_pos (info, offsets[i], NULL))
         return FALSE;
 
       /* get the tile from the tile manager */
@@ -1513,7 +1622,7 @@ xcf_load_level (XcfInfo    *info,
           break;
         case COMPRESS_RLE:
           if (!xcf_load_tile_rle (info, buffer, &rect, format,
-                                  offset2 - offset))
+                                  xcf_load_tile_data_length (offsets, i)))
             fail = TRUE;
           break;
         case COMPRESS_ZLIB:
@@ -1528,25 +1637,183 @@ xcf_load_level (XcfInfo    *info,
 
       if (fail)
         return FALSE;
+    }
 
-      /* restore the saved position so we'll be ready to
-       *  read the next offset.
-       */
-      if (!xcf_seek_pos (info, saved_pos, NULL))
-        return FALSE;
+  return TRUE;
+}
 
-      /* read in the offset of the next tile */
-      info->cp += xcf_read_int32 (info->fp, &offset, 1);
+/* loads the tiles straight from the mapped file. RLE tiles are
+ * decoded by a pool of threads while the tiles before them are
+ * written to the buffer, with at most XCF_TILES_IN_FLIGHT tiles per
+ * thread decoded ahead.
+ */
+static gboolean
+xcf_load_level_mapped (XcfInfo       *info,
+                       GeglBuffer    *buffer,
+                       const guint32 *offsets,
+                       gint           ntiles)
+{
+  const guchar *file_data;
+  gsize         file_size;
+  const Babl   *format;
+  gint          bpp;
+  XcfTileQueue  queue;
+  XcfTileJob   *jobs;
+  GThreadPool  *pool = NULL;
+  gint          n_threads;
+  gint          n_queued = 0;
+  gint          i;
+  gboolean      success  = TRUE;
+
+  GIMP_TRACE_BEGIN ("xcf_load_level_mapped");
+
+  file_data = (const guchar *) g_mapped_file_get_contents (info->mapped);
+  file_size = g_mapped_file_get_length (info->mapped);
+
+  format = gegl_buffer_get_format (buffer);
+  bpp    = babl_format_get_bytes_per_pixel (format);
+
+  n_threads = GIMP_GEGL_CONFIG (info->gimp->config)->num_processors;
+
+  jobs = g_new0 (XcfTileJob, ntiles);
+
+  g_mutex_init (&queue.mutex);
+  g_cond_init (&queue.cond);
+
+  if (info->compression == COMPRESS_RLE && n_threads > 1)
+    pool = g_thread_pool_new ((GFunc) xcf_load_tile_job, &queue,
+                              n_threads, FALSE, NULL);
+
+  for (i = 0; i < ntiles && success; i++)
+    {
+      XcfTileJob *job;
+
+      /* keep the pool busy, but bound the decoded data in flight */
+      for (;
+           n_queued < ntiles &&
+           n_queued < i + n_threads * XCF_TILES_IN_FLIGHT;
+           n_queued++)
+        {
+          job = &jobs[n_queued];
+
+          gimp_gegl_buffer_get_tile_rect (buffer,
+                                          XCF_TILE_WIDTH, XCF_TILE_HEIGHT,
+                                          n_queued, &job->rect);
+
+          job->bpp    = bpp;
+          job->offset = offsets[n_queued];
+
+          if (info->compression == COMPRESS_RLE)
+            {
+              gint length = xcf_load_tile_data_length (offsets, n_queued);
+
+              if (length <= 0)
+                {
+                  job->skip = TRUE;
+                }
+              else
+                {
+                  /* like fread(), stop at the end of the file */
+                  if (job->offset >= file_size)
+                    length = 0;
+                  else if (length > file_size - job->offset)
+                    length = file_size - job->offset;
+
+                  job->src        = file_data + MIN (job->offset, file_size);
+                  job->src_length = length;
+                }
+
+              if (pool)
+                g_thread_pool_push (pool, job, NULL);
+            }
+        }
+
+      job = &jobs[i];
+
+      if (info->compression == COMPRESS_NONE)
+        {
+          gsize tile_size = bpp * job->rect.width * job->rect.height;
+
+          if (job->offset + tile_size > file_size)
+            {
+              success = FALSE;
+              break;
+            }
+
+          gegl_buffer_set (buffer, &job->rect, 0, format,
+                           file_data + job->offset,
+                           GEGL_AUTO_ROWSTRIDE);
+          continue;
+        }
+
+      if (pool)
+        {
+          g_mutex_lock (&queue.mutex);
+
+          while (! job->done)
+            g_cond_wait (&queue.cond, &queue.mutex);
+
+          g_mutex_unlock (&queue.mutex);
+        }
+      else
+        {
+          xcf_load_tile_job (job, &queue);
+        }
+
+      if (! job->success)
+        success = FALSE;
+      else if (job->tile_data)
+        gegl_buffer_set (buffer, &job->rect, 0, format, job->tile_data,
+                         GEGL_AUTO_ROWSTRIDE);
+
+      g_free (job->tile_data);
+      job->tile_data = NULL;
     }
 
-  if (offset != 0)
+  /* on failure, wait for the tiles already queued before freeing them */
+  if (pool)
+    g_thread_pool_free (pool, FALSE, TRUE);
+
+  for (i = 0; i < ntiles; i++)
+    g_free (jobs[i].tile_data);
+
+  g_free (jobs);
+
+  g_cond_clear (&queue.cond);
+  g_mutex_clear (&queue.mutex);
+
+  GIMP_TRACE_END ("xcf_load_level_mapped");
+
+  return success;
+}
+
+static void
+xcf_load_tile_job (XcfTileJob   *job,
+                   XcfTileQueue *queue)
+{
+  /* Workaround for bug #357809: tiles without data are skipped as if
+   * they were empty, see xcf_load_tile_rle()
+   */
+  if (job->skip)
     {
-      gimp_message (info->gimp, G_OBJECT (info->progress), GIMP_MESSAGE_ERROR,
-                    "encountered garbage after reading level: %d", offset);
-      return FALSE;
+      job->success = TRUE;
     }
+  else
+    {
+      gint n_pixels = job->rect.width * job->rect.height;
 
-  return TRUE;
+      job->tile_data = g_malloc (job->bpp * n_pixels);
+      job->success   = xcf_decode_tile_rle (job->src, job->src_length,
+                                            job->tile_data,
+                                            job->bpp, n_pixels);
+    }
+
+  g_mutex_lock (&queue->mutex);
+
+  job->done = TRUE;
+  g_cond_broadcast (&queue->cond);
+
+  g_mutex_unlock (&queue->mutex);
 }
 
 static gboolean
@@ -1575,13 +1842,10 @@ xcf_load_tile_rle (XcfInfo       *info,
                    gint           data_length)
 {
   gint    bpp       = babl_format_get_bytes_per_pixel (format);
-  gint    tile_size = bpp * tile_rect->width * tile_rect->height;
-  guchar *tile_data = g_alloca (tile_size);
-  gint    i;
+  gint    n_pixels  = tile_rect->width * tile_rect->height;
+  guchar *tile_data = g_alloca (bpp * n_pixels);
   gint    nmemb_read_successfully;
   guchar *xcfdata;
-  guchar *xcfodata;
-  guchar *xcfdatalimit;
 
   /* Workaround for bug #357809: avoid crashing on g_malloc() and skip
    * this tile (return TRUE without storing data) as if it did not
@@ -1592,7 +1856,7 @@ xcf_load_tile_rle (XcfInfo       *info,
   if (data_length <= 0)
     return TRUE;
 
-  xcfdata = xcfodata = g_alloca (data_length);
+  xcfdata = g_alloca (data_length);
 
   /* we have to use fread instead of xcf_read_* because we may be
    * reading past the end of the file here
@@ -1601,12 +1865,33 @@ xcf_load_tile_rle (XcfInfo       *info,
                                    data_length, info->fp);
   info->cp += nmemb_read_successfully;
 
-  xcfdatalimit = &xcfodata[nmemb_read_successfully - 1];
+  if (! xcf_decode_tile_rle (xcfdata, nmemb_read_successfully,
+                             tile_data, bpp, n_pixels))
+    return FALSE;
+
+  gegl_buffer_set (buffer, tile_rect, 0, format, tile_data,
+                   GEGL_AUTO_ROWSTRIDE);
+
+  return TRUE;
+}
+
+/* decodes @data_length bytes of RLE data into @n_pixels pixels of
+ * @bpp bytes, only touches its arguments so it can run in any thread
+ */
+static gboolean
+xcf_decode_tile_rle (const guchar *xcfdata,
+                     gint          data_length,
+                     guchar       *tile_data,
+                     gint          bpp,
+                     gint          n_pixels)
+{
+  const guchar *xcfdatalimit = &xcfdata[data_length - 1];
+  gint          i;
 
   for (i = 0; i < bpp; i++)
     {
       guchar *data  = tile_data + i;
-      gint    size  = tile_rect->width * tile_rect->height;
+      gint    size  = n_pixels;
       gint    count = 0;
       guchar  val;
       gint    length;
@@ -1693,9 +1978,6 @@ xcf_load_tile_rle (XcfInfo       *info,
         }
     }
 
-  gegl_buffer_set (buffer, tile_rect, 0, format, tile_data,
-                   GEGL_AUTO_ROWSTRIDE);
-
   return TRUE;
 
  bogus_rle:
@@ -90,6 +90,7 @@ struct _XcfInfo
   Gimp               *gimp;
   GimpProgress       *progress;
   FILE               *fp;
+  GMappedFile        *mapped;  /* the file for loading tiles, or NULL */
   guint               cp;
   const gchar        *filename;
   GimpTattoo          tattoo_state;
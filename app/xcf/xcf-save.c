@@ -65,6 +65,8 @@
 #include "xcf-seek.h"
 #include "xcf-write.h"
 
+#include "gimp-trace.h"
+
 #include "gimp-intl.h"
 
 
@@ -238,6 +240,7 @@ xcf_save_image (XcfInfo    *info,
   guint    max_progress;
   gint     t1, t2, t3, t4;
   gchar    version_tag[16];
+  gboolean success;
   GError  *tmp_error = NULL;
 
   /* write out the tag information for the image */
@@ -287,7 +290,11 @@ xcf_save_image (XcfInfo    *info,
   /* write the property information for the image.
    */
 
-  xcf_check_error (xcf_save_image_props (info, image, error));
+  GIMP_TRACE_BEGIN ("xcf_save_image_props");
+  success = xcf_save_image_props (info, image, error);
+  GIMP_TRACE_END ("xcf_save_image_props");
+
+  xcf_check_error (success);
 
   xcf_progress_update (info);
 
@@ -311,7 +318,11 @@ xcf_save_image (XcfInfo    *info,
       offset = info->cp;
 
       /* write out the layer. */
-      xcf_check_error (xcf_save_layer (info, image, layer, error));
+      GIMP_TRACE_BEGIN ("xcf_save_layer");
+      success = xcf_save_layer (info, image, layer, error);
+      GIMP_TRACE_END ("xcf_save_layer");
+
+      xcf_check_error (success);
 
       xcf_progress_update (info);
 
@@ -351,7 +362,11 @@ xcf_save_image (XcfInfo    *info,
       offset = info->cp;
 
       /* write out the layer. */
-      xcf_check_error (xcf_save_channel (info, image, channel, error));
+      GIMP_TRACE_BEGIN ("xcf_save_channel");
+      success = xcf_save_channel (info, image, channel, error);
+      GIMP_TRACE_END ("xcf_save_channel");
+
+      xcf_check_error (success);
 
       xcf_progress_update (info);
 
@@ -42,6 +42,8 @@
 #include "xcf-read.h"
 #include "xcf-save.h"
 
+#include "gimp-trace.h"
+
 #include "gimp-intl.h"
 
 
@@ -256,6 +258,7 @@ xcf_load_invoker (GimpProcedure         *procedure,
       info.progress              = progress;
       info.cp                    = 0;
       info.filename              = filename;
+      info.mapped                = g_mapped_file_new (filename, FALSE, NULL);
       info.tattoo_state          = 0;
       info.active_layer          = NULL;
       info.active_channel        = NULL;
@@ -303,7 +306,9 @@ xcf_load_invoker (GimpProcedure         *procedure,
           if (info.file_version >= 0 &&
               info.file_version < G_N_ELEMENTS (xcf_loaders))
             {
+              GIMP_TRACE_BEGIN ("xcf_load_image");
               image = (*(xcf_loaders[info.file_version])) (gimp, &info, error);
+              GIMP_TRACE_END ("xcf_load_image");
 
               if (! image)
                 success = FALSE;
@@ -319,6 +324,9 @@ xcf_load_invoker (GimpProcedure         *procedure,
 
       fclose (info.fp);
 
+      if (info.mapped)
+        g_mapped_file_unref (info.mapped);
+
       if (progress)
         gimp_progress_end (progress);
     }
@@ -369,6 +377,7 @@ xcf_save_invoker (GimpProcedure         *procedure,
       info.progress              = progress;
       info.cp                    = 0;
       info.filename              = filename;
+      info.mapped                = NULL;
       info.active_layer          = NULL;
       info.active_channel        = NULL;
       info.floating_sel_drawable = NULL;
@@ -391,7 +400,9 @@ xcf_save_invoker (GimpProcedure         *procedure,
 
       xcf_save_choose_format (&info, image);
 
+      GIMP_TRACE_BEGIN ("xcf_save_image");
       success = xcf_save_image (&info, image, error);
+      GIMP_TRACE_END ("xcf_save_image");
 
       if (success)
         {
@@ -3118,3 +3118,83 @@ gimp_image_get_parasite_list (gint32  image_ID,
 
   return parasites;
 }
+
+/**
+ * gimp_image_get_memory_usage:
+ * @image_ID: The image.
+ * @total: The total memory used by the image, in bytes.
+ * @layers: Memory used by layer buffers, in bytes.
+ * @layer_masks: Memory used by layer mask buffers, in bytes.
+ * @channels: Memory used by channel buffers, in bytes.
+ * @selection: Memory used by the selection mask, in bytes.
+ * @projections: Memory used by the rendered tiles of the image and group layer projections, in bytes.
+ * @shadows: Memory used by shadow buffers, in bytes.
+ * @undo: Memory used by the undo stack, in bytes.
+ * @redo: Memory used by the redo stack, in bytes.
+ * @previews: Memory used by cached previews, in bytes.
+ *
+ * Returns the memory used by the specified image.
+ *
+ * This procedure returns the memory used by the specified image,
+ * broken down by what it is used for. Every buffer is attributed to
+ * exactly one category, so the categories add up to the total. Sizes
+ * are returned as floating point numbers because they may exceed the
+ * range of a 32-bit integer.
+ *
+ * Returns: TRUE on success.
+ *
+ * Since: GIMP 2.10
+ **/
+gboolean
+gimp_image_get_memory_usage (gint32   image_ID,
+                              gdouble *total,
+                              gdouble *layers,
+                              gdouble *layer_masks,
+                              gdouble *channels,
+                              gdouble *selection,
+                              gdouble *projections,
+                              gdouble *shadows,
+                              gdouble *undo,
+                              gdouble *redo,
+                              gdouble *previews)
+{
+  GimpParam *return_vals;
+  gint nreturn_vals;
+  gboolean success = TRUE;
+
+  return_vals = gimp_run_procedure ("gimp-image-get-memory-usage",
+                                    &nreturn_vals,
+                                    GIMP_PDB_IMAGE, image_ID,
+                                    GIMP_PDB_END);
+
+  *total = 0.0;
+  *layers = 0.0;
+  *layer_masks = 0.0;
+  *channels = 0.0;
+  *selection = 0.0;
+  *projections = 0.0;
+  *shadows = 0.0;
+  *undo = 0.0;
+  *redo = 0.0;
+  *previews = 0.0;
+
+  success = return_vals[0].data.d_status == GIMP_PDB_SUCCESS;
+
+  if (success)
+    {
+      *total = return_vals[1].data.d_float;
+      *layers = return_vals[2].data.d_float;
+      *layer_masks = return_vals[3].data.d_float;
+      *channels = return_vals[4].data.d_float;
+      *selection = return_vals[5].data.d_float;
+      *projections = return_vals[6].data.d_float;
+      *shadows = return_vals[7].data.d_float;
+      *undo = return_vals[8].data.d_float;
+      *redo = return_vals[9].data.d_float;
+      *previews = return_vals[10].data.d_float;
+    }
+
+  gimp_destroy_params (return_vals, nreturn_vals);
+
+  return success;
+}
@@ -218,6 +218,17 @@ GimpParasite*            gimp_image_get_parasite             (gint32
                                                               const gchar            *name);
 gchar**                  gimp_image_get_parasite_list        (gint32                  image_ID,
                                                               gint                   *num_parasites);
+gboolean                 gimp_image_get_memory_usage         (gint32                  image_ID,
+                                                              gdouble                *total,
+                                                              gdouble                *layers,
+                                                              gdouble                *layer_masks,
+                                                              gdouble                *channels,
+                                                              gdouble                *selection,
+                                                              gdouble                *projections,
+                                                              gdouble                *shadows,
+                                                              gdouble                *undo,
+                                                              gdouble                *redo,
+                                                              gdouble                *previews);
 
 
 G_END_DECLS
@@ -22,6 +22,8 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include "gimp.h"
 
 
@@ -355,3 +357,93 @@ gimp_plugin_precision_enabled (void)
 
   return enabled;
 }
+
+/**
+ * gimp_plugin_get_ipc_stats:
+ * @plugin: The plug-in executable's name, e.g. "blur".
+ * @message_type: The wire protocol message type, or -1 for all types.
+ * @n_runs: The number of times the plug-in was run.
+ * @time_running: The time the plug-in was running.
+ * @time_blocked: The time GIMP was blocked reading from or writing to the plug-in.
+ * @time_handling: The time GIMP spent handling messages from the plug-in.
+ * @n_messages: The number of messages received and sent.
+ * @pipe_bytes: The number of bytes received and sent through the pipe.
+ * @shm_bytes: The number of bytes of tile data passed in shared memory.
+ * @num_buckets: The number of histogram buckets.
+ * @latency: The handling latency histogram.
+ *
+ * Returns statistics about the communication with a plug-in.
+ *
+ * This procedure returns what GIMP measured while talking to the
+ * plug-in executable @plugin, summed over all its runs in this
+ * session. If @message_type is -1, the message counts, byte counts and
+ * handling times are summed over all wire protocol message types,
+ * otherwise they are restricted to the given type (0 = QUIT, ..., 12 =
+ * HAS_INIT). Times are in seconds. The latency histogram counts how
+ * long GIMP took to handle each received message: bucket n counts
+ * messages that took less than 2^n microseconds. Byte counts are
+ * returned as floating point numbers because they may exceed the range
+ * of a 32-bit integer.
+ *
+ * Set GIMP_LOG=plug-in-stats to have these statistics printed every
+ * time a plug-in exits.
+ *
+ * Returns: TRUE on success.
+ *
+ * Since: GIMP 2.10
+ **/
+gboolean
+gimp_plugin_get_ipc_stats (const gchar  *plugin,
+                           gint          message_type,
+                           gint         *n_runs,
+                           gdouble      *time_running,
+                           gdouble      *time_blocked,
+                           gdouble      *time_handling,
+                           gint         *n_messages,
+                           gdouble      *pipe_bytes,
+                           gdouble      *shm_bytes,
+                           gint         *num_buckets,
+                           gdouble     **latency)
+{
+  GimpParam *return_vals;
+  gint nreturn_vals;
+  gboolean success = TRUE;
+
+  return_vals = gimp_run_procedure ("gimp-plugin-get-ipc-stats",
+                                    &nreturn_vals,
+                                    GIMP_PDB_STRING, plugin,
+                                    GIMP_PDB_INT32, message_type,
+                                    GIMP_PDB_END);
+
+  *n_runs = 0;
+  *time_running = 0.0;
+  *time_blocked = 0.0;
+  *time_handling = 0.0;
+  *n_messages = 0;
+  *pipe_bytes = 0.0;
+  *shm_bytes = 0.0;
+  *num_buckets = 0;
+  *latency = NULL;
+
+  success = return_vals[0].data.d_status == GIMP_PDB_SUCCESS;
+
+  if (success)
+    {
+      *n_runs = return_vals[1].data.d_int32;
+      *time_running = return_vals[2].data.d_float;
+      *time_blocked = return_vals[3].data.d_float;
+      *time_handling = return_vals[4].data.d_float;
+      *n_messages = return_vals[5].data.d_int32;
+      *pipe_bytes = return_vals[6].data.d_float;
+      *shm_bytes = return_vals[7].data.d_float;
+      *num_buckets = return_vals[8].data.d_int32;
+      *latency = g_new (gdouble, *num_buckets);
+      memcpy (*latency,
+              return_vals[9].data.d_floatarray,
+              *num_buckets * sizeof (gdouble));
+    }
+
+  gimp_destroy_params (return_vals, nreturn_vals);
+
+  return success;
+}
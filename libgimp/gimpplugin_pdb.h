@@ -48,6 +48,17 @@ gboolean                 gimp_plugin_set_pdb_error_handler (GimpPDBErrorHandler
 GimpPDBErrorHandler      gimp_plugin_get_pdb_error_handler (void);
 gboolean                 gimp_plugin_enable_precision      (void);
 gboolean                 gimp_plugin_precision_enabled     (void);
+gboolean                 gimp_plugin_get_ipc_stats         (const gchar         *plugin,
+                                                            gint                 message_type,
+                                                            gint                *n_runs,
+                                                            gdouble             *time_running,
+                                                            gdouble             *time_blocked,
+                                                            gdouble             *time_handling,
+                                                            gint                *n_messages,
+                                                            gdouble             *pipe_bytes,
+                                                            gdouble             *shm_bytes,
+                                                            gint                *num_buckets,
+                                                            gdouble            **latency);
 
 
 G_END_DECLS
@@ -60,6 +60,21 @@ typedef enum
 } operatingMode;
 
 
+/*  a band of tile rows, which two consecutive frames are compared in  */
+typedef struct
+{
+  const guchar *this_frame;
+  const guchar *last_frame;
+  gint          y1, y2;
+  gboolean      find_opaque; /* find the opaque pixels of 'this' instead
+                              * of the ones which changed since 'last'
+                              */
+
+  gboolean      can_combine;
+  gint          left, top, right, bottom;
+} CompareBand;
+
+
 /* Declare local functions. */
 static  void query (void);
 static  void run   (const gchar      *name,
@@ -87,6 +102,20 @@ static  gboolean    is_ms_tag           (const gchar *str,
                                          gint        *duration,
                                          gint        *taglength);
 
+static  void        compose_frame       (GimpDrawable *drawable,
+                                         DisposeType   dispose,
+                                         guchar       *dest,
+                                         const guchar *last);
+static  gboolean    find_frame_bounds   (const guchar *this_frame,
+                                         const guchar *last_frame,
+                                         gboolean      find_opaque,
+                                         gint32       *left,
+                                         gint32       *top,
+                                         gint32       *right,
+                                         gint32       *bottom);
+static  void        compare_band        (gpointer      data,
+                                         gpointer      user_data);
+
 
 const GimpPlugInInfo PLUG_IN_INFO =
 {
@@ -111,6 +140,9 @@ static  guchar           *palette;
 static  gint              ncolours;
 static  operatingMode     opmode;
 
+static  GThreadPool      *compare_pool  = NULL;
+static  GAsyncQueue      *compare_queue = NULL;
+
 
 MAIN ()
 
@@ -390,22 +422,278 @@ compose_row (gint          frame_num,
 }
 
 
+/* Renders a frame over 'last', the previous one.  The frame's layer
+ * is read once, a row of tiles at a time.
+ */
+static void
+compose_frame (GimpDrawable *drawable,
+               DisposeType   dispose,
+               guchar       *dest,
+               const guchar *last)
+{
+  GimpPixelRgn  pixel_rgn;
+  guchar       *strip;
+  gint          rawx, rawy, rawbpp, rawwidth, rawheight;
+  gint          x1, y1, x2, y2;
+  gint          y;
+  gboolean      has_alpha;
+
+  if (dispose == DISPOSE_REPLACE)
+    total_alpha (dest, width * height, pixelstep);
+  else
+    memcpy (dest, last, width * height * pixelstep);
+
+  gimp_drawable_offsets (drawable->drawable_id,
+                         &rawx,
+                         &rawy);
+
+  rawbpp    = drawable->bpp;
+  rawwidth  = drawable->width;
+  rawheight = drawable->height;
+  has_alpha = gimp_drawable_has_alpha (drawable->drawable_id);
+
+  /* the part of the frame which is inside the image */
+  x1 = MAX (rawx, 0);
+  y1 = MAX (rawy, 0);
+  x2 = MIN (rawx + rawwidth,  (gint) width);
+  y2 = MIN (rawy + rawheight, (gint) height);
+
+  if (x1 >= x2 || y1 >= y2)
+    return;
+
+  gimp_pixel_rgn_init (&pixel_rgn, drawable,
+                       0, 0,
+                       rawwidth, rawheight,
+                       FALSE, FALSE);
+
+  strip = g_malloc ((x2 - x1) * gimp_tile_height () * rawbpp);
+
+  for (y = y1; y < y2; )
+    {
+      gint rows = MIN (gimp_tile_height () - (y - rawy) % gimp_tile_height (),
+                       y2 - y);
+      gint row;
+
+      gimp_pixel_rgn_get_rect (&pixel_rgn, strip,
+                               x1 - rawx, y - rawy,
+                               x2 - x1, rows);
+
+      for (row = 0; row < rows; row++)
+        {
+          const guchar *srcptr  = strip + row * (x2 - x1) * rawbpp;
+          guchar       *destptr = dest + ((y + row) * width + x1) * pixelstep;
+          gint          i;
+
+          for (i = x1; i < x2; i++)
+            {
+              if ((!has_alpha) || (srcptr[rawbpp - 1] & 128))
+                {
+                  memcpy (destptr, srcptr, pixelstep - 1);
+                  destptr[pixelstep - 1] = 255;
+                }
+
+              srcptr  += rawbpp;
+              destptr += pixelstep;
+            }
+        }
+
+      y += rows;
+    }
+
+  g_free (strip);
+}
+
+
+/* Whether a pixel looks the same in two frames: both are transparent,
+ * or both are opaque and of the same colour.
+ */
+static inline gboolean
+same_pixel (const guchar *this_pixel,
+            const guchar *last_pixel)
+{
+  gboolean this_opaque = this_pixel[pixelstep - 1] & 128;
+  gboolean last_opaque = last_pixel[pixelstep - 1] & 128;
+
+  if (! this_opaque && ! last_opaque)
+    return TRUE;
+
+  return (this_opaque && last_opaque &&
+          memcmp (this_pixel, last_pixel, pixelstep - 1) == 0);
+}
+
+/* Finds the bounding box of the band's changed, or opaque, pixels.
+ * Runs in the compare pool's threads, so it must not talk to the core.
+ */
+static void
+compare_band (gpointer data,
+              gpointer user_data)
+{
+  CompareBand *band       = data;
+  GAsyncQueue *queue      = user_data;
+  gint         rowstride  = width * pixelstep;
+  gint         tile_width = gimp_tile_width ();
+  gint         x1, y;
+
+  band->can_combine = TRUE;
+  band->left        = width;
+  band->top         = height;
+  band->right       = 0;
+  band->bottom      = 0;
+
+  if (band->find_opaque)
+    {
+      for (y = band->y1; y < band->y2; y++)
+        {
+          const guchar *row = band->this_frame + y * rowstride;
+          gint          left, right;
+
+          for (left = 0; left < (gint) width; left++)
+            if (row[left * pixelstep + pixelstep - 1] & 128)
+              break;
+
+          if (left == (gint) width)
+            continue;
+
+          for (right = width; right > left; right--)
+            if (row[(right - 1) * pixelstep + pixelstep - 1] & 128)
+              break;
+
+          band->left   = MIN (band->left, left);
+          band->right  = MAX (band->right, right);
+          band->top    = MIN (band->top, y);
+          band->bottom = y + 1;
+        }
+    }
+  else
+    {
+      for (x1 = 0; x1 < (gint) width; x1 += tile_width)
+        {
+          gint x2 = MIN (x1 + tile_width, (gint) width);
+
+          /* nothing in this tile could grow the box or forbid combining */
+          if (! band->can_combine                           &&
+              x1 >= band->left && x2 <= band->right         &&
+              band->y1 >= band->top && band->y2 <= band->bottom)
+            continue;
+
+          for (y = band->y1; y < band->y2; y++)
+            {
+              const guchar *this_pixel = band->this_frame + y * rowstride +
+                                         x1 * pixelstep;
+              const guchar *last_pixel = band->last_frame + y * rowstride +
+                                         x1 * pixelstep;
+              gint          x;
+
+              /* most rows of most tiles don't change at all */
+              if (memcmp (this_pixel, last_pixel, (x2 - x1) * pixelstep) == 0)
+                continue;
+
+              for (x = x1; x < x2; x++)
+                {
+                  if (! same_pixel (this_pixel, last_pixel))
+                    {
+                      /* an opaque pixel became transparent */
+                      if (! (this_pixel[pixelstep - 1] & 128))
+                        band->can_combine = FALSE;
+
+                      band->left   = MIN (band->left, x);
+                      band->right  = MAX (band->right, x + 1);
+                      band->top    = MIN (band->top, y);
+                      band->bottom = MAX (band->bottom, y + 1);
+                    }
+
+                  this_pixel += pixelstep;
+                  last_pixel += pixelstep;
+                }
+            }
+        }
+    }
+
+  if (queue)
+    g_async_queue_push (queue, band);
+}
+
+/* Finds the bounding box of the pixels which changed between two
+ * frames, or of the opaque pixels of 'this_frame' if 'find_opaque'.
+ * The image is split in bands of tile rows, which are compared in
+ * parallel.  Returns whether 'this_frame' can be combined with
+ * 'last_frame', i.e. no opaque pixel became transparent.
+ */
+static gboolean
+find_frame_bounds (const guchar *this_frame,
+                   const guchar *last_frame,
+                   gboolean      find_opaque,
+                   gint32       *left,
+                   gint32       *top,
+                   gint32       *right,
+                   gint32       *bottom)
+{
+  CompareBand *bands;
+  gint         n_bands;
+  gboolean     can_combine = TRUE;
+  gint         i;
+
+  n_bands = (height + gimp_tile_height () - 1) / gimp_tile_height ();
+  bands   = g_new (CompareBand, n_bands);
+
+  for (i = 0; i < n_bands; i++)
+    {
+      bands[i].this_frame  = this_frame;
+      bands[i].last_frame  = last_frame;
+      bands[i].y1          = i * gimp_tile_height ();
+      bands[i].y2          = MIN ((i + 1) * gimp_tile_height (), height);
+      bands[i].find_opaque = find_opaque;
+
+      if (compare_pool)
+        g_thread_pool_push (compare_pool, &bands[i], NULL);
+      else
+        compare_band (&bands[i], NULL);
+    }
+
+  if (compare_pool)
+    {
+      for (i = 0; i < n_bands; i++)
+        g_async_queue_pop (compare_queue);
+    }
+
+  *left   = width;
+  *top    = height;
+  *right  = 0;
+  *bottom = 0;
+
+  for (i = 0; i < n_bands; i++)
+    {
+      can_combine = can_combine && bands[i].can_combine;
+
+      *left   = MIN (*left,   bands[i].left);
+      *top    = MIN (*top,    bands[i].top);
+      *right  = MAX (*right,  bands[i].right);
+      *bottom = MAX (*bottom, bands[i].bottom);
+    }
+
+  g_free (bands);
+
+  return can_combine;
+}
+
+
 static gint32
 do_optimizations (GimpRunMode run_mode,
                   gboolean    diff_only)
 {
   GimpPixelRgn   pixel_rgn;
   static guchar *rawframe = NULL;
-  guchar        *srcptr;
-  guchar        *destptr;
   gint           row, this_frame_num;
   guint32        frame_sizebytes;
+  guint32        opti_sizebytes = 0;
   gint32         new_layer_id;
   DisposeType    dispose;
   guchar        *this_frame = NULL;
   guchar        *last_frame = NULL;
   guchar        *opti_frame = NULL;
   guchar        *back_frame = NULL;
+  guchar        *layer_data;
+  gint           layer_rowstride;
 
   gint           this_delay;
   gint           cumulated_delay = 0;
@@ -418,7 +706,6 @@ do_optimizations (GimpRunMode run_mode,
   gboolean       can_combine;
 
   gint32         bbox_top, bbox_bottom, bbox_left, bbox_right;
-  gint32         rbox_top, rbox_bottom, rbox_left, rbox_right;
 
   switch (opmode)
     {
@@ -453,7 +740,6 @@ do_optimizations (GimpRunMode run_mode,
 
   this_frame = g_malloc (frame_sizebytes);
   last_frame = g_malloc (frame_sizebytes);
-  opti_frame = g_malloc (frame_sizebytes);
 
   if (opmode == OPBACKGROUND ||
       opmode == OPFOREGROUND)
@@ -462,6 +748,26 @@ do_optimizations (GimpRunMode run_mode,
   total_alpha (this_frame, width*height, pixelstep);
   total_alpha (last_frame, width*height, pixelstep);
 
+  /* consecutive frames are compared using as many threads as GIMP does */
+  if (opmode == OPOPTIMIZE)
+    {
+      gchar *num_processors = gimp_gimprc_query ("num-processors");
+      gint   n_threads      = 1;
+
+      if (num_processors)
+        {
+          n_threads = g_ascii_strtoll (num_processors, NULL, 10);
+          g_free (num_processors);
+        }
+
+      if (n_threads > 1)
+        {
+          compare_queue = g_async_queue_new ();
+          compare_pool  = g_thread_pool_new (compare_band, compare_queue,
+                                             n_threads, FALSE, NULL);
+        }
+    }
+
   new_image_id = gimp_image_new(width, height, imagetype);
   gimp_image_undo_disable (new_image_id);
 
@@ -662,6 +968,8 @@ do_optimizations (GimpRunMode run_mode,
     {
       for (this_frame_num=0; this_frame_num<total_frames; this_frame_num++)
         {
+          guchar *swap;
+
           /*
            * BUILD THIS FRAME into our 'this_frame' buffer.
            */
@@ -679,17 +987,7 @@ do_optimizations (GimpRunMode run_mode,
           this_delay = get_frame_duration (this_frame_num);
           dispose    = get_frame_disposal (this_frame_num);
 
-          for (row = 0; row < height; row++)
-            {
-              compose_row (this_frame_num,
-                           dispose,
-                           row,
-                           &this_frame[pixelstep*width * row],
-                           width,
-                           drawable,
-                           FALSE
-                           );
-            }
+          compose_frame (drawable, dispose, this_frame, last_frame);
 
           /* clean up */
           gimp_drawable_detach(drawable);
@@ -727,13 +1025,11 @@ do_optimizations (GimpRunMode run_mode,
           bbox_top    = 0;
           bbox_right  = width;
           bbox_bottom = height;
-          rbox_left   = 0;
-          rbox_top    = 0;
-          rbox_right  = width;
-          rbox_bottom = height;
 
-          /* copy 'this' frame into a buffer which we can safely molest */
-          memcpy (opti_frame, this_frame, frame_sizebytes);
+          /* the whole frame, unless it can be cropped below */
+          layer_data      = this_frame;
+          layer_rowstride = width * pixelstep;
+
           /*
            *
            * OPTIMIZE HERE!
@@ -746,118 +1042,71 @@ do_optimizations (GimpRunMode run_mode,
             {
               gint xit, yit, byteit;
 
-              can_combine = TRUE;
-
               /*
                * SEARCH FOR BOUNDING BOX
                */
-              bbox_left   = width;
-              bbox_top    = height;
-              bbox_right  = 0;
-              bbox_bottom = 0;
-              rbox_left   = width;
-              rbox_top    = height;
-              rbox_right  = 0;
-              rbox_bottom = 0;
+              can_combine = find_frame_bounds (this_frame, last_frame, FALSE,
+                                               &bbox_left, &bbox_top,
+                                               &bbox_right, &bbox_bottom);
 
-              for (yit=0; yit<height; yit++)
+              /*
+               * An opaque pixel became transparent this frame, so it
+               *  has to replace the last one, and we need everything
+               *  which is opaque in it.
+               */
+              if (!can_combine)
+                find_frame_bounds (this_frame, last_frame, TRUE,
+                                   &bbox_left, &bbox_top,
+                                   &bbox_right, &bbox_bottom);
+
+              /*
+               * Copy the bounding box out of the frame.
+               */
+              if (bbox_right > bbox_left && bbox_bottom > bbox_top)
                 {
-                  for (xit=0; xit<width; xit++)
+                  layer_rowstride = (bbox_right - bbox_left) * pixelstep;
+
+                  if (opti_sizebytes < layer_rowstride * (bbox_bottom - bbox_top))
                     {
-                      gboolean keep_pix;
-                      gboolean opaq_pix;
-
-                      /* Check if 'this' and 'last' are transparent */
-                      if (!(this_frame[yit*width*pixelstep + xit*pixelstep
-                                      + pixelstep-1]&128)
-                          &&
-                          !(last_frame[yit*width*pixelstep + xit*pixelstep
-                                      + pixelstep-1]&128))
-                        {
-                          keep_pix = FALSE;
-                          opaq_pix = FALSE;
-                          goto decided;
-                        }
-                      /* Check if just 'this' is transparent */
-                      if ((last_frame[yit*width*pixelstep + xit*pixelstep
-                                     + pixelstep-1]&128)
-                          &&
-                          !(this_frame[yit*width*pixelstep + xit*pixelstep
-                                      + pixelstep-1]&128))
-                        {
-                          keep_pix = TRUE;
-                          opaq_pix = FALSE;
-                          can_combine = FALSE;
-                          goto decided;
-                        }
-                      /* Check if just 'last' is transparent */
-                      if (!(last_frame[yit*width*pixelstep + xit*pixelstep
-                                      + pixelstep-1]&128)
-                          &&
-                          (this_frame[yit*width*pixelstep + xit*pixelstep
-                                     + pixelstep-1]&128))
-                        {
-                          keep_pix = TRUE;
-                          opaq_pix = TRUE;
-                          goto decided;
-                        }
-                      /* If 'last' and 'this' are opaque, we have
-                       *  to check if they're the same colour - we
-                       *  only have to keep the pixel if 'last' or
-                       *  'this' are opaque and different.
-                       */
-                      keep_pix = FALSE;
-                      opaq_pix = TRUE;
-                      for (byteit=0; byteit<pixelstep-1; byteit++)
+                      opti_sizebytes = layer_rowstride * (bbox_bottom - bbox_top);
+
+                      g_free (opti_frame);
+                      opti_frame = g_malloc (opti_sizebytes);
+                    }
+
+                  layer_data = opti_frame;
+
+                  for (yit=bbox_top; yit<bbox_bottom; yit++)
+                    {
+                      memcpy (&opti_frame[(yit-bbox_top)*layer_rowstride],
+                              &this_frame[yit*width*pixelstep +
+                                          bbox_left*pixelstep],
+                              layer_rowstride);
+                    }
+                }
+
+              if (can_combine && bbox_right > bbox_left)
+                {
+                  /* pixels which didn't change this frame - make
+                   *  them transparent in our optimized buffer!
+                   */
+                  for (yit=bbox_top; yit<bbox_bottom; yit++)
+                    {
+                      for (xit=bbox_left; xit<bbox_right; xit++)
                         {
-                          if ((last_frame[yit*width*pixelstep + xit*pixelstep
-                                         + byteit]
-                               !=
-                               this_frame[yit*width*pixelstep + xit*pixelstep
-                                         + byteit])
-                              )
+                          if (same_pixel (&this_frame[yit*width*pixelstep
+                                                      + xit*pixelstep],
+                                          &last_frame[yit*width*pixelstep
+                                                      + xit*pixelstep]))
                             {
-                              keep_pix = TRUE;
-                              goto decided;
+                              opti_frame[(yit-bbox_top)*layer_rowstride
+                                         + (xit-bbox_left)*pixelstep
+                                         + pixelstep-1] = 0;
                             }
                         }
-                    decided:
-                      if (opaq_pix)
-                        {
-                          if (xit<rbox_left) rbox_left=xit;
-                          if (xit>rbox_right) rbox_right=xit;
-                          if (yit<rbox_top) rbox_top=yit;
-                          if (yit>rbox_bottom) rbox_bottom=yit;
-                        }
-                      if (keep_pix)
-                        {
-                          if (xit<bbox_left) bbox_left=xit;
-                          if (xit>bbox_right) bbox_right=xit;
-                          if (yit<bbox_top) bbox_top=yit;
-                          if (yit>bbox_bottom) bbox_bottom=yit;
-                        }
-                      else
-                        {
-                          /* pixel didn't change this frame - make
-                           *  it transparent in our optimized buffer!
-                           */
-                          opti_frame[yit*width*pixelstep + xit*pixelstep
-                                    + pixelstep-1] = 0;
-                        }
-                    } /* xit */
-                } /* yit */
-
-              if (!can_combine)
-                {
-                  bbox_left = rbox_left;
-                  bbox_top = rbox_top;
-                  bbox_right = rbox_right;
-                  bbox_bottom = rbox_bottom;
+                    }
                 }
 
-              bbox_right++;
-              bbox_bottom++;
-
               if (can_combine && !diff_only)
                 {
                   /* Try to optimize the pixel data for RLE or LZW compression
@@ -872,24 +1121,23 @@ do_optimizations (GimpRunMode run_mode,
                    */
                   for (yit = bbox_top; yit < bbox_bottom; yit++)
                     {
+                      guchar *opti_row = &opti_frame[(yit-bbox_top)*layer_rowstride];
+
                       /* Compare with previous pixels from left to right */
                       for (xit = bbox_left + 1; xit < bbox_right; xit++)
                         {
-                          if (!(opti_frame[yit*width*pixelstep
-                                           + xit*pixelstep
+                          if (!(opti_row[(xit-bbox_left)*pixelstep
+                                         + pixelstep-1]&128)
+                              && (opti_row[(xit-bbox_left-1)*pixelstep
                                            + pixelstep-1]&128)
-                              && (opti_frame[yit*width*pixelstep
-                                             + (xit-1)*pixelstep
-                                             + pixelstep-1]&128)
                               && (last_frame[yit*width*pixelstep
                                              + xit*pixelstep
                                              + pixelstep-1]&128))
                             {
                               for (byteit=0; byteit<pixelstep-1; byteit++)
                                 {
-                                  if (opti_frame[yit*width*pixelstep
-                                                 + (xit-1)*pixelstep
-                                                 + byteit]
+                                  if (opti_row[(xit-bbox_left-1)*pixelstep
+                                               + byteit]
                                       !=
                                       last_frame[yit*width*pixelstep
                                                  + xit*pixelstep
@@ -901,9 +1149,8 @@ do_optimizations (GimpRunMode run_mode,
                               /* copy the color and alpha */
                               for (byteit=0; byteit<pixelstep; byteit++)
                                 {
-                                  opti_frame[yit*width*pixelstep
-                                             + xit*pixelstep
-                                             + byteit]
+                                  opti_row[(xit-bbox_left)*pixelstep
+                                           + byteit]
                                     = last_frame[yit*width*pixelstep
                                                  + xit*pixelstep
                                                  + byteit];
@@ -916,21 +1163,18 @@ do_optimizations (GimpRunMode run_mode,
                       /* Compare with next pixels from right to left */
                       for (xit = bbox_right - 2; xit >= bbox_left; xit--)
                         {
-                          if (!(opti_frame[yit*width*pixelstep
-                                           + xit*pixelstep
+                          if (!(opti_row[(xit-bbox_left)*pixelstep
+                                         + pixelstep-1]&128)
+                              && (opti_row[(xit-bbox_left+1)*pixelstep
                                            + pixelstep-1]&128)
-                              && (opti_frame[yit*width*pixelstep
-                                             + (xit+1)*pixelstep
-                                             + pixelstep-1]&128)
                               && (last_frame[yit*width*pixelstep
                                              + xit*pixelstep
                                              + pixelstep-1]&128))
                             {
                               for (byteit=0; byteit<pixelstep-1; byteit++)
                                 {
-                                  if (opti_frame[yit*width*pixelstep
-                                                 + (xit+1)*pixelstep
-                                                 + byteit]
+                                  if (opti_row[(xit-bbox_left+1)*pixelstep
+                                               + byteit]
                                       !=
                                       last_frame[yit*width*pixelstep
                                                  + xit*pixelstep
@@ -942,9 +1186,8 @@ do_optimizations (GimpRunMode run_mode,
                               /* copy the color and alpha */
                               for (byteit=0; byteit<pixelstep; byteit++)
                                 {
-                                  opti_frame[yit*width*pixelstep
-                                             + xit*pixelstep
-                                             + byteit]
+                                  opti_row[(xit-bbox_left)*pixelstep
+                                           + byteit]
                                     = last_frame[yit*width*pixelstep
                                                  + xit*pixelstep
                                                  + byteit];
@@ -955,46 +1198,16 @@ do_optimizations (GimpRunMode run_mode,
                         } /* xit */
                     } /* yit */
                 }
-
-              /*
-               * Collapse opti_frame data down such that the data
-               *  which occupies the bounding box sits at the start
-               *  of the data (for convenience with ..set_rect()).
-               */
-              destptr = opti_frame;
-              /*
-               * If can_combine, then it's safe to use our optimized
-               *  alpha information.  Otherwise, an opaque pixel became
-               *  transparent this frame, and we'll have to use the
-               *  actual true frame's alpha.
-               */
-              if (can_combine)
-                srcptr = opti_frame;
-              else
-                srcptr = this_frame;
-              for (yit=bbox_top; yit<bbox_bottom; yit++)
-                {
-                  for (xit=bbox_left; xit<bbox_right; xit++)
-                    {
-                      for (byteit=0; byteit<pixelstep; byteit++)
-                        {
-                          *(destptr++) = srcptr[yit*pixelstep*width +
-                                               pixelstep*xit + byteit];
-                        }
-                    }
-                }
             } /* !bot frame? */
-          else
-            {
-              memcpy (opti_frame, this_frame, frame_sizebytes);
-            }
 
           /*
            *
            * REMEMBER THE ANIMATION STATUS TO DELTA AGAINST NEXT TIME
            *
            */
-          memcpy (last_frame, this_frame, frame_sizebytes);
+          swap       = last_frame;
+          last_frame = this_frame;
+          this_frame = swap;
 
 
           /*
@@ -1076,7 +1289,7 @@ do_optimizations (GimpRunMode run_mode,
                                    bbox_right-bbox_left,
                                    bbox_bottom-bbox_top,
                                    TRUE, FALSE);
-              gimp_pixel_rgn_set_rect (&pixel_rgn, opti_frame, 0, 0,
+              gimp_pixel_rgn_set_rect (&pixel_rgn, layer_data, 0, 0,
                                        bbox_right-bbox_left,
                                        bbox_bottom-bbox_top);
               gimp_drawable_flush (drawable);
@@ -1090,6 +1303,15 @@ do_optimizations (GimpRunMode run_mode,
       gimp_progress_update (1.0);
     }
 
+  if (compare_pool)
+    {
+      g_thread_pool_free (compare_pool, FALSE, TRUE);
+      compare_pool = NULL;
+
+      g_async_queue_unref (compare_queue);
+      compare_queue = NULL;
+    }
+
   gimp_image_undo_enable (new_image_id);
 
   if (run_mode != GIMP_RUN_NONINTERACTIVE)
@@ -44,15 +44,6 @@
 #define PLUG_IN_ROLE   "gimp-file-gif-save"
 
 
-/* Define only one of these to determine which kind of gif's you would like.
- * GIF_UN means use uncompressed gifs.  These will be large, but no
- * patent problems.
- * GIF_RLE uses Run-length-encoding, which should not be covered by the
- * patent, but this is not legal advice.
- */
-/* #define GIF_UN */
-/* #define GIF_RLE */
-
 /* uncomment the line below for a little debugging info */
 /* #define GIFDEBUG yesplease */
 
@@ -85,6 +76,7 @@ typedef struct
   gboolean always_use_default_delay;
   gboolean always_use_default_dispose;
   gboolean as_animation;
+  gboolean difference_frames;
 } GIFSaveVals;
 
 
@@ -119,9 +111,6 @@ static GimpRunMode run_mode;
 static GimpParasite * comment_parasite = NULL;
 #endif
 
-/* For compression code */
-static gint Interlace;
-
 
 const GimpPlugInInfo PLUG_IN_INFO =
 {
@@ -140,7 +129,8 @@ static GIFSaveVals gsvals =
   0,       /* default_dispose = "don't care"       */
   FALSE,   /* don't always use default_delay       */
   FALSE,   /* don't always use default_dispose     */
-  FALSE    /* as_animation                         */
+  FALSE,   /* as_animation                         */
+  FALSE    /* don't difference frames              */
 };
 
 
@@ -349,23 +339,35 @@ static gchar * globalcomment = NULL;
 
 #define MAXCOLORS 256
 
-/*
- * Pointer to function returning an int
- */
-typedef int (*ifunptr) (int, int);
-
 /*
  * a code_int must be able to hold 2**BITS values of type int, and also -1
  */
 typedef int code_int;
 
-#ifdef SIGNED_COMPARE_SLOW
-typedef unsigned long int count_int;
-typedef unsigned short int count_short;
-#else /*SIGNED_COMPARE_SLOW */
-typedef long int count_int;
-#endif /*SIGNED_COMPARE_SLOW */
-
+/*
+ * The canvas an animation is shown on, to only encode the changes
+ * between frames.
+ */
+typedef struct
+{
+  gint      width;
+  gint      height;
+  gint16   *base;        /* the canvas before the pending frame,
+                          * -1 is transparent
+                          */
+  gint16   *cur;         /* the canvas with the pending frame */
+  gint16   *next;        /* scratch space for the frame after it */
+
+  /*  the frame waiting to be encoded, if any  */
+  gboolean  pending;
+  guchar   *pixels;      /* the layer as it would be encoded on its own */
+  gint      transparent;
+  gint      bpp;
+  gint      disposal;
+  gint      x, y;
+  gint      w, h;
+  gint      delay;
+} GIFDifference;
 
 
 static gint find_unused_ia_colour   (const guchar *pixels,
@@ -378,39 +380,48 @@ static void special_flatten_indexed_alpha (guchar *pixels,
                                            gint    numpixels);
 static int colors_to_bpp  (int);
 static int bpp_to_colors  (int);
-static int get_pixel      (int, int);
-static int gif_next_pixel (ifunptr);
-static void bump_pixel    (void);
+
+static GIFDifference * gif_difference_new    (gint           width,
+                                              gint           height);
+static void            gif_difference_add    (GIFDifference *difference,
+                                              FILE          *fp,
+                                              const guchar  *pixels,
+                                              gint           width,
+                                              gint           height,
+                                              gint           offset_x,
+                                              gint           offset_y,
+                                              gint           transparent,
+                                              gint           layer_bpp,
+                                              gint           disposal,
+                                              gint           delay,
+                                              gint           n_frames,
+                                              gint           bpp);
+static void            gif_difference_flush  (GIFDifference *difference,
+                                              FILE          *fp,
+                                              gboolean       clear_after,
+                                              gint           n_frames,
+                                              gint           bpp);
+static void            gif_difference_free   (GIFDifference *difference);
 
 static void gif_encode_header              (FILE *, gboolean, int, int, int, int,
-                                            int *, int *, int *, ifunptr);
+                                            int *, int *, int *);
 static void gif_encode_graphic_control_ext (FILE *, int, int, int, int,
-                                            int, int, int, ifunptr);
+                                            int, int, int);
 static void gif_encode_image_data          (FILE *, int, int, int, int,
-                                            ifunptr, gint, gint);
+                                            const guchar *, gint, gint, gint);
 static void gif_encode_close               (FILE *);
 static void gif_encode_loop_ext            (FILE *, guint);
 static void gif_encode_comment_ext         (FILE *, const gchar *comment);
 
-static gint     rowstride;
-static guchar  *pixels;
 static gint     cur_progress;
 static gint     max_progress;
 
-#ifdef GIF_UN
-static void no_compress     (int, FILE *, ifunptr);
-#else
-#ifdef GIF_RLE
-static void rle_compress    (int, FILE *, ifunptr);
-#else
-static void normal_compress (int, FILE *, ifunptr);
-#endif
-#endif
 static void put_word   (int, FILE *);
-static void compress   (int, FILE *, ifunptr);
+static void compress   (int, FILE *, const guchar *, gint, gint, gint, gint);
+static gint next_row   (gint, gint, gint, gint *);
 static void output     (code_int);
 static void cl_block   (void);
-static void cl_hash    (count_int);
+static void cl_table   (void);
 static void write_err  (void);
 static void char_init  (void);
 static void char_out   (int);
@@ -640,7 +651,9 @@ save_image (const gchar *filename,
   GimpPixelRgn pixel_rgn;
   GimpDrawable *drawable;
   GimpImageType drawable_type;
+  GIFDifference *difference = NULL;
   FILE *outfile;
+  guchar *pixels;
   gint Red[MAXCOLORS];
   gint Green[MAXCOLORS];
   gint Blue[MAXCOLORS];
@@ -813,9 +826,12 @@ save_image (const gchar *filename,
 
   cols = gimp_image_width (image_ID);
   rows = gimp_image_height (image_ID);
-  Interlace = gsvals.interlace;
   gif_encode_header (outfile, is_gif89, cols, rows, bgindex,
-                     BitsPerPixel, Red, Green, Blue, get_pixel);
+                     BitsPerPixel, Red, Green, Blue);
+
+  /* Encoding only what changes on the canvas needs GIF89a's disposal */
+  if (nlayers > 1 && gsvals.difference_frames)
+    difference = gif_difference_new (cols, rows);
 
 
   /* If the image has multiple layers it'll be made into an
@@ -843,7 +859,6 @@ save_image (const gchar *filename,
       gimp_drawable_offsets (layers[i], &offset_x, &offset_y);
       cols = drawable->width;
       rows = drawable->height;
-      rowstride = drawable->width;
 
       gimp_pixel_rgn_init (&pixel_rgn, drawable, 0, 0,
                            drawable->width, drawable->height, FALSE, FALSE);
@@ -935,18 +950,29 @@ save_image (const gchar *filename,
               Delay89 = 1;
             }
 
-          gif_encode_graphic_control_ext (outfile, Disposal, Delay89, nlayers,
-                                          cols, rows,
-                                          transparent,
-                                          useBPP,
-                                          get_pixel);
+          if (! difference)
+            gif_encode_graphic_control_ext (outfile, Disposal, Delay89,
+                                            nlayers,
+                                            cols, rows,
+                                            transparent,
+                                            useBPP);
+        }
+
+      if (difference)
+        {
+          gif_difference_add (difference, outfile, pixels, cols, rows,
+                              offset_x, offset_y, transparent, useBPP,
+                              Disposal, Delay89, nlayers, liberalBPP);
+        }
+      else
+        {
+          gif_encode_image_data (outfile, cols, rows,
+                                 (rows > 4) ? gsvals.interlace : 0,
+                                 useBPP,
+                                 pixels, cols,
+                                 offset_x, offset_y);
         }
 
-      gif_encode_image_data (outfile, cols, rows,
-                             (rows > 4) ? gsvals.interlace : 0,
-                             useBPP,
-                             get_pixel,
-                             offset_x, offset_y);
       gimp_progress_update (1.0);
 
       gimp_drawable_detach (drawable);
@@ -956,6 +982,16 @@ save_image (const gchar *filename,
 
   g_free(layers);
 
+  if (difference)
+    {
+      /* The last frame's own disposal decides whether the canvas is
+         cleared before the animation loops. */
+      gif_difference_flush (difference, outfile,
+                            difference->disposal == DISPOSE_REPLACE,
+                            nlayers, liberalBPP);
+      gif_difference_free (difference);
+    }
+
   gif_encode_close (outfile);
 
   return TRUE;
@@ -1200,6 +1236,10 @@ save_dialog (gint32 image_ID)
                                gsvals.always_use_default_dispose,
                                &gsvals.always_use_default_dispose);
 
+  file_gif_toggle_button_init (builder, "difference-frames",
+                               gsvals.difference_frames,
+                               &gsvals.difference_frames);
+
   frame  = GTK_WIDGET (gtk_builder_get_object (builder, "animation-frame"));
   toggle = GTK_WIDGET (gtk_builder_get_object (builder, "as-animation"));
   gtk_widget_set_sensitive (toggle, animation_supported);
@@ -1274,115 +1314,286 @@ bpp_to_colors (int bpp)
 
 
 
-static int
-get_pixel (int x,
-           int y)
+/*
+ * Frame differencing
+ *
+ * The canvas a viewer shows after each frame is tracked, and each
+ * frame is encoded as the smallest rectangle of the canvas it changes,
+ * with the unchanged pixels in it left transparent, and kept for the
+ * next one to draw on.  A frame is held back until the next one is
+ * known: if that one makes pixels transparent again, only the layer's
+ * own disposal can do that, so the frame is encoded as the layer
+ * itself, exactly like without differencing.  The same happens if the
+ * rectangle has pixels to leave transparent but no free index.
+ *
+ * Both keep the canvas exactly as the layers without differencing
+ * would leave it: a differenced frame only ever turns pixels opaque,
+ * so whenever the layer itself is encoded, the canvas below its
+ * transparent pixels is the same as without differencing.
+ */
+
+static GIFDifference *
+gif_difference_new (gint width,
+                    gint height)
 {
-  return *(pixels + (rowstride * (long) y) + (long) x);
-}
+  GIFDifference *difference = g_slice_new0 (GIFDifference);
+  gint           i;
 
+  difference->width  = width;
+  difference->height = height;
+  difference->base   = g_new (gint16, width * height);
+  difference->cur    = g_new (gint16, width * height);
+  difference->next   = g_new (gint16, width * height);
 
-/*****************************************************************************
- *
- * GIFENCODE.C    - GIF Image compression interface
- *
- * GIFEncode( FName, GHeight, GWidth, GInterlace, Background, Transparent,
- *            BitsPerPixel, Red, Green, Blue, get_pixel )
- *
- *****************************************************************************/
+  for (i = 0; i < width * height; i++)
+    difference->base[i] = difference->cur[i] = -1;
 
-static gint  Width, Height;
-static gint  curx, cury;
-static glong CountDown;
-static gint  Pass = 0;
+  return difference;
+}
+
+static void
+gif_difference_free (GIFDifference *difference)
+{
+  g_free (difference->base);
+  g_free (difference->cur);
+  g_free (difference->next);
+  g_free (difference->pixels);
+
+  g_slice_free (GIFDifference, difference);
+}
 
 /*
- * Bump the 'curx' and 'cury' to point to the next pixel
+ * Adds a layer's frame, as it would be encoded on its own, and
+ * encodes the previous frame.
  */
 static void
-bump_pixel (void)
+gif_difference_add (GIFDifference *difference,
+                    FILE          *fp,
+                    const guchar  *pixels,
+                    gint           width,
+                    gint           height,
+                    gint           offset_x,
+                    gint           offset_y,
+                    gint           transparent,
+                    gint           layer_bpp,
+                    gint           disposal,
+                    gint           delay,
+                    gint           n_frames,
+                    gint           bpp)
 {
-  /*
-   * Bump the current X position
-   */
-  curx++;
+  gint16   *next = difference->next;
+  gint      stride = difference->width;
+  gboolean  clear_after = FALSE;
+  gint      x, y;
 
-  /*
-   * If we are at the end of a scan line, set curx back to the beginning
-   * If we are interlaced, bump the cury to the appropriate spot,
-   * otherwise, just increment it.
-   */
-  if (curx == Width)
-    {
-      cur_progress++;
+  memcpy (next, difference->cur, sizeof (gint16) * stride * difference->height);
 
-      if ((cur_progress % 20) == 0)
-        gimp_progress_update ((gdouble) cur_progress / (gdouble) max_progress);
+  /* what the previous layer's disposal leaves of the canvas */
+  if (difference->pending && difference->disposal == DISPOSE_REPLACE)
+    {
+      for (y = difference->y; y < difference->y + difference->h; y++)
+        for (x = difference->x; x < difference->x + difference->w; x++)
+          next[y * stride + x] = -1;
+    }
 
-      curx = 0;
+  for (y = 0; y < height; y++)
+    {
+      const guchar *src  = pixels + y * width;
+      gint16       *dest = next + (offset_y + y) * stride + offset_x;
 
-      if (! Interlace)
-        ++cury;
-      else
+      for (x = 0; x < width; x++)
         {
-          switch (Pass)
-            {
-
-            case 0:
-              cury += 8;
-              if (cury >= Height)
-                {
-                  Pass++;
-                  cury = 4;
-                }
-              break;
-
-            case 1:
-              cury += 8;
-              if (cury >= Height)
-                {
-                  Pass++;
-                  cury = 2;
-                }
-              break;
+          if (src[x] != transparent)
+            dest[x] = src[x];
+        }
+    }
 
-            case 2:
-              cury += 4;
-              if (cury >= Height)
-                {
-                  Pass++;
-                  cury = 1;
-                }
-              break;
+  if (difference->pending)
+    {
+      const gint16 *cur = difference->cur;
+      gint          i;
 
-            case 3:
-              cury += 2;
+      for (i = 0; i < stride * difference->height; i++)
+        {
+          if (cur[i] >= 0 && next[i] < 0)
+            {
+              clear_after = TRUE;
               break;
             }
         }
+
+      gif_difference_flush (difference, fp, clear_after, n_frames, bpp);
     }
+
+  difference->next = difference->cur;
+  difference->cur  = next;
+
+  g_free (difference->pixels);
+
+  difference->pending     = TRUE;
+  difference->pixels      = g_memdup (pixels, width * height);
+  difference->transparent = transparent;
+  difference->bpp         = layer_bpp;
+  difference->disposal    = disposal;
+  difference->x           = offset_x;
+  difference->y           = offset_y;
+  difference->w           = width;
+  difference->h           = height;
+  difference->delay       = delay;
 }
 
 /*
- * Return the next pixel from the image
+ * Encodes the pending frame.  If @clear_after, the frame after it makes
+ * pixels transparent again, and the frame is encoded as the layer
+ * itself.
  */
-static int
-gif_next_pixel (ifunptr getpixel)
+static void
+gif_difference_flush (GIFDifference *difference,
+                      FILE          *fp,
+                      gboolean       clear_after,
+                      gint           n_frames,
+                      gint           bpp)
 {
-  int r;
+  gint16       *base   = difference->base;
+  const gint16 *cur    = difference->cur;
+  gint          stride = difference->width;
+  gint          x1, y1, x2, y2;
+  gint          transparent = -1;
+  gboolean      used[256]   = { FALSE, };
+  gboolean      as_layer    = clear_after;
+  guchar       *pixels;
+  gint          x, y, i;
+
+  if (! as_layer)
+    {
+      x1 = difference->width;
+      y1 = difference->height;
+      x2 = 0;
+      y2 = 0;
 
-  if (CountDown == 0)
-    return EOF;
+      for (y = 0; y < difference->height; y++)
+        for (x = 0; x < difference->width; x++)
+          {
+            if (cur[y * stride + x] != base[y * stride + x])
+              {
+                x1 = MIN (x1, x);
+                y1 = MIN (y1, y);
+                x2 = MAX (x2, x + 1);
+                y2 = MAX (y2, y + 1);
+              }
+          }
+
+      /* nothing changed, but the frame's delay still counts */
+      if (x1 >= x2)
+        {
+          x1 = y1 = 0;
+          x2 = y2 = 1;
+        }
 
-  --CountDown;
+      for (y = y1; y < y2; y++)
+        for (x = x1; x < x2; x++)
+          {
+            if (cur[y * stride + x] >= 0)
+              used[cur[y * stride + x]] = TRUE;
+          }
 
-  r = (*getpixel) (curx, cury);
+      for (i = (1 << bpp) - 1; i >= 0; i--)
+        {
+          if (! used[i])
+            {
+              transparent = i;
+              break;
+            }
+        }
 
-  bump_pixel ();
+      /* A canvas pixel is only transparent if it was before, so
+         without a free index, unchanged pixels keep their values, and
+         only pixels which stay transparent can't be encoded. */
+      if (transparent < 0)
+        {
+          for (y = y1; y < y2 && ! as_layer; y++)
+            for (x = x1; x < x2; x++)
+              {
+                if (cur[y * stride + x] < 0)
+                  {
+                    as_layer = TRUE;
+                    break;
+                  }
+              }
+        }
+    }
 
-  return r;
+  if (as_layer)
+    {
+      gif_encode_graphic_control_ext (fp, difference->disposal,
+                                      difference->delay, n_frames,
+                                      difference->w, difference->h,
+                                      difference->transparent,
+                                      difference->bpp);
+
+      gif_encode_image_data (fp, difference->w, difference->h,
+                             (difference->h > 4) ? gsvals.interlace : 0,
+                             difference->bpp,
+                             difference->pixels, difference->w,
+                             difference->x, difference->y);
+
+      /* what the viewer shows after the layer's own disposal */
+      memcpy (base, cur, sizeof (gint16) * stride * difference->height);
+
+      if (difference->disposal == DISPOSE_REPLACE)
+        {
+          for (y = difference->y; y < difference->y + difference->h; y++)
+            for (x = difference->x; x < difference->x + difference->w; x++)
+              base[y * stride + x] = -1;
+        }
+
+      difference->pending = FALSE;
+
+      return;
+    }
+
+  pixels = g_new (guchar, (x2 - x1) * (y2 - y1));
+
+  for (y = y1, i = 0; y < y2; y++)
+    for (x = x1; x < x2; x++, i++)
+      {
+        gint value = cur[y * stride + x];
+
+        if (transparent >= 0 && value == base[y * stride + x])
+          pixels[i] = transparent;
+        else
+          pixels[i] = value;
+      }
+
+  gif_encode_graphic_control_ext (fp, DISPOSE_COMBINE,
+                                  difference->delay, n_frames,
+                                  x2 - x1, y2 - y1,
+                                  transparent,
+                                  bpp);
+
+  gif_encode_image_data (fp, x2 - x1, y2 - y1,
+                         (y2 - y1 > 4) ? gsvals.interlace : 0,
+                         bpp,
+                         pixels, x2 - x1,
+                         x1, y1);
+
+  g_free (pixels);
+
+  memcpy (base, cur, sizeof (gint16) * stride * difference->height);
+
+  difference->pending = FALSE;
 }
 
+
+/*****************************************************************************
+ *
+ * GIFENCODE.C    - GIF Image compression interface
+ *
+ * GIFEncode( FName, GHeight, GWidth, GInterlace, Background, Transparent,
+ *            BitsPerPixel, Red, Green, Blue, pixels )
+ *
+ *****************************************************************************/
+
 /* public */
 
 static void
@@ -1394,8 +1605,7 @@ gif_encode_header (FILE     *fp,
                    int       BitsPerPixel,
                    int       Red[],
                    int       Green[],
-                   int       Blue[],
-                   ifunptr   get_pixel)
+                   int       Blue[])
 {
   int B;
   int RWidth, RHeight;
@@ -1405,26 +1615,11 @@ gif_encode_header (FILE     *fp,
 
   ColorMapSize = 1 << BitsPerPixel;
 
-  RWidth = Width = GWidth;
-  RHeight = Height = GHeight;
+  RWidth = GWidth;
+  RHeight = GHeight;
 
   Resolution = BitsPerPixel;
 
-  /*
-   * Calculate number of bits we are expecting
-   */
-  CountDown = (long) Width *(long) Height;
-
-  /*
-   * Indicate which pass we are on (if interlace)
-   */
-  Pass = 0;
-
-  /*
-   * Set up the current x and y position
-   */
-  curx = cury = 0;
-
   /*
    * Write the Magic header
    */
@@ -1486,27 +1681,8 @@ gif_encode_graphic_control_ext (FILE    *fp,
                                 int      GWidth,
                                 int      GHeight,
                                 int      Transparent,
-                                int      BitsPerPixel,
-                                ifunptr  get_pixel)
+                                int      BitsPerPixel)
 {
-  Width = GWidth;
-  Height = GHeight;
-
-  /*
-   * Calculate number of bits we are expecting
-   */
-  CountDown = (long) Width *(long) Height;
-
-  /*
-   * Indicate which pass we are on (if interlace)
-   */
-  Pass = 0;
-
-  /*
-   * Set up the current x and y position
-   */
-  curx = cury = 0;
-
   /*
    * Write out extension for transparent colour index, if necessary.
    */
@@ -1541,35 +1717,22 @@ gif_encode_graphic_control_ext (FILE    *fp,
 
 
 static void
-gif_encode_image_data (FILE    *fp,
-                       int      GWidth,
-                       int      GHeight,
-                       int      GInterlace,
-                       int      BitsPerPixel,
-                       ifunptr  get_pixel,
-                       gint     offset_x,
-                       gint     offset_y)
+gif_encode_image_data (FILE         *fp,
+                       int           GWidth,
+                       int           GHeight,
+                       int           GInterlace,
+                       int           BitsPerPixel,
+                       const guchar *pixels,
+                       gint          rowstride,
+                       gint          offset_x,
+                       gint          offset_y)
 {
   int LeftOfs, TopOfs;
   int InitCodeSize;
 
-  Interlace = GInterlace;
-
-  Width = GWidth;
-  Height = GHeight;
   LeftOfs = (int) offset_x;
   TopOfs = (int) offset_y;
 
-  /*
-   * Calculate number of bits we are expecting
-   */
-  CountDown = (long) Width * (long) Height;
-
-  /*
-   * Indicate which pass we are on (if interlace)
-   */
-  Pass = 0;
-
   /*
    * The initial code size
    */
@@ -1578,11 +1741,6 @@ gif_encode_image_data (FILE    *fp,
   else
     InitCodeSize = BitsPerPixel;
 
-  /*
-   * Set up the current x and y position
-   */
-  curx = cury = 0;
-
   /*
    * Write an Image separator
    */
@@ -1594,13 +1752,13 @@ gif_encode_image_data (FILE    *fp,
 
   put_word (LeftOfs, fp);
   put_word (TopOfs, fp);
-  put_word (Width, fp);
-  put_word (Height, fp);
+  put_word (GWidth, fp);
+  put_word (GHeight, fp);
 
   /*
    * Write out whether or not the image is interlaced
    */
-  if (Interlace)
+  if (GInterlace)
     fputc (0x40, fp);
   else
     fputc (0x00, fp);
@@ -1613,34 +1771,13 @@ gif_encode_image_data (FILE    *fp,
   /*
    * Go and actually compress the data
    */
-  compress (InitCodeSize + 1, fp, get_pixel);
+  compress (InitCodeSize + 1, fp, pixels, rowstride,
+            GWidth, GHeight, GInterlace);
 
   /*
    * Write out a Zero-length packet (to end the series)
    */
   fputc (0, fp);
-
-#if 0
-  /***************************/
-  Interlace = GInterlace;
-  Width = GWidth;
-  Height = GHeight;
-  LeftOfs = TopOfs = 0;
-
-  CountDown = (long) Width *(long) Height;
-  Pass = 0;
-  /*
-   * The initial code size
-   */
-  if (BitsPerPixel <= 1)
-    InitCodeSize = 2;
-  else
-    InitCodeSize = BitsPerPixel;
-  /*
-   * Set up the current x and y position
-   */
-  curx = cury = 0;
-#endif
 }
 
 
@@ -1726,14 +1863,6 @@ put_word (int   w,
 
 #define GIF_BITS    12
 
-#define HSIZE  5003                /* 80% occupancy */
-
-#ifdef NO_UCHAR
-typedef char char_type;
-#else /*NO_UCHAR */
-typedef unsigned char char_type;
-#endif /*NO_UCHAR */
-
 /*
 
  * GIF Image compression - modified 'compress'
@@ -1753,21 +1882,17 @@ static int n_bits;                /* number of bits/code */
 static int maxbits = GIF_BITS;        /* user settable max # bits/code */
 static code_int maxcode;        /* maximum code, given n_bits */
 static code_int maxmaxcode = (code_int) 1 << GIF_BITS;        /* should NEVER generate this code */
-#ifdef COMPATIBLE                /* But wrong! */
-#define MAXCODE(Mn_bits)        ((code_int) 1 << (Mn_bits) - 1)
-#else /*COMPATIBLE */
 #define MAXCODE(Mn_bits)        (((code_int) 1 << (Mn_bits)) - 1)
-#endif /*COMPATIBLE */
-
-static count_int htab[HSIZE];
-static unsigned short codetab[HSIZE];
-#define HashTabOf(i)       htab[i]
-#define CodeTabOf(i)    codetab[i]
 
-static const code_int hsize = HSIZE; /* the original reason for this being
-                                        variable was "for dynamic table sizing",
-                                        but since it was never actually changed
-                                        I made it const   --Adam. */
+/*
+ * The string table is a plain array instead of a hash: the code for
+ * string 'ent' followed by pixel 'c' lives at child[ent * ClearCode + c],
+ * 0 meaning there is none yet, since no string is ever given one of the
+ * codes below ClearCode + 2.  slot[] remembers where each code was
+ * stored, so clearing the table only has to visit the codes in use.
+ */
+static guint16 child[(1 << GIF_BITS) * MAXCOLORS];
+static guint32 slot[1 << GIF_BITS];
 
 static code_int free_ent = 0;        /* first unused entry */
 
@@ -1777,24 +1902,14 @@ static code_int free_ent = 0;        /* first unused entry */
  */
 static int clear_flg = 0;
 
-static int offset;
-static long int in_count = 1;        /* length of input */
-static long int out_count = 0;        /* # of codes output (for debugging) */
-
 /*
- * compress stdin to stdout
+ * compress the pixels to the GIF file
  *
- * Algorithm:  use open addressing double hashing (no chaining) on the
- * prefix code / next character combination.  We do a variant of Knuth's
- * algorithm D (vol. 3, sec. 6.4) along with G. Knott's relatively-prime
- * secondary probe.  Here, the modular division first probe is gives way
- * to a faster exclusive-or manipulation.  Also do block compression with
- * an adaptive reset, whereby the code table is cleared when the compression
- * ratio decreases, but after the table fills.  The variable-length output
- * codes are re-sized at this point, and a special CLEAR code is generated
- * for the decompressor.  Late addition:  construct the table according to
- * file size for noticeable speed improvement on small files.  Please direct
- * questions about this implementation to ames!jaw.
+ * Algorithm:  the longest string in the table which the input continues
+ * with is extended by one pixel at a time, looking the extension up in
+ * the child table.  When the table fills, a CLEAR code is emitted and it
+ * starts over; the variable-length output codes are re-sized at that
+ * point.
  */
 
 static int g_init_bits;
@@ -1816,34 +1931,17 @@ static unsigned long masks[] =
 
 
 static void
-compress (int      init_bits,
-          FILE    *outfile,
-          ifunptr  ReadValue)
-{
-#ifdef GIF_UN
-        no_compress(init_bits, outfile, ReadValue);
-#else
-#ifdef GIF_RLE
-        rle_compress(init_bits, outfile, ReadValue);
-#else
-        normal_compress(init_bits, outfile, ReadValue);
-#endif
-#endif
-}
-
-#ifdef GIF_UN
-static void
-no_compress (int      init_bits,
-             FILE    *outfile,
-             ifunptr  ReadValue)
+compress (int           init_bits,
+          FILE         *outfile,
+          const guchar *pixels,
+          gint          rowstride,
+          gint          width,
+          gint          height,
+          gint          interlace)
 {
-  register long fcode;
-  register code_int i /* = 0 */ ;
-  register int c;
-  register code_int ent;
-  register code_int hsize_reg;
-  register int hshift;
-
+  code_int ent = -1;
+  gint     pass = 0;
+  gint     y;
 
   /*
    * Set up the globals:  g_init_bits - initial number of bits
@@ -1858,321 +1956,104 @@ no_compress (int      init_bits,
   /*
    * Set up the necessary values
    */
-  offset = 0;
-  out_count = 0;
   clear_flg = 0;
-  in_count = 1;
 
   ClearCode = (1 << (init_bits - 1));
   EOFCode = ClearCode + 1;
   free_ent = ClearCode + 2;
 
-
-  /* Had some problems here... should be okay now.  --Adam */
   n_bits = g_init_bits;
   maxcode = MAXCODE (n_bits);
 
-
-
   char_init ();
 
-  ent = gif_next_pixel (ReadValue);
-
-  hshift = 0;
-  for (fcode = (long) hsize; fcode < 65536L; fcode *= 2L)
-    ++hshift;
-  hshift = 8 - hshift;                /* set hash code range bound */
-
-  hsize_reg = hsize;
-  cl_hash ((count_int) hsize_reg);        /* clear hash table */
-
   output ((code_int) ClearCode);
 
-
-#ifdef SIGNED_COMPARE_SLOW
-  while ((c = gif_next_pixel (ReadValue)) != (unsigned) EOF)
+  for (y = 0;
+       y < height;
+       y = next_row (y, height, interlace, &pass))
     {
-#else /*SIGNED_COMPARE_SLOW */
-  while ((c = gif_next_pixel (ReadValue)) != EOF)
-    {                                /* } */
-#endif /*SIGNED_COMPARE_SLOW */
-
-      ++in_count;
+      const guchar *row = pixels + y * rowstride;
+      gint          x;
 
-      fcode = (long) (((long) c << maxbits) + ent);
-      i = (((code_int) c << hshift) ^ ent);        /* xor hashing */
-
-      output ((code_int) ent);
-      ++out_count;
-      ent = c;
-#ifdef SIGNED_COMPARE_SLOW
-      if ((unsigned) free_ent < (unsigned) maxmaxcode)
+      for (x = 0; x < width; x++)
         {
-#else /*SIGNED_COMPARE_SLOW */
-      if (free_ent < maxmaxcode)
-        {                        /* } */
-#endif /*SIGNED_COMPARE_SLOW */
-          CodeTabOf (i) = free_ent++;        /* code -> hashtable */
-          HashTabOf (i) = fcode;
-        }
-      else
-        cl_block ();
-    }
-
-  /*
-   * Put out the final code.
-   */
-  output ((code_int) ent);
-  ++out_count;
-  output ((code_int) EOFCode);
-}
-#else
-#ifdef GIF_RLE
-
-static void
-rle_compress (int      init_bits,
-              FILE    *outfile,
-              ifunptr  ReadValue)
-{
-  register long fcode;
-  register code_int i /* = 0 */ ;
-  register int c, last;
-  register code_int ent;
-  register code_int disp;
-  register code_int hsize_reg;
-  register int hshift;
-
-
-  /*
-   * Set up the globals:  g_init_bits - initial number of bits
-   *                      g_outfile   - pointer to output file
-   */
-  g_init_bits = init_bits;
-  g_outfile = outfile;
+          code_int c = row[x];
+          guint32  i;
 
-  cur_bits = 0;
-  cur_accum = 0;
-
-  /*
-   * Set up the necessary values
-   */
-  offset = 0;
-  out_count = 0;
-  clear_flg = 0;
-  in_count = 1;
-
-  ClearCode = (1 << (init_bits - 1));
-  EOFCode = ClearCode + 1;
-  free_ent = ClearCode + 2;
-
-
-  /* Had some problems here... should be okay now.  --Adam */
-  n_bits = g_init_bits;
-  maxcode = MAXCODE (n_bits);
-
-
-
-  char_init ();
-
-  last = ent = gif_next_pixel (ReadValue);
-
-  hshift = 0;
-  for (fcode = (long) hsize; fcode < 65536L; fcode *= 2L)
-    ++hshift;
-  hshift = 8 - hshift;                /* set hash code range bound */
-
-  hsize_reg = hsize;
-  cl_hash ((count_int) hsize_reg);        /* clear hash table */
-
-  output ((code_int) ClearCode);
+          if (ent < 0)
+            {
+              ent = c;
+              continue;
+            }
 
+          i = (guint32) ent * ClearCode + c;
 
+          if (child[i])
+            {
+              ent = child[i];
+              continue;
+            }
 
-#ifdef SIGNED_COMPARE_SLOW
-  while ((c = gif_next_pixel (ReadValue)) != (unsigned) EOF)
-    {
-#else /*SIGNED_COMPARE_SLOW */
-  while ((c = gif_next_pixel (ReadValue)) != EOF)
-    {                                /* } */
-#endif /*SIGNED_COMPARE_SLOW */
+          output (ent);
 
-      ++in_count;
+          if (free_ent < maxmaxcode)
+            {
+              child[i] = free_ent;
+              slot[free_ent++] = i;
+            }
+          else
+            {
+              cl_block ();
+            }
 
-      fcode = (long) (((long) c << maxbits) + ent);
-      i = (((code_int) c << hshift) ^ ent);        /* xor hashing */
+          ent = c;
+        }
 
+      cur_progress++;
 
-      if (last == c) {
-        if (HashTabOf (i) == fcode)
-          {
-            ent = CodeTabOf (i);
-            continue;
-          }
-        else if ((long) HashTabOf (i) < 0)        /* empty slot */
-          goto nomatch;
-        disp = hsize_reg - i;        /* secondary hash (after G. Knott) */
-        if (i == 0)
-          disp = 1;
-      probe:
-        if ((i -= disp) < 0)
-          i += hsize_reg;
-
-        if (HashTabOf (i) == fcode)
-          {
-            ent = CodeTabOf (i);
-            continue;
-          }
-        if ((long) HashTabOf (i) > 0)
-          goto probe;
-        }
-    nomatch:
-      output ((code_int) ent);
-      ++out_count;
-      last = ent = c;
-#ifdef SIGNED_COMPARE_SLOW
-      if ((unsigned) free_ent < (unsigned) maxmaxcode)
-        {
-#else /*SIGNED_COMPARE_SLOW */
-      if (free_ent < maxmaxcode)
-        {                        /* } */
-#endif /*SIGNED_COMPARE_SLOW */
-          CodeTabOf (i) = free_ent++;        /* code -> hashtable */
-          HashTabOf (i) = fcode;
-        }
-      else
-        cl_block ();
+      if ((cur_progress % 20) == 0)
+        gimp_progress_update ((gdouble) cur_progress /
+                              (gdouble) max_progress);
     }
 
   /*
    * Put out the final code.
    */
-  output ((code_int) ent);
-  ++out_count;
+  if (ent >= 0)
+    output (ent);
+
   output ((code_int) EOFCode);
-}
 
-#else
+  cl_table ();
+}
 
-static void
-normal_compress (int      init_bits,
-                 FILE    *outfile,
-                 ifunptr  ReadValue)
+/*
+ * Return the row following @y, going through the four passes of an
+ * interlaced image, or @height when there is none left.
+ */
+static gint
+next_row (gint  y,
+          gint  height,
+          gint  interlace,
+          gint *pass)
 {
-  register long fcode;
-  register code_int i /* = 0 */ ;
-  register int c;
-  register code_int ent;
-  register code_int disp;
-  register code_int hsize_reg;
-  register int hshift;
+  static const gint starts[] = { 0, 4, 2, 1 };
+  static const gint steps[]  = { 8, 8, 4, 2 };
 
+  if (! interlace)
+    return y + 1;
 
-  /*
-   * Set up the globals:  g_init_bits - initial number of bits
-   *                      g_outfile   - pointer to output file
-   */
-  g_init_bits = init_bits;
-  g_outfile = outfile;
+  y += steps[*pass];
 
-  cur_bits = 0;
-  cur_accum = 0;
-
-  /*
-   * Set up the necessary values
-   */
-  offset = 0;
-  out_count = 0;
-  clear_flg = 0;
-  in_count = 1;
-
-  ClearCode = (1 << (init_bits - 1));
-  EOFCode = ClearCode + 1;
-  free_ent = ClearCode + 2;
-
-
-  /* Had some problems here... should be okay now.  --Adam */
-  n_bits = g_init_bits;
-  maxcode = MAXCODE (n_bits);
-
-
-
-  char_init ();
-
-  ent = gif_next_pixel (ReadValue);
-
-  hshift = 0;
-  for (fcode = (long) hsize; fcode < 65536L; fcode *= 2L)
-    ++hshift;
-  hshift = 8 - hshift;                /* set hash code range bound */
-
-  hsize_reg = hsize;
-  cl_hash ((count_int) hsize_reg);        /* clear hash table */
-
-  output ((code_int) ClearCode);
-
-
-
-#ifdef SIGNED_COMPARE_SLOW
-  while ((c = gif_next_pixel (ReadValue)) != (unsigned) EOF)
+  while (y >= height && *pass < 3)
     {
-#else /*SIGNED_COMPARE_SLOW */
-  while ((c = gif_next_pixel (ReadValue)) != EOF)
-    {                                /* } */
-#endif /*SIGNED_COMPARE_SLOW */
-
-      ++in_count;
-
-      fcode = (long) (((long) c << maxbits) + ent);
-      i = (((code_int) c << hshift) ^ ent);        /* xor hashing */
-
-      if (HashTabOf (i) == fcode)
-        {
-          ent = CodeTabOf (i);
-          continue;
-        }
-      else if ((long) HashTabOf (i) < 0)        /* empty slot */
-        goto nomatch;
-      disp = hsize_reg - i;        /* secondary hash (after G. Knott) */
-      if (i == 0)
-        disp = 1;
-    probe:
-      if ((i -= disp) < 0)
-        i += hsize_reg;
-
-      if (HashTabOf (i) == fcode)
-        {
-          ent = CodeTabOf (i);
-          continue;
-        }
-      if ((long) HashTabOf (i) > 0)
-        goto probe;
-    nomatch:
-      output ((code_int) ent);
-      ++out_count;
-      ent = c;
-#ifdef SIGNED_COMPARE_SLOW
-      if ((unsigned) free_ent < (unsigned) maxmaxcode)
-        {
-#else /*SIGNED_COMPARE_SLOW */
-      if (free_ent < maxmaxcode)
-        {                        /* } */
-#endif /*SIGNED_COMPARE_SLOW */
-          CodeTabOf (i) = free_ent++;        /* code -> hashtable */
-          HashTabOf (i) = fcode;
-        }
-      else
-        cl_block ();
+      (*pass)++;
+      y = starts[*pass];
     }
 
-  /*
-   * Put out the final code.
-   */
-  output ((code_int) ent);
-  ++out_count;
-  output ((code_int) EOFCode);
+  return MIN (y, height);
 }
-#endif
-#endif
 
 
 
@@ -2258,12 +2139,12 @@ output (code_int code)
 }
 
 /*
- * Clear out the hash table
+ * Clear out the string table
  */
 static void
 cl_block (void)                        /* table clear for block compress */
 {
-  cl_hash ((count_int) hsize);
+  cl_table ();
   free_ent = ClearCode + 2;
   clear_flg = 1;
 
@@ -2271,39 +2152,12 @@ cl_block (void)                        /* table clear for block compress */
 }
 
 static void
-cl_hash (count_int hsize)        /* reset code table */
+cl_table (void)                        /* reset code table */
 {
+  code_int code;
 
-  register count_int *htab_p = htab + hsize;
-
-  register long i;
-  register long m1 = -1;
-
-  i = hsize - 16;
-  do
-    {                                /* might use Sys V memset(3) here */
-      *(htab_p - 16) = m1;
-      *(htab_p - 15) = m1;
-      *(htab_p - 14) = m1;
-      *(htab_p - 13) = m1;
-      *(htab_p - 12) = m1;
-      *(htab_p - 11) = m1;
-      *(htab_p - 10) = m1;
-      *(htab_p - 9) = m1;
-      *(htab_p - 8) = m1;
-      *(htab_p - 7) = m1;
-      *(htab_p - 6) = m1;
-      *(htab_p - 5) = m1;
-      *(htab_p - 4) = m1;
-      *(htab_p - 3) = m1;
-      *(htab_p - 2) = m1;
-      *(htab_p - 1) = m1;
-      htab_p -= 16;
-    }
-  while ((i -= 16) >= 0);
-
-  for (i += 16; i > 0; --i)
-    *--htab_p = m1;
+  for (code = ClearCode + 2; code < free_ent; code++)
+    child[slot[code]] = 0;
 }
 
 static void